@@ -0,0 +1,99 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __FREERTOS_H__
+#define __FREERTOS_H__
+/**********************************************************************************************/
+
+/*
+ * FreeRTOS kernel API used by the atcmd core, implemented on top of pthreads (linux-os.c).
+ * Only tasks, task notifications, mutexes and event groups are provided.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+typedef uint32_t EventBits_t;
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef struct QueueDefinition *SemaphoreHandle_t;
+typedef struct EventGroupDef_t *EventGroupHandle_t;
+
+typedef void (*TaskFunction_t) (void *);
+
+#define configUSE_16_BIT_TICKS		0
+#define configTICK_RATE_HZ			1000
+#define configMAX_PRIORITIES		32
+
+#define pdFALSE						((BaseType_t)0)
+#define pdTRUE						((BaseType_t)1)
+#define pdPASS						(pdTRUE)
+#define pdFAIL						(pdFALSE)
+
+#define portMAX_DELAY				((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS			((TickType_t)1000 / configTICK_RATE_HZ)
+#define portYIELD_FROM_ISR(x)		(void)(x)
+
+#define pdMS_TO_TICKS(ms)			((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000))
+
+#define tskIDLE_PRIORITY			((UBaseType_t)0)
+
+/* Task */
+extern BaseType_t xTaskCreate (TaskFunction_t func, const char *name, uint32_t stack_depth,
+								void *param, UBaseType_t priority, TaskHandle_t *handle);
+extern void vTaskDelete (TaskHandle_t task);
+extern void vTaskDelay (TickType_t ticks);
+extern TaskHandle_t xTaskGetCurrentTaskHandle (void);
+extern TickType_t xTaskGetTickCount (void);
+
+extern BaseType_t xTaskNotifyGive (TaskHandle_t task);
+extern void vTaskNotifyGiveFromISR (TaskHandle_t task, BaseType_t *woken);
+extern uint32_t ulTaskNotifyTake (BaseType_t clear, TickType_t ticks);
+
+/* Mutex */
+extern SemaphoreHandle_t xSemaphoreCreateMutex (void);
+extern void vSemaphoreDelete (SemaphoreHandle_t sem);
+extern BaseType_t xSemaphoreTake (SemaphoreHandle_t sem, TickType_t ticks);
+extern BaseType_t xSemaphoreGive (SemaphoreHandle_t sem);
+
+/* Event Group */
+extern EventGroupHandle_t xEventGroupCreate (void);
+extern void vEventGroupDelete (EventGroupHandle_t group);
+extern EventBits_t xEventGroupGetBits (EventGroupHandle_t group);
+extern EventBits_t xEventGroupSetBits (EventGroupHandle_t group, EventBits_t bits);
+extern EventBits_t xEventGroupClearBits (EventGroupHandle_t group, EventBits_t bits);
+extern EventBits_t xEventGroupWaitBits (EventGroupHandle_t group, EventBits_t bits,
+								BaseType_t clear, BaseType_t wait_all, TickType_t ticks);
+
+/* Heap */
+extern void *pvPortMalloc (size_t size);
+extern void vPortFree (void *ptr);
+
+/**********************************************************************************************/
+#endif /* #ifndef __FREERTOS_H__ */
@@ -0,0 +1,106 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __LWIP_SOCKETS_H__
+#define __LWIP_SOCKETS_H__
+/**********************************************************************************************/
+
+/*
+ * lwIP socket API on top of the host sockets (linux-lwip.c).
+ *
+ * The application sees small lwIP style socket indices (0 ~ MEMP_NUM_NETCONN - 1),
+ * which are mapped to host file descriptors. This keeps the fd_set bit and event group
+ * assumptions of lwip_socket.c valid. Address types are the host ones, only IPv4 is supported.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "lwip/ip_addr.h"
+
+/* struct sockaddr_in of lwIP has 'sin_len', it is ignored by the host */
+#define sin_len		sin_zero[0]
+
+/* lwip/inet.h */
+#define inet_addr_from_ip4addr(target_inaddr, source_ipaddr) \
+		((target_inaddr)->s_addr = ip4_addr_get_u32(source_ipaddr))
+#define inet_addr_to_ip4addr(target_ipaddr, source_inaddr) \
+		(ip4_addr_set_u32(target_ipaddr, (source_inaddr)->s_addr))
+
+extern int lwip_socket (int domain, int type, int protocol);
+extern int lwip_bind (int s, const struct sockaddr *name, socklen_t namelen);
+extern int lwip_listen (int s, int backlog);
+extern int lwip_accept (int s, struct sockaddr *addr, socklen_t *addrlen);
+extern int lwip_connect (int s, const struct sockaddr *name, socklen_t namelen);
+extern int lwip_shutdown (int s, int how);
+extern int lwip_close (int s);
+
+extern ssize_t lwip_send (int s, const void *dataptr, size_t size, int flags);
+extern ssize_t lwip_sendto (int s, const void *dataptr, size_t size, int flags,
+								const struct sockaddr *to, socklen_t tolen);
+extern ssize_t lwip_recv (int s, void *mem, size_t len, int flags);
+extern ssize_t lwip_recvfrom (int s, void *mem, size_t len, int flags,
+								struct sockaddr *from, socklen_t *fromlen);
+
+extern int lwip_select (int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptset,
+								struct timeval *timeout);
+extern int lwip_fcntl (int s, int cmd, int val);
+extern int lwip_ioctl (int s, long cmd, void *argp);
+
+extern int lwip_getsockopt (int s, int level, int optname, void *optval, socklen_t *optlen);
+extern int lwip_setsockopt (int s, int level, int optname, const void *optval, socklen_t optlen);
+extern int lwip_getpeername (int s, struct sockaddr *name, socklen_t *namelen);
+extern int lwip_getsockname (int s, struct sockaddr *name, socklen_t *namelen);
+
+/* LWIP_COMPAT_SOCKETS */
+#define socket(domain,type,protocol)				lwip_socket(domain,type,protocol)
+#define bind(s,name,namelen)						lwip_bind(s,name,namelen)
+#define listen(s,backlog)							lwip_listen(s,backlog)
+#define accept(s,addr,addrlen)						lwip_accept(s,addr,addrlen)
+#define connect(s,name,namelen)						lwip_connect(s,name,namelen)
+#define shutdown(s,how)								lwip_shutdown(s,how)
+#define close(s)									lwip_close(s)
+#define send(s,dataptr,size,flags)					lwip_send(s,dataptr,size,flags)
+#define sendto(s,dataptr,size,flags,to,tolen)		lwip_sendto(s,dataptr,size,flags,to,tolen)
+#define recv(s,mem,len,flags)						lwip_recv(s,mem,len,flags)
+#define recvfrom(s,mem,len,flags,from,fromlen)		lwip_recvfrom(s,mem,len,flags,from,fromlen)
+#define select(maxfdp1,readset,writeset,exceptset,timeout) \
+		lwip_select(maxfdp1,readset,writeset,exceptset,timeout)
+#define fcntl(s,cmd,val)							lwip_fcntl(s,cmd,val)
+#define ioctl(s,cmd,argp)							lwip_ioctl(s,cmd,argp)
+#define getsockopt(s,level,optname,opval,optlen)	lwip_getsockopt(s,level,optname,opval,optlen)
+#define setsockopt(s,level,optname,opval,optlen)	lwip_setsockopt(s,level,optname,opval,optlen)
+#define getpeername(s,name,namelen)					lwip_getpeername(s,name,namelen)
+#define getsockname(s,name,namelen)					lwip_getsockname(s,name,namelen)
+
+/**********************************************************************************************/
+#endif /* #ifndef __LWIP_SOCKETS_H__ */
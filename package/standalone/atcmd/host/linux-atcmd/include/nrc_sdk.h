@@ -0,0 +1,162 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __NRC_SDK_H__
+#define __NRC_SDK_H__
+/**********************************************************************************************/
+
+/*
+ * Host replacement of sdk/include/nrc_sdk.h for the Linux build of the atcmd core.
+ * It only provides what the core (atcmd_core.c, atcmd_socket.c, lwip_socket.c, hif*.c) uses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+
+#include <assert.h>
+
+#define NRC7292
+#define CPU_CM3
+
+#define NRC_TASK_PRIORITY		(configMAX_PRIORITIES - 3)
+
+/* lib/modem/inc/hal/hal_uart.h */
+enum uart_data_bit
+{
+	UART_DB5 = 0,
+	UART_DB6 = 1,
+	UART_DB7 = 2,
+	UART_DB8 = 3,
+};
+
+enum uart_stop_bit
+{
+	UART_SB1 = 0,
+	UART_SB2 = 1,
+};
+
+enum uart_parity_bit
+{
+	UART_PB_NONE = 0,
+	UART_PB_ODD  = 1,
+	UART_PB_EVEN = 2,
+};
+
+enum uart_hardware_flow_control
+{
+	UART_HFC_DISABLE,
+	UART_HFC_ENABLE,
+};
+
+/* lib/modem/inc/system/system_common.h */
+typedef enum _COUNTRY_CODE_INDEX
+{
+	COUNTRY_CODE_US,
+	COUNTRY_CODE_JP,
+	COUNTRY_CODE_K1,
+	COUNTRY_CODE_TW,
+	COUNTRY_CODE_EU,
+	COUNTRY_CODE_CN,
+	COUNTRY_CODE_NZ,
+	COUNTRY_CODE_AU,
+	COUNTRY_CODE_K2,
+	COUNTRY_CODE_MAX,
+} COUNTRY_CODE_INDEX;
+
+typedef struct
+{
+	COUNTRY_CODE_INDEX cc_index;
+	const char *alpha2_cc;
+} country_codes;
+
+/* lib/modem/inc/system/system_macro.h */
+#define ASSERT(x)		assert(x)
+
+/* sdk/include/nrc_types.h */
+#define MAX_SCAN_RESULTS		(30)
+
+typedef enum
+{
+	WIFI_SEC_OPEN = 0,
+	WIFI_SEC_WPA2,
+	WIFI_SEC_WPA3_OWE,
+	WIFI_SEC_WPA3_SAE,
+
+	WIFI_SEC_MAX,
+} tWIFI_SECURITY;
+
+typedef union
+{
+	char *items[5];
+	struct
+	{
+		char *bssid;
+		char *freq;
+		char *sig_level;
+		char *flags;
+		char *ssid;
+		tWIFI_SECURITY security;
+	};
+} SCAN_RESULT;
+
+typedef struct
+{
+	int n_result;
+	SCAN_RESULT result[MAX_SCAN_RESULTS];
+} SCAN_RESULTS;
+
+#ifndef __must_check
+#define __must_check __attribute__((__warn_unused_result__))
+#endif
+
+extern int hal_uart_printf (const char *fmt, ...);
+
+/* newlib */
+extern char *strupr (char *str);
+extern char *strlwr (char *str);
+
+/* lib/modem/inc/util/util_fota.h */
+extern void util_fota_reboot_firmware (void);
+
+#define nrc_mem_malloc	pvPortMalloc
+#define nrc_mem_free	vPortFree
+
+#define nrc_usr_print	hal_uart_printf
+
+#define _delay_ms(x)	vTaskDelay(pdMS_TO_TICKS(x))
+
+/**********************************************************************************************/
+#endif /* #ifndef __NRC_SDK_H__ */
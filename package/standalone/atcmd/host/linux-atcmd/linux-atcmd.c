@@ -0,0 +1,166 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include "atcmd.h"
+
+/*
+ * Parts of the atcmd application that need the Wi-Fi stack or the flash are not built for Linux.
+ * The BASIC and WIFI groups are left out, only the socket timeouts of AT+STIMEOUT are kept.
+ */
+
+/* atcmd.h, external definition of the inline function */
+extern inline uint32_t atcmd_sys_now (void);
+
+/**********************************************************************************************/
+
+int atcmd_basic_enable (void)
+{
+	return 0;
+}
+
+void atcmd_basic_disable (void)
+{
+}
+
+#if defined(CONFIG_ATCMD_UART) || defined(CONFIG_ATCMD_UART_HFC)
+bool g_atcmd_uart_passthrough_support = false;
+#endif
+
+void atcmd_firmware_write (char *buf, int len)
+{
+}
+
+void atcmd_firmware_download_event_idle (uint32_t len, uint32_t cnt)
+{
+}
+
+void atcmd_firmware_download_event_drop (uint32_t len)
+{
+}
+
+void atcmd_firmware_download_event_done (uint32_t len)
+{
+}
+
+/**********************************************************************************************/
+
+#define ATCMD_TIMEOUT_CMD_LEN_MAX		20
+
+typedef struct
+{
+	char *cmd;
+	uint32_t sec;
+} atcmd_timeout_t;
+
+static atcmd_timeout_t g_atcmd_timeout_socket[] =
+{
+	{ "SOPEN", 30 },
+	{ "SSEND", 1 },
+
+	{ NULL, 0 }
+};
+
+static atcmd_timeout_t *_atcmd_timeout_search (const char *cmd)
+{
+	int i;
+
+	for (i = 0 ; g_atcmd_timeout_socket[i].cmd ; i++)
+	{
+		if (strcmp(cmd, g_atcmd_timeout_socket[i].cmd) == 0)
+			return &g_atcmd_timeout_socket[i];
+	}
+
+	return NULL;
+}
+
+uint32_t _atcmd_timeout_value (const char *cmd)
+{
+	atcmd_timeout_t *timeout = _atcmd_timeout_search(cmd);
+
+	if (!timeout)
+	{
+		_atcmd_error("no cmd");
+		return 0;
+	}
+
+	return timeout->sec * 1000; // msec
+}
+
+int _atcmd_basic_timeout_get (int argc, char *argv[])
+{
+	char param_cmd[ATCMD_STR_PARAM_SIZE(ATCMD_TIMEOUT_CMD_LEN_MAX)];
+	int i;
+
+	for (i = 0 ; g_atcmd_timeout_socket[i].cmd ; i++)
+	{
+		if (!atcmd_str_to_param(g_atcmd_timeout_socket[i].cmd, param_cmd, sizeof(param_cmd)))
+			return ATCMD_ERROR_FAIL;
+
+		ATCMD_MSG_INFO("STIMEOUT", "%s,%d", param_cmd, g_atcmd_timeout_socket[i].sec);
+	}
+
+	return ATCMD_SUCCESS;
+}
+
+int _atcmd_basic_timeout_set (int argc, char *argv[])
+{
+	char str_cmd[ATCMD_STR_SIZE(ATCMD_TIMEOUT_CMD_LEN_MAX)];
+	atcmd_timeout_t *timeout;
+	int time_sec;
+
+	if (argc != 2)
+		return ATCMD_ERROR_INVAL;
+
+	if (!atcmd_param_to_str(argv[0], str_cmd, sizeof(str_cmd)))
+		return ATCMD_ERROR_FAIL;
+
+	timeout = _atcmd_timeout_search(str_cmd);
+	if (!timeout)
+		return ATCMD_ERROR_INVAL;
+
+	time_sec = atoi(argv[1]);
+	if (time_sec < 0)
+		return ATCMD_ERROR_INVAL;
+
+	timeout->sec = time_sec;
+
+	return ATCMD_SUCCESS;
+}
+
+/**********************************************************************************************/
+
+int atcmd_wifi_enable (void)
+{
+	return 0;
+}
+
+void atcmd_wifi_disable (void)
+{
+}
+
+void atcmd_wifi_deep_sleep_send_event (void)
+{
+}
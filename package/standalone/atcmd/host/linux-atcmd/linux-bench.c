@@ -0,0 +1,249 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <time.h>
+#include <ctype.h>
+
+#include "atcmd.h"
+#include "linux-atcmd.h"
+
+/*
+ * Parser benchmark, replays the AT commands of raspi-atcmd-cli scripts (ATC/) through
+ * atcmd_receive_command(). Every command found in the scripts is registered again
+ * in a group registered last, so that it shadows the real handler and the time
+ * covers the line input, atcmd_parse() and the command lookup only.
+ * ATZ is skipped, and the responses of AT/ATE are dropped by the HIF without a host.
+ */
+
+#define LINUX_BENCH_GROUP_ID		((enum ATCMD_GROUP_ID)0x100)
+#define LINUX_BENCH_LINE_MAX		ATCMD_MSG_LEN_MAX
+#define LINUX_BENCH_CMD_MAX			256
+
+typedef struct
+{
+	int n_lines;
+	char *lines[LINUX_BENCH_CMD_MAX];
+	int len[LINUX_BENCH_CMD_MAX];
+
+	int n_cmds;
+	atcmd_info_t *cmds[LINUX_BENCH_CMD_MAX];
+} linux_bench_t;
+
+static atcmd_group_t g_linux_bench_group =
+{
+	.list.next = NULL,
+	.list.prev = NULL,
+
+	.name = "BENCH",
+	.id = LINUX_BENCH_GROUP_ID,
+
+	.cmd_prefix = "",
+	.cmd_prefix_size = 0,
+
+	.cmd_list_head.next = NULL,
+	.cmd_list_head.prev = NULL,
+};
+
+static int linux_bench_handler (int argc, char *argv[])
+{
+	return ATCMD_NO_RETURN;
+}
+
+static int linux_bench_add_cmd (linux_bench_t *bench, const char *line)
+{
+	atcmd_info_t *info;
+	char *cmd;
+	int len;
+	int i;
+
+	if (strncasecmp(line, "AT+", 3) != 0)
+		return 0;
+
+	line += 3;
+	len = strcspn(line, "=?");
+
+	for (i = 0 ; i < bench->n_cmds ; i++)
+	{
+		if (strncasecmp(line, bench->cmds[i]->cmd, len) == 0 && bench->cmds[i]->cmd[len] == '\0')
+			return 0;
+	}
+
+	if (bench->n_cmds >= LINUX_BENCH_CMD_MAX)
+		return -ENOSPC;
+
+	info = calloc(1, sizeof(atcmd_info_t));
+	cmd = strndup(line, len);
+	if (!info || !cmd)
+	{
+		free(info);
+		free(cmd);
+		return -ENOMEM;
+	}
+
+	info->group = LINUX_BENCH_GROUP_ID;
+	info->id = bench->n_cmds;
+	info->cmd = strupr(cmd);
+
+	for (i = 0 ; i < ATCMD_HANDLER_NUM ; i++)
+		info->handler[i] = linux_bench_handler;
+
+	bench->cmds[bench->n_cmds++] = info;
+
+	return 0;
+}
+
+static int linux_bench_load (linux_bench_t *bench, const char *file)
+{
+	char buf[LINUX_BENCH_LINE_MAX + 1];
+	char *line;
+	FILE *fp;
+	int len;
+	int ret = 0;
+
+	fp = fopen(file, "r");
+	if (!fp)
+	{
+		_atcmd_error("%s, %s", file, strerror(errno));
+		return -errno;
+	}
+
+	while (fgets(buf, sizeof(buf) - 1, fp))
+	{
+		for (line = buf ; *line == ' ' || *line == '\t' ; line++)
+			;
+
+		for (len = strlen(line) ; len > 0 && isspace((int)line[len - 1]) ; len--)
+			;
+
+		line[len] = '\0';
+
+		if (strncasecmp(line, "AT", 2) != 0 || strcasecmp(line, "ATZ") == 0)
+			continue;
+
+		if (bench->n_lines >= LINUX_BENCH_CMD_MAX)
+		{
+			ret = -ENOSPC;
+			break;
+		}
+
+		ret = linux_bench_add_cmd(bench, line);
+		if (ret != 0)
+			break;
+
+		bench->lines[bench->n_lines] = malloc(len + 3);
+		if (!bench->lines[bench->n_lines])
+		{
+			ret = -ENOMEM;
+			break;
+		}
+
+		sprintf(bench->lines[bench->n_lines], "%s\r\n", line);
+		bench->len[bench->n_lines++] = len + 2;
+	}
+
+	fclose(fp);
+
+	return ret;
+}
+
+static void linux_bench_free (linux_bench_t *bench)
+{
+	int i;
+
+	for (i = 0 ; i < bench->n_lines ; i++)
+		free(bench->lines[i]);
+
+	for (i = 0 ; i < bench->n_cmds ; i++)
+	{
+		free((char *)bench->cmds[i]->cmd);
+		free(bench->cmds[i]);
+	}
+}
+
+static uint64_t linux_bench_time_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int linux_atcmd_bench (char *files[], int n_files, int count)
+{
+	linux_bench_t bench;
+	uint64_t time_ns;
+	uint64_t n_cmds;
+	int ret = 0;
+	int i, j;
+
+	memset(&bench, 0, sizeof(bench));
+
+	for (i = 0 ; i < n_files ; i++)
+	{
+		ret = linux_bench_load(&bench, files[i]);
+		if (ret != 0)
+			goto bench_exit;
+	}
+
+	if (bench.n_lines == 0)
+	{
+		_atcmd_error("no command");
+		ret = -EINVAL;
+		goto bench_exit;
+	}
+
+	atcmd_group_register(&g_linux_bench_group);
+
+	for (i = 0 ; i < bench.n_cmds ; i++)
+		atcmd_info_register(LINUX_BENCH_GROUP_ID, bench.cmds[i]);
+
+	time_ns = linux_bench_time_ns();
+
+	for (i = 0 ; i < count ; i++)
+	{
+		for (j = 0 ; j < bench.n_lines ; j++)
+			atcmd_receive_command(bench.lines[j], bench.len[j]);
+	}
+
+	time_ns = linux_bench_time_ns() - time_ns;
+	n_cmds = (uint64_t)count * bench.n_lines;
+
+	for (i = 0 ; i < bench.n_cmds ; i++)
+		atcmd_info_unregister(LINUX_BENCH_GROUP_ID, bench.cmds[i]->id);
+
+	atcmd_group_unregister(LINUX_BENCH_GROUP_ID);
+
+	printf("BENCH: files=%d lines=%d cmds=%d count=%d\n", n_files, bench.n_lines, bench.n_cmds, count);
+	printf("BENCH: %llu commands, %llu ns, %llu ns/cmd\n",
+				(unsigned long long)n_cmds, (unsigned long long)time_ns,
+				(unsigned long long)(time_ns / n_cmds));
+
+bench_exit:
+
+	linux_bench_free(&bench);
+
+	return ret;
+}
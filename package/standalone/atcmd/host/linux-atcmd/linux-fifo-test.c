@@ -0,0 +1,261 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "hif.h"
+
+/*
+ * RX FIFO test, a producer thread writes a counting byte pattern in chunks of random size
+ * and the consumer checks it, either copied out by _hif_fifo_read() as the HIF RX task did
+ * or in place by _hif_fifo_peek() and _hif_fifo_commit().
+ * As in linux-hif.c, a mutex covers the FIFO calls only, the data is checked without it.
+ */
+
+#define FIFO_TEST_SIZE			(4 * 1024)
+#define FIFO_TEST_CHUNK_MAX		1024
+#define FIFO_TEST_READ_MAX		1024 /* ATCMD_RXBUF_SIZE */
+#define FIFO_TEST_BYTES			(256 * 1024 * 1024)
+
+enum FIFO_TEST_MODE
+{
+	FIFO_TEST_COPY = 0,
+	FIFO_TEST_SPAN,
+};
+
+typedef struct
+{
+	_hif_fifo_t *fifo;
+	uint64_t bytes;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool producer_wait;
+	bool consumer_wait;
+} fifo_test_t;
+
+static fifo_test_t g_fifo_test =
+{
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void fifo_test_lock (void)
+{
+	pthread_mutex_lock(&g_fifo_test.mutex);
+}
+
+static void fifo_test_unlock (void)
+{
+	pthread_mutex_unlock(&g_fifo_test.mutex);
+}
+
+static void fifo_test_wait (bool *wait)
+{
+	*wait = true;
+	pthread_cond_wait(&g_fifo_test.cond, &g_fifo_test.mutex);
+	*wait = false;
+}
+
+static void fifo_test_wakeup (bool wait)
+{
+	if (wait)
+		pthread_cond_broadcast(&g_fifo_test.cond);
+}
+
+static void *fifo_test_producer (void *arg)
+{
+	char buf[FIFO_TEST_CHUNK_MAX];
+	unsigned int seed = 1;
+	uint8_t val = 0;
+	uint64_t done;
+	int len;
+	int ret;
+	int i;
+
+	for (done = 0 ; done < g_fifo_test.bytes ; )
+	{
+		len = 1 + rand_r(&seed) % FIFO_TEST_CHUNK_MAX;
+		if (len > (g_fifo_test.bytes - done))
+			len = g_fifo_test.bytes - done;
+
+		for (i = 0 ; i < len ; i++)
+			buf[i] = val++;
+
+		for (i = 0 ; i < len ; i += ret)
+		{
+			fifo_test_lock();
+
+			while (_hif_fifo_full(g_fifo_test.fifo))
+				fifo_test_wait(&g_fifo_test.producer_wait);
+
+			ret = _hif_fifo_write(g_fifo_test.fifo, buf + i, len - i);
+
+			fifo_test_wakeup(g_fifo_test.consumer_wait);
+			fifo_test_unlock();
+		}
+
+		done += len;
+	}
+
+	return NULL;
+}
+
+static int fifo_test_check (char *buf, int len, uint8_t *val)
+{
+	int i;
+
+	for (i = 0 ; i < len ; i++)
+	{
+		if ((uint8_t)buf[i] != (*val)++)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int fifo_test_consumer (enum FIFO_TEST_MODE mode)
+{
+	char buf[FIFO_TEST_READ_MAX];
+	_hif_buf_t span[2];
+	uint8_t val = 0;
+	uint64_t done;
+	int len;
+	int i;
+
+	for (done = 0 ; done < g_fifo_test.bytes ; done += len)
+	{
+		fifo_test_lock();
+
+		while (_hif_fifo_empty(g_fifo_test.fifo))
+			fifo_test_wait(&g_fifo_test.consumer_wait);
+
+		if (mode == FIFO_TEST_COPY)
+		{
+			len = _hif_fifo_read(g_fifo_test.fifo, buf, sizeof(buf));
+
+			fifo_test_wakeup(g_fifo_test.producer_wait);
+			fifo_test_unlock();
+
+			if (fifo_test_check(buf, len, &val) != 0)
+				return -1;
+		}
+		else
+		{
+			len = _hif_fifo_peek(g_fifo_test.fifo, span, FIFO_TEST_READ_MAX);
+
+			fifo_test_unlock();
+
+			for (i = 0 ; i < 2 ; i++)
+			{
+				if (fifo_test_check(span[i].addr, span[i].size, &val) != 0)
+					return -1;
+			}
+
+			fifo_test_lock();
+
+			_hif_fifo_commit(g_fifo_test.fifo, len);
+
+			fifo_test_wakeup(g_fifo_test.producer_wait);
+			fifo_test_unlock();
+		}
+	}
+
+	return 0;
+}
+
+static int fifo_test_run (enum FIFO_TEST_MODE mode, int size)
+{
+	const char *str_mode[] = { "copy", "span" };
+	struct timespec start, end;
+	pthread_t producer;
+	double time;
+	int ret;
+
+	g_fifo_test.fifo = _hif_fifo_create(NULL, size);
+	if (!g_fifo_test.fifo)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	pthread_create(&producer, NULL, fifo_test_producer, NULL);
+
+	ret = fifo_test_consumer(mode);
+	if (ret != 0)
+	{
+		printf("%s: data mismatch\n", str_mode[mode]);
+		exit(1);
+	}
+
+	pthread_join(producer, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("%s: fifo=%d bytes=%llu time=%.3f sec, %.1f MB/s\n", str_mode[mode], size,
+				(unsigned long long)g_fifo_test.bytes, time, g_fifo_test.bytes / time / 1e6);
+
+	_hif_fifo_delete(g_fifo_test.fifo);
+	g_fifo_test.fifo = NULL;
+
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	int size = FIFO_TEST_SIZE;
+	int opt;
+
+	g_fifo_test.bytes = FIFO_TEST_BYTES;
+
+	while ((opt = getopt(argc, argv, "b:s:h")) != -1)
+	{
+		switch (opt)
+		{
+			case 'b':
+				g_fifo_test.bytes = strtoull(optarg, NULL, 10);
+				break;
+
+			case 's':
+				size = atoi(optarg);
+				break;
+
+			default:
+				printf("Usage: %s [-b <bytes>] [-s <fifo size>]\n", argv[0]);
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (g_fifo_test.bytes == 0 || size <= 0)
+		return 1;
+
+	fifo_test_run(FIFO_TEST_COPY, size);
+	fifo_test_run(FIFO_TEST_SPAN, size);
+
+	return 0;
+}
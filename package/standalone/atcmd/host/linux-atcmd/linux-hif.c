@@ -0,0 +1,322 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "hif.h"
+#include "linux-atcmd.h"
+
+/*
+ * UART HIF on a UNIX domain stream socket.
+ *
+ * The host (raspi-atcmd-cli -L) connects to the socket instead of opening a tty.
+ * As with the UART DMA on the target, a receive thread fills the RX FIFO and resumes
+ * the HIF RX task, which then calls _hif_uart_peek(). A full FIFO stops the receive thread,
+ * so the socket buffer takes the role of the hardware flow control.
+ */
+
+#define linux_hif_info(fmt, ...)	hal_uart_printf("[HIF] " fmt "\n", ##__VA_ARGS__)
+#define linux_hif_error(fmt, ...)	hal_uart_printf("[HIF] %s::%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__)
+
+static struct
+{
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+	int listen_fd;
+	int fd;
+
+	pthread_t thread;
+	bool thread_run;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond; /* RX FIFO not full */
+	_hif_fifo_t *rx_fifo;
+} g_linux_hif =
+{
+	.path = LINUX_ATCMD_HIF_PATH,
+	.listen_fd = -1,
+	.fd = -1,
+	.thread_run = false,
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.rx_fifo = NULL,
+};
+
+int linux_hif_set_path (const char *path)
+{
+	if (!path || strlen(path) >= sizeof(g_linux_hif.path))
+		return -EINVAL;
+
+	strcpy(g_linux_hif.path, path);
+
+	return 0;
+}
+
+/**********************************************************************************************/
+
+static int linux_hif_rx_push (char *buf, int len)
+{
+	int ret;
+	int i;
+
+	pthread_mutex_lock(&g_linux_hif.mutex);
+
+	for (i = 0 ; i < len ; i += ret)
+	{
+		while (_hif_fifo_full(g_linux_hif.rx_fifo))
+		{
+			pthread_mutex_unlock(&g_linux_hif.mutex);
+			_hif_rx_resume();
+			pthread_mutex_lock(&g_linux_hif.mutex);
+
+			if (_hif_fifo_full(g_linux_hif.rx_fifo))
+				pthread_cond_wait(&g_linux_hif.cond, &g_linux_hif.mutex);
+		}
+
+		ret = _hif_fifo_write(g_linux_hif.rx_fifo, buf + i, len - i);
+	}
+
+	pthread_mutex_unlock(&g_linux_hif.mutex);
+
+	_hif_rx_resume();
+
+	return len;
+}
+
+static void *linux_hif_rx_thread (void *arg)
+{
+	char buf[4096];
+	int fd;
+	int ret;
+
+	while (1)
+	{
+		fd = accept(g_linux_hif.listen_fd, NULL, NULL);
+		if (fd < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			linux_hif_error("accept(), %s", strerror(errno));
+			break;
+		}
+
+		linux_hif_info("connected, %s", g_linux_hif.path);
+
+		pthread_mutex_lock(&g_linux_hif.mutex);
+		g_linux_hif.fd = fd;
+		pthread_mutex_unlock(&g_linux_hif.mutex);
+
+		while (1)
+		{
+			ret = read(fd, buf, sizeof(buf));
+			if (ret < 0 && errno == EINTR)
+				continue;
+			else if (ret <= 0)
+				break;
+
+			linux_hif_rx_push(buf, ret);
+		}
+
+		linux_hif_info("disconnected");
+
+		pthread_mutex_lock(&g_linux_hif.mutex);
+		g_linux_hif.fd = -1;
+		pthread_mutex_unlock(&g_linux_hif.mutex);
+
+		close(fd);
+	}
+
+	return NULL;
+}
+
+/**********************************************************************************************/
+
+int _hif_uart_open (_hif_info_t *info)
+{
+	struct sockaddr_un addr;
+	int fd;
+	int ret;
+
+	if (!info || !info->rx_fifo.size)
+		return -1;
+
+	g_linux_hif.rx_fifo = _hif_fifo_create(info->rx_fifo.addr, info->rx_fifo.size);
+	if (!g_linux_hif.rx_fifo)
+		return -1;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		linux_hif_error("socket(), %s", strerror(errno));
+		goto _hif_uart_open_fail;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, g_linux_hif.path);
+
+	unlink(g_linux_hif.path);
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 1) < 0)
+	{
+		linux_hif_error("%s, %s", g_linux_hif.path, strerror(errno));
+		close(fd);
+		goto _hif_uart_open_fail;
+	}
+
+	g_linux_hif.listen_fd = fd;
+
+	ret = pthread_create(&g_linux_hif.thread, NULL, linux_hif_rx_thread, NULL);
+	if (ret != 0)
+	{
+		linux_hif_error("pthread_create(), %s", strerror(ret));
+		goto _hif_uart_open_fail;
+	}
+
+	g_linux_hif.thread_run = true;
+
+	linux_hif_info("listen, %s", g_linux_hif.path);
+
+	return 0;
+
+_hif_uart_open_fail:
+
+	_hif_uart_close();
+
+	return -1;
+}
+
+void _hif_uart_close (void)
+{
+	if (g_linux_hif.thread_run)
+	{
+		pthread_cancel(g_linux_hif.thread);
+		pthread_join(g_linux_hif.thread, NULL);
+
+		g_linux_hif.thread_run = false;
+	}
+
+	if (g_linux_hif.fd >= 0)
+	{
+		close(g_linux_hif.fd);
+		g_linux_hif.fd = -1;
+	}
+
+	if (g_linux_hif.listen_fd >= 0)
+	{
+		close(g_linux_hif.listen_fd);
+		g_linux_hif.listen_fd = -1;
+
+		unlink(g_linux_hif.path);
+	}
+
+	if (g_linux_hif.rx_fifo)
+	{
+		_hif_fifo_delete(g_linux_hif.rx_fifo);
+		g_linux_hif.rx_fifo = NULL;
+	}
+}
+
+int _hif_uart_read (char *buf, int len)
+{
+	int ret = 0;
+
+	if (g_linux_hif.rx_fifo)
+	{
+		pthread_mutex_lock(&g_linux_hif.mutex);
+
+		ret = _hif_fifo_read(g_linux_hif.rx_fifo, buf, len);
+		if (ret > 0)
+			pthread_cond_signal(&g_linux_hif.cond);
+
+		pthread_mutex_unlock(&g_linux_hif.mutex);
+	}
+
+	return ret;
+}
+
+int _hif_uart_peek (_hif_buf_t span[2], int len)
+{
+	int ret = -1;
+
+	if (g_linux_hif.rx_fifo)
+	{
+		pthread_mutex_lock(&g_linux_hif.mutex);
+		ret = _hif_fifo_peek(g_linux_hif.rx_fifo, span, len);
+		pthread_mutex_unlock(&g_linux_hif.mutex);
+	}
+
+	return ret;
+}
+
+void _hif_uart_commit (int len)
+{
+	if (g_linux_hif.rx_fifo)
+	{
+		pthread_mutex_lock(&g_linux_hif.mutex);
+
+		if (_hif_fifo_commit(g_linux_hif.rx_fifo, len) > 0)
+			pthread_cond_signal(&g_linux_hif.cond);
+
+		pthread_mutex_unlock(&g_linux_hif.mutex);
+	}
+}
+
+int _hif_uart_write (char *buf, int len)
+{
+	int fd;
+	int ret;
+	int i;
+
+	pthread_mutex_lock(&g_linux_hif.mutex);
+	fd = g_linux_hif.fd;
+	pthread_mutex_unlock(&g_linux_hif.mutex);
+
+	/* Nothing is connected, drop the data like a UART with no host attached. */
+	if (fd < 0)
+		return len;
+
+	for (i = 0 ; i < len ; i += ret)
+	{
+		ret = send(fd, buf + i, len - i, MSG_NOSIGNAL);
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+			{
+				ret = 0;
+				continue;
+			}
+
+			break;
+		}
+	}
+
+	return len;
+}
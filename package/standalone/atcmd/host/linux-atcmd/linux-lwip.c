@@ -0,0 +1,691 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <poll.h>
+#include <pthread.h>
+
+#include "nrc_sdk.h"
+#include "lwip/sockets.h"
+#include "lwip/api.h"
+#include "nrc_lwip.h"
+
+/*
+ * lwIP socket API on top of the host sockets.
+ *
+ * The lwIP socket indices handed to the application are mapped to host file descriptors.
+ * An event thread polls the host sockets and raises LWIP_HOOK_SOCKETS_EVENT like the tcpip
+ * thread does on the target. An event is reported once and then masked until the socket is
+ * used again (recv/accept for RCVPLUS, send for SENDPLUS) or a select() finds it not ready,
+ * so that a socket left unread does not keep the event thread busy.
+ *
+ * As with lwIP, the first recv() after a FIN returns 0 and the following ones fail with ENOTCONN.
+ */
+
+#undef socket
+#undef bind
+#undef listen
+#undef accept
+#undef connect
+#undef shutdown
+#undef close
+#undef send
+#undef sendto
+#undef recv
+#undef recvfrom
+#undef select
+#undef fcntl
+#undef ioctl
+#undef getsockopt
+#undef setsockopt
+#undef getpeername
+#undef getsockname
+
+#define LINUX_LWIP_SOCKET_NUM		MEMP_NUM_NETCONN
+
+#define LINUX_LWIP_EVENT_RCV		(1 << 0)
+#define LINUX_LWIP_EVENT_SEND		(1 << 1)
+
+#define linux_lwip_error(fmt, ...)	fprintf(stderr, "%s::%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__)
+
+typedef struct
+{
+	int fd; /* host, -1 if free */
+	int type; /* SOCK_STREAM, SOCK_DGRAM */
+	int armed; /* LINUX_LWIP_EVENT_xxx */
+	bool fin; /* end of stream returned once */
+} linux_lwip_socket_t;
+
+static struct
+{
+	pthread_mutex_t mutex;
+	linux_lwip_socket_t socket[LINUX_LWIP_SOCKET_NUM];
+
+	void (*event_cb) (int s, int evt);
+
+	pthread_t thread;
+	bool thread_run;
+	int wakeup[2]; /* pipe */
+} g_linux_lwip =
+{
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.event_cb = NULL,
+	.thread_run = false,
+	.wakeup = { -1, -1 },
+};
+
+/**********************************************************************************************/
+
+static void linux_lwip_wakeup (void)
+{
+	char c = 0;
+
+	if (g_linux_lwip.wakeup[1] >= 0)
+	{
+		if (write(g_linux_lwip.wakeup[1], &c, 1) < 0 && errno != EAGAIN)
+			linux_lwip_error("write(), %s", strerror(errno));
+	}
+}
+
+static void linux_lwip_arm (int s, int events)
+{
+	bool wakeup = false;
+
+	pthread_mutex_lock(&g_linux_lwip.mutex);
+
+	if (g_linux_lwip.socket[s].fd >= 0 && (g_linux_lwip.socket[s].armed & events) != events)
+	{
+		g_linux_lwip.socket[s].armed |= events;
+		wakeup = true;
+	}
+
+	pthread_mutex_unlock(&g_linux_lwip.mutex);
+
+	if (wakeup)
+		linux_lwip_wakeup();
+}
+
+static void *linux_lwip_event_thread (void *arg)
+{
+	struct pollfd fds[1 + LINUX_LWIP_SOCKET_NUM];
+	int index[1 + LINUX_LWIP_SOCKET_NUM];
+	int events[LINUX_LWIP_SOCKET_NUM];
+	void (*event_cb) (int s, int evt);
+	int nfds;
+	int ret;
+	int i;
+
+	while (1)
+	{
+		fds[0].fd = g_linux_lwip.wakeup[0];
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+
+		pthread_mutex_lock(&g_linux_lwip.mutex);
+
+		for (nfds = 1, i = 0 ; i < LINUX_LWIP_SOCKET_NUM ; i++)
+		{
+			linux_lwip_socket_t *socket = &g_linux_lwip.socket[i];
+
+			if (socket->fd < 0 || !socket->armed)
+				continue;
+
+			fds[nfds].fd = socket->fd;
+			fds[nfds].events = 0;
+			fds[nfds].revents = 0;
+
+			if (socket->armed & LINUX_LWIP_EVENT_RCV)
+				fds[nfds].events |= POLLIN;
+
+			if (socket->armed & LINUX_LWIP_EVENT_SEND)
+				fds[nfds].events |= POLLOUT;
+
+			index[nfds++] = i;
+		}
+
+		pthread_mutex_unlock(&g_linux_lwip.mutex);
+
+		ret = poll(fds, nfds, -1);
+		if (ret < 0)
+		{
+			if (errno != EINTR)
+				linux_lwip_error("poll(), %s", strerror(errno));
+			continue;
+		}
+
+		if (fds[0].revents & POLLIN)
+		{
+			char buf[64];
+
+			while (read(fds[0].fd, buf, sizeof(buf)) == sizeof(buf))
+				;
+		}
+
+		memset(events, 0, sizeof(events));
+
+		pthread_mutex_lock(&g_linux_lwip.mutex);
+
+		for (i = 1 ; i < nfds ; i++)
+		{
+			linux_lwip_socket_t *socket = &g_linux_lwip.socket[index[i]];
+			short revents = fds[i].revents;
+
+			if (!revents || socket->fd != fds[i].fd)
+				continue;
+
+			if (revents & (POLLIN | POLLHUP | POLLERR))
+			{
+				if (socket->armed & LINUX_LWIP_EVENT_RCV)
+					events[index[i]] |= LINUX_LWIP_EVENT_RCV;
+			}
+
+			if (revents & (POLLOUT | POLLHUP | POLLERR))
+			{
+				if (socket->armed & LINUX_LWIP_EVENT_SEND)
+					events[index[i]] |= LINUX_LWIP_EVENT_SEND;
+			}
+
+			if (revents & POLLERR)
+				events[index[i]] |= LINUX_LWIP_EVENT_RCV | LINUX_LWIP_EVENT_SEND;
+
+			socket->armed &= ~events[index[i]];
+		}
+
+		event_cb = g_linux_lwip.event_cb;
+
+		pthread_mutex_unlock(&g_linux_lwip.mutex);
+
+		if (!event_cb)
+			continue;
+
+		for (i = 0 ; i < LINUX_LWIP_SOCKET_NUM ; i++)
+		{
+			if (events[i] & LINUX_LWIP_EVENT_RCV)
+				event_cb(i, NETCONN_EVT_RCVPLUS);
+
+			if (events[i] & LINUX_LWIP_EVENT_SEND)
+				event_cb(i, NETCONN_EVT_SENDPLUS);
+		}
+	}
+
+	return NULL;
+}
+
+static int linux_lwip_event_thread_create (void)
+{
+	int ret;
+
+	if (g_linux_lwip.thread_run)
+		return 0;
+
+	if (pipe(g_linux_lwip.wakeup) < 0)
+		return -errno;
+
+	fcntl(g_linux_lwip.wakeup[0], F_SETFL, O_NONBLOCK);
+	fcntl(g_linux_lwip.wakeup[1], F_SETFL, O_NONBLOCK);
+
+	ret = pthread_create(&g_linux_lwip.thread, NULL, linux_lwip_event_thread, NULL);
+	if (ret != 0)
+	{
+		close(g_linux_lwip.wakeup[0]);
+		close(g_linux_lwip.wakeup[1]);
+
+		g_linux_lwip.wakeup[0] = g_linux_lwip.wakeup[1] = -1;
+
+		return -ret;
+	}
+
+	g_linux_lwip.thread_run = true;
+
+	return 0;
+}
+
+void nrc_lwip_set_socket_event_cb (void (*cb)(int s, int evt))
+{
+	int ret;
+
+	pthread_mutex_lock(&g_linux_lwip.mutex);
+	g_linux_lwip.event_cb = cb;
+	pthread_mutex_unlock(&g_linux_lwip.mutex);
+
+	if (cb)
+	{
+		ret = linux_lwip_event_thread_create();
+		if (ret < 0)
+			linux_lwip_error("event thread, %s", strerror(-ret));
+	}
+}
+
+/**********************************************************************************************/
+
+static void linux_lwip_init (void)
+{
+	static bool init = false;
+	int i;
+
+	if (!init)
+	{
+		for (i = 0 ; i < LINUX_LWIP_SOCKET_NUM ; i++)
+		{
+			g_linux_lwip.socket[i].fd = -1;
+			g_linux_lwip.socket[i].armed = 0;
+		}
+
+		init = true;
+	}
+}
+
+static int linux_lwip_alloc (int fd, int type)
+{
+	int s = -1;
+	int i;
+
+	pthread_mutex_lock(&g_linux_lwip.mutex);
+
+	linux_lwip_init();
+
+	for (i = 0 ; i < LINUX_LWIP_SOCKET_NUM ; i++)
+	{
+		if (g_linux_lwip.socket[i].fd < 0)
+		{
+			g_linux_lwip.socket[i].fd = fd;
+			g_linux_lwip.socket[i].type = type;
+			g_linux_lwip.socket[i].armed = LINUX_LWIP_EVENT_RCV;
+			g_linux_lwip.socket[i].fin = false;
+
+			s = i;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&g_linux_lwip.mutex);
+
+	if (s < 0)
+	{
+		close(fd);
+		errno = ENFILE;
+	}
+	else
+		linux_lwip_wakeup();
+
+	return s;
+}
+
+static int linux_lwip_fd (int s)
+{
+	int fd = -1;
+
+	if (s >= 0 && s < LINUX_LWIP_SOCKET_NUM)
+	{
+		pthread_mutex_lock(&g_linux_lwip.mutex);
+		linux_lwip_init();
+		fd = g_linux_lwip.socket[s].fd;
+		pthread_mutex_unlock(&g_linux_lwip.mutex);
+	}
+
+	if (fd < 0)
+		errno = EBADF;
+
+	return fd;
+}
+
+/**********************************************************************************************/
+
+int lwip_socket (int domain, int type, int protocol)
+{
+	int fd = socket(domain, type, protocol);
+
+	if (fd < 0)
+		return -1;
+
+	return linux_lwip_alloc(fd, type & ~(SOCK_NONBLOCK | SOCK_CLOEXEC));
+}
+
+int lwip_bind (int s, const struct sockaddr *name, socklen_t namelen)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return bind(fd, name, namelen);
+}
+
+int lwip_listen (int s, int backlog)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return listen(fd, backlog);
+}
+
+int lwip_accept (int s, struct sockaddr *addr, socklen_t *addrlen)
+{
+	int fd = linux_lwip_fd(s);
+	int ret;
+
+	if (fd < 0)
+		return -1;
+
+	ret = accept(fd, addr, addrlen);
+
+	linux_lwip_arm(s, LINUX_LWIP_EVENT_RCV);
+
+	if (ret < 0)
+		return -1;
+
+	return linux_lwip_alloc(ret, SOCK_STREAM);
+}
+
+int lwip_connect (int s, const struct sockaddr *name, socklen_t namelen)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return connect(fd, name, namelen);
+}
+
+int lwip_shutdown (int s, int how)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return shutdown(fd, how);
+}
+
+int lwip_close (int s)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	pthread_mutex_lock(&g_linux_lwip.mutex);
+	g_linux_lwip.socket[s].fd = -1;
+	g_linux_lwip.socket[s].armed = 0;
+	pthread_mutex_unlock(&g_linux_lwip.mutex);
+
+	linux_lwip_wakeup();
+
+	return close(fd);
+}
+
+ssize_t lwip_send (int s, const void *dataptr, size_t size, int flags)
+{
+	int fd = linux_lwip_fd(s);
+	ssize_t ret;
+
+	if (fd < 0)
+		return -1;
+
+	ret = send(fd, dataptr, size, flags | MSG_NOSIGNAL);
+
+	linux_lwip_arm(s, LINUX_LWIP_EVENT_SEND);
+
+	return ret;
+}
+
+ssize_t lwip_sendto (int s, const void *dataptr, size_t size, int flags,
+						const struct sockaddr *to, socklen_t tolen)
+{
+	int fd = linux_lwip_fd(s);
+	ssize_t ret;
+
+	if (fd < 0)
+		return -1;
+
+	ret = sendto(fd, dataptr, size, flags | MSG_NOSIGNAL, to, tolen);
+
+	linux_lwip_arm(s, LINUX_LWIP_EVENT_SEND);
+
+	return ret;
+}
+
+ssize_t lwip_recv (int s, void *mem, size_t len, int flags)
+{
+	linux_lwip_socket_t *socket = &g_linux_lwip.socket[s];
+	int fd = linux_lwip_fd(s);
+	ssize_t ret;
+
+	if (fd < 0)
+		return -1;
+
+	if (socket->type != SOCK_STREAM)
+		ret = recv(fd, mem, len, flags);
+	else if (socket->fin)
+	{
+		errno = ENOTCONN;
+		ret = -1;
+	}
+	else
+	{
+		char c;
+
+		/* A zero length recv() still reports the end of stream. */
+		if (len > 0)
+			ret = recv(fd, mem, len, flags);
+		else
+		{
+			ret = recv(fd, &c, 1, flags | MSG_PEEK);
+			if (ret > 0)
+				ret = 0;
+			else if (ret == 0)
+				socket->fin = true;
+		}
+
+		if (ret == 0 && len > 0)
+			socket->fin = true;
+	}
+
+	linux_lwip_arm(s, LINUX_LWIP_EVENT_RCV);
+
+	return ret;
+}
+
+ssize_t lwip_recvfrom (int s, void *mem, size_t len, int flags,
+						struct sockaddr *from, socklen_t *fromlen)
+{
+	int fd = linux_lwip_fd(s);
+	ssize_t ret;
+
+	if (fd < 0)
+		return -1;
+
+	ret = recvfrom(fd, mem, len, flags, from, fromlen);
+
+	linux_lwip_arm(s, LINUX_LWIP_EVENT_RCV);
+
+	return ret;
+}
+
+int lwip_select (int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptset,
+					struct timeval *timeout)
+{
+	fd_set *sets[3] = { readset, writeset, exceptset };
+	fd_set host_sets[3];
+	int host_nfds = 0;
+	int fd[LINUX_LWIP_SOCKET_NUM];
+	int ret;
+	int s;
+	int i;
+
+	if (maxfdp1 > LINUX_LWIP_SOCKET_NUM)
+		maxfdp1 = LINUX_LWIP_SOCKET_NUM;
+
+	for (i = 0 ; i < 3 ; i++)
+		FD_ZERO(&host_sets[i]);
+
+	for (s = 0 ; s < maxfdp1 ; s++)
+	{
+		fd[s] = -1;
+
+		for (i = 0 ; i < 3 ; i++)
+		{
+			if (!sets[i] || !FD_ISSET(s, sets[i]))
+				continue;
+
+			if (fd[s] < 0)
+			{
+				fd[s] = linux_lwip_fd(s);
+				if (fd[s] < 0)
+					return -1;
+			}
+
+			FD_SET(fd[s], &host_sets[i]);
+
+			if (fd[s] >= host_nfds)
+				host_nfds = fd[s] + 1;
+		}
+	}
+
+	ret = select(host_nfds,
+				readset ? &host_sets[0] : NULL,
+				writeset ? &host_sets[1] : NULL,
+				exceptset ? &host_sets[2] : NULL,
+				timeout);
+
+	if (ret < 0)
+		return -1;
+
+	for (s = 0 ; s < maxfdp1 ; s++)
+	{
+		if (fd[s] < 0)
+			continue;
+
+		if (readset && FD_ISSET(s, readset) && !FD_ISSET(fd[s], &host_sets[0]))
+		{
+			FD_CLR(s, readset);
+			linux_lwip_arm(s, LINUX_LWIP_EVENT_RCV);
+		}
+
+		if (writeset && FD_ISSET(s, writeset) && !FD_ISSET(fd[s], &host_sets[1]))
+		{
+			FD_CLR(s, writeset);
+			linux_lwip_arm(s, LINUX_LWIP_EVENT_SEND);
+		}
+
+		if (exceptset && FD_ISSET(s, exceptset) && !FD_ISSET(fd[s], &host_sets[2]))
+			FD_CLR(s, exceptset);
+	}
+
+	return ret;
+}
+
+int lwip_fcntl (int s, int cmd, int val)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return fcntl(fd, cmd, val);
+}
+
+int lwip_ioctl (int s, long cmd, void *argp)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return ioctl(fd, cmd, argp);
+}
+
+int lwip_getsockopt (int s, int level, int optname, void *optval, socklen_t *optlen)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return getsockopt(fd, level, optname, optval, optlen);
+}
+
+int lwip_setsockopt (int s, int level, int optname, const void *optval, socklen_t optlen)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return setsockopt(fd, level, optname, optval, optlen);
+}
+
+int lwip_getpeername (int s, struct sockaddr *name, socklen_t *namelen)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return getpeername(fd, name, namelen);
+}
+
+int lwip_getsockname (int s, struct sockaddr *name, socklen_t *namelen)
+{
+	int fd = linux_lwip_fd(s);
+
+	if (fd < 0)
+		return -1;
+
+	return getsockname(fd, name, namelen);
+}
+
+/**********************************************************************************************/
+
+int ip4addr_aton (const char *cp, ip4_addr_t *addr)
+{
+	struct in_addr in;
+
+	if (!inet_aton(cp, &in))
+		return 0;
+
+	if (addr)
+		ip4_addr_set_u32(addr, in.s_addr);
+
+	return 1;
+}
+
+char *ip4addr_ntoa_r (const ip4_addr_t *addr, char *buf, int buflen)
+{
+	struct in_addr in;
+
+	in.s_addr = ip4_addr_get_u32(addr);
+
+	return (char *)inet_ntop(AF_INET, &in, buf, buflen);
+}
+
+char *ip4addr_ntoa (const ip4_addr_t *addr)
+{
+	static char str[INET_ADDRSTRLEN];
+
+	return ip4addr_ntoa_r(addr, str, sizeof(str));
+}
@@ -0,0 +1,530 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#define _GNU_SOURCE /* pthread_setname_np */
+
+#include <time.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include "nrc_sdk.h"
+#include "drv_rtc.h"
+
+/*
+ * FreeRTOS kernel API on top of pthreads.
+ *
+ * Every task is a detached pthread with its own notification counter. Priorities and stack
+ * sizes are ignored, the host scheduler decides. Threads not created by xTaskCreate() get a
+ * control block on first use so that they can also wait for notifications.
+ */
+
+#define linux_os_error(fmt, ...)	fprintf(stderr, "%s::%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__)
+
+/**********************************************************************************************/
+
+static uint64_t linux_os_now_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void linux_os_abstime (TickType_t ticks, struct timespec *ts)
+{
+	uint64_t msec = (uint64_t)ticks * portTICK_PERIOD_MS;
+
+	clock_gettime(CLOCK_MONOTONIC, ts);
+
+	ts->tv_sec += msec / 1000;
+	ts->tv_nsec += (msec % 1000) * 1000000;
+
+	if (ts->tv_nsec >= 1000000000)
+	{
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+static void linux_os_cond_init (pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+static void linux_os_unlock (void *mutex)
+{
+	pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+/*
+ * Wait on 'cond' until 'done' returns true or the ticks elapse.
+ * The mutex is released if the waiting thread is canceled by vTaskDelete().
+ */
+static bool linux_os_cond_wait (pthread_cond_t *cond, pthread_mutex_t *mutex, TickType_t ticks,
+								bool (*done)(void *), void *arg)
+{
+	struct timespec ts;
+	int ret = 0;
+
+	if (ticks != portMAX_DELAY)
+		linux_os_abstime(ticks, &ts);
+
+	pthread_cleanup_push(linux_os_unlock, mutex);
+
+	while (!done(arg) && ret != ETIMEDOUT)
+	{
+		if (ticks == 0)
+			break;
+		else if (ticks == portMAX_DELAY)
+			ret = pthread_cond_wait(cond, mutex);
+		else
+			ret = pthread_cond_timedwait(cond, mutex, &ts);
+	}
+
+	pthread_cleanup_pop(0);
+
+	return done(arg);
+}
+
+/**********************************************************************************************/
+
+struct tskTaskControlBlock
+{
+	pthread_t thread;
+	char name[16];
+
+	TaskFunction_t func;
+	void *param;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint32_t notify;
+};
+
+static __thread struct tskTaskControlBlock *g_linux_os_task = NULL;
+
+static struct tskTaskControlBlock *linux_os_task_alloc (const char *name)
+{
+	struct tskTaskControlBlock *task;
+
+	task = calloc(1, sizeof(struct tskTaskControlBlock));
+	if (!task)
+		return NULL;
+
+	snprintf(task->name, sizeof(task->name), "%s", name);
+
+	pthread_mutex_init(&task->mutex, NULL);
+	linux_os_cond_init(&task->cond);
+
+	return task;
+}
+
+static void linux_os_task_free (struct tskTaskControlBlock *task)
+{
+	pthread_cond_destroy(&task->cond);
+	pthread_mutex_destroy(&task->mutex);
+
+	free(task);
+}
+
+static void *linux_os_task_entry (void *arg)
+{
+	struct tskTaskControlBlock *task = (struct tskTaskControlBlock *)arg;
+
+	g_linux_os_task = task;
+
+	pthread_setname_np(pthread_self(), task->name);
+
+	task->func(task->param);
+
+	/* A FreeRTOS task must not return. */
+	vTaskDelete(NULL);
+
+	return NULL;
+}
+
+BaseType_t xTaskCreate (TaskFunction_t func, const char *name, uint32_t stack_depth,
+						void *param, UBaseType_t priority, TaskHandle_t *handle)
+{
+	struct tskTaskControlBlock *task;
+	int ret;
+
+	task = linux_os_task_alloc(name);
+	if (!task)
+		return pdFAIL;
+
+	task->func = func;
+	task->param = param;
+
+	/* The handle is valid before the task runs, as with a higher priority creator. */
+	if (handle)
+		*handle = task;
+
+	ret = pthread_create(&task->thread, NULL, linux_os_task_entry, task);
+	if (ret != 0)
+	{
+		linux_os_error("pthread_create(), %s", strerror(ret));
+
+		if (handle)
+			*handle = NULL;
+
+		linux_os_task_free(task);
+		return pdFAIL;
+	}
+
+	return pdPASS;
+}
+
+void vTaskDelete (TaskHandle_t task)
+{
+	if (!task || task == g_linux_os_task)
+	{
+		task = g_linux_os_task;
+		g_linux_os_task = NULL;
+
+		if (task)
+			linux_os_task_free(task);
+
+		pthread_detach(pthread_self());
+		pthread_exit(NULL);
+	}
+
+	pthread_cancel(task->thread);
+	pthread_join(task->thread, NULL);
+
+	linux_os_task_free(task);
+}
+
+void vTaskDelay (TickType_t ticks)
+{
+	struct timespec ts;
+
+	linux_os_abstime(ticks, &ts);
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle (void)
+{
+	if (!g_linux_os_task)
+	{
+		g_linux_os_task = linux_os_task_alloc("thread");
+		if (g_linux_os_task)
+			g_linux_os_task->thread = pthread_self();
+	}
+
+	return g_linux_os_task;
+}
+
+TickType_t xTaskGetTickCount (void)
+{
+	static uint64_t start = 0;
+
+	if (!start)
+		start = linux_os_now_us();
+
+	return (TickType_t)((linux_os_now_us() - start) / (1000 * portTICK_PERIOD_MS));
+}
+
+BaseType_t xTaskNotifyGive (TaskHandle_t task)
+{
+	if (!task)
+		return pdFAIL;
+
+	pthread_mutex_lock(&task->mutex);
+	task->notify++;
+	pthread_cond_signal(&task->cond);
+	pthread_mutex_unlock(&task->mutex);
+
+	return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR (TaskHandle_t task, BaseType_t *woken)
+{
+	xTaskNotifyGive(task);
+
+	if (woken)
+		*woken = pdFALSE;
+}
+
+static bool linux_os_task_notified (void *arg)
+{
+	return ((struct tskTaskControlBlock *)arg)->notify > 0;
+}
+
+uint32_t ulTaskNotifyTake (BaseType_t clear, TickType_t ticks)
+{
+	struct tskTaskControlBlock *task = xTaskGetCurrentTaskHandle();
+	uint32_t value;
+
+	if (!task)
+		return 0;
+
+	pthread_mutex_lock(&task->mutex);
+
+	linux_os_cond_wait(&task->cond, &task->mutex, ticks, linux_os_task_notified, task);
+
+	value = task->notify;
+
+	if (value > 0)
+		task->notify = clear ? 0 : value - 1;
+
+	pthread_mutex_unlock(&task->mutex);
+
+	return value;
+}
+
+/**********************************************************************************************/
+
+struct QueueDefinition
+{
+	pthread_mutex_t mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex (void)
+{
+	struct QueueDefinition *sem;
+
+	sem = calloc(1, sizeof(struct QueueDefinition));
+	if (sem)
+		pthread_mutex_init(&sem->mutex, NULL);
+
+	return sem;
+}
+
+void vSemaphoreDelete (SemaphoreHandle_t sem)
+{
+	if (sem)
+	{
+		pthread_mutex_destroy(&sem->mutex);
+		free(sem);
+	}
+}
+
+BaseType_t xSemaphoreTake (SemaphoreHandle_t sem, TickType_t ticks)
+{
+	struct timespec ts;
+	uint64_t msec;
+
+	if (ticks == portMAX_DELAY)
+		return pthread_mutex_lock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+	else if (ticks == 0)
+		return pthread_mutex_trylock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+
+	/* pthread_mutex_timedlock() only takes CLOCK_REALTIME */
+	msec = (uint64_t)ticks * portTICK_PERIOD_MS;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	ts.tv_sec += msec / 1000;
+	ts.tv_nsec += (msec % 1000) * 1000000;
+
+	if (ts.tv_nsec >= 1000000000)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	return pthread_mutex_timedlock(&sem->mutex, &ts) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive (SemaphoreHandle_t sem)
+{
+	return pthread_mutex_unlock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+/**********************************************************************************************/
+
+struct EventGroupDef_t
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	EventBits_t bits;
+
+	/* used by linux_os_event_group_done() */
+	EventBits_t wait_bits;
+	bool wait_all;
+};
+
+EventGroupHandle_t xEventGroupCreate (void)
+{
+	struct EventGroupDef_t *group;
+
+	group = calloc(1, sizeof(struct EventGroupDef_t));
+	if (group)
+	{
+		pthread_mutex_init(&group->mutex, NULL);
+		linux_os_cond_init(&group->cond);
+	}
+
+	return group;
+}
+
+void vEventGroupDelete (EventGroupHandle_t group)
+{
+	if (group)
+	{
+		pthread_cond_destroy(&group->cond);
+		pthread_mutex_destroy(&group->mutex);
+		free(group);
+	}
+}
+
+EventBits_t xEventGroupGetBits (EventGroupHandle_t group)
+{
+	EventBits_t bits;
+
+	pthread_mutex_lock(&group->mutex);
+	bits = group->bits;
+	pthread_mutex_unlock(&group->mutex);
+
+	return bits;
+}
+
+EventBits_t xEventGroupSetBits (EventGroupHandle_t group, EventBits_t bits)
+{
+	EventBits_t ret;
+
+	pthread_mutex_lock(&group->mutex);
+	group->bits |= bits;
+	ret = group->bits;
+	pthread_cond_broadcast(&group->cond);
+	pthread_mutex_unlock(&group->mutex);
+
+	return ret;
+}
+
+EventBits_t xEventGroupClearBits (EventGroupHandle_t group, EventBits_t bits)
+{
+	EventBits_t ret;
+
+	pthread_mutex_lock(&group->mutex);
+	ret = group->bits;
+	group->bits &= ~bits;
+	pthread_mutex_unlock(&group->mutex);
+
+	return ret;
+}
+
+static bool linux_os_event_group_done (void *arg)
+{
+	struct EventGroupDef_t *group = (struct EventGroupDef_t *)arg;
+	EventBits_t bits = group->bits & group->wait_bits;
+
+	return group->wait_all ? (bits == group->wait_bits) : (bits != 0);
+}
+
+EventBits_t xEventGroupWaitBits (EventGroupHandle_t group, EventBits_t bits,
+								BaseType_t clear, BaseType_t wait_all, TickType_t ticks)
+{
+	EventBits_t ret;
+
+	pthread_mutex_lock(&group->mutex);
+
+	/* Only one waiter per event group is expected. */
+	group->wait_bits = bits;
+	group->wait_all = !!wait_all;
+
+	if (linux_os_cond_wait(&group->cond, &group->mutex, ticks, linux_os_event_group_done, group))
+	{
+		ret = group->bits;
+
+		if (clear)
+			group->bits &= ~bits;
+	}
+	else
+		ret = group->bits;
+
+	pthread_mutex_unlock(&group->mutex);
+
+	return ret;
+}
+
+/**********************************************************************************************/
+
+void *pvPortMalloc (size_t size)
+{
+	return malloc(size);
+}
+
+void vPortFree (void *ptr)
+{
+	free(ptr);
+}
+
+/**********************************************************************************************/
+
+uint64_t drv_rtc_get_us (void)
+{
+	return linux_os_now_us();
+}
+
+int hal_uart_printf (const char *fmt, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, fmt);
+	ret = vprintf(fmt, ap);
+	va_end(ap);
+
+	fflush(stdout);
+
+	return ret;
+}
+
+char *strupr (char *str)
+{
+	char *p;
+
+	for (p = str ; *p ; p++)
+		*p = toupper((unsigned char)*p);
+
+	return str;
+}
+
+char *strlwr (char *str)
+{
+	char *p;
+
+	for (p = str ; *p ; p++)
+		*p = tolower((unsigned char)*p);
+
+	return str;
+}
+
+void util_fota_reboot_firmware (void)
+{
+	/* ATZ, there is nothing to reboot into. */
+	exit(0);
+}
@@ -0,0 +1,162 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <getopt.h>
+#include <signal.h>
+
+#include "atcmd.h"
+#include "linux-atcmd.h"
+
+/**********************************************************************************************/
+
+static void linux_atcmd_help (char *cmd)
+{
+	printf("Usage:\n");
+	printf("  $ %s [-D <path>] [-p]\n", cmd);
+	printf("  $ %s -b <count> <script>...\n", cmd);
+	printf("\n");
+	printf("  -D, --device #        Specify the UNIX socket for the host. (default: %s)\n", LINUX_ATCMD_HIF_PATH);
+	printf("  -p, --passthrough     Enable the UART passthrough mode of AT+SSEND.\n");
+	printf("  -b, --bench #         Replay the AT commands of the scripts # times through the parser and quit.\n");
+	printf("  -h, --help            Print this message and quit.\n");
+}
+
+static int g_linux_atcmd_bench_count = 0;
+
+static int linux_atcmd_option (int argc, char *argv[])
+{
+	struct option opt_info[] =
+	{
+		{ "device",				required_argument,		0,		'D' },
+		{ "passthrough",		no_argument,			0,		'p' },
+		{ "bench",				required_argument,		0,		'b' },
+		{ "help",				no_argument,			0,		'h' },
+
+		{ 0, 0, 0, 0 }
+	};
+	int opt_idx;
+	int ret;
+
+	while (1)
+	{
+		ret = getopt_long(argc, argv, "D:pb:h", opt_info, &opt_idx);
+
+		switch (ret)
+		{
+			case -1: /* end */
+				if (g_linux_atcmd_bench_count > 0 && optind >= argc)
+				{
+					printf("no script\n");
+					return -1;
+				}
+				return 0;
+
+			case 'D':
+				if (linux_hif_set_path(optarg) != 0)
+				{
+					printf("invalid path\n");
+					return -1;
+				}
+				break;
+
+			case 'p':
+			{
+				extern bool g_atcmd_uart_passthrough_support;
+
+				g_atcmd_uart_passthrough_support = true;
+				break;
+			}
+
+			case 'b':
+				g_linux_atcmd_bench_count = atoi(optarg);
+				if (g_linux_atcmd_bench_count <= 0)
+				{
+					printf("invalid count\n");
+					return -1;
+				}
+				break;
+
+			case 'h':
+				linux_atcmd_help(argv[0]);
+				return 1;
+
+			default:
+				return -1;
+		}
+	}
+}
+
+/**********************************************************************************************/
+
+int main (int argc, char *argv[])
+{
+	_hif_info_t info;
+	sigset_t sigset;
+	int sig;
+	int ret;
+
+	ret = linux_atcmd_option(argc, argv);
+	if (ret != 0)
+		return ret < 0 ? 1 : 0;
+
+	/* Writes to a closed host socket are handled by send() */
+	signal(SIGPIPE, SIG_IGN);
+
+	sigemptyset(&sigset);
+	sigaddset(&sigset, SIGINT);
+	sigaddset(&sigset, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+	_atcmd_info("BUILD: Linux,%s (%s, %s)", "IPv4", __TIME__, __DATE__);
+	_atcmd_info("VERSION: %d.%d.%d (SDK-%d.%d.%d)",
+					ATCMD_VER_MAJOR, ATCMD_VER_MINOR, ATCMD_VER_REVISION,
+					SDK_VER_MAJOR, SDK_VER_MINOR, SDK_VER_REVISION);
+
+	memset(&info, 0, sizeof(info));
+
+	info.type = _HIF_TYPE_UART;
+	info.uart.channel = 0;
+	info.uart.baudrate = 0;
+	info.uart.data_bits = UART_DB8;
+	info.uart.stop_bits = UART_SB1;
+	info.uart.parity = UART_PB_NONE;
+	info.uart.hfc = UART_HFC_DISABLE;
+
+	if (atcmd_enable(&info) != 0)
+	{
+		_atcmd_error("atcmd_enable()");
+		return 1;
+	}
+
+	if (g_linux_atcmd_bench_count > 0)
+		ret = linux_atcmd_bench(argv + optind, argc - optind, g_linux_atcmd_bench_count);
+	else
+		sigwait(&sigset, &sig);
+
+	atcmd_disable();
+
+	return ret < 0 ? 1 : 0;
+}
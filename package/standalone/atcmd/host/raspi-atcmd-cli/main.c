@@ -39,6 +39,8 @@
 #define DEFAULT_UART_DEVICE		"/dev/ttyAMA0"
 #define DEFAULT_UART_BAUDRATE	115200
 
+#define DEFAULT_UNIX_PATH		"/tmp/linux-atcmd.sock"
+
 /**********************************************************************************************/
 
 static int raspi_get_time (double *time) /* usec */
@@ -73,6 +75,7 @@ static void raspi_cli_help (char *cmd)
 	printf("  $ %s -S [-D <device>] [-E <trigger>] [-c <clock>] [-s <script> [-n]]\n", cmd);
 	printf("  $ %s -U [-D <device>] [-b <baudrate>] [-s <script> [-n]]\n", cmd);
 	printf("  $ %s -U -f [-D <device>] [-b <baudrate>] [-s <script> [-n]]\n", cmd);
+	printf("  $ %s -L [-D <path>] [-s <script> [-n]]\n", cmd);
 	printf("\n");
 
 	printf("UART/SPI:\n");
@@ -93,6 +96,10 @@ static void raspi_cli_help (char *cmd)
 	printf("  -b, --baudrate #      Specify the baudrate for the UART. (default: %d bps)\n", DEFAULT_UART_BAUDRATE);
 	printf("\n");
 
+	printf("Linux:\n");
+	printf("  -L  --linux           Use the UNIX socket to communicate with linux-atcmd. (default: %s)\n", DEFAULT_UNIX_PATH);
+	printf("\n");
+
 	printf("Miscellaneous:\n");
 	printf("  -v, --version         Print version information and quit.\n");
 	printf("  -h, --help            Print this message and quit.\n");
@@ -138,6 +145,9 @@ static int raspi_cli_option (int argc, char *argv[], raspi_cli_opt_t *opt)
 		{ "clock",				required_argument,		0,		'c' },
 		{ "eirq",				required_argument,		0,		'E' },
 
+		/* Linux */
+		{ "linux",				no_argument,			0,		'L' },
+
 		{ "version",			no_argument,			0,		'v' },
 		{ "help",				no_argument,			0,		'h' },
 
@@ -162,7 +172,7 @@ static int raspi_cli_option (int argc, char *argv[], raspi_cli_opt_t *opt)
 
 	while (1)
 	{
-		ret = getopt_long(argc, argv, "D:s:nUb:fSc:E:vh", opt_info, &opt_idx);
+		ret = getopt_long(argc, argv, "D:s:nUb:fSc:E:Lvh", opt_info, &opt_idx);
 
 		switch (ret)
 		{
@@ -184,6 +194,11 @@ static int raspi_cli_option (int argc, char *argv[], raspi_cli_opt_t *opt)
 							opt->hif.speed = DEFAULT_SPI_CLOCK;
 						break;
 
+					case RASPI_HIF_UNIX:
+						if (!opt->hif.device)
+							opt->hif.device = DEFAULT_UNIX_PATH;
+						break;
+
 					default:
 						return -1;
 				}
@@ -264,6 +279,11 @@ static int raspi_cli_option (int argc, char *argv[], raspi_cli_opt_t *opt)
 				break;
 			}
 
+			/* Linux */
+			case 'L':
+				opt->hif.type = RASPI_HIF_UNIX;
+				break;
+
 			/* Miscellaneous */
 			case 'v':
 				raspi_cli_version();
@@ -470,6 +470,7 @@ void nrc_atcmd_recv (char *buf, int len)
 		ATCMD_MSG_WEVENT,
 		ATCMD_MSG_SEVENT,
 		ATCMD_MSG_DATA,
+		ATCMD_MSG_BATCH,
 
 		ATCMD_MSG_NONE = 255,
 	};
@@ -506,10 +507,24 @@ void nrc_atcmd_recv (char *buf, int len)
 		.cnt = 0,
 		.buf = { 0, }
 	};
+
+	/* +RXDB:<count>,<length> followed by <count> +RXD records */
+	static struct
+	{
+		int cnt;
+		int len;
+	} batch =
+	{
+		.cnt = 0,
+		.len = 0
+	};
 	int i;
 
 	for (i = 0 ; i < len ; i++)
 	{
+		if (batch.cnt > 0)
+			batch.len--;
+
 		if (data.rxd.len > 0)
 		{
 			data.buf[data.cnt] = buf[i];
@@ -528,6 +543,18 @@ void nrc_atcmd_recv (char *buf, int len)
 
 				nrc_atcmd_init_rxd(&data.rxd);
 				data.cnt = 0;
+
+				if (batch.cnt > 0)
+				{
+					if (--batch.cnt == 0 && batch.len != 0)
+						log_error("rxd batch: length mismatch (%d)\n", batch.len);
+					else if (batch.cnt > 0 && batch.len <= 0)
+						log_error("rxd batch: %d records left\n", batch.cnt);
+					else
+						continue;
+
+					batch.cnt = batch.len = 0;
+				}
 			}
 
 			continue;
@@ -602,6 +629,12 @@ void nrc_atcmd_recv (char *buf, int len)
 						msg.type = ATCMD_MSG_DATA;
 					continue;
 				}
+				else if (memcmp(msg.buf, "+RXDB:", msg.cnt) == 0)
+				{
+					if (msg.cnt == 6)
+						msg.type = ATCMD_MSG_BATCH;
+					continue;
+				}
 				else if (memcmp(msg.buf, "+BEVENT:", msg.cnt) == 0)
 				{
 					if (msg.cnt == 8)
@@ -654,6 +687,18 @@ void nrc_atcmd_recv (char *buf, int len)
 						atcmd_log_recv("!!! RXD FAIL !!!\n");
 					break;
 
+				case ATCMD_MSG_BATCH:
+					if (batch.cnt > 0)
+						log_error("rxd batch: %d records lost\n", batch.cnt);
+
+					if (sscanf(msg.buf + 6, "%d,%d", &batch.cnt, &batch.len) != 2 ||
+							batch.cnt <= 0 || batch.len <= 0)
+					{
+						atcmd_log_recv("!!! RXDB FAIL !!!\n");
+						batch.cnt = batch.len = 0;
+					}
+					break;
+
 				default:
 					log_error("invalid message type (%d)\n", msg.type);
 			}
@@ -48,13 +48,18 @@ static hspi_info_t g_hspi_info =
 #define HSPI_TXQ_SLOT_SIZE()				g_hspi_info.queue.slot[HSPI_TXQ].size
 #define HSPI_TXQ_SLOT_COUNT()				g_hspi_info.queue.status.txq.slot_cnt
 #define HSPI_TXQ_SLOT_COUNT_UPDATE(c)		g_hspi_info.queue.status.txq.slot_cnt = (c)
+#define HSPI_TXQ_SLOT_SEQ()					g_hspi_info.queue.slot[HSPI_TXQ].seq
 
 #define HSPI_RXQ_SLOT_NUM()					g_hspi_info.queue.slot[HSPI_RXQ].num
 #define HSPI_RXQ_SLOT_SIZE()				g_hspi_info.queue.slot[HSPI_RXQ].size
 #define HSPI_RXQ_SLOT_COUNT()				g_hspi_info.queue.status.rxq.slot_cnt
 #define HSPI_RXQ_SLOT_COUNT_UPDATE(c)		g_hspi_info.queue.status.rxq.slot_cnt = (c)
+#define HSPI_RXQ_SLOT_SEQ()					g_hspi_info.queue.slot[HSPI_RXQ].seq
+
+#define HSPI_BATCH_ACTIVE()					(g_hspi_info.ops.spi_transfer_batch != NULL)
 
 #define SPI_TRANSFER(tx, rx, len)			g_hspi_info.ops.spi_transfer(tx, rx, len)
+#define SPI_TRANSFER_BATCH(xfers, n)		g_hspi_info.ops.spi_transfer_batch(xfers, n)
 
 static int HSPI_ACTIVE (void)
 {
@@ -162,6 +167,12 @@ static void hspi_transfer_setup (hspi_xfer_t *xfer, void *tx_buf, void *rx_buf,
 	xfer->rx_buf = (char *)rx_buf;
 }
 
+static void hspi_cmd_setup (hspi_cmd_t *cmd, hspi_opcode_t *opcode)
+{
+	cmd->opcode.val = _CPU_TO_BE32(opcode->val);
+	cmd->crc = (hspi_crc7((char *)&cmd->opcode, sizeof(hspi_opcode_t)) << 1) | 0x01;
+}
+
 static int hspi_transfer (hspi_opcode_t *opcode, char *buf, int len)
 {
 	const int retry_max = HSPI_XFER_RETRY_MAX;
@@ -178,8 +189,7 @@ static int hspi_transfer (hspi_opcode_t *opcode, char *buf, int len)
 
 /*	hspi_opcode_print(opcode); */
 
-	cmd.opcode.val = _CPU_TO_BE32(opcode->val);
-	cmd.crc = (hspi_crc7((char *)&cmd.opcode, sizeof(hspi_opcode_t)) << 1) | 0x01;
+	hspi_cmd_setup(&cmd, opcode);
 
 	hspi_transfer_setup(p_xfers++, &cmd, &resp, 8);
 
@@ -315,6 +325,24 @@ static int hspi_regs_read_eirq (hspi_eirq_t *eirq)
 	return hspi_reg_read(HSPI_REG_EIRQ, (char *)eirq, sizeof(hspi_eirq_t));
 }
 
+static void hspi_regs_convert_status (hspi_status_t *status_tmp, hspi_status_t *status)
+{
+	status->eirq.txq = status_tmp->eirq.txq;
+	status->eirq.rxq = status_tmp->eirq.rxq;
+	status->eirq.ready = status_tmp->eirq.ready;
+	status->eirq.sleep = status_tmp->eirq.sleep;
+
+	status->txq.error = status_tmp->txq.error;
+	status->txq.slot_cnt = status_tmp->txq.slot_cnt;
+	status->txq.slot_size = _BE16_TO_CPU(status_tmp->txq.slot_size);
+	status->txq.total_slot_size = _BE16_TO_CPU(status_tmp->txq.total_slot_size);
+
+	status->rxq.error = status_tmp->rxq.error;
+	status->rxq.slot_cnt = status_tmp->rxq.slot_cnt;
+	status->rxq.slot_size = _BE16_TO_CPU(status_tmp->rxq.slot_size);
+	status->rxq.total_slot_size = _BE16_TO_CPU(status_tmp->rxq.total_slot_size);
+}
+
 static int hspi_regs_read_status (hspi_status_t *status)
 {
 	hspi_status_t status_tmp;
@@ -322,22 +350,7 @@ static int hspi_regs_read_status (hspi_status_t *status)
 
 	err = hspi_reg_read(HSPI_REG_STATUS, (char *)&status_tmp, sizeof(hspi_status_t));
 	if (!err)
-	{
-		status->eirq.txq = status_tmp.eirq.txq;
-		status->eirq.rxq = status_tmp.eirq.rxq;
-		status->eirq.ready = status_tmp.eirq.ready;
-		status->eirq.sleep = status_tmp.eirq.sleep;
-
-		status->txq.error = status_tmp.txq.error;
-		status->txq.slot_cnt = status_tmp.txq.slot_cnt;
-		status->txq.slot_size = _BE16_TO_CPU(status_tmp.txq.slot_size);
-		status->txq.total_slot_size = _BE16_TO_CPU(status_tmp.txq.total_slot_size);
-
-		status->rxq.error = status_tmp.rxq.error;
-		status->rxq.slot_cnt = status_tmp.rxq.slot_cnt;
-		status->rxq.slot_size = _BE16_TO_CPU(status_tmp.rxq.slot_size);
-		status->rxq.total_slot_size = _BE16_TO_CPU(status_tmp.rxq.total_slot_size);
-	}
+		hspi_regs_convert_status(&status_tmp, status);
 
 	return err;
 }
@@ -508,11 +521,30 @@ static void hspi_status_init (int que)
 
 	if (que == HSPI_RXQ || que == HSPI_QUE_ALL)
 		memset(&status->rxq, 0, sizeof(status->rxq));
+
+	g_hspi_info.queue.status_batch_valid = false;
 }
 
-static int hspi_status_update (void)
+static void hspi_status_apply (hspi_status_t *new)
 {
 	hspi_status_t *old = HSPI_QUEUE_STATUS();
+
+/*	hspi_regs_print_status(old); */
+/*	hspi_regs_print_status(new); */
+
+	if (new->txq.slot_cnt > 0 && new->txq.slot_cnt <= HSPI_TXQ_SLOT_NUM() &&
+			(new->txq.slot_size << 2) == HSPI_TXQ_SLOT_SIZE() &&
+			(new->txq.slot_cnt * new->txq.slot_size) == new->txq.total_slot_size)
+		memcpy(&old->txq, &new->txq, sizeof(old->txq));
+
+	if (new->rxq.slot_cnt > 0 && new->rxq.slot_cnt <= HSPI_RXQ_SLOT_NUM() &&
+			(new->rxq.slot_size << 2) == HSPI_RXQ_SLOT_SIZE() &&
+			(new->rxq.slot_cnt * new->rxq.slot_size) == new->rxq.total_slot_size)
+		memcpy(&old->rxq, &new->rxq, sizeof(old->rxq));
+}
+
+static int hspi_status_update (void)
+{
 	hspi_status_t new;
 	int ret;
 
@@ -520,32 +552,308 @@ static int hspi_status_update (void)
 	if (ret != 0)
 		return ret;
 
-/*	hspi_regs_print_status(old); */
-/*	hspi_regs_print_status(&new); */
+	hspi_status_apply(&new);
+
+	return 0;
+}
+
+static void hspi_status_update_batch (void)
+{
+	if (g_hspi_info.queue.status_batch_valid)
+	{
+		g_hspi_info.queue.status_batch_valid = false;
 
-	if (new.txq.slot_cnt > 0 && new.txq.slot_cnt <= HSPI_TXQ_SLOT_NUM() &&
-			(new.txq.slot_size << 2) == HSPI_TXQ_SLOT_SIZE() &&
-			(new.txq.slot_cnt * new.txq.slot_size) == new.txq.total_slot_size)
-		memcpy(&old->txq, &new.txq, sizeof(old->txq));
+		hspi_status_apply(&g_hspi_info.queue.status_batch);
+	}
+}
+
+/**********************************************************************************************/
+
+typedef struct
+{
+	int n_xfers;
+	hspi_xfer_t xfers[HSPI_BATCH_XFER_MAX];
 
-	if (new.rxq.slot_cnt > 0 && new.rxq.slot_cnt <= HSPI_RXQ_SLOT_NUM() &&
-			(new.rxq.slot_size << 2) == HSPI_RXQ_SLOT_SIZE() &&
-			(new.rxq.slot_cnt * new.rxq.slot_size) == new.rxq.total_slot_size)
-		memcpy(&old->rxq, &new.rxq, sizeof(old->rxq));
+	/* status read appended to the batch */
+	hspi_cmd_t status_cmd;
+	hspi_resp_t status_resp;
+	hspi_status_t status;
+	uint32_t status_crc;
+} hspi_batch_t;
+
+static int hspi_batch_slot_max (int slot_size)
+{
+	/* cmd + slot + crc per slot, cmd + status + crc at the end */
+	int slot_max = (HSPI_BATCH_LEN_MAX - (8 + sizeof(hspi_status_t) + 4)) / (8 + slot_size + 4);
+
+	if (slot_max > HSPI_BATCH_SLOT_MAX)
+		slot_max = HSPI_BATCH_SLOT_MAX;
+	else if (slot_max < 1)
+		slot_max = 1;
+
+	return slot_max;
+}
+
+static void hspi_batch_init (hspi_batch_t *batch)
+{
+	batch->n_xfers = 0;
+}
+
+static void hspi_batch_add (hspi_batch_t *batch, void *tx_buf, void *rx_buf, int len)
+{
+	hspi_transfer_setup(&batch->xfers[batch->n_xfers++], tx_buf, rx_buf, len);
+}
+
+static void hspi_batch_add_status (hspi_batch_t *batch)
+{
+	hspi_opcode_t opcode;
+
+	opcode.val = HSPI_OPCODE_READ_REG(HSPI_REG_STATUS, sizeof(hspi_status_t));
+
+	hspi_cmd_setup(&batch->status_cmd, &opcode);
+
+	batch->status_resp.ack = 0;
+
+	hspi_batch_add(batch, &batch->status_cmd, &batch->status_resp, sizeof(hspi_cmd_t));
+	hspi_batch_add(batch, NULL, &batch->status, sizeof(hspi_status_t));
+	hspi_batch_add(batch, NULL, &batch->status_crc, 4);
+}
+
+static int hspi_batch_transfer (hspi_batch_t *batch)
+{
+	int ret = SPI_TRANSFER_BATCH(batch->xfers, batch->n_xfers);
+
+	if (ret != 0)
+	{
+		_hspi_log("hspi_batch_transfer: n_xfers=%d ret=%d\n", batch->n_xfers, ret);
+		return -1;
+	}
 
 	return 0;
 }
 
+static void hspi_batch_status (hspi_batch_t *batch)
+{
+	if (batch->status_resp.ack == HSPI_ACK_VALUE)
+	{
+		hspi_regs_convert_status(&batch->status, &g_hspi_info.queue.status_batch);
+
+		g_hspi_info.queue.status_batch_valid = true;
+	}
+}
+
+/*
+ * A slot whose command is not acknowledged has not been taken by the target,
+ * it stays in the queue and is read by the next call.
+ */
+static int hspi_read_slot_batch (int slot_num, int slot_size, char *buf, int *len)
+{
+	const int slot_max = hspi_batch_slot_max(slot_size);
+	const int data_len_max = slot_size - HSPI_SLOT_HDR_SIZE;
+	uint8_t *seq = &HSPI_TXQ_SLOT_SEQ();
+	hspi_batch_t batch;
+	hspi_opcode_t opcode;
+	hspi_cmd_t cmd;
+	hspi_resp_t resp[HSPI_BATCH_SLOT_MAX];
+	hspi_slot_t hdr[HSPI_BATCH_SLOT_MAX];
+	uint32_t burst_crc;
+	char *data;
+	int done, nack;
+	int i, j, k, n;
+
+	opcode.val = HSPI_OPCODE_READ_DATA(HSPI_REG_TXQ_WINDOW, slot_size);
+
+	hspi_cmd_setup(&cmd, &opcode);
+
+	for (i = 0, j = 0, done = 0, nack = 0 ; i < slot_num ; i += n)
+	{
+		n = slot_num - i;
+		if (n > slot_max)
+			n = slot_max;
+
+		/* The slot data is placed directly into the buffer and packed after the transfer. */
+		data = buf + j;
+
+		hspi_batch_init(&batch);
+
+		for (k = 0 ; k < n ; k++)
+		{
+			resp[k].ack = 0;
+
+			hspi_batch_add(&batch, &cmd, &resp[k], sizeof(hspi_cmd_t));
+			hspi_batch_add(&batch, NULL, &hdr[k], HSPI_SLOT_HDR_SIZE);
+			hspi_batch_add(&batch, NULL, data + (k * data_len_max), data_len_max);
+			hspi_batch_add(&batch, NULL, &burst_crc, 4);
+		}
+
+		if ((i + n) == slot_num)
+			hspi_batch_add_status(&batch);
+
+		if (hspi_batch_transfer(&batch) != 0)
+		{
+			if (done == 0)
+				return -1;
+			break;
+		}
+
+		for (k = 0 ; k < n ; k++)
+		{
+			if (resp[k].ack != HSPI_ACK_VALUE)
+			{
+				nack++;
+				continue;
+			}
+
+			done++;
+
+			if (memcmp(hdr[k].start, HSPI_SLOT_START, HSPI_SLOT_START_SIZE) != 0 ||
+					hdr[k].len > data_len_max)
+			{
+				_hspi_log("hspi_read: invalid header, start=%c(%X),%c(%X) len=%u \n",
+							hdr[k].start[0], hdr[k].start[0], hdr[k].start[1], hdr[k].start[1],
+							hdr[k].len);
+				continue;
+			}
+
+			if ((buf + j) != (data + (k * data_len_max)))
+				memmove(buf + j, data + (k * data_len_max), hdr[k].len);
+
+			j += hdr[k].len;
+
+			_hspi_read_debug("slot: seq=%u len=%u\n", hdr[k].seq, hdr[k].len);
+
+			if (hdr[k].seq != *seq)
+			{
+/*				_hspi_log("hspi_read: slot_seq: %u -> %u\n", *seq, hdr[k].seq); */
+
+				*seq = hdr[k].seq;
+			}
+
+			if (++(*seq) > HSPI_SLOT_SEQ_MAX)
+				*seq = 0;
+		}
+
+		if ((i + n) == slot_num)
+			hspi_batch_status(&batch);
+	}
+
+	if (nack > 0)
+		_hspi_log("hspi_read: nack=%d/%d\n", nack, slot_num);
+
+	if (done == 0)
+		return -1;
+
+	*len = j;
+
+	return done;
+}
+
+/*
+ * A slot whose command is not acknowledged has not been taken by the target.
+ * The slots after it are reported as not written and sent again with the next call,
+ * unless the target took any of them, which breaks the data order and fails the write.
+ */
+static int hspi_write_slot_batch (int slot_num, int slot_size, char *buf, int *len)
+{
+	static char padding[HSPI_SLOT_SIZE_MAX] = { 0, };
+	const int slot_max = hspi_batch_slot_max(slot_size);
+	const int data_len_max = slot_size - HSPI_SLOT_HDR_SIZE;
+	uint8_t *seq = &HSPI_RXQ_SLOT_SEQ();
+	hspi_batch_t batch;
+	hspi_opcode_t opcode;
+	hspi_cmd_t cmd;
+	hspi_resp_t resp[HSPI_BATCH_SLOT_MAX];
+	hspi_slot_t hdr[HSPI_BATCH_SLOT_MAX];
+	uint32_t burst_crc = ~0;
+	int i, j, k, l, n;
+
+	opcode.val = HSPI_OPCODE_WRITE_DATA(HSPI_REG_RXQ_WINDOW, slot_size);
+
+	hspi_cmd_setup(&cmd, &opcode);
+
+	for (i = 0, j = 0 ; i < slot_num ; i += n)
+	{
+		n = slot_num - i;
+		if (n > slot_max)
+			n = slot_max;
+
+		hspi_batch_init(&batch);
+
+		for (k = 0, l = j ; k < n ; k++)
+		{
+			memcpy(hdr[k].start, HSPI_SLOT_START, HSPI_SLOT_START_SIZE);
+			hdr[k].len = (*len - l) < data_len_max ? (*len - l) : data_len_max;
+			hdr[k].seq = (*seq + k) & HSPI_SLOT_SEQ_MAX;
+
+			resp[k].ack = 0;
+
+			hspi_batch_add(&batch, &cmd, &resp[k], sizeof(hspi_cmd_t));
+			hspi_batch_add(&batch, &hdr[k], NULL, HSPI_SLOT_HDR_SIZE);
+			hspi_batch_add(&batch, buf + l, NULL, hdr[k].len);
+
+			if (hdr[k].len < data_len_max)
+				hspi_batch_add(&batch, padding, NULL, data_len_max - hdr[k].len);
+
+			hspi_batch_add(&batch, &burst_crc, NULL, 4);
+
+			_hspi_write_debug("slot: seq=%u len=%u\n", hdr[k].seq, hdr[k].len);
+
+			l += hdr[k].len;
+		}
+
+		if ((i + n) == slot_num)
+			hspi_batch_add_status(&batch);
+
+		if (hspi_batch_transfer(&batch) != 0)
+			break;
+
+		for (k = 0 ; k < n ; k++)
+		{
+			if (resp[k].ack != HSPI_ACK_VALUE)
+				break;
+
+			j += hdr[k].len;
+		}
+
+		*seq = (*seq + k) & HSPI_SLOT_SEQ_MAX;
+
+		if (k < n)
+		{
+			for (l = k + 1 ; l < n ; l++)
+			{
+				if (resp[l].ack == HSPI_ACK_VALUE)
+				{
+					_hspi_log("hspi_write: slot %d taken after nack\n", i + l);
+					return -1;
+				}
+			}
+
+			i += k;
+			break;
+		}
+
+		if ((i + n) == slot_num)
+			hspi_batch_status(&batch);
+	}
+
+	*len = j;
+
+	return i;
+}
+
 /**********************************************************************************************/
 
 static int hspi_read_slot (int slot_num, int slot_size, char *buf, int *len)
 {
-	static uint8_t seq = 0;
+	uint8_t *seq = &HSPI_TXQ_SLOT_SEQ();
 	char slot_buf[HSPI_SLOT_SIZE_MAX];
 	hspi_slot_t *slot = (hspi_slot_t *)slot_buf;
 	hspi_opcode_t opcode;
 	int i, j;
 
+	if (HSPI_BATCH_ACTIVE())
+		return hspi_read_slot_batch(slot_num, slot_size, buf, len);
+
 	for (i = 0, j = 0 ; i < slot_num ; i++, j += slot->len)
 	{
 		opcode.val = HSPI_OPCODE_READ_DATA(HSPI_REG_TXQ_WINDOW, slot_size);
@@ -568,15 +876,15 @@ static int hspi_read_slot (int slot_num, int slot_size, char *buf, int *len)
 
 		_hspi_read_debug("slot: seq=%u len=%u\n", slot->seq, slot->len);
 
-		if (slot->seq != seq)
+		if (slot->seq != *seq)
 		{
-/*			_hspi_log("hspi_read: slot_seq: %u -> %u\n", seq, slot->seq); */
+/*			_hspi_log("hspi_read: slot_seq: %u -> %u\n", *seq, slot->seq); */
 
-			seq = slot->seq;
+			*seq = slot->seq;
 		}
 
-		if (++seq > HSPI_SLOT_SEQ_MAX)
-			seq = 0;
+		if (++(*seq) > HSPI_SLOT_SEQ_MAX)
+			*seq = 0;
 	}
 
 	*len = j;
@@ -636,6 +944,8 @@ static int hspi_read (char *buf, int len)
 			slot_cnt -= slot_num;
 			HSPI_TXQ_SLOT_COUNT_UPDATE(slot_cnt);
 		}
+
+		hspi_status_update_batch();
 	}
 
 	_hspi_read_debug("slot_cnt=%u slot_num=%u ret=%d\n", slot_cnt, slot_num, ret);
@@ -645,12 +955,15 @@ static int hspi_read (char *buf, int len)
 
 static int hspi_write_slot (int slot_num, int slot_size, char *buf, int *len)
 {
-	static uint8_t seq = 0;
+	uint8_t *seq = &HSPI_RXQ_SLOT_SEQ();
 	char slot_buf[HSPI_SLOT_SIZE_MAX];
 	hspi_slot_t *slot = (hspi_slot_t *)slot_buf;
 	hspi_opcode_t opcode;
 	int i, j;
 
+	if (HSPI_BATCH_ACTIVE())
+		return hspi_write_slot_batch(slot_num, slot_size, buf, len);
+
 	memcpy(slot->start, HSPI_SLOT_START, HSPI_SLOT_START_SIZE);
 
 	slot->len = slot_size - HSPI_SLOT_HDR_SIZE;
@@ -664,7 +977,7 @@ static int hspi_write_slot (int slot_num, int slot_size, char *buf, int *len)
 			memset(slot_buf + HSPI_SLOT_HDR_SIZE + slot->len, 0, slot_size - HSPI_SLOT_HDR_SIZE - slot->len);
 		}
 
-		slot->seq = seq;
+		slot->seq = *seq;
 
 		memcpy(slot->data, buf + j, slot->len);
 
@@ -675,8 +988,8 @@ static int hspi_write_slot (int slot_num, int slot_size, char *buf, int *len)
 		if (hspi_transfer(&opcode, (char *)slot, slot_size) != 0)
 			break;
 
-		if (++seq > HSPI_SLOT_SEQ_MAX)
-			seq = 0;
+		if (++(*seq) > HSPI_SLOT_SEQ_MAX)
+			*seq = 0;
 	}
 
 	*len = j;
@@ -728,7 +1041,12 @@ static int hspi_write (char *buf, int len)
 	}
 
 	ret = hspi_write_slot(slot_num, slot_size, buf, &len);
-	if (ret < slot_num)
+	if (ret < 0)
+	{
+		hspi_status_init(HSPI_RXQ);
+		return -1;
+	}
+	else if (ret < slot_num)
 	{
 		slot_num = ret;
 		slot_cnt = 0;
@@ -738,6 +1056,8 @@ static int hspi_write (char *buf, int len)
 	{
 		slot_cnt -= slot_num;
 		HSPI_RXQ_SLOT_COUNT_UPDATE(slot_cnt);
+
+		hspi_status_update_batch();
 	}
 
 	ret = len;
@@ -270,6 +270,15 @@ typedef struct
 	char *rx_buf;
 } hspi_xfer_t;
 
+/*
+ * Batched slot transfers, all slots of a read or write and a trailing status read
+ * are submitted as one SPI message. The message length is limited by the 'bufsiz'
+ * parameter of the spidev driver (default: 4096).
+ */
+#define HSPI_BATCH_LEN_MAX		4096
+#define HSPI_BATCH_SLOT_MAX		16
+#define HSPI_BATCH_XFER_MAX		((HSPI_BATCH_SLOT_MAX * 5) + 3)
+
 typedef struct
 {
 #define HSPI_SLOT_SIZE_MAX		512
@@ -288,6 +297,7 @@ typedef struct
 typedef struct
 {
 	int (*spi_transfer) (char *tx_buf, char *rx_buf, int len);
+	int (*spi_transfer_batch) (hspi_xfer_t *xfers, int n_xfers); /* optional */
 } hspi_ops_t;
 
 typedef struct
@@ -300,9 +310,14 @@ typedef struct
 		{
 			uint16_t num;
 			uint16_t size;
+			uint8_t seq;
 		} slot[HSPI_QUE_NUM];
 
 		hspi_status_t status;
+
+		/* status read at the end of the last batch */
+		bool status_batch_valid;
+		hspi_status_t status_batch;
 	} queue;
 
 	hspi_ops_t ops;
@@ -57,6 +57,44 @@ static void raspi_hif_mutex_unlock (void)
 
 /**********************************************************************************************/
 
+static int raspi_hif_spi_transfer_batch (hspi_xfer_t *xfers, int n_xfers)
+{
+	struct spi_ioc_transfer spi_xfers[HSPI_BATCH_XFER_MAX];
+	int len;
+	int ret;
+	int i;
+
+	if (!xfers || n_xfers <= 0 || n_xfers > HSPI_BATCH_XFER_MAX)
+		return -EINVAL;
+
+	memset(spi_xfers, 0, sizeof(struct spi_ioc_transfer) * n_xfers);
+
+	for (i = 0, len = 0 ; i < n_xfers ; i++)
+	{
+		spi_xfers[i].tx_buf = (uintptr_t)xfers[i].tx_buf;
+		spi_xfers[i].rx_buf = (uintptr_t)xfers[i].rx_buf;
+		spi_xfers[i].len = xfers[i].len;
+
+		/* Toggle CS between transfers as if each one was a separate message. */
+		spi_xfers[i].cs_change = (i < (n_xfers - 1)) ? 1 : 0;
+
+		len += xfers[i].len;
+	}
+
+	ret = raspi_spi_transfer(spi_xfers, n_xfers);
+	if (ret < 0)
+		return ret;
+	else if (ret != len)
+	{
+		log_error("not completed. (%d/%d)\n", ret, len);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**********************************************************************************************/
+
 static raspi_hif_t g_raspi_hif =
 {
 	.type = RASPI_HIF_NONE,
@@ -78,7 +116,7 @@ int raspi_hif_open (int type, char *device, uint32_t speed, uint32_t flags)
 	raspi_hif_t *hif = &g_raspi_hif;
 	int ret;
 
-	if (type == RASPI_HIF_NONE || !device || !speed)
+	if (type == RASPI_HIF_NONE || !device || (!speed && type != RASPI_HIF_UNIX))
 		return -EINVAL;
 
 	if (hif->type != RASPI_HIF_NONE)
@@ -124,6 +162,10 @@ int raspi_hif_open (int type, char *device, uint32_t speed, uint32_t flags)
 					raspi_hif_mutex_init();
 
 					ops.spi_transfer = raspi_spi_single_transfer;
+					ops.spi_transfer_batch = NULL;
+
+					if (!(flags & RASPI_HIF_SPI_NO_BATCH))
+						ops.spi_transfer_batch = raspi_hif_spi_transfer_batch;
 
 					ret = nrc_hspi_open(&ops, eirq_mode);
 					if (ret == 0)
@@ -175,6 +217,22 @@ int raspi_hif_open (int type, char *device, uint32_t speed, uint32_t flags)
 			}
 			break;
 
+		case RASPI_HIF_UNIX:
+			log_info("\r\n");
+			log_info("[ UNIX ]\n");
+			log_info(" - path: %s\n", device);
+			log_info("\r\n");
+
+			ret = raspi_unix_open(device);
+			if (ret == 0)
+			{
+				hif->type = type;
+				hif->flags = flags;
+				hif->read = raspi_unix_read;
+				hif->write = raspi_unix_write;
+			}
+			break;
+
 		default:
 			return -ENODEV;
 	}
@@ -198,6 +256,10 @@ void raspi_hif_close (void)
 			raspi_uart_close();
 			break;
 
+		case RASPI_HIF_UNIX:
+			raspi_unix_close();
+			break;
+
 		default:
 			break;
 	}
@@ -214,6 +276,7 @@ int raspi_hif_read (char *buf, int len)
 	{
 		case RASPI_HIF_SPI:
 		case RASPI_HIF_UART:
+		case RASPI_HIF_UNIX:
 			if (!hif->read)
 				return -EPERM;
 			break;
@@ -242,6 +305,7 @@ int raspi_hif_write (char *buf, int len)
 	{
 		case RASPI_HIF_SPI:
 		case RASPI_HIF_UART:
+		case RASPI_HIF_UNIX:
 			if (!hif->write)
 				return -EPERM;
 			break;
@@ -45,6 +45,7 @@ enum RASPI_HIF_TYPE
 
 	RASPI_HIF_SPI = 0,
 	RASPI_HIF_UART,
+	RASPI_HIF_UNIX, /* linux-atcmd */
 
 	RASPI_HIF_NUM
 };
@@ -58,8 +59,19 @@ enum RASPI_HIF_FLAG
 	RASPI_HIF_EIRQ_FALLING = (1 << 3),
 	RASPI_HIF_EIRQ_RISING = (1 << 4),
 	RASPI_HIF_EIRQ_MASK = (0xF << 1),
+
+	RASPI_HIF_SPI_NO_BATCH = (1 << 5), /* one ioctl per transfer */
 };
 
+#define RASPI_SPI_LOOPBACK		"loopback" /* device name of the emulated target */
+
+typedef struct
+{
+	uint64_t ioctls;	/* SPI_IOC_MESSAGE */
+	uint64_t xfers;
+	uint64_t bytes;
+} raspi_spi_stats_t;
+
 typedef struct
 {
 	enum RASPI_HIF_TYPE type;
@@ -77,12 +89,22 @@ extern int raspi_spi_close (void);
 extern int raspi_spi_setup (int mode, int bits_per_word, int max_speed_hz, bool print);
 extern int raspi_spi_transfer (struct spi_ioc_transfer *xfers, int n_xfers);
 extern int raspi_spi_single_transfer (char *tx_buf, char *rx_buf, int len);
+extern void raspi_spi_get_stats (raspi_spi_stats_t *stats);
+extern void raspi_spi_clear_stats (void);
+
+extern void raspi_spi_loopback_open (void);
+extern int raspi_spi_loopback_ioctl (unsigned long request, void *val);
 
 extern int raspi_uart_open (char *device, uint32_t baudrate, bool hfc);
 extern void raspi_uart_close (void);
 extern int raspi_uart_read (char *buf, int len);
 extern int raspi_uart_write (char *buf, int len);
 
+extern int raspi_unix_open (char *path);
+extern void raspi_unix_close (void);
+extern int raspi_unix_read (char *buf, int len);
+extern int raspi_unix_write (char *buf, int len);
+
 extern int raspi_eirq_open (const char *gpiochip, int gpio, bool falling, bool nonblock);
 extern void raspi_eirq_close (void);
 extern int raspi_eirq_poll (int timeout);
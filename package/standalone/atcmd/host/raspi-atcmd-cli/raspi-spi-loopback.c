@@ -0,0 +1,606 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+/*
+ * Loopback stand-in for the spidev device, selected with the device name "loopback".
+ *
+ * It emulates the H-SPI target at the byte level: command/response, register reads and
+ * writes, and the TXQ/RXQ slot windows. Data written to the RXQ window comes back from
+ * the TXQ window, so the HSPI driver can be exercised and measured without a target.
+ */
+
+#include "raspi-hif.h"
+#include "nrc-hspi.h"
+
+
+#define raspi_spi_loopback_error(fmt, ...)		log_error(fmt, ##__VA_ARGS__)
+
+#define LOOPBACK_SLOT_NUM			32
+#define LOOPBACK_SLOT_SIZE			512
+#define LOOPBACK_SLOT_DATA_LEN		(LOOPBACK_SLOT_SIZE - HSPI_SLOT_HDR_SIZE)
+#define LOOPBACK_FIFO_SIZE			(LOOPBACK_SLOT_NUM * LOOPBACK_SLOT_DATA_LEN)
+
+#define LOOPBACK_REG_SIZE			0x50
+
+enum LOOPBACK_PHASE
+{
+	LOOPBACK_PHASE_CMD = 0,
+	LOOPBACK_PHASE_DATA,
+	LOOPBACK_PHASE_CRC,
+};
+
+static struct
+{
+	uint8_t mode;
+	uint8_t bits_per_word;
+	uint32_t max_speed_hz;
+
+	uint8_t regs[LOOPBACK_REG_SIZE];
+
+	struct
+	{
+		enum LOOPBACK_PHASE phase;
+		int cnt;
+		uint8_t cmd[sizeof(hspi_cmd_t)];
+		hspi_opcode_t opcode;
+		bool ack;
+		uint32_t seq;
+	} xfer;
+
+	struct
+	{
+		uint8_t seq[HSPI_QUE_NUM];
+		uint8_t buf[LOOPBACK_SLOT_SIZE];
+	} slot;
+
+	struct
+	{
+		int head;
+		int tail;
+		int len;
+		uint8_t buf[LOOPBACK_FIFO_SIZE];
+	} fifo;
+
+	int nack_interval; /* RASPI_SPI_LOOPBACK_NACK=<n>, every n-th read command is not acknowledged */
+} g_raspi_spi_loopback;
+
+/**********************************************************************************************/
+
+static uint8_t raspi_spi_loopback_crc7 (uint8_t *data, int len)
+{
+	uint8_t crc = 0;
+	int i, j;
+
+	for (i = 0 ; i < len ; i++)
+	{
+		crc ^= data[i];
+
+		for (j = 0 ; j < 8 ; j++)
+		{
+			if (crc & 0x80)
+				crc ^= 0x89;
+
+			crc <<= 1;
+		}
+	}
+
+	return crc >> 1;
+}
+
+static void raspi_spi_loopback_put_be16 (uint8_t *p, uint16_t val)
+{
+	p[0] = val >> 8;
+	p[1] = val;
+}
+
+static void raspi_spi_loopback_put_be32 (uint8_t *p, uint32_t val)
+{
+	p[0] = val >> 24;
+	p[1] = val >> 16;
+	p[2] = val >> 8;
+	p[3] = val;
+}
+
+static void raspi_spi_loopback_fifo_push (uint8_t *data, int len)
+{
+	int i;
+
+	for (i = 0 ; i < len ; i++)
+	{
+		g_raspi_spi_loopback.fifo.buf[g_raspi_spi_loopback.fifo.tail] = data[i];
+
+		if (++g_raspi_spi_loopback.fifo.tail == LOOPBACK_FIFO_SIZE)
+			g_raspi_spi_loopback.fifo.tail = 0;
+	}
+
+	g_raspi_spi_loopback.fifo.len += len;
+}
+
+static void raspi_spi_loopback_fifo_pop (uint8_t *data, int len)
+{
+	int i;
+
+	for (i = 0 ; i < len ; i++)
+	{
+		data[i] = g_raspi_spi_loopback.fifo.buf[g_raspi_spi_loopback.fifo.head];
+
+		if (++g_raspi_spi_loopback.fifo.head == LOOPBACK_FIFO_SIZE)
+			g_raspi_spi_loopback.fifo.head = 0;
+	}
+
+	g_raspi_spi_loopback.fifo.len -= len;
+}
+
+/**********************************************************************************************/
+
+static void raspi_spi_loopback_update_status (void)
+{
+	uint8_t *status = g_raspi_spi_loopback.regs + HSPI_REG_STATUS;
+	const int slot_size = LOOPBACK_SLOT_SIZE >> 2; /* 4-byte unit */
+	int fifo_len = g_raspi_spi_loopback.fifo.len;
+	int txq_cnt, rxq_cnt;
+
+	txq_cnt = (fifo_len + LOOPBACK_SLOT_DATA_LEN - 1) / LOOPBACK_SLOT_DATA_LEN;
+	rxq_cnt = (LOOPBACK_FIFO_SIZE - fifo_len) / LOOPBACK_SLOT_DATA_LEN;
+
+	/* hspi_status_t: latch, eirq, txq { error, slot_cnt, slot_size, total }, rxq { ... } */
+	status[0] = 0;
+	status[1] = (txq_cnt > 0 ? HSPI_EIRQ_TXQ : 0) | (rxq_cnt > 0 ? HSPI_EIRQ_RXQ : 0);
+
+	status[2] = 0;
+	status[3] = txq_cnt;
+	raspi_spi_loopback_put_be16(status + 4, slot_size);
+	raspi_spi_loopback_put_be16(status + 6, txq_cnt * slot_size);
+
+	status[8] = 0;
+	status[9] = rxq_cnt;
+	raspi_spi_loopback_put_be16(status + 10, slot_size);
+	raspi_spi_loopback_put_be16(status + 12, rxq_cnt * slot_size);
+}
+
+static void raspi_spi_loopback_reset_regs (void)
+{
+	uint8_t *regs = g_raspi_spi_loopback.regs;
+	const char *id = "NRC-HSPI";
+	uint32_t word;
+	int i;
+
+	memset(regs, 0, LOOPBACK_REG_SIZE);
+
+	regs[HSPI_REG_DEVICE_STATUS] = 0x01; /* ready */
+	raspi_spi_loopback_put_be16(regs + HSPI_REG_CHIP_ID, 0x7292);
+
+	/* The target writes the message registers as 32-bit words. */
+	for (i = 0 ; i < 2 ; i++)
+	{
+		memcpy(&word, id + (i * 4), 4);
+		raspi_spi_loopback_put_be32(regs + HSPI_REG_MSG + (i * 4), word);
+	}
+
+	raspi_spi_loopback_put_be32(regs + HSPI_REG_DEV_MSG_2, (LOOPBACK_SLOT_NUM << 16) | LOOPBACK_SLOT_SIZE);
+	raspi_spi_loopback_put_be32(regs + HSPI_REG_DEV_MSG_3, (LOOPBACK_SLOT_NUM << 16) | LOOPBACK_SLOT_SIZE);
+
+	raspi_spi_loopback_update_status();
+}
+
+/**********************************************************************************************/
+
+static void raspi_spi_loopback_txq_slot (void)
+{
+	hspi_slot_t *slot = (hspi_slot_t *)g_raspi_spi_loopback.slot.buf;
+	int len = g_raspi_spi_loopback.fifo.len;
+
+	memset(slot, 0, LOOPBACK_SLOT_SIZE);
+
+	if (len == 0)
+		return;
+
+	if (len > LOOPBACK_SLOT_DATA_LEN)
+		len = LOOPBACK_SLOT_DATA_LEN;
+
+	memcpy(slot->start, HSPI_SLOT_START, HSPI_SLOT_START_SIZE);
+	slot->len = len;
+	slot->seq = g_raspi_spi_loopback.slot.seq[HSPI_TXQ]++ & HSPI_SLOT_SEQ_MAX;
+
+	raspi_spi_loopback_fifo_pop(slot->data, len);
+	raspi_spi_loopback_update_status();
+}
+
+static void raspi_spi_loopback_rxq_slot (void)
+{
+	hspi_slot_t *slot = (hspi_slot_t *)g_raspi_spi_loopback.slot.buf;
+
+	if (memcmp(slot->start, HSPI_SLOT_START, HSPI_SLOT_START_SIZE) != 0 ||
+			slot->len > LOOPBACK_SLOT_DATA_LEN)
+	{
+		raspi_spi_loopback_error("invalid slot header\n");
+		return;
+	}
+
+	if (slot->seq != (g_raspi_spi_loopback.slot.seq[HSPI_RXQ] & HSPI_SLOT_SEQ_MAX))
+		raspi_spi_loopback_error("slot_seq: %u -> %u\n",
+						g_raspi_spi_loopback.slot.seq[HSPI_RXQ] & HSPI_SLOT_SEQ_MAX, slot->seq);
+
+	g_raspi_spi_loopback.slot.seq[HSPI_RXQ] = slot->seq + 1;
+
+	if (slot->len > (LOOPBACK_FIFO_SIZE - g_raspi_spi_loopback.fifo.len))
+	{
+		raspi_spi_loopback_error("rxq overflow\n");
+		return;
+	}
+
+	raspi_spi_loopback_fifo_push(slot->data, slot->len);
+	raspi_spi_loopback_update_status();
+}
+
+static void raspi_spi_loopback_cmd (void)
+{
+	hspi_opcode_t *opcode = &g_raspi_spi_loopback.xfer.opcode;
+	uint8_t *cmd = g_raspi_spi_loopback.xfer.cmd;
+	uint8_t crc;
+
+	opcode->val = (cmd[0] << 24) | (cmd[1] << 16) | (cmd[2] << 8) | cmd[3];
+	crc = (raspi_spi_loopback_crc7(cmd, 4) << 1) | 0x01;
+
+	g_raspi_spi_loopback.xfer.ack = (opcode->start == (HSPI_START >> 24) && cmd[4] == crc);
+
+	if (g_raspi_spi_loopback.nack_interval > 0 && !opcode->write &&
+			(++g_raspi_spi_loopback.xfer.seq % g_raspi_spi_loopback.nack_interval) == 0)
+		g_raspi_spi_loopback.xfer.ack = false;
+
+	if (!g_raspi_spi_loopback.xfer.ack || !opcode->burst)
+		return;
+
+	if (opcode->write)
+		memset(g_raspi_spi_loopback.slot.buf, 0, LOOPBACK_SLOT_SIZE);
+	else if (opcode->address == HSPI_REG_TXQ_WINDOW)
+		raspi_spi_loopback_txq_slot();
+}
+
+static uint8_t raspi_spi_loopback_cmd_done (void)
+{
+	hspi_opcode_t *opcode = &g_raspi_spi_loopback.xfer.opcode;
+
+	if (!g_raspi_spi_loopback.xfer.ack)
+		return 0;
+
+	if (opcode->burst)
+	{
+		g_raspi_spi_loopback.xfer.phase = LOOPBACK_PHASE_DATA;
+		g_raspi_spi_loopback.xfer.cnt = 0;
+	}
+	else if (opcode->write && opcode->address < LOOPBACK_REG_SIZE)
+		g_raspi_spi_loopback.regs[opcode->address] = opcode->length & 0xff;
+
+	return HSPI_ACK_VALUE;
+}
+
+static uint8_t raspi_spi_loopback_data (uint8_t tx)
+{
+	hspi_opcode_t *opcode = &g_raspi_spi_loopback.xfer.opcode;
+	int cnt = g_raspi_spi_loopback.xfer.cnt++;
+	uint8_t rx = 0;
+
+	switch (opcode->address)
+	{
+		case HSPI_REG_RXQ_WINDOW:
+			if (opcode->write && cnt < LOOPBACK_SLOT_SIZE)
+				g_raspi_spi_loopback.slot.buf[cnt] = tx;
+			break;
+
+		case HSPI_REG_TXQ_WINDOW:
+			if (!opcode->write && cnt < LOOPBACK_SLOT_SIZE)
+				rx = g_raspi_spi_loopback.slot.buf[cnt];
+			break;
+
+		default:
+			if (!opcode->write && (opcode->address + cnt) < LOOPBACK_REG_SIZE)
+				rx = g_raspi_spi_loopback.regs[opcode->address + cnt];
+	}
+
+	if (g_raspi_spi_loopback.xfer.cnt == opcode->length)
+	{
+		if (opcode->write && opcode->address == HSPI_REG_RXQ_WINDOW)
+			raspi_spi_loopback_rxq_slot();
+
+		g_raspi_spi_loopback.xfer.phase = LOOPBACK_PHASE_CRC;
+		g_raspi_spi_loopback.xfer.cnt = 0;
+	}
+
+	return rx;
+}
+
+static uint8_t raspi_spi_loopback_byte (uint8_t tx)
+{
+	uint8_t rx = 0;
+
+	switch (g_raspi_spi_loopback.xfer.phase)
+	{
+		case LOOPBACK_PHASE_CMD:
+		{
+			int cnt = g_raspi_spi_loopback.xfer.cnt++;
+			hspi_opcode_t *opcode = &g_raspi_spi_loopback.xfer.opcode;
+
+			g_raspi_spi_loopback.xfer.cmd[cnt] = tx;
+
+			if (cnt == 4) /* opcode + crc */
+				raspi_spi_loopback_cmd();
+			else if (cnt == 6) /* hspi_resp_t.data */
+			{
+				if (g_raspi_spi_loopback.xfer.ack && !opcode->burst && !opcode->write &&
+						opcode->address < LOOPBACK_REG_SIZE)
+					rx = g_raspi_spi_loopback.regs[opcode->address];
+			}
+			else if (cnt == 7) /* hspi_resp_t.ack */
+			{
+				g_raspi_spi_loopback.xfer.cnt = 0;
+
+				rx = raspi_spi_loopback_cmd_done();
+			}
+			break;
+		}
+
+		case LOOPBACK_PHASE_DATA:
+			rx = raspi_spi_loopback_data(tx);
+			break;
+
+		case LOOPBACK_PHASE_CRC:
+			if (++g_raspi_spi_loopback.xfer.cnt == 4)
+			{
+				g_raspi_spi_loopback.xfer.phase = LOOPBACK_PHASE_CMD;
+				g_raspi_spi_loopback.xfer.cnt = 0;
+			}
+	}
+
+	return rx;
+}
+
+static int raspi_spi_loopback_message (struct spi_ioc_transfer *xfers, int n_xfers)
+{
+	uint8_t *tx_buf;
+	uint8_t *rx_buf;
+	uint8_t rx;
+	int len;
+	int i, j;
+
+	for (i = 0, len = 0 ; i < n_xfers ; i++)
+	{
+		tx_buf = (uint8_t *)(uintptr_t)xfers[i].tx_buf;
+		rx_buf = (uint8_t *)(uintptr_t)xfers[i].rx_buf;
+
+		for (j = 0 ; j < xfers[i].len ; j++)
+		{
+			rx = raspi_spi_loopback_byte(tx_buf ? tx_buf[j] : 0);
+
+			if (rx_buf)
+				rx_buf[j] = rx;
+		}
+
+		/* A command is framed by CS, the partial command is discarded when CS goes high. */
+		if (xfers[i].cs_change || i == (n_xfers - 1))
+		{
+			if (g_raspi_spi_loopback.xfer.phase == LOOPBACK_PHASE_CMD)
+				g_raspi_spi_loopback.xfer.cnt = 0;
+		}
+
+		len += xfers[i].len;
+	}
+
+	return len;
+}
+
+/**********************************************************************************************/
+
+void raspi_spi_loopback_open (void)
+{
+	char *nack = getenv("RASPI_SPI_LOOPBACK_NACK");
+
+	memset(&g_raspi_spi_loopback, 0, sizeof(g_raspi_spi_loopback));
+
+	g_raspi_spi_loopback.xfer.phase = LOOPBACK_PHASE_CMD;
+
+	if (nack)
+		g_raspi_spi_loopback.nack_interval = atoi(nack);
+
+	raspi_spi_loopback_reset_regs();
+}
+
+int raspi_spi_loopback_ioctl (unsigned long request, void *val)
+{
+	if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0 &&
+			_IOC_DIR(request) == _IOC_WRITE)
+	{
+		int n_xfers = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+
+		return raspi_spi_loopback_message((struct spi_ioc_transfer *)val, n_xfers);
+	}
+
+	switch (request)
+	{
+		case SPI_IOC_WR_MODE:
+			g_raspi_spi_loopback.mode = *(uint8_t *)val;
+			break;
+
+		case SPI_IOC_RD_MODE:
+			*(uint8_t *)val = g_raspi_spi_loopback.mode;
+			break;
+
+		case SPI_IOC_WR_BITS_PER_WORD:
+			g_raspi_spi_loopback.bits_per_word = *(uint8_t *)val;
+			break;
+
+		case SPI_IOC_RD_BITS_PER_WORD:
+			*(uint8_t *)val = g_raspi_spi_loopback.bits_per_word;
+			break;
+
+		case SPI_IOC_WR_MAX_SPEED_HZ:
+			g_raspi_spi_loopback.max_speed_hz = *(uint32_t *)val;
+			break;
+
+		case SPI_IOC_RD_MAX_SPEED_HZ:
+			*(uint32_t *)val = g_raspi_spi_loopback.max_speed_hz;
+			break;
+
+		default:
+			errno = ENOTTY;
+			return -1;
+	}
+
+	return 0;
+}
+
+/**********************************************************************************************/
+
+#ifdef CONFIG_SPI_LOOPBACK_TEST
+/*
+ * $ make loopback-test
+ * $ ./raspi-spi-loopback-test [<size in KB>]
+ */
+
+static double raspi_spi_loopback_time (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + (ts.tv_nsec / 1000000000.);
+}
+
+static int raspi_spi_loopback_test (const char *name, uint32_t flags, int size)
+{
+	const int buf_size = 4096;
+	char *tx_buf, *rx_buf;
+	raspi_spi_stats_t stats;
+	double start, time;
+	int sent, recv;
+	int ret = -1;
+	int len;
+
+	tx_buf = malloc(buf_size);
+	rx_buf = malloc(buf_size);
+
+	if (!tx_buf || !rx_buf)
+		goto test_done;
+
+	if (raspi_hif_open(RASPI_HIF_SPI, RASPI_SPI_LOOPBACK, 16000000, flags) != 0)
+		goto test_done;
+
+	raspi_spi_clear_stats();
+
+	start = raspi_spi_loopback_time();
+
+	for (sent = 0, recv = 0 ; recv < size ; )
+	{
+		if (sent < size && (sent - recv) < buf_size)
+		{
+			int i;
+
+			len = buf_size - (sent - recv);
+			if (len > (size - sent))
+				len = size - sent;
+
+			for (i = 0 ; i < len ; i++)
+				tx_buf[i] = (sent + i) * 31;
+
+			len = raspi_hif_write(tx_buf, len);
+			if (len < 0)
+				break;
+
+			sent += len;
+		}
+
+		len = raspi_hif_read(rx_buf, buf_size);
+		if (len < 0)
+			break;
+		else
+		{
+			int i;
+
+			for (i = 0 ; i < len ; i++)
+			{
+				if (rx_buf[i] != (char)((recv + i) * 31))
+				{
+					raspi_spi_loopback_error("%s: data mismatch at %d\n", name, recv + i);
+					raspi_hif_close();
+					goto test_done;
+				}
+			}
+
+			recv += len;
+		}
+	}
+
+	time = raspi_spi_loopback_time() - start;
+
+	raspi_spi_get_stats(&stats);
+	raspi_hif_close();
+
+	if (recv < size)
+	{
+		raspi_spi_loopback_error("%s: %d/%d bytes\n", name, recv, size);
+		goto test_done;
+	}
+
+	log_info("%-6s: %d KB, %.3lf sec, %.2lf MB/s, ioctl=%llu (%.2lf/KB) xfer=%llu\n",
+				name, size / 1024, time, (size / time) / (1024 * 1024),
+				(unsigned long long)stats.ioctls, stats.ioctls / (size / 1024.),
+				(unsigned long long)stats.xfers);
+
+	ret = 0;
+
+test_done:
+
+	if (tx_buf)
+		free(tx_buf);
+
+	if (rx_buf)
+		free(rx_buf);
+
+	return ret;
+}
+
+int main (int argc, char *argv[])
+{
+	int size = 4 * 1024;
+
+	if (argc > 1)
+		size = atoi(argv[1]);
+
+	if (size <= 0)
+		return 1;
+
+	size *= 1024;
+
+	if (raspi_spi_loopback_test("single", RASPI_HIF_SPI_NO_BATCH, size) != 0)
+		return 1;
+
+	if (raspi_spi_loopback_test("batch", 0, size) != 0)
+		return 1;
+
+	return 0;
+}
+#endif /* #ifdef CONFIG_SPI_LOOPBACK_TEST */
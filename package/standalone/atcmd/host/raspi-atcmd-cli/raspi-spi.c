@@ -34,6 +34,8 @@
 
 
 static int g_raspi_spi_fd = -1;
+static bool g_raspi_spi_loopback = false;
+static raspi_spi_stats_t g_raspi_spi_stats;
 
 /**********************************************************************************************/
 
@@ -45,6 +47,9 @@ static int raspi_spi_ioctl (unsigned long request, void *val)
 		return -1;
 	}
 
+	if (g_raspi_spi_loopback)
+		return raspi_spi_loopback_ioctl(request, val);
+
 	return ioctl(g_raspi_spi_fd, request, val);
 }
 
@@ -114,6 +119,15 @@ int raspi_spi_open (const char *device)
 		return -EBUSY;
 	}
 
+	g_raspi_spi_loopback = (strcmp(device, RASPI_SPI_LOOPBACK) == 0);
+
+	if (g_raspi_spi_loopback)
+	{
+		raspi_spi_loopback_open();
+
+		device = "/dev/null";
+	}
+
 	fd = open(device, O_RDWR);
 	if (fd < 0)
 	{
@@ -123,6 +137,8 @@ int raspi_spi_open (const char *device)
 
 	g_raspi_spi_fd = fd;
 
+	raspi_spi_clear_stats();
+
 	return 0;
 }
 
@@ -141,6 +157,7 @@ int raspi_spi_close (void)
 	}
 
 	g_raspi_spi_fd = -1;
+	g_raspi_spi_loopback = false;
 
 	return 0;
 }
@@ -228,6 +245,10 @@ int raspi_spi_transfer (struct spi_ioc_transfer *xfers, int n_xfers)
 		return -errno;
 	}
 
+	g_raspi_spi_stats.ioctls++;
+	g_raspi_spi_stats.xfers += n_xfers;
+	g_raspi_spi_stats.bytes += ret;
+
 	return ret;
 }
 
@@ -265,3 +286,13 @@ int raspi_spi_single_transfer (char *tx_buf, char *rx_buf, int len)
 	return 0;
 }
 
+void raspi_spi_get_stats (raspi_spi_stats_t *stats)
+{
+	memcpy(stats, &g_raspi_spi_stats, sizeof(raspi_spi_stats_t));
+}
+
+void raspi_spi_clear_stats (void)
+{
+	memset(&g_raspi_spi_stats, 0, sizeof(raspi_spi_stats_t));
+}
+
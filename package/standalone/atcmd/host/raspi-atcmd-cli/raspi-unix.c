@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "raspi-hif.h"
+
+#define raspi_unix_info(fmt, ...)		/* log_info(fmt, ##__VA_ARGS__) */
+#define raspi_unix_error(fmt, ...)		log_error(fmt, ##__VA_ARGS__)
+
+/**********************************************************************************************/
+
+/*
+ * Stream socket to the host build of the target (linux-atcmd).
+ * It carries the same byte stream as the UART without any line settings.
+ */
+
+static int g_raspi_unix_sockfd = -1;
+
+int raspi_unix_open (char *path)
+{
+	struct sockaddr_un addr;
+	int sockfd;
+
+	raspi_unix_info("unix_open: path=%s\n", path);
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+	{
+		raspi_unix_error("%s, path=%s\n", strerror(ENAMETOOLONG), path);
+		return -ENAMETOOLONG;
+	}
+
+	sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sockfd < 0)
+	{
+		raspi_unix_error("%s, socket()\n", strerror(errno));
+		return -errno;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	if (connect(sockfd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		int err = errno;
+
+		close(sockfd);
+
+		raspi_unix_error("%s, connect(), %s\n", strerror(err), path);
+		return -err;
+	}
+
+	g_raspi_unix_sockfd = sockfd;
+
+	return 0;
+}
+
+void raspi_unix_close (void)
+{
+	raspi_unix_info("unix_close\n");
+
+	if (g_raspi_unix_sockfd >= 0)
+		close(g_raspi_unix_sockfd);
+
+	g_raspi_unix_sockfd = -1;
+}
+
+int raspi_unix_read (char *buf, int len)
+{
+	int ret = -ENODEV;
+
+	if (g_raspi_unix_sockfd >= 0)
+	{
+		ret = recv(g_raspi_unix_sockfd, buf, len, 0);
+		if (ret < 0)
+			ret = -errno;
+		else if (ret == 0)
+			ret = -EPIPE; /* target exited */
+	}
+
+	return ret;
+}
+
+int raspi_unix_write (char *buf, int len)
+{
+	int ret = -ENODEV;
+
+	if (g_raspi_unix_sockfd >= 0)
+	{
+		ret = send(g_raspi_unix_sockfd, buf, len, MSG_NOSIGNAL);
+		if (ret < 0)
+			ret = -errno;
+	}
+
+	return ret;
+}
+
@@ -125,6 +125,86 @@ static cJSON *cJSON_New_Item(void)
     return node;
 }
 
+/* Where the parser takes its memory from, the heap hooks unless an arena is given. */
+typedef struct
+{
+    cJSON_Arena *arena;
+    /* strings are unescaped in place and referenced from the input */
+    bool insitu;
+} parse_context;
+
+/* Nodes hold a double, keep them aligned for it. */
+#define CJSON_ARENA_ALIGN sizeof(double)
+
+/* Nodes are taken from the bottom of the arena and strings, which need no alignment, from the top,
+ * so no padding is lost between them. */
+static cJSON *cJSON_arena_node(cJSON_Arena *arena)
+{
+    size_t pad = (CJSON_ARENA_ALIGN - ((size_t)(arena->buffer + arena->head) & (CJSON_ARENA_ALIGN - 1))) & (CJSON_ARENA_ALIGN - 1);
+
+    if ((arena->tail - arena->head) < pad || (arena->tail - arena->head - pad) < sizeof(cJSON))
+    {
+        return NULL;
+    }
+    arena->head += pad + sizeof(cJSON);
+    arena->used += pad + sizeof(cJSON);
+
+    return (cJSON*)(arena->buffer + arena->head - sizeof(cJSON));
+}
+
+static char *cJSON_arena_string(cJSON_Arena *arena, size_t size)
+{
+    if ((arena->tail - arena->head) < size)
+    {
+        return NULL;
+    }
+    arena->tail -= size;
+    arena->used += size;
+
+    return arena->buffer + arena->tail;
+}
+
+static cJSON *parse_new_item(const parse_context *ctx)
+{
+    cJSON *node = NULL;
+
+    if (!ctx->arena)
+    {
+        return cJSON_New_Item();
+    }
+    node = cJSON_arena_node(ctx->arena);
+    if (node)
+    {
+        memset(node, '\0', sizeof(cJSON));
+    }
+
+    return node;
+}
+
+static char *parse_alloc_string(const parse_context *ctx, size_t size)
+{
+    if (!ctx->arena)
+    {
+        return (char*)cJSON_malloc(size);
+    }
+
+    return cJSON_arena_string(ctx->arena, size);
+}
+
+void cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size)
+{
+    arena->buffer = (char*)buffer;
+    arena->size = buffer ? size : 0;
+    cJSON_ResetArena(arena);
+}
+
+void cJSON_ResetArena(cJSON_Arena *arena)
+{
+    arena->used = 0;
+    arena->head = 0;
+    arena->tail = arena->size;
+}
+
 /* Delete a cJSON structure. */
 void cJSON_Delete(cJSON *c)
 {
@@ -470,7 +550,7 @@ static const unsigned char firstByteMark[7] =
 };
 
 /* Parse the input text into an unescaped cstring, and populate item. */
-static const char *parse_string(cJSON *item, const char *str, const char **ep)
+static const char *parse_string(cJSON *item, const char *str, const char **ep, const parse_context *ctx)
 {
     const char *ptr = str + 1;
     const char *end_ptr =str + 1;
@@ -479,6 +559,7 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
     int len = 0;
     unsigned uc = 0;
     unsigned uc2 = 0;
+    bool closed = false;
 
     /* not a string! */
     if (*str != '\"')
@@ -501,11 +582,21 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
         }
     }
 
-    /* This is at most how long we need for the string, roughly. */
-    out = (char*)cJSON_malloc(len + 1);
-    if (!out)
+    closed = (*end_ptr == '\"');
+
+    if (ctx->insitu)
     {
-        return NULL;
+        /* unescaping never lengthens the string, write it over itself and terminate at (or before) the quote */
+        out = (char*)str + 1;
+    }
+    else
+    {
+        /* This is at most how long we need for the string, roughly. */
+        out = parse_alloc_string(ctx, len + 1);
+        if (!out)
+        {
+            return NULL;
+        }
     }
     item->valuestring = out; /* assign here so out will be deleted during cJSON_Delete() later */
     item->type = cJSON_String;
@@ -638,7 +729,7 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
         }
     }
     *ptr2 = '\0';
-    if (*ptr == '\"')
+    if (closed)
     {
         ptr++;
     }
@@ -798,11 +889,11 @@ static char *print_string(const cJSON *item, printbuffer *p)
 }
 
 /* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep);
+static const char *parse_value(cJSON *item, const char *value, const char **ep, const parse_context *ctx);
 static char *print_value(const cJSON *item, int depth, bool fmt, printbuffer *p);
-static const char *parse_array(cJSON *item, const char *value, const char **ep);
+static const char *parse_array(cJSON *item, const char *value, const char **ep, const parse_context *ctx);
 static char *print_array(const cJSON *item, int depth, bool fmt, printbuffer *p);
-static const char *parse_object(cJSON *item, const char *value, const char **ep);
+static const char *parse_object(cJSON *item, const char *value, const char **ep, const parse_context *ctx);
 static char *print_object(const cJSON *item, int depth, bool fmt, printbuffer *p);
 
 /* Utility to jump whitespace and cr/lf */
@@ -822,6 +913,7 @@ cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, boo
     const char *end = NULL;
     /* use global error pointer if no specific one was given */
     const char **ep = return_parse_end ? return_parse_end : &global_ep;
+    parse_context ctx = { NULL, false };
     cJSON *c = cJSON_New_Item();
     *ep = NULL;
     if (!c) /* memory fail */
@@ -829,7 +921,7 @@ cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, boo
         return NULL;
     }
 
-    end = parse_value(c, skip(value), ep);
+    end = parse_value(c, skip(value), ep, &ctx);
     if (!end)
     {
         /* parse failure. ep is set. */
@@ -862,6 +954,54 @@ cJSON *cJSON_Parse(const char *value)
     return cJSON_ParseWithOpts(value, 0, 0);
 }
 
+/* Parse into an arena. On failure the arena is rewound to where it was, so nothing is lost. */
+static cJSON *parse_with_arena(const char *value, const parse_context *ctx)
+{
+    const char *end = NULL;
+    cJSON_Arena mark = *ctx->arena;
+    cJSON *c = NULL;
+
+    global_ep = NULL;
+    c = parse_new_item(ctx);
+    if (!c) /* arena full */
+    {
+        return NULL;
+    }
+
+    end = parse_value(c, skip(value), &global_ep, ctx);
+    if (!end)
+    {
+        *ctx->arena = mark;
+        return NULL;
+    }
+
+    return c;
+}
+
+cJSON *cJSON_ParseWithArena(const char *value, cJSON_Arena *arena)
+{
+    parse_context ctx = { arena, false };
+
+    if (!arena)
+    {
+        return NULL;
+    }
+
+    return parse_with_arena(value, &ctx);
+}
+
+cJSON *cJSON_ParseInSitu(char *value, cJSON_Arena *arena)
+{
+    parse_context ctx = { arena, true };
+
+    if (!arena)
+    {
+        return NULL;
+    }
+
+    return parse_with_arena(value, &ctx);
+}
+
 /* Render a cJSON item/entity/structure to text. */
 char *cJSON_Print(const cJSON *item)
 {
@@ -889,7 +1029,7 @@ char *cJSON_PrintBuffered(const cJSON *item, int prebuffer, bool fmt)
 
 
 /* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep)
+static const char *parse_value(cJSON *item, const char *value, const char **ep, const parse_context *ctx)
 {
     if (!value)
     {
@@ -916,7 +1056,7 @@ static const char *parse_value(cJSON *item, const char *value, const char **ep)
     }
     if (*value == '\"')
     {
-        return parse_string(item, value, ep);
+        return parse_string(item, value, ep, ctx);
     }
     if ((*value == '-') || ((*value >= '0') && (*value <= '9')))
     {
@@ -924,11 +1064,11 @@ static const char *parse_value(cJSON *item, const char *value, const char **ep)
     }
     if (*value == '[')
     {
-        return parse_array(item, value, ep);
+        return parse_array(item, value, ep, ctx);
     }
     if (*value == '{')
     {
-        return parse_object(item, value, ep);
+        return parse_object(item, value, ep, ctx);
     }
 
     /* failure. */
@@ -1016,7 +1156,7 @@ static char *print_value(const cJSON *item, int depth, bool fmt, printbuffer *p)
 }
 
 /* Build an array from input text. */
-static const char *parse_array(cJSON *item,const char *value,const char **ep)
+static const char *parse_array(cJSON *item, const char *value, const char **ep, const parse_context *ctx)
 {
     cJSON *child = NULL;
     if (*value != '[')
@@ -1034,14 +1174,14 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         return value + 1;
     }
 
-    item->child = child = cJSON_New_Item();
+    item->child = child = parse_new_item(ctx);
     if (!item->child)
     {
         /* memory fail */
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value), ep));
+    value = skip(parse_value(child, skip(value), ep, ctx));
     if (!value)
     {
         return NULL;
@@ -1051,7 +1191,7 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
     while (*value == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = parse_new_item(ctx)))
         {
             /* memory fail */
             return NULL;
@@ -1062,7 +1202,7 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         child = new_item;
 
         /* go to the next comma */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(parse_value(child, skip(value + 1), ep, ctx));
         if (!value)
         {
             /* memory fail */
@@ -1249,7 +1389,7 @@ static char *print_array(const cJSON *item, int depth, bool fmt, printbuffer *p)
 }
 
 /* Build an object from the text. */
-static const char *parse_object(cJSON *item, const char *value, const char **ep)
+static const char *parse_object(cJSON *item, const char *value, const char **ep, const parse_context *ctx)
 {
     cJSON *child = NULL;
     if (*value != '{')
@@ -1267,14 +1407,14 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         return value + 1;
     }
 
-    child = cJSON_New_Item();
+    child = parse_new_item(ctx);
     item->child = child;
     if (!item->child)
     {
         return NULL;
     }
     /* parse first key */
-    value = skip(parse_string(child, skip(value), ep));
+    value = skip(parse_string(child, skip(value), ep, ctx));
     if (!value)
     {
         return NULL;
@@ -1290,7 +1430,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value + 1), ep));
+    value = skip(parse_value(child, skip(value + 1), ep, ctx));
     if (!value)
     {
         return NULL;
@@ -1299,7 +1439,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
     while (*value == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = parse_new_item(ctx)))
         {
             /* memory fail */
             return NULL;
@@ -1309,7 +1449,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         new_item->prev = child;
 
         child = new_item;
-        value = skip(parse_string(child, skip(value + 1), ep));
+        value = skip(parse_string(child, skip(value + 1), ep, ctx));
         if (!value)
         {
             return NULL;
@@ -1326,7 +1466,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
             return NULL;
         }
         /* skip any spacing, get the value. */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(parse_value(child, skip(value + 1), ep, ctx));
         if (!value)
         {
             return NULL;
@@ -74,6 +74,22 @@ typedef struct cJSON_Hooks
 /* Supply malloc, realloc and free functions to cJSON */
 extern void cJSON_InitHooks(cJSON_Hooks* hooks);
 
+/* A caller-provided block that a parsed tree is carved out of instead of the heap. */
+typedef struct cJSON_Arena
+{
+    char *buffer;
+    size_t size;
+    /* bytes taken so far, check it after a parse to size the buffer */
+    size_t used;
+    /* nodes are taken below head, strings above tail */
+    size_t head;
+    size_t tail;
+} cJSON_Arena;
+
+extern void cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size);
+/* Forget every tree parsed into the arena, so the buffer can be reused or freed. */
+extern void cJSON_ResetArena(cJSON_Arena *arena);
+
 
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. Call cJSON_Delete when finished. */
 extern cJSON *cJSON_Parse(const char *value);
@@ -141,6 +157,17 @@ The item->next and ->prev pointers are always zero on return from Duplicate. */
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error. If not, then cJSON_GetErrorPtr() does the job. */
 extern cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, int require_null_terminated);
 
+/* Parse into an arena: every node and string comes from it, so the tree costs no heap allocations
+and is released all at once with cJSON_ResetArena() or by freeing the arena buffer.
+Don't cJSON_Delete() such a tree or any of its items, and don't add heap items to it; use
+cJSON_Duplicate() for a part that has to outlive the arena. Returns NULL on a parse error or
+when the arena is too small, leaving the arena as it was. */
+extern cJSON *cJSON_ParseWithArena(const char *value, cJSON_Arena *arena);
+/* As cJSON_ParseWithArena(), but strings and keys are unescaped in place and point into value,
+which must be writable and outlive the tree. Only the nodes come from the arena.
+value is modified even if the parse fails. */
+extern cJSON *cJSON_ParseInSitu(char *value, cJSON_Arena *arena);
+
 extern void cJSON_Minify(char *json);
 
 /* Macros for creating things quickly. */
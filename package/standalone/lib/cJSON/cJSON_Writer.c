@@ -0,0 +1,415 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/* Streaming JSON writer, see cJSON_Writer.h. */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "cJSON_Writer.h"
+
+#define WRITER_BIT(depth) (1UL << (depth))
+
+/* Numbers below this with at most this many decimals are formatted without printf */
+#define WRITER_FAST_LIMIT 1.0e9
+#define WRITER_FAST_SCALE 1000000
+#define WRITER_FAST_DECIMALS 6
+
+/* Write the digits of n to the end of a buffer, returning where they start. */
+static char *writer_digits(char *end, unsigned long n)
+{
+    do
+    {
+        *--end = (char)('0' + (n % 10));
+        n /= 10;
+    } while (n);
+
+    return end;
+}
+
+void cJSON_WriterInit(cJSON_Writer *w, char *buffer, size_t size, cJSON_WriterSink sink, void *sink_arg)
+{
+    memset(w, 0, sizeof(cJSON_Writer));
+    w->buffer = buffer;
+    w->size = size;
+    w->sink = sink;
+    w->sink_arg = sink_arg;
+    /* the document itself takes one value */
+    w->empty = WRITER_BIT(0);
+
+    /* a fixed buffer keeps room for the terminating NUL */
+    if (!buffer || (size < (sink ? 1 : 2)))
+    {
+        w->error = 1;
+    }
+}
+
+static int writer_flush(cJSON_Writer *w)
+{
+    if (w->length > 0)
+    {
+        if (!w->sink || (w->sink(w->sink_arg, w->buffer, w->length) < 0))
+        {
+            w->error = 1;
+            return -1;
+        }
+        w->length = 0;
+    }
+
+    return 0;
+}
+
+static int writer_put(cJSON_Writer *w, const char *data, size_t len)
+{
+    size_t capacity = w->sink ? w->size : (w->size - 1);
+    size_t room = 0;
+
+    if (w->error)
+    {
+        return -1;
+    }
+
+    while (len > 0)
+    {
+        room = capacity - w->length;
+        if (room == 0)
+        {
+            if (writer_flush(w) < 0)
+            {
+                return -1;
+            }
+            continue;
+        }
+        if (room > len)
+        {
+            room = len;
+        }
+        memcpy(w->buffer + w->length, data, room);
+        w->length += room;
+        w->total += room;
+        data += room;
+        len -= room;
+    }
+
+    return 0;
+}
+
+/* Quote and escape a string, copying the runs between characters that need escaping in one go. */
+static int writer_put_string(cJSON_Writer *w, const char *str)
+{
+    const unsigned char *run = (const unsigned char*)str;
+    const unsigned char *ptr = NULL;
+    char esc[8];
+    const char *seq = NULL;
+
+    writer_put(w, "\"", 1);
+    for (ptr = run; *ptr; ptr++)
+    {
+        if ((*ptr >= 32) && (*ptr != '\"') && (*ptr != '\\'))
+        {
+            continue;
+        }
+        writer_put(w, (const char*)run, ptr - run);
+        switch (*ptr)
+        {
+            case '\"':
+                seq = "\\\"";
+                break;
+            case '\\':
+                seq = "\\\\";
+                break;
+            case '\b':
+                seq = "\\b";
+                break;
+            case '\f':
+                seq = "\\f";
+                break;
+            case '\n':
+                seq = "\\n";
+                break;
+            case '\r':
+                seq = "\\r";
+                break;
+            case '\t':
+                seq = "\\t";
+                break;
+            default:
+                /* escape and print as unicode codepoint */
+                sprintf(esc, "\\u%04x", *ptr);
+                seq = esc;
+                break;
+        }
+        writer_put(w, seq, strlen(seq));
+        run = ptr + 1;
+    }
+    writer_put(w, (const char*)run, ptr - run);
+
+    return writer_put(w, "\"", 1);
+}
+
+/* Separator and member name in front of a value. */
+static int writer_begin_value(cJSON_Writer *w, const char *name)
+{
+    unsigned long bit = WRITER_BIT(w->depth);
+
+    if (w->error)
+    {
+        return -1;
+    }
+    /* names inside objects only, and one value at the top */
+    if ((!(w->object & bit) != !name) || ((w->depth == 0) && !(w->empty & bit)))
+    {
+        w->error = 1;
+        return -1;
+    }
+
+    if (!(w->empty & bit))
+    {
+        writer_put(w, ",", 1);
+    }
+    w->empty &= ~bit;
+
+    if (name)
+    {
+        writer_put_string(w, name);
+        writer_put(w, ":", 1);
+    }
+
+    return w->error ? -1 : 0;
+}
+
+static int writer_start(cJSON_Writer *w, const char *name, int object)
+{
+    if (writer_begin_value(w, name) < 0)
+    {
+        return -1;
+    }
+    if ((w->depth + 1) >= CJSON_WRITER_MAX_DEPTH)
+    {
+        w->error = 1;
+        return -1;
+    }
+
+    w->depth++;
+    w->empty |= WRITER_BIT(w->depth);
+    if (object)
+    {
+        w->object |= WRITER_BIT(w->depth);
+    }
+    else
+    {
+        w->object &= ~WRITER_BIT(w->depth);
+    }
+
+    return writer_put(w, object ? "{" : "[", 1);
+}
+
+static int writer_end(cJSON_Writer *w, int object)
+{
+    if (w->error)
+    {
+        return -1;
+    }
+    if ((w->depth == 0) || (!(w->object & WRITER_BIT(w->depth)) != !object))
+    {
+        w->error = 1;
+        return -1;
+    }
+    w->depth--;
+
+    return writer_put(w, object ? "}" : "]", 1);
+}
+
+int cJSON_WriterStartObject(cJSON_Writer *w, const char *name)
+{
+    return writer_start(w, name, 1);
+}
+
+int cJSON_WriterEndObject(cJSON_Writer *w)
+{
+    return writer_end(w, 1);
+}
+
+int cJSON_WriterStartArray(cJSON_Writer *w, const char *name)
+{
+    return writer_start(w, name, 0);
+}
+
+int cJSON_WriterEndArray(cJSON_Writer *w)
+{
+    return writer_end(w, 0);
+}
+
+int cJSON_WriterAddString(cJSON_Writer *w, const char *name, const char *string)
+{
+    if (!string)
+    {
+        return cJSON_WriterAddNull(w, name);
+    }
+    if (writer_begin_value(w, name) < 0)
+    {
+        return -1;
+    }
+
+    return writer_put_string(w, string);
+}
+
+int cJSON_WriterAddNumber(cJSON_Writer *w, const char *name, double number)
+{
+    char buf[32];
+    int len = 0;
+
+    if (writer_begin_value(w, name) < 0)
+    {
+        return -1;
+    }
+
+    /* This checks for NaN and Infinity, neither can be written in JSON */
+    if ((number * 0) != 0)
+    {
+        return writer_put(w, "null", 4);
+    }
+
+    /* Sensor values mostly have a few decimals. If number is n / 10^6 for an integer n, printing n
+     * with the point moved reads back exactly, as the division is correctly rounded like strtod(). */
+    if (fabs(number) < WRITER_FAST_LIMIT)
+    {
+        double scaled = floor(fabs(number) * WRITER_FAST_SCALE + 0.5);
+
+        if ((scaled / WRITER_FAST_SCALE) == fabs(number))
+        {
+            unsigned long long n = (unsigned long long)scaled;
+            unsigned long frac = (unsigned long)(n % WRITER_FAST_SCALE);
+            char *end = buf + sizeof(buf);
+            char *ptr = end;
+            int decimals = WRITER_FAST_DECIMALS;
+
+            if (frac)
+            {
+                while ((frac % 10) == 0)
+                {
+                    frac /= 10;
+                    decimals--;
+                }
+                ptr = writer_digits(end, frac);
+                while ((end - ptr) < decimals)
+                {
+                    *--ptr = '0';
+                }
+                *--ptr = '.';
+            }
+            ptr = writer_digits(ptr, (unsigned long)(n / WRITER_FAST_SCALE));
+            if ((number < 0) && n)
+            {
+                *--ptr = '-';
+            }
+
+            return writer_put(w, ptr, end - ptr);
+        }
+    }
+
+    /* shortest of 15 digits that reads back the same, else the full 17 */
+    len = snprintf(buf, sizeof(buf), "%1.15g", number);
+    if (strtod(buf, NULL) != number)
+    {
+        len = snprintf(buf, sizeof(buf), "%1.17g", number);
+    }
+
+    return writer_put(w, buf, len);
+}
+
+int cJSON_WriterAddInt(cJSON_Writer *w, const char *name, long number)
+{
+    char buf[24];
+    char *ptr = NULL;
+    unsigned long n = (number < 0) ? (0UL - (unsigned long)number) : (unsigned long)number;
+
+    if (writer_begin_value(w, name) < 0)
+    {
+        return -1;
+    }
+
+    ptr = writer_digits(buf + sizeof(buf), n);
+    if (number < 0)
+    {
+        *--ptr = '-';
+    }
+
+    return writer_put(w, ptr, buf + sizeof(buf) - ptr);
+}
+
+int cJSON_WriterAddBool(cJSON_Writer *w, const char *name, int b)
+{
+    if (writer_begin_value(w, name) < 0)
+    {
+        return -1;
+    }
+
+    return b ? writer_put(w, "true", 4) : writer_put(w, "false", 5);
+}
+
+int cJSON_WriterAddNull(cJSON_Writer *w, const char *name)
+{
+    if (writer_begin_value(w, name) < 0)
+    {
+        return -1;
+    }
+
+    return writer_put(w, "null", 4);
+}
+
+int cJSON_WriterAddRaw(cJSON_Writer *w, const char *name, const char *json)
+{
+    if (!json || (writer_begin_value(w, name) < 0))
+    {
+        w->error = 1;
+        return -1;
+    }
+
+    return writer_put(w, json, strlen(json));
+}
+
+int cJSON_WriterFinish(cJSON_Writer *w)
+{
+    if (w->error || (w->depth != 0) || (w->empty & WRITER_BIT(0)))
+    {
+        return -1;
+    }
+
+    if (w->sink)
+    {
+        if (writer_flush(w) < 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        w->buffer[w->length] = '\0';
+    }
+
+    return (int)w->total;
+}
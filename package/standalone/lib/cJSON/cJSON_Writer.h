@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef cJSON_Writer__h
+#define cJSON_Writer__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+/* Streaming JSON writer: emits objects and arrays as they are described, without building a cJSON tree
+ * and without allocating. Output goes into a fixed buffer, or through the buffer to a sink in chunks.
+ *
+ * MQTT publish, the payload is written into a buffer that is then published:
+ *
+ *     cJSON_WriterInit(&w, payload, sizeof(payload), NULL, NULL);
+ *     cJSON_WriterStartObject(&w, NULL);
+ *     cJSON_WriterAddInt(&w, "seq", seq);
+ *     cJSON_WriterAddNumber(&w, "temperature", temperature);
+ *     cJSON_WriterEndObject(&w);
+ *     message.payloadlen = cJSON_WriterFinish(&w);
+ *
+ * httpd chunked response, each full buffer is sent as a chunk:
+ *
+ *     static int send_chunk(void *arg, const char *data, size_t len)
+ *     {
+ *         return httpd_resp_send_chunk((httpd_req_t *)arg, data, len) == ESP_OK ? 0 : -1;
+ *     }
+ *
+ *     cJSON_WriterInit(&w, chunk, sizeof(chunk), send_chunk, req);
+ *     ...
+ *     if (cJSON_WriterFinish(&w) >= 0)
+ *         httpd_resp_send_chunk(req, NULL, 0);
+ */
+
+/* Levels of nesting counting the document itself, one bit of state per level. */
+#define CJSON_WRITER_MAX_DEPTH 32
+
+/* Takes len bytes of output, returns 0 or a negative value to stop the writer. */
+typedef int (*cJSON_WriterSink)(void *arg, const char *data, size_t len);
+
+typedef struct cJSON_Writer
+{
+    char *buffer;
+    size_t size;
+    /* bytes in buffer not yet given to the sink */
+    size_t length;
+    /* bytes written in all */
+    size_t total;
+    cJSON_WriterSink sink;
+    void *sink_arg;
+    int depth;
+    /* per level: container is an object, no member written yet */
+    unsigned long object;
+    unsigned long empty;
+    /* set by the first misuse, full buffer or sink failure, every later call fails */
+    int error;
+} cJSON_Writer;
+
+/* Without a sink the whole document must fit in size - 1 bytes, it is NUL terminated by cJSON_WriterFinish().
+With a sink the buffer is flushed to it whenever it fills up. */
+extern void cJSON_WriterInit(cJSON_Writer *w, char *buffer, size_t size, cJSON_WriterSink sink, void *sink_arg);
+
+/* name is the member name inside an object and must be NULL anywhere else. All return 0 or -1. */
+extern int cJSON_WriterStartObject(cJSON_Writer *w, const char *name);
+extern int cJSON_WriterEndObject(cJSON_Writer *w);
+extern int cJSON_WriterStartArray(cJSON_Writer *w, const char *name);
+extern int cJSON_WriterEndArray(cJSON_Writer *w);
+extern int cJSON_WriterAddString(cJSON_Writer *w, const char *name, const char *string);
+extern int cJSON_WriterAddNumber(cJSON_Writer *w, const char *name, double number);
+extern int cJSON_WriterAddInt(cJSON_Writer *w, const char *name, long number);
+extern int cJSON_WriterAddBool(cJSON_Writer *w, const char *name, int b);
+extern int cJSON_WriterAddNull(cJSON_Writer *w, const char *name);
+/* Adds already formatted JSON as a value, e.g. a cached fragment. */
+extern int cJSON_WriterAddRaw(cJSON_Writer *w, const char *name, const char *json);
+
+/* Checks that every object and array was closed and flushes the rest to the sink.
+Returns the length of the document, or -1 if anything went wrong. */
+extern int cJSON_WriterFinish(cJSON_Writer *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
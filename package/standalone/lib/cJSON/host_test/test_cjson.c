@@ -0,0 +1,841 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Host test and benchmark of cJSON arena and in-situ parsing and of the streaming writer.
+ *
+ *   test_cjson                     all tests
+ *   test_cjson parse [payload]     one test, or one payload of parse (shadow, jobs, fota, onem2m)
+ *   test_cjson write
+ *
+ * parse: each payload is parsed onto the heap, into an arena and in situ. The trees are checked to
+ * print the same, and the parse time, heap allocations and peak heap of each mode are reported.
+ * The peak is also given as heap_4 would count it, with an 8 byte header per block rounded up
+ * to 8 bytes, which is what fragments a long-running device.
+ *
+ * write: a sensor telemetry message is produced by building a cJSON tree and printing it, and by
+ * cJSON_Writer into a fixed buffer and through a chunked sink. The outputs must read back the same;
+ * throughput and heap use of both paths are reported. Escaping, number formatting and misuse of
+ * the writer are checked separately.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <math.h>
+
+#include "cJSON.h"
+#include "cJSON_Writer.h"
+
+#define TEST_CJSON_ITERATIONS	20000
+#define TEST_CJSON_ARENA_SIZE	8192
+
+#define TEST_CJSON_HEAP4_HEADER	8
+#define TEST_CJSON_HEAP4_ALIGN	8
+
+typedef struct
+{
+	const char *name;
+	const char *json;
+} test_cjson_payload;
+
+static const test_cjson_payload s_test_cjson_payloads[] =
+{
+	/* AWS IoT device shadow update/documents, as received by sample_aws_iot_sensor */
+	{ "shadow",
+		"{\"previous\":{\"state\":{\"desired\":{\"interval\":30,\"led\":\"off\",\"threshold\":{\"temperature\":28.5,\"humidity\":70}},"
+		"\"reported\":{\"interval\":30,\"led\":\"off\",\"temperature\":24.375,\"humidity\":51.25,\"pressure\":1013.2,"
+		"\"battery\":3.71,\"rssi\":-67,\"fw\":\"1.4.2\",\"uptime\":86412}},"
+		"\"metadata\":{\"desired\":{\"interval\":{\"timestamp\":1666080011},\"led\":{\"timestamp\":1666080011},"
+		"\"threshold\":{\"temperature\":{\"timestamp\":1666080011},\"humidity\":{\"timestamp\":1666080011}}},"
+		"\"reported\":{\"interval\":{\"timestamp\":1666080342},\"led\":{\"timestamp\":1666080342},\"temperature\":{\"timestamp\":1666080342},"
+		"\"humidity\":{\"timestamp\":1666080342},\"pressure\":{\"timestamp\":1666080342},\"battery\":{\"timestamp\":1666080342},"
+		"\"rssi\":{\"timestamp\":1666080342},\"fw\":{\"timestamp\":1666080342},\"uptime\":{\"timestamp\":1666080342}}},\"version\":1187},"
+		"\"current\":{\"state\":{\"desired\":{\"interval\":10,\"led\":\"on\",\"threshold\":{\"temperature\":28.5,\"humidity\":70}},"
+		"\"reported\":{\"interval\":30,\"led\":\"off\",\"temperature\":24.375,\"humidity\":51.25,\"pressure\":1013.2,"
+		"\"battery\":3.71,\"rssi\":-67,\"fw\":\"1.4.2\",\"uptime\":86412}},"
+		"\"metadata\":{\"desired\":{\"interval\":{\"timestamp\":1666080399},\"led\":{\"timestamp\":1666080399}}},\"version\":1188},"
+		"\"timestamp\":1666080399,\"clientToken\":\"halow-sensor-0042-7f3a\"}" },
+
+	/* AWS IoT jobs notification with a pending execution list */
+	{ "jobs",
+		"{\"timestamp\":1666080400,\"jobs\":{\"QUEUED\":[{\"jobId\":\"ota-2022-10-18-0042\",\"queuedAt\":1666080300,"
+		"\"lastUpdatedAt\":1666080300,\"executionNumber\":1,\"versionNumber\":1},{\"jobId\":\"reboot-maint\\/weekly\","
+		"\"queuedAt\":1666080350,\"lastUpdatedAt\":1666080350,\"executionNumber\":3,\"versionNumber\":1}],"
+		"\"IN_PROGRESS\":[]},\"execution\":{\"jobId\":\"ota-2022-10-18-0042\",\"status\":\"QUEUED\",\"jobDocument\":"
+		"{\"operation\":\"fota\",\"url\":\"https:\\/\\/fw.example.com\\/halow\\/nrc7292_1.4.3.bin\",\"crc\":\"9a3f01c7\","
+		"\"size\":712704,\"notes\":\"fixes \\\"beacon loss\\\" on \\u00e9t\\u00e9 firmware \\ud83d\\ude80\\n\"}}}" },
+
+	/* FOTA info file read by _atcmd_fota_info_parse() */
+	{ "fota",
+		"{\n\t\"AT_SDK_VER\": \"1.4.2\",\n\t\"AT_CMD_VER\": \"1.23.0\",\n"
+		"\t\"AT_HSPI_BIN\": \"nrc7292_standalone_xip_ATCMD_HSPI.bin\",\n\t\"AT_HSPI_CRC\": \"3c1d9e42\",\n"
+		"\t\"AT_UART_BIN\": \"nrc7292_standalone_xip_ATCMD_UART.bin\",\n\t\"AT_UART_CRC\": \"b7e0a115\",\n"
+		"\t\"AT_UART_HFC_BIN\": \"nrc7292_standalone_xip_ATCMD_UART_HFC.bin\",\n\t\"AT_UART_HFC_CRC\": \"04f2c6d8\"\n}\n" },
+
+	/* oneM2M AE registration from sample_json */
+	{ "onem2m",
+		"{\"fr\":\"S\",\"op\":1,\"pc\":{\"m2m:ae\":{\"api\":\"A01.com.farm.sensor01\",\"rr\":true,"
+		"\"poa\":[\"mqtt://sensor01.farm.com\"],\"rn\":\"sensor_ae01\"}},\"rqi\":\"m_createAE142308\","
+		"\"to\":\"/CSE3409165/farm_gateway\",\"ty\":2}" },
+};
+
+#define TEST_CJSON_PAYLOADS		(int)(sizeof(s_test_cjson_payloads) / sizeof(s_test_cjson_payloads[0]))
+
+/* Heap accounting */
+
+static size_t s_heap_current;
+static size_t s_heap_peak;
+static size_t s_heap4_current;
+static size_t s_heap4_peak;
+static int s_heap_allocs;
+
+static size_t test_cjson_heap4_size (size_t size)
+{
+	return (size + TEST_CJSON_HEAP4_HEADER + TEST_CJSON_HEAP4_ALIGN - 1) & ~(size_t)(TEST_CJSON_HEAP4_ALIGN - 1);
+}
+
+void *pvPortMalloc (size_t size)
+{
+	size_t *block = malloc(sizeof(size_t) * 2 + size);
+
+	if (!block)
+		return NULL;
+
+	block[0] = size;
+
+	s_heap_allocs++;
+	s_heap_current += size;
+	s_heap4_current += test_cjson_heap4_size(size);
+
+	if (s_heap_current > s_heap_peak)
+		s_heap_peak = s_heap_current;
+	if (s_heap4_current > s_heap4_peak)
+		s_heap4_peak = s_heap4_current;
+
+	return block + 2;
+}
+
+void vPortFree (void *ptr)
+{
+	size_t *block = ptr;
+
+	if (!block)
+		return;
+
+	block -= 2;
+
+	s_heap_current -= block[0];
+	s_heap4_current -= test_cjson_heap4_size(block[0]);
+
+	free(block);
+}
+
+static void test_cjson_heap_reset (void)
+{
+	s_heap_peak = s_heap_current;
+	s_heap4_peak = s_heap4_current;
+	s_heap_allocs = 0;
+}
+
+static double test_cjson_now_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+/* Correctness */
+
+static char s_arena_buf[TEST_CJSON_ARENA_SIZE] __attribute__((aligned(8)));
+static char s_insitu_buf[TEST_CJSON_ARENA_SIZE];
+
+static int test_cjson_same (const char *name, const char *mode, cJSON *expected, cJSON *tree)
+{
+	char *a = cJSON_PrintUnformatted(expected);
+	char *b = cJSON_PrintUnformatted(tree);
+	int ret = 0;
+
+	if (!a || !b || strcmp(a, b) != 0)
+	{
+		printf("  %s: %s tree differs\n    heap: %s\n    %s: %s\n", name, mode, a, mode, b);
+		ret = -1;
+	}
+
+	vPortFree(a);
+	vPortFree(b);
+
+	return ret;
+}
+
+static int test_cjson_check (const test_cjson_payload *payload)
+{
+	cJSON_Arena arena;
+	cJSON *heap;
+	cJSON *tree;
+	cJSON *dup;
+	size_t used;
+	int ret = 0;
+
+	heap = cJSON_Parse(payload->json);
+	if (!heap)
+	{
+		printf("  %s: heap parse failed\n", payload->name);
+		return -1;
+	}
+
+	cJSON_InitArena(&arena, s_arena_buf, sizeof(s_arena_buf));
+
+	test_cjson_heap_reset();
+	tree = cJSON_ParseWithArena(payload->json, &arena);
+	if (!tree || s_heap_allocs != 0)
+	{
+		printf("  %s: arena parse %s, %d heap allocations\n", payload->name, tree ? "ok" : "failed", s_heap_allocs);
+		ret = -1;
+	}
+	else
+		ret |= test_cjson_same(payload->name, "arena", heap, tree);
+
+	/* a copy for use after the arena is gone */
+	dup = tree ? cJSON_Duplicate(tree, 1) : NULL;
+	used = arena.used;
+
+	/* too small by one byte: no tree, arena untouched */
+	cJSON_InitArena(&arena, s_arena_buf, used - 1);
+	if (cJSON_ParseWithArena(payload->json, &arena) || arena.used != 0)
+	{
+		printf("  %s: parse into %zu bytes of a %zu byte tree, %zu used\n", payload->name, used - 1, used, arena.used);
+		ret = -1;
+	}
+
+	cJSON_InitArena(&arena, s_arena_buf, sizeof(s_arena_buf));
+	strcpy(s_insitu_buf, payload->json);
+
+	test_cjson_heap_reset();
+	tree = cJSON_ParseInSitu(s_insitu_buf, &arena);
+	if (!tree || s_heap_allocs != 0)
+	{
+		printf("  %s: in-situ parse %s, %d heap allocations\n", payload->name, tree ? "ok" : "failed", s_heap_allocs);
+		ret = -1;
+	}
+	else
+		ret |= test_cjson_same(payload->name, "in-situ", heap, tree);
+
+	cJSON_ResetArena(&arena);
+	memset(s_arena_buf, 0xa5, sizeof(s_arena_buf));
+
+	if (dup)
+	{
+		ret |= test_cjson_same(payload->name, "duplicate", heap, dup);
+		cJSON_Delete(dup);
+	}
+
+	cJSON_Delete(heap);
+
+	return ret;
+}
+
+static int test_cjson_errors (void)
+{
+	static const char *bad[] =
+	{
+		"{\"a\":1,}",
+		"[1,2",
+		"{\"a\" 1}",
+		"{\"a\":\"\\q\"}",
+		"\"\\ud83d\"",
+	};
+	cJSON_Arena arena;
+	char buf[64];
+	int ret = 0;
+	int i;
+
+	cJSON_InitArena(&arena, s_arena_buf, sizeof(s_arena_buf));
+
+	for (i = 0 ; i < (int)(sizeof(bad) / sizeof(bad[0])) ; i++)
+	{
+		strcpy(buf, bad[i]);
+
+		if (cJSON_ParseWithArena(bad[i], &arena) || cJSON_ParseInSitu(buf, &arena) || arena.used != 0)
+		{
+			printf("  error: %s parsed, %zu arena bytes left in use\n", bad[i], arena.used);
+			ret = -1;
+		}
+	}
+
+	if (cJSON_ParseWithArena("{}", NULL) || cJSON_ParseInSitu(buf, NULL))
+	{
+		printf("  error: parsed without an arena\n");
+		ret = -1;
+	}
+
+	return ret;
+}
+
+/* Benchmark */
+
+enum
+{
+	TEST_CJSON_HEAP = 0,
+	TEST_CJSON_ARENA,
+	TEST_CJSON_INSITU,
+
+	TEST_CJSON_MODES
+};
+
+static const char *s_test_cjson_modes[TEST_CJSON_MODES] = { "heap", "arena", "in-situ" };
+
+static void test_cjson_bench (const test_cjson_payload *payload)
+{
+	cJSON_Arena arena;
+	double elapsed;
+	double start;
+	size_t peak = 0;
+	size_t heap4_peak = 0;
+	int allocs = 0;
+	int mode;
+	int i;
+
+	cJSON_InitArena(&arena, s_arena_buf, sizeof(s_arena_buf));
+
+	printf("  %s, %zu bytes\n", payload->name, strlen(payload->json));
+
+	for (mode = 0 ; mode < TEST_CJSON_MODES ; mode++)
+	{
+		elapsed = 0;
+
+		for (i = 0 ; i < TEST_CJSON_ITERATIONS ; i++)
+		{
+			cJSON *tree;
+
+			if (mode == TEST_CJSON_INSITU)
+				strcpy(s_insitu_buf, payload->json);
+
+			cJSON_ResetArena(&arena);
+			test_cjson_heap_reset();
+
+			start = test_cjson_now_us();
+
+			switch (mode)
+			{
+				case TEST_CJSON_HEAP:
+					tree = cJSON_Parse(payload->json);
+					break;
+
+				case TEST_CJSON_ARENA:
+					tree = cJSON_ParseWithArena(payload->json, &arena);
+					break;
+
+				default:
+					tree = cJSON_ParseInSitu(s_insitu_buf, &arena);
+			}
+
+			if (mode == TEST_CJSON_HEAP)
+			{
+				allocs = s_heap_allocs;
+				peak = s_heap_peak;
+				heap4_peak = s_heap4_peak;
+
+				cJSON_Delete(tree);
+			}
+			else
+			{
+				allocs = s_heap_allocs;
+				peak = arena.used;
+				heap4_peak = 0;
+			}
+
+			elapsed += test_cjson_now_us() - start;
+		}
+
+		printf("    %-8s %7.2f us/parse  %4d allocs  %5zu bytes peak", s_test_cjson_modes[mode],
+					elapsed / TEST_CJSON_ITERATIONS, allocs, peak);
+
+		if (mode == TEST_CJSON_HEAP)
+			printf(" (%zu in heap_4)\n", heap4_peak);
+		else
+			printf(" (arena)\n");
+	}
+}
+
+static int test_cjson_parse (int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	printf("parse:\n");
+
+	for (i = 0 ; i < TEST_CJSON_PAYLOADS ; i++)
+	{
+		if (argc > 1 && strcmp(argv[1], s_test_cjson_payloads[i].name) != 0)
+			continue;
+
+		ret |= test_cjson_check(&s_test_cjson_payloads[i]);
+		test_cjson_bench(&s_test_cjson_payloads[i]);
+	}
+
+	ret |= test_cjson_errors();
+
+	return ret;
+}
+
+/* Streaming writer */
+
+#define TEST_CJSON_TELEMETRY_SIZE	512
+#define TEST_CJSON_CHUNK_SIZE		16
+
+typedef struct
+{
+	const char *device;
+	long seq;
+	long timestamp;
+	double temperature;
+	double humidity;
+	double pressure;
+	double battery;
+	int rssi;
+	int motion;
+	double samples[8];
+	const char *fw;
+	long uptime;
+	const char *note;
+} test_cjson_telemetry;
+
+static const test_cjson_telemetry s_telemetry =
+{
+	"halow-sensor-0042", 18231, 1666080399,
+	24.375, 51.25, 1013.2, 3.71, -67, 0,
+	{ 24.25, 24.3125, 24.375, 24.4, 24.375, 24.3, 24.25, 24.1875 },
+	"1.4.2", 86412, "door \"B\" closed\n"
+};
+
+static char *test_cjson_tree_print (const test_cjson_telemetry *t)
+{
+	cJSON *root = cJSON_CreateObject();
+	cJSON *status = NULL;
+	char *out = NULL;
+
+	cJSON_AddStringToObject(root, "device", t->device);
+	cJSON_AddNumberToObject(root, "seq", t->seq);
+	cJSON_AddNumberToObject(root, "ts", t->timestamp);
+	cJSON_AddNumberToObject(root, "temperature", t->temperature);
+	cJSON_AddNumberToObject(root, "humidity", t->humidity);
+	cJSON_AddNumberToObject(root, "pressure", t->pressure);
+	cJSON_AddNumberToObject(root, "battery", t->battery);
+	cJSON_AddNumberToObject(root, "rssi", t->rssi);
+	cJSON_AddBoolToObject(root, "motion", t->motion);
+	cJSON_AddItemToObject(root, "samples", cJSON_CreateDoubleArray(t->samples, 8));
+	cJSON_AddItemToObject(root, "status", status = cJSON_CreateObject());
+	cJSON_AddStringToObject(status, "fw", t->fw);
+	cJSON_AddNumberToObject(status, "uptime", t->uptime);
+	cJSON_AddStringToObject(status, "note", t->note);
+
+	out = cJSON_PrintUnformatted(root);
+	cJSON_Delete(root);
+
+	return out;
+}
+
+static int test_cjson_write_telemetry (cJSON_Writer *w, const test_cjson_telemetry *t)
+{
+	int i;
+
+	cJSON_WriterStartObject(w, NULL);
+	cJSON_WriterAddString(w, "device", t->device);
+	cJSON_WriterAddInt(w, "seq", t->seq);
+	cJSON_WriterAddInt(w, "ts", t->timestamp);
+	cJSON_WriterAddNumber(w, "temperature", t->temperature);
+	cJSON_WriterAddNumber(w, "humidity", t->humidity);
+	cJSON_WriterAddNumber(w, "pressure", t->pressure);
+	cJSON_WriterAddNumber(w, "battery", t->battery);
+	cJSON_WriterAddInt(w, "rssi", t->rssi);
+	cJSON_WriterAddBool(w, "motion", t->motion);
+	cJSON_WriterStartArray(w, "samples");
+	for (i = 0 ; i < 8 ; i++)
+		cJSON_WriterAddNumber(w, NULL, t->samples[i]);
+	cJSON_WriterEndArray(w);
+	cJSON_WriterStartObject(w, "status");
+	cJSON_WriterAddString(w, "fw", t->fw);
+	cJSON_WriterAddInt(w, "uptime", t->uptime);
+	cJSON_WriterAddString(w, "note", t->note);
+	cJSON_WriterEndObject(w);
+	cJSON_WriterEndObject(w);
+
+	return cJSON_WriterFinish(w);
+}
+
+typedef struct
+{
+	char data[TEST_CJSON_TELEMETRY_SIZE];
+	size_t length;
+	int chunks;
+	int fail_at;	/* chunk the sink refuses, 0 for none */
+} test_cjson_sink_state;
+
+static int test_cjson_sink (void *arg, const char *data, size_t len)
+{
+	test_cjson_sink_state *state = arg;
+
+	if (++state->chunks == state->fail_at || state->length + len > sizeof(state->data))
+		return -1;
+
+	memcpy(state->data + state->length, data, len);
+	state->length += len;
+
+	return 0;
+}
+
+/* Both documents must parse and print the same */
+static int test_cjson_same_json (const char *what, const char *expected, const char *json)
+{
+	cJSON *a = cJSON_Parse(expected);
+	cJSON *b = cJSON_Parse(json);
+	int ret = 0;
+
+	if (!a || !b)
+	{
+		printf("  %s: does not parse\n    %s\n", what, a ? json : expected);
+		ret = -1;
+	}
+	else
+		ret = test_cjson_same(what, "writer", a, b);
+
+	cJSON_Delete(a);
+	cJSON_Delete(b);
+
+	return ret;
+}
+
+static int test_cjson_write_check (void)
+{
+	char buf[TEST_CJSON_TELEMETRY_SIZE];
+	char small[64];
+	test_cjson_sink_state sink;
+	cJSON_Writer w;
+	char *tree;
+	int len;
+	int ret = 0;
+
+	tree = test_cjson_tree_print(&s_telemetry);
+
+	cJSON_WriterInit(&w, buf, sizeof(buf), NULL, NULL);
+	len = test_cjson_write_telemetry(&w, &s_telemetry);
+	if (len != (int)strlen(buf))
+	{
+		printf("  telemetry: length %d, buffer holds %zu\n", len, strlen(buf));
+		ret = -1;
+	}
+	ret |= test_cjson_same_json("telemetry", tree, buf);
+
+	memset(&sink, 0, sizeof(sink));
+	cJSON_WriterInit(&w, small, TEST_CJSON_CHUNK_SIZE, test_cjson_sink, &sink);
+	if (test_cjson_write_telemetry(&w, &s_telemetry) != len || sink.length != (size_t)len ||
+			memcmp(sink.data, buf, len) != 0 || sink.chunks != (len + TEST_CJSON_CHUNK_SIZE - 1) / TEST_CJSON_CHUNK_SIZE)
+	{
+		printf("  sink: %zu bytes in %d chunks, expected %d\n", sink.length, sink.chunks, len);
+		ret = -1;
+	}
+
+	memset(&sink, 0, sizeof(sink));
+	sink.fail_at = 3;
+	cJSON_WriterInit(&w, small, TEST_CJSON_CHUNK_SIZE, test_cjson_sink, &sink);
+	if (test_cjson_write_telemetry(&w, &s_telemetry) != -1 || sink.chunks != 3)
+	{
+		printf("  sink failure: not reported, %d chunks\n", sink.chunks);
+		ret = -1;
+	}
+
+	cJSON_WriterInit(&w, small, sizeof(small), NULL, NULL);
+	if (test_cjson_write_telemetry(&w, &s_telemetry) != -1)
+	{
+		printf("  overflow: %zu byte buffer accepted a %d byte document\n", sizeof(small), len);
+		ret = -1;
+	}
+
+	vPortFree(tree);
+
+	return ret;
+}
+
+static int test_cjson_write_values (void)
+{
+	static const char *strings[] =
+	{
+		"", "plain", "quote \" backslash \\ slash /", "\b\f\n\r\t", "\x01\x1f\x7f", "caf\xc3\xa9 \xf0\x9f\x9a\x80",
+	};
+	static const double numbers[] =
+	{
+		0, -0.0, 1, -1, 0.1, 1.0 / 3, 24.375, 1013.2, 1e9, 1.5e10, 123456789012345678.0, 1e300, -1e-7, 5e-324, 2147483648.0,
+		1e-6, -0.5, 12.000001, 999999999.999999, 0.1 + 0.2, -3.71,
+	};
+	static const long ints[] = { 0, 1, -1, 2147483647, -2147483647 - 1 };
+	char buf[1024];
+	cJSON_Writer w;
+	cJSON *root;
+	cJSON *item;
+	int ret = 0;
+	int i;
+
+	cJSON_WriterInit(&w, buf, sizeof(buf), NULL, NULL);
+	cJSON_WriterStartObject(&w, NULL);
+	cJSON_WriterStartArray(&w, "strings");
+	for (i = 0 ; i < (int)(sizeof(strings) / sizeof(strings[0])) ; i++)
+		cJSON_WriterAddString(&w, NULL, strings[i]);
+	cJSON_WriterEndArray(&w);
+	cJSON_WriterStartArray(&w, "numbers");
+	for (i = 0 ; i < (int)(sizeof(numbers) / sizeof(numbers[0])) ; i++)
+		cJSON_WriterAddNumber(&w, NULL, numbers[i]);
+	cJSON_WriterAddNumber(&w, NULL, NAN);
+	cJSON_WriterAddNumber(&w, NULL, -INFINITY);
+	cJSON_WriterEndArray(&w);
+	cJSON_WriterStartArray(&w, "ints");
+	for (i = 0 ; i < (int)(sizeof(ints) / sizeof(ints[0])) ; i++)
+		cJSON_WriterAddInt(&w, NULL, ints[i]);
+	cJSON_WriterEndArray(&w);
+	cJSON_WriterAddString(&w, "key \"quoted\"", NULL);
+	cJSON_WriterAddRaw(&w, "raw", "{\"a\":[true,false]}");
+	cJSON_WriterStartObject(&w, "empty");
+	cJSON_WriterEndObject(&w);
+	cJSON_WriterStartArray(&w, "none");
+	cJSON_WriterEndArray(&w);
+	cJSON_WriterEndObject(&w);
+
+	if (cJSON_WriterFinish(&w) < 0 || !(root = cJSON_Parse(buf)))
+	{
+		printf("  values: %s\n", buf);
+		return -1;
+	}
+
+	item = cJSON_GetObjectItem(root, "strings")->child;
+	for (i = 0 ; item ; i++, item = item->next)
+	{
+		if (strcmp(item->valuestring, strings[i]) != 0)
+		{
+			printf("  string %d reads back as \"%s\"\n", i, item->valuestring);
+			ret = -1;
+		}
+	}
+
+	item = cJSON_GetObjectItem(root, "numbers")->child;
+	for (i = 0 ; item && i < (int)(sizeof(numbers) / sizeof(numbers[0])) ; i++, item = item->next)
+	{
+		/* cJSON's own parser is not correctly rounded, read the text back with strtod */
+		char text[32];
+		cJSON_Writer n;
+
+		cJSON_WriterInit(&n, text, sizeof(text), NULL, NULL);
+		cJSON_WriterAddNumber(&n, NULL, numbers[i]);
+		cJSON_WriterFinish(&n);
+
+		if (item->type != cJSON_Number || strtod(text, NULL) != numbers[i])
+		{
+			printf("  number %.17g written as %s\n", numbers[i], text);
+			ret = -1;
+		}
+	}
+	if (!item || item->type != cJSON_NULL || !item->next || item->next->type != cJSON_NULL)
+	{
+		printf("  NaN and infinity not written as null\n");
+		ret = -1;
+	}
+
+	item = cJSON_GetObjectItem(root, "ints")->child;
+	for (i = 0 ; item ; i++, item = item->next)
+	{
+		if (item->valuedouble != ints[i])
+		{
+			printf("  int %ld reads back as %.17g\n", ints[i], item->valuedouble);
+			ret = -1;
+		}
+	}
+
+	if (!cJSON_GetObjectItem(root, "key \"quoted\"") || !cJSON_GetObjectItem(root, "raw") ||
+			!cJSON_GetObjectItem(root, "empty") || !cJSON_GetObjectItem(root, "none"))
+	{
+		printf("  values: %s\n", buf);
+		ret = -1;
+	}
+
+	cJSON_Delete(root);
+
+	return ret;
+}
+
+static int test_cjson_write_misuse (void)
+{
+	char buf[64];
+	cJSON_Writer w;
+	int ret = 0;
+	int i;
+
+	for (i = 0 ; i < 7 ; i++)
+	{
+		cJSON_WriterInit(&w, buf, sizeof(buf), NULL, NULL);
+
+		switch (i)
+		{
+			case 0: /* name in an array */
+				cJSON_WriterStartArray(&w, NULL);
+				cJSON_WriterAddInt(&w, "a", 1);
+				cJSON_WriterEndArray(&w);
+				break;
+
+			case 1: /* no name in an object */
+				cJSON_WriterStartObject(&w, NULL);
+				cJSON_WriterAddInt(&w, NULL, 1);
+				cJSON_WriterEndObject(&w);
+				break;
+
+			case 2: /* object closed as an array */
+				cJSON_WriterStartObject(&w, NULL);
+				cJSON_WriterEndArray(&w);
+				break;
+
+			case 3: /* left open */
+				cJSON_WriterStartObject(&w, NULL);
+				cJSON_WriterStartArray(&w, "a");
+				cJSON_WriterEndArray(&w);
+				break;
+
+			case 4: /* two documents */
+				cJSON_WriterAddInt(&w, NULL, 1);
+				cJSON_WriterAddInt(&w, NULL, 2);
+				break;
+
+			case 5: /* nothing */
+				break;
+
+			case 6: /* too deep */
+				while (cJSON_WriterStartArray(&w, NULL) == 0)
+					;
+				break;
+		}
+
+		if (cJSON_WriterFinish(&w) != -1)
+		{
+			printf("  misuse %d: accepted as %s\n", i, buf);
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+static int test_cjson_write (int argc, char *argv[])
+{
+	char buf[TEST_CJSON_TELEMETRY_SIZE];
+	cJSON_Writer w;
+	test_cjson_telemetry t = s_telemetry;
+	double elapsed[2] = { 0, 0 };
+	size_t bytes[2] = { 0, 0 };
+	size_t peak[2] = { 0, 0 };
+	size_t heap4_peak[2] = { 0, 0 };
+	int allocs[2] = { 0, 0 };
+	double start;
+	int ret = 0;
+	int mode;
+	int i;
+
+	printf("write:\n");
+
+	ret |= test_cjson_write_check();
+	ret |= test_cjson_write_values();
+	ret |= test_cjson_write_misuse();
+
+	for (mode = 0 ; mode < 2 ; mode++)
+	{
+		for (i = 0 ; i < TEST_CJSON_ITERATIONS ; i++)
+		{
+			t.seq = s_telemetry.seq + i;
+			t.temperature = s_telemetry.temperature + (i % 64) * 0.0625;
+
+			test_cjson_heap_reset();
+			start = test_cjson_now_us();
+
+			if (mode == 0)
+			{
+				char *out = test_cjson_tree_print(&t);
+
+				bytes[mode] += strlen(out);
+				vPortFree(out);
+			}
+			else
+			{
+				cJSON_WriterInit(&w, buf, sizeof(buf), NULL, NULL);
+				bytes[mode] += test_cjson_write_telemetry(&w, &t);
+			}
+
+			elapsed[mode] += test_cjson_now_us() - start;
+
+			allocs[mode] = s_heap_allocs;
+			peak[mode] = s_heap_peak;
+			heap4_peak[mode] = s_heap4_peak;
+		}
+
+		printf("  %-10s %6.2f MB/s  %4zu bytes/msg  %3d allocs  %5zu bytes peak (%zu in heap_4)\n",
+					mode ? "writer" : "tree+print", bytes[mode] / elapsed[mode],
+					bytes[mode] / TEST_CJSON_ITERATIONS, allocs[mode], peak[mode], heap4_peak[mode]);
+	}
+
+	return ret;
+}
+
+static const struct
+{
+	const char *name;
+	int (*func) (int argc, char *argv[]);
+} s_test_cjson_cmds[] =
+{
+	{ "parse", test_cjson_parse },
+	{ "write", test_cjson_write },
+};
+
+int main (int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0 ; i < (int)(sizeof(s_test_cjson_cmds) / sizeof(s_test_cjson_cmds[0])) ; i++)
+	{
+		if (argc > 1 && strcmp(argv[1], s_test_cjson_cmds[i].name) != 0)
+			continue;
+
+		ret |= s_test_cjson_cmds[i].func(argc - 1, argv + 1);
+	}
+
+	if (s_heap_current != 0)
+	{
+		printf("%zu heap bytes leaked\n", s_heap_current);
+		ret = -1;
+	}
+
+	printf("%s\n", ret ? "FAIL" : "PASS");
+
+	return ret ? 1 : 0;
+}
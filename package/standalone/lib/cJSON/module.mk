@@ -4,4 +4,5 @@ VPATH	+= $(CJSON_BASE)
 
 CSRCS		+= \
 	cJSON.c \
+	cJSON_Writer.c \
 #	cJSON_Utils.c
@@ -0,0 +1,294 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * FreeRTOS, lwIP and mbedtls stand-ins for the host test of the http server.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>
+
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/base64.h"
+
+unsigned int host_send_count;
+
+/* Tasks */
+
+BaseType_t xTaskCreate (TaskFunction_t func, const char *name, uint32_t stack_depth,
+						void *param, UBaseType_t priority, TaskHandle_t *handle)
+{
+	pthread_t thread;
+
+	if (pthread_create(&thread, NULL, (void *(*)(void *))func, param) != 0)
+		return pdFALSE;
+
+	pthread_detach(thread);
+
+	if (handle)
+		*handle = (TaskHandle_t)thread;
+
+	return pdPASS;
+}
+
+void vTaskDelete (TaskHandle_t task)
+{
+	/* Only self delete is used */
+	pthread_exit(NULL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle (void)
+{
+	return (TaskHandle_t)pthread_self();
+}
+
+void vTaskDelay (TickType_t ticks)
+{
+	usleep(ticks * 1000);
+}
+
+/* Event groups */
+
+struct EventGroupDef_t
+{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate (void)
+{
+	EventGroupHandle_t group = calloc(1, sizeof(*group));
+
+	if (group)
+	{
+		pthread_mutex_init(&group->lock, NULL);
+		pthread_cond_init(&group->cond, NULL);
+	}
+
+	return group;
+}
+
+void vEventGroupDelete (EventGroupHandle_t group)
+{
+	pthread_cond_destroy(&group->cond);
+	pthread_mutex_destroy(&group->lock);
+	free(group);
+}
+
+EventBits_t xEventGroupSetBits (EventGroupHandle_t group, const EventBits_t bits)
+{
+	EventBits_t ret;
+
+	pthread_mutex_lock(&group->lock);
+	group->bits |= bits;
+	ret = group->bits;
+	pthread_cond_broadcast(&group->cond);
+	pthread_mutex_unlock(&group->lock);
+
+	return ret;
+}
+
+/* Only portMAX_DELAY is used */
+EventBits_t xEventGroupWaitBits (EventGroupHandle_t group, const EventBits_t bits,
+									const BaseType_t clear_on_exit, const BaseType_t wait_for_all,
+									TickType_t ticks)
+{
+	EventBits_t ret;
+
+	pthread_mutex_lock(&group->lock);
+
+	while (wait_for_all ? (group->bits & bits) != bits : !(group->bits & bits))
+		pthread_cond_wait(&group->cond, &group->lock);
+
+	ret = group->bits;
+	if (clear_on_exit)
+		group->bits &= ~bits;
+
+	pthread_mutex_unlock(&group->lock);
+
+	return ret;
+}
+
+/* Heap */
+
+void *pvPortMalloc (size_t size)
+{
+	return malloc(size);
+}
+
+void *pvPortCalloc (size_t num, size_t size)
+{
+	return calloc(num, size);
+}
+
+void vPortFree (void *ptr)
+{
+	free(ptr);
+}
+
+size_t strlcpy (char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size > 0)
+	{
+		size_t n = (len < size) ? len : size - 1;
+
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+
+	return len;
+}
+
+/* Hashes */
+
+#define SHA1_ROL(x, n)		(((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_block (uint32_t state[5], const unsigned char *block)
+{
+	uint32_t w[80];
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+	int i;
+
+	for (i = 0 ; i < 16 ; i++)
+		w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+				(uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+	for ( ; i < 80 ; i++)
+		w[i] = SHA1_ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+	for (i = 0 ; i < 80 ; i++)
+	{
+		uint32_t f, k, t;
+
+		if (i < 20)
+			f = (b & c) | (~b & d), k = 0x5a827999;
+		else if (i < 40)
+			f = b ^ c ^ d, k = 0x6ed9eba1;
+		else if (i < 60)
+			f = (b & c) | (b & d) | (c & d), k = 0x8f1bbcdc;
+		else
+			f = b ^ c ^ d, k = 0xca62c1d6;
+
+		t = SHA1_ROL(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = SHA1_ROL(b, 30);
+		b = a;
+		a = t;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+int mbedtls_sha1 (const unsigned char *input, size_t ilen, unsigned char output[20])
+{
+	uint32_t state[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+	unsigned char block[128];
+	uint64_t bits = (uint64_t)ilen * 8;
+	size_t len;
+	int i;
+
+	for ( ; ilen >= 64 ; input += 64, ilen -= 64)
+		sha1_block(state, input);
+
+	/* Padding and length, in one or two blocks */
+	memset(block, 0, sizeof(block));
+	memcpy(block, input, ilen);
+	block[ilen] = 0x80;
+	len = (ilen < 56) ? 64 : 128;
+	for (i = 0 ; i < 8 ; i++)
+		block[len - 1 - i] = bits >> (i * 8);
+
+	sha1_block(state, block);
+	if (len == 128)
+		sha1_block(state, block + 64);
+
+	for (i = 0 ; i < 20 ; i++)
+		output[i] = state[i / 4] >> (24 - (i % 4) * 8);
+
+	return 0;
+}
+
+int mbedtls_base64_encode (unsigned char *dst, size_t dlen, size_t *olen,
+							const unsigned char *src, size_t slen)
+{
+	static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t n = (slen + 2) / 3 * 4;
+	size_t i;
+
+	*olen = n + 1;
+	if (dlen < n + 1)
+		return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+
+	for (i = 0 ; i < slen ; i += 3, dst += 4)
+	{
+		uint32_t v = (uint32_t)src[i] << 16 | (i + 1 < slen ? src[i + 1] << 8 : 0) | (i + 2 < slen ? src[i + 2] : 0);
+
+		dst[0] = digits[v >> 18];
+		dst[1] = digits[(v >> 12) & 0x3f];
+		dst[2] = (i + 1 < slen) ? digits[(v >> 6) & 0x3f] : '=';
+		dst[3] = (i + 2 < slen) ? digits[v & 0x3f] : '=';
+	}
+	*dst = '\0';
+	*olen = n;
+
+	return 0;
+}
+
+/* Sockets */
+
+ssize_t host_send (int fd, const void *buf, size_t len, int flags)
+{
+	__sync_fetch_and_add(&host_send_count, 1);
+
+	return send(fd, buf, len, flags | MSG_NOSIGNAL);
+}
+
+unsigned int host_tcp_data_segs_out (int fd)
+{
+	struct tcp_info info;
+	socklen_t len = sizeof(info);
+
+	memset(&info, 0, sizeof(info));
+
+	if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) < 0)
+		return 0;
+
+	return info.tcpi_data_segs_out;
+}
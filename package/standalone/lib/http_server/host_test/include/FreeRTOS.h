@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __FREERTOS_H__
+#define __FREERTOS_H__
+/**********************************************************************************************/
+
+/*
+ * FreeRTOS kernel API used by the http server, implemented in host_stubs.c on pthreads.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef struct QueueDefinition *SemaphoreHandle_t;
+
+typedef void (*TaskFunction_t) (void *);
+
+#define configMAX_PRIORITIES		32
+#define NRC_TASK_PRIORITY			(configMAX_PRIORITIES - 3)
+
+#define pdFALSE						((BaseType_t)0)
+#define pdTRUE						((BaseType_t)1)
+#define pdPASS						pdTRUE
+
+#define portMAX_DELAY				((TickType_t)0xffffffff)
+#define portTICK_PERIOD_MS			((TickType_t)1)
+
+extern BaseType_t xTaskCreate (TaskFunction_t func, const char *name, uint32_t stack_depth,
+								void *param, UBaseType_t priority, TaskHandle_t *handle);
+extern void vTaskDelete (TaskHandle_t task);
+extern TaskHandle_t xTaskGetCurrentTaskHandle (void);
+extern void vTaskDelay (TickType_t ticks);
+
+extern void *pvPortMalloc (size_t size);
+extern void *pvPortCalloc (size_t num, size_t size);
+extern void vPortFree (void *ptr);
+
+/**********************************************************************************************/
+#endif /* #ifndef __FREERTOS_H__ */
@@ -0,0 +1,47 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __EVENT_GROUPS_H__
+#define __EVENT_GROUPS_H__
+/**********************************************************************************************/
+
+/*
+ * FreeRTOS event groups used by the WebSocket server, implemented in host_stubs.c on pthreads.
+ */
+
+#include "FreeRTOS.h"
+
+typedef struct EventGroupDef_t *EventGroupHandle_t;
+typedef TickType_t EventBits_t;
+
+extern EventGroupHandle_t xEventGroupCreate (void);
+extern void vEventGroupDelete (EventGroupHandle_t group);
+extern EventBits_t xEventGroupSetBits (EventGroupHandle_t group, const EventBits_t bits);
+extern EventBits_t xEventGroupWaitBits (EventGroupHandle_t group, const EventBits_t bits,
+										const BaseType_t clear_on_exit, const BaseType_t wait_for_all,
+										TickType_t ticks);
+
+/**********************************************************************************************/
+#endif /* #ifndef __EVENT_GROUPS_H__ */
@@ -0,0 +1,51 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __UTIL_TRACE_H__
+#define __UTIL_TRACE_H__
+/**********************************************************************************************/
+
+/*
+ * Trace macros of the http server. Errors are printed when the test is built with HOST_TRACE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#define TT_SDK_HTTPD	0
+
+#ifdef HOST_TRACE
+#define E(x, format, ...)	fprintf(stderr, format "\n", ##__VA_ARGS__)
+#else
+#define E(x, format, ...)	do{}while(0)
+#endif
+#define V(x, format, ...)	do{}while(0)
+#define I(x, format, ...)	do{}while(0)
+
+/* newlib has strlcpy(), glibc only from 2.38; host_stubs.c provides it */
+extern size_t strlcpy (char *dst, const char *src, size_t size);
+
+/**********************************************************************************************/
+#endif /* #ifndef __UTIL_TRACE_H__ */
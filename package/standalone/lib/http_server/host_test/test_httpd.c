@@ -0,0 +1,1848 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Host test of the http server on host sockets.
+ *
+ *   test_httpd                       all tests
+ *   test_httpd respond [scenario]    one test, or one scenario of it
+ *
+ * respond: a client sends requests on one keep-alive connection and checks every response.
+ * Requests per second, send() calls and TCP data segments per response are reported. The
+ * accepted sockets have Nagle off, so every send() is a segment as it would be over HaLow.
+ * test_httpd_uncoalesced is the same test built with CONFIG_HTTPD_RESP_BUF_LEN 0 for comparison.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "esp_http_server.h"
+#include "esp_httpd_priv.h"
+#include "httpd_static.h"
+#include "lwip/sockets.h"
+
+#define TEST_HTTPD_PORT				18080
+#define TEST_HTTPD_CTRL_PORT		18081
+#define TEST_HTTPD_REQUESTS			2000
+#define TEST_HTTPD_RX_BUF_SIZE		8192
+#define TEST_HTTPD_BODY_SIZE		(128 * 1024)
+#define TEST_HTTPD_MAX_SESSIONS		48
+
+static httpd_handle_t s_server;
+static int s_sess_fd = -1;
+static clockid_t s_server_clock;
+static int s_errors;
+
+static double test_httpd_now_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+/* CPU time of the server task, known once it opened a session */
+static double test_httpd_server_cpu_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime(s_server_clock, &ts);
+
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+/* Server */
+
+static esp_err_t test_httpd_open (httpd_handle_t hd, int sockfd)
+{
+	int nodelay = 1;
+
+	setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+	s_sess_fd = sockfd;
+	pthread_getcpuclockid(pthread_self(), &s_server_clock);
+
+	return ESP_OK;
+}
+
+/* The ports, open_fn and the number of handlers are filled in */
+static int test_httpd_start (httpd_config_t *config, httpd_uri_t *uris, int count)
+{
+	int i;
+
+	config->server_port = TEST_HTTPD_PORT;
+	config->ctrl_port = TEST_HTTPD_CTRL_PORT;
+	config->max_uri_handlers = count;
+	config->open_fn = test_httpd_open;
+
+	if (httpd_start(&s_server, config) != ESP_OK)
+	{
+		printf("  httpd_start failed\n");
+		return -1;
+	}
+
+	for (i = 0 ; i < count ; i++)
+		httpd_register_uri_handler(s_server, &uris[i]);
+
+	return 0;
+}
+
+static void test_httpd_stop (void)
+{
+	httpd_stop(s_server);
+	s_server = NULL;
+	s_sess_fd = -1;
+}
+
+/* Client */
+
+typedef struct
+{
+	int fd;
+	char buf[TEST_HTTPD_RX_BUF_SIZE];
+	int len;
+	int pos;
+} test_httpd_client;
+
+typedef struct
+{
+	int status;
+	char headers[1024];
+	char body[TEST_HTTPD_BODY_SIZE];
+	int body_len;
+	int chunks;
+} test_httpd_response;
+
+static int test_httpd_connect (test_httpd_client *client)
+{
+	struct timeval tv = { .tv_sec = 2 };
+	struct sockaddr_in addr;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(TEST_HTTPD_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	client->fd = socket(AF_INET, SOCK_STREAM, 0);
+	client->len = client->pos = 0;
+
+	/* a closed session must show up as an error, not hang the test */
+	setsockopt(client->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	if (connect(client->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		close(client->fd);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void test_httpd_disconnect (test_httpd_client *client)
+{
+	close(client->fd);
+	client->fd = -1;
+}
+
+static int test_httpd_fill (test_httpd_client *client)
+{
+	int ret;
+
+	if (client->pos > 0)
+	{
+		memmove(client->buf, client->buf + client->pos, client->len - client->pos);
+		client->len -= client->pos;
+		client->pos = 0;
+	}
+
+	if (client->len == sizeof(client->buf))
+		return -1;
+
+	ret = recv(client->fd, client->buf + client->len, sizeof(client->buf) - client->len, 0);
+	if (ret <= 0)
+		return -1;
+
+	client->len += ret;
+
+	return 0;
+}
+
+/* A line without its CRLF */
+static int test_httpd_line (test_httpd_client *client, char *line, int size)
+{
+	char *end;
+	int len;
+
+	while (!(end = memmem(client->buf + client->pos, client->len - client->pos, "\r\n", 2)))
+	{
+		if (test_httpd_fill(client) < 0)
+			return -1;
+	}
+
+	len = end - (client->buf + client->pos);
+	if (len >= size)
+		return -1;
+
+	memcpy(line, client->buf + client->pos, len);
+	line[len] = '\0';
+	client->pos += len + 2;
+
+	return len;
+}
+
+static int test_httpd_read (test_httpd_client *client, char *buf, int len)
+{
+	int n;
+
+	while (len > 0)
+	{
+		if (client->pos == client->len && test_httpd_fill(client) < 0)
+			return -1;
+
+		n = client->len - client->pos;
+		if (n > len)
+			n = len;
+
+		memcpy(buf, client->buf + client->pos, n);
+		client->pos += n;
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/* hdrs holds additional request header lines, each ending with CRLF */
+static int test_httpd_request_hdrs (test_httpd_client *client, const char *uri, const char *hdrs,
+										test_httpd_response *resp)
+{
+	char line[512];
+	int content_length = -1;
+	int chunked = 0;
+	int len;
+
+	len = snprintf(line, sizeof(line), "GET %s HTTP/1.1\r\nHost: test\r\n%s\r\n", uri, hdrs);
+	/* write(), the server's send() calls are the ones counted */
+	if (write(client->fd, line, len) != len)
+		return -1;
+
+	if (test_httpd_line(client, line, sizeof(line)) < 0 || sscanf(line, "HTTP/1.1 %d", &resp->status) != 1)
+		return -1;
+
+	resp->headers[0] = '\0';
+	resp->body_len = 0;
+	resp->chunks = 0;
+
+	while ((len = test_httpd_line(client, line, sizeof(line))) > 0)
+	{
+		if (strncasecmp(line, "Content-Length: ", 16) == 0)
+			content_length = atoi(line + 16);
+		else if (strcasecmp(line, "Transfer-Encoding: chunked") == 0)
+			chunked = 1;
+
+		if (strlen(resp->headers) + len + 2 < sizeof(resp->headers))
+		{
+			strcat(resp->headers, line);
+			strcat(resp->headers, "\n");
+		}
+	}
+	if (len < 0)
+		return -1;
+
+	/* no body, whatever the headers say */
+	if (resp->status == 304 || resp->status == 101)
+		return 0;
+
+	if (!chunked)
+	{
+		if (content_length < 0 || content_length > (int)sizeof(resp->body) ||
+				test_httpd_read(client, resp->body, content_length) < 0)
+			return -1;
+
+		resp->body_len = content_length;
+		return 0;
+	}
+
+	while (1)
+	{
+		if (test_httpd_line(client, line, sizeof(line)) < 0)
+			return -1;
+
+		len = strtol(line, NULL, 16);
+		if (resp->body_len + len > (int)sizeof(resp->body) ||
+				test_httpd_read(client, resp->body + resp->body_len, len) < 0 ||
+				test_httpd_line(client, line, sizeof(line)) != 0)
+			return -1;
+
+		if (len == 0)
+			return 0;
+
+		resp->body_len += len;
+		resp->chunks++;
+	}
+}
+
+static int test_httpd_request (test_httpd_client *client, const char *uri, test_httpd_response *resp)
+{
+	return test_httpd_request_hdrs(client, uri, "", resp);
+}
+
+/* Responses */
+
+#define TEST_HTTPD_CHUNKS			8
+
+static char s_json_body[256];
+static char s_large_body[3000];
+static char s_chunk_body[TEST_HTTPD_CHUNKS][48];
+
+static void test_httpd_bodies (void)
+{
+	int i;
+
+	snprintf(s_json_body, sizeof(s_json_body),
+				"{\"device\":\"halow-sensor-0042\",\"seq\":18231,\"temperature\":24.375,\"humidity\":51.25,"
+				"\"pressure\":1013.2,\"battery\":3.71,\"rssi\":-67,\"motion\":false,\"fw\":\"1.4.2\",\"uptime\":86412,"
+				"\"note\":\"%-40s\"}", "ok");
+
+	for (i = 0 ; i < sizeof(s_large_body) ; i++)
+		s_large_body[i] = 'a' + (i * 7) % 26;
+
+	for (i = 0 ; i < TEST_HTTPD_CHUNKS ; i++)
+		memset(s_chunk_body[i], '0' + i, sizeof(s_chunk_body[i]));
+}
+
+static esp_err_t test_httpd_json (httpd_req_t *req)
+{
+	httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+	httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+	httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+	httpd_resp_set_hdr(req, "X-Device-Id", "halow-sensor-0042");
+	httpd_resp_set_hdr(req, "X-Request-Seq", "18231");
+
+	return httpd_resp_send(req, s_json_body, HTTPD_RESP_USE_STRLEN);
+}
+
+static esp_err_t test_httpd_chunked (httpd_req_t *req)
+{
+	int i;
+
+	httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+	httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+	httpd_resp_set_hdr(req, "X-Device-Id", "halow-sensor-0042");
+
+	for (i = 0 ; i < TEST_HTTPD_CHUNKS ; i++)
+	{
+		if (httpd_resp_send_chunk(req, s_chunk_body[i], sizeof(s_chunk_body[i])) != ESP_OK)
+			return ESP_FAIL;
+	}
+
+	return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t test_httpd_large (httpd_req_t *req)
+{
+	httpd_resp_set_type(req, "application/octet-stream");
+	httpd_resp_set_hdr(req, "Cache-Control", "max-age=3600");
+
+	return httpd_resp_send(req, s_large_body, sizeof(s_large_body));
+}
+
+typedef struct
+{
+	const char *name;
+	const char *uri;
+	const char *body;
+	int body_len;			/* -1 for the length of body */
+	int chunks;
+	const char *header;		/* one of the set headers, checked in every response */
+	int max_sends;			/* per response, with the response buffer */
+} test_httpd_respond_scenario;
+
+static const test_httpd_respond_scenario s_test_httpd_respond_scenarios[] =
+{
+	{ "json",		"/json",	s_json_body,	-1,						0,					"X-Request-Seq: 18231",			1 },
+	{ "chunked",	"/chunked",	NULL,			TEST_HTTPD_CHUNKS * 48,	TEST_HTTPD_CHUNKS,	"X-Device-Id: halow-sensor-0042",	TEST_HTTPD_CHUNKS + 1 },
+	{ "large",		"/large",	s_large_body,	sizeof(s_large_body),	0,					"Cache-Control: max-age=3600",	2 },
+};
+
+static httpd_uri_t s_test_httpd_respond_uris[] =
+{
+	{ .uri = "/json",		.method = HTTP_GET,	.handler = test_httpd_json },
+	{ .uri = "/chunked",	.method = HTTP_GET,	.handler = test_httpd_chunked },
+	{ .uri = "/large",		.method = HTTP_GET,	.handler = test_httpd_large },
+};
+
+static int test_httpd_body_len (const test_httpd_respond_scenario *scenario)
+{
+	return scenario->body_len < 0 ? strlen(scenario->body) : scenario->body_len;
+}
+
+static int test_httpd_check (const test_httpd_respond_scenario *scenario, test_httpd_response *resp)
+{
+	int i;
+
+	if (resp->status != 200 || resp->body_len != test_httpd_body_len(scenario) || resp->chunks != scenario->chunks ||
+			!strstr(resp->headers, scenario->header))
+	{
+		printf("  %s: status %d, %d bytes in %d chunks\n%s", scenario->name, resp->status, resp->body_len,
+					resp->chunks, resp->headers);
+		return -1;
+	}
+
+	if (scenario->body)
+		return memcmp(resp->body, scenario->body, resp->body_len) ? -1 : 0;
+
+	for (i = 0 ; i < scenario->chunks ; i++)
+	{
+		if (memcmp(resp->body + i * 48, s_chunk_body[i], 48) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int test_httpd_respond_run (const test_httpd_respond_scenario *scenario)
+{
+	test_httpd_client *client = malloc(sizeof(test_httpd_client));
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	unsigned int sends;
+	unsigned int segs;
+	double start;
+	double elapsed;
+	int ret = 0;
+	int i;
+
+	if (test_httpd_connect(client) < 0)
+	{
+		printf("  %s: connect failed\n", scenario->name);
+		free(client);
+		free(resp);
+		return -1;
+	}
+
+	/* the first request also accepts the connection */
+	if (test_httpd_request(client, scenario->uri, resp) < 0 || test_httpd_check(scenario, resp) < 0)
+	{
+		printf("  %s: first response bad\n", scenario->name);
+		ret = -1;
+		goto done;
+	}
+
+	sends = host_send_count;
+	segs = host_tcp_data_segs_out(s_sess_fd);
+	start = test_httpd_now_us();
+
+	for (i = 0 ; i < TEST_HTTPD_REQUESTS ; i++)
+	{
+		if (test_httpd_request(client, scenario->uri, resp) < 0 || test_httpd_check(scenario, resp) < 0)
+		{
+			printf("  %s: response %d bad\n", scenario->name, i);
+			ret = -1;
+			goto done;
+		}
+	}
+
+	elapsed = test_httpd_now_us() - start;
+	sends = host_send_count - sends;
+	segs = host_tcp_data_segs_out(s_sess_fd) - segs;
+
+	printf("  %-8s %6.0f req/s  %5.2f send/resp  %5.2f segments/resp  %5d bytes/resp\n", scenario->name,
+				TEST_HTTPD_REQUESTS * 1000000.0 / elapsed, (double)sends / TEST_HTTPD_REQUESTS,
+				(double)segs / TEST_HTTPD_REQUESTS, test_httpd_body_len(scenario));
+
+#ifndef CONFIG_HTTPD_RESP_BUF_LEN
+	if (sends > scenario->max_sends * TEST_HTTPD_REQUESTS)
+	{
+		printf("  %s: more than %d send() per response\n", scenario->name, scenario->max_sends);
+		ret = -1;
+	}
+#endif
+
+done:
+	test_httpd_disconnect(client);
+	free(client);
+	free(resp);
+
+	return ret;
+}
+
+/* An error response closes the connection, it goes through httpd_resp_send() as well */
+static int test_httpd_respond_error (void)
+{
+	test_httpd_client client;
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	int ret = 0;
+
+	if (test_httpd_connect(&client) < 0 || test_httpd_request(&client, "/missing", resp) < 0 ||
+			resp->status != 404 || resp->body_len != strlen("Nothing matches the given URI") ||
+			memcmp(resp->body, "Nothing matches the given URI", resp->body_len) != 0)
+	{
+		printf("  error: 404 response bad\n");
+		ret = -1;
+	}
+
+	test_httpd_disconnect(&client);
+	free(resp);
+
+	return ret;
+}
+
+static int test_httpd_respond (int argc, char *argv[])
+{
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	int ret = 0;
+	int i;
+
+	printf("respond:\n");
+
+	test_httpd_bodies();
+
+	if (test_httpd_start(&config, s_test_httpd_respond_uris, 3) < 0)
+		return -1;
+
+	for (i = 0 ; i < sizeof(s_test_httpd_respond_scenarios) / sizeof(s_test_httpd_respond_scenarios[0]) ; i++)
+	{
+		if (argc > 1 && strcmp(argv[1], s_test_httpd_respond_scenarios[i].name) != 0)
+			continue;
+
+		ret |= test_httpd_respond_run(&s_test_httpd_respond_scenarios[i]);
+	}
+
+	if (argc <= 1)
+		ret |= test_httpd_respond_error();
+
+	test_httpd_stop();
+
+	return ret;
+}
+
+/* Sessions */
+
+static esp_err_t test_httpd_ping (httpd_req_t *req)
+{
+	return httpd_resp_send(req, "pong", 4);
+}
+
+static httpd_uri_t s_test_httpd_sessions_uri =
+{
+	.uri = "/ping", .method = HTTP_GET, .handler = test_httpd_ping
+};
+
+static int test_httpd_ping_ok (test_httpd_client *client, test_httpd_response *resp)
+{
+	return test_httpd_request(client, "/ping", resp) == 0 && resp->status == 200 &&
+			resp->body_len == 4 && memcmp(resp->body, "pong", 4) == 0;
+}
+
+/* Fill every session slot, then check that a new connection replaces the least recently used one */
+static int test_httpd_sessions_lru (test_httpd_client *clients, test_httpd_response *resp)
+{
+	int fds[TEST_HTTPD_MAX_SESSIONS + 1];
+	size_t nfds = TEST_HTTPD_MAX_SESSIONS + 1;
+	int victim = 1;
+	int i;
+
+	for (i = 0 ; i < TEST_HTTPD_MAX_SESSIONS ; i++)
+	{
+		if (test_httpd_connect(&clients[i]) < 0 || !test_httpd_ping_ok(&clients[i], resp))
+		{
+			printf("  lru: session %d bad\n", i);
+			return -1;
+		}
+	}
+
+	if (httpd_get_client_list(s_server, &nfds, fds) != ESP_OK || nfds != TEST_HTTPD_MAX_SESSIONS)
+	{
+		printf("  lru: %d sessions listed\n", (int)nfds);
+		return -1;
+	}
+
+	/* session 0 becomes the most recently used one, session 1 the least */
+	if (!test_httpd_ping_ok(&clients[0], resp))
+	{
+		printf("  lru: session 0 bad\n");
+		return -1;
+	}
+
+	if (test_httpd_connect(&clients[TEST_HTTPD_MAX_SESSIONS]) < 0 ||
+			!test_httpd_ping_ok(&clients[TEST_HTTPD_MAX_SESSIONS], resp))
+	{
+		printf("  lru: new session bad\n");
+		return -1;
+	}
+
+	if (test_httpd_fill(&clients[victim]) == 0)
+	{
+		printf("  lru: session %d not closed\n", victim);
+		return -1;
+	}
+	test_httpd_disconnect(&clients[victim]);
+
+	for (i = 0 ; i <= TEST_HTTPD_MAX_SESSIONS ; i++)
+	{
+		if (i != victim && !test_httpd_ping_ok(&clients[i], resp))
+		{
+			printf("  lru: session %d closed\n", i);
+			return -1;
+		}
+	}
+
+	printf("  lru      %d sessions, least recently used one closed for a new connection\n", TEST_HTTPD_MAX_SESSIONS);
+
+	return 0;
+}
+
+/* Requests round robin over the first 'count' sessions, the others stay idle */
+static int test_httpd_sessions_load (test_httpd_client *clients, test_httpd_response *resp, int count)
+{
+	double start;
+	double elapsed;
+	int i;
+
+	start = test_httpd_now_us();
+
+	for (i = 0 ; i < TEST_HTTPD_REQUESTS ; i++)
+	{
+		test_httpd_client *client = &clients[i % count];
+
+		if (client->fd < 0)
+			client = &clients[TEST_HTTPD_MAX_SESSIONS];
+
+		if (!test_httpd_ping_ok(client, resp))
+		{
+			printf("  load: response %d bad\n", i);
+			return -1;
+		}
+	}
+
+	elapsed = test_httpd_now_us() - start;
+
+	printf("  load     %6.0f req/s  round robin over %2d of %d sessions\n",
+				TEST_HTTPD_REQUESTS * 1000000.0 / elapsed, count, TEST_HTTPD_MAX_SESSIONS);
+
+	return 0;
+}
+
+static int test_httpd_sessions (int argc, char *argv[])
+{
+	test_httpd_client *clients = calloc(TEST_HTTPD_MAX_SESSIONS + 1, sizeof(test_httpd_client));
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	int ret;
+	int i;
+
+	printf("sessions:\n");
+
+	for (i = 0 ; i <= TEST_HTTPD_MAX_SESSIONS ; i++)
+		clients[i].fd = -1;
+
+	config.max_open_sockets = TEST_HTTPD_MAX_SESSIONS;
+	config.lru_purge_enable = true;
+
+	if (test_httpd_start(&config, &s_test_httpd_sessions_uri, 1) < 0)
+	{
+		free(clients);
+		free(resp);
+		return -1;
+	}
+
+	ret = test_httpd_sessions_lru(clients, resp);
+	if (ret == 0)
+		ret |= test_httpd_sessions_load(clients, resp, 4);
+	if (ret == 0)
+		ret |= test_httpd_sessions_load(clients, resp, TEST_HTTPD_MAX_SESSIONS);
+
+	for (i = 0 ; i <= TEST_HTTPD_MAX_SESSIONS ; i++)
+	{
+		if (clients[i].fd >= 0)
+			test_httpd_disconnect(&clients[i]);
+	}
+
+	test_httpd_stop();
+
+	free(clients);
+	free(resp);
+
+	return ret;
+}
+
+/* URI router */
+
+#define TEST_HTTPD_ROUTES			100
+#define TEST_HTTPD_LOOKUPS			10000
+
+static char s_route_uri[TEST_HTTPD_ROUTES][48];
+static httpd_uri_t s_routes[TEST_HTTPD_ROUTES];
+
+/* Lookups with any other uri_match_fn try the handlers one by one */
+static bool test_httpd_match_linear (const char *template, const char *uri, size_t len)
+{
+	return httpd_uri_match_wildcard(template, uri, len);
+}
+
+static esp_err_t test_httpd_route (httpd_req_t *req)
+{
+	return httpd_resp_send(req, req->user_ctx, -1);
+}
+
+/* Device API routes for every method, with '*' and '?' wildcards, plus a catch-all */
+static void test_httpd_routes (void)
+{
+	int i;
+
+	for (i = 0 ; i < TEST_HTTPD_ROUTES - 1 ; i++)
+	{
+		switch (i % 4)
+		{
+			case 0:
+				snprintf(s_route_uri[i], sizeof(s_route_uri[i]), "/api/v1/devices/%d/status", i / 4);
+				s_routes[i].method = HTTP_GET;
+				break;
+
+			case 1:
+				snprintf(s_route_uri[i], sizeof(s_route_uri[i]), "/api/v1/devices/%d/config", i / 4);
+				s_routes[i].method = HTTP_POST;
+				break;
+
+			case 2:
+				snprintf(s_route_uri[i], sizeof(s_route_uri[i]), "/api/v1/sensors/%d/*", i / 4);
+				s_routes[i].method = HTTP_GET;
+				break;
+
+			case 3:
+				snprintf(s_route_uri[i], sizeof(s_route_uri[i]), "/fw/%d/images?*", i / 4);
+				s_routes[i].method = HTTP_PUT;
+		}
+	}
+
+	snprintf(s_route_uri[i], sizeof(s_route_uri[i]), "/api/v1/*");
+	s_routes[i].method = HTTP_DELETE;
+
+	for (i = 0 ; i < TEST_HTTPD_ROUTES ; i++)
+	{
+		s_routes[i].uri = s_route_uri[i];
+		s_routes[i].handler = test_httpd_route;
+		s_routes[i].user_ctx = s_route_uri[i];
+	}
+}
+
+typedef struct
+{
+	char uri[64];
+	httpd_method_t method;
+} test_httpd_lookup;
+
+/* Hits for every route, other methods, near misses and unknown URIs */
+static int test_httpd_lookups (test_httpd_lookup *lookups)
+{
+	static const char *suffixes[] = { "", "/", "x", "/temp", "s", "/status" };
+	static const httpd_method_t methods[] = { HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_DELETE };
+	int n = 0;
+	int i;
+	int j;
+
+	for (i = 0 ; i < TEST_HTTPD_ROUTES ; i++)
+	{
+		const char *uri = s_route_uri[i];
+		int len = strcspn(uri, "*?");
+
+		if (uri[len] == '?')
+			len--;
+
+		for (j = 0 ; j < sizeof(suffixes) / sizeof(suffixes[0]) ; j++)
+		{
+			snprintf(lookups[n].uri, sizeof(lookups[n].uri), "%.*s%s", len, uri, suffixes[j]);
+			lookups[n].method = methods[(i + j) % 4];
+			n++;
+		}
+
+		snprintf(lookups[n].uri, sizeof(lookups[n].uri), "%.*s", len / 2, uri);
+		lookups[n].method = s_routes[i].method;
+		n++;
+	}
+
+	return n;
+}
+
+static httpd_uri_t *test_httpd_find (struct httpd_data *hd, bool linear, const test_httpd_lookup *lookup,
+										httpd_err_code_t *err)
+{
+	hd->config.uri_match_fn = linear ? test_httpd_match_linear : httpd_uri_match_wildcard;
+
+	return httpd_find_uri_handler(hd, lookup->uri, strlen(lookup->uri), lookup->method, err);
+}
+
+/* The trie must pick the same handler as trying them in registration order */
+static int test_httpd_uri_compare (struct httpd_data *hd, test_httpd_lookup *lookups, int count, const char *when)
+{
+	httpd_err_code_t err_linear;
+	httpd_err_code_t err_trie;
+	httpd_uri_t *linear;
+	httpd_uri_t *trie;
+	int hits = 0;
+	int i;
+
+	for (i = 0 ; i < count ; i++)
+	{
+		linear = test_httpd_find(hd, true, &lookups[i], &err_linear);
+		trie = test_httpd_find(hd, false, &lookups[i], &err_trie);
+
+		if (linear != trie || err_linear != err_trie)
+		{
+			printf("  %s: %s method %d: %s/%d != %s/%d\n", when, lookups[i].uri, lookups[i].method,
+						trie ? trie->uri : "-", err_trie, linear ? linear->uri : "-", err_linear);
+			return -1;
+		}
+
+		if (trie)
+			hits++;
+	}
+
+	printf("  %-8s %d lookups, %d hits, same as linear\n", when, count, hits);
+
+	return 0;
+}
+
+static int test_httpd_uri_bench (struct httpd_data *hd, test_httpd_lookup *lookups, int count)
+{
+	double elapsed[2];
+	int hits = 0;
+	double start;
+	int linear;
+	int i;
+
+	for (linear = 0 ; linear <= 1 ; linear++)
+	{
+		start = test_httpd_now_us();
+
+		for (i = 0 ; i < TEST_HTTPD_LOOKUPS ; i++)
+			hits += test_httpd_find(hd, linear, &lookups[i % count], NULL) != NULL;
+
+		elapsed[linear] = test_httpd_now_us() - start;
+	}
+
+	printf("  bench    %d lookups over %d routes: trie %.3f us, linear %.3f us per lookup\n",
+				TEST_HTTPD_LOOKUPS, TEST_HTTPD_ROUTES,
+				elapsed[0] / TEST_HTTPD_LOOKUPS, elapsed[1] / TEST_HTTPD_LOOKUPS);
+
+	return hits ? 0 : -1;
+}
+
+/* Dispatch through the server, a known URI with another method is 405 */
+static int test_httpd_uri_serve (void)
+{
+	test_httpd_client client;
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	int ret = -1;
+
+	if (test_httpd_connect(&client) < 0)
+		goto done;
+
+	if (test_httpd_request(&client, "/api/v1/sensors/8/temp?unit=c", resp) < 0 || resp->status != 200 ||
+			resp->body_len != strlen(s_route_uri[34]) || memcmp(resp->body, s_route_uri[34], resp->body_len) != 0)
+	{
+		printf("  serve: sensor route bad\n");
+		goto done;
+	}
+
+	if (test_httpd_request(&client, "/api/v1/devices/3/config", resp) < 0 || resp->status != 405)
+	{
+		printf("  serve: method not allowed bad\n");
+		goto done;
+	}
+
+	printf("  serve    GET %s, GET on a POST route 405\n", s_route_uri[34]);
+	ret = 0;
+
+done:
+	test_httpd_disconnect(&client);
+	free(resp);
+
+	return ret;
+}
+
+static int test_httpd_uri (int argc, char *argv[])
+{
+	test_httpd_lookup *lookups = malloc(TEST_HTTPD_ROUTES * 7 * sizeof(test_httpd_lookup));
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	struct httpd_data *hd;
+	int count;
+	int ret;
+	int i;
+
+	printf("uri:\n");
+
+	test_httpd_routes();
+	count = test_httpd_lookups(lookups);
+
+	config.uri_match_fn = httpd_uri_match_wildcard;
+
+	if (test_httpd_start(&config, s_routes, TEST_HTTPD_ROUTES) < 0)
+	{
+		free(lookups);
+		return -1;
+	}
+
+	hd = (struct httpd_data *)s_server;
+
+	ret = test_httpd_uri_compare(hd, lookups, count, "compare");
+	if (ret == 0)
+		ret = test_httpd_uri_bench(hd, lookups, count);
+
+	/* Dropping handlers recompiles the rest */
+	for (i = 0 ; ret == 0 && i < TEST_HTTPD_ROUTES ; i += 3)
+	{
+		if (httpd_unregister_uri_handler(s_server, s_routes[i].uri, s_routes[i].method) != ESP_OK)
+		{
+			printf("  unregister %s failed\n", s_routes[i].uri);
+			ret = -1;
+		}
+	}
+	if (ret == 0)
+		ret = test_httpd_uri_compare(hd, lookups, count, "removed");
+
+	hd->config.uri_match_fn = httpd_uri_match_wildcard;
+
+	if (ret == 0)
+		ret = test_httpd_uri_serve();
+
+	test_httpd_stop();
+	free(lookups);
+
+	return ret;
+}
+
+/* Static assets */
+
+#define TEST_HTTPD_STATIC_REQUESTS	500
+#define TEST_HTTPD_STATIC_GZIP		"Accept-Encoding: gzip, deflate, br\r\n"
+
+/* Generated from the sample_http_server page and a couple of sources by the Makefile */
+extern const httpd_static_bundle_t test_httpd_www;
+
+static httpd_uri_t s_test_httpd_static_uri =
+{
+	.uri = "/*", .method = HTTP_GET, .handler = httpd_static_handler, .user_ctx = (void *)&test_httpd_www
+};
+
+/* A bundle without identity copies, the gzip asset can't go to a client without gzip */
+static const uint8_t s_test_httpd_static_gz_data[] = { 0x1f, 0x8b };
+static const uint8_t s_test_httpd_static_plain_data[] = { 'p', 'l', 'a', 'i', 'n' };
+
+static const httpd_static_asset_t s_test_httpd_static_gz_assets[] =
+{
+	{ "/gz/only.txt", "text/plain", "\"0001\"", s_test_httpd_static_gz_data, sizeof(s_test_httpd_static_gz_data), true },
+	{ "/gz/plain.txt", "text/plain", "\"0002\"", s_test_httpd_static_plain_data, sizeof(s_test_httpd_static_plain_data), false },
+};
+
+static const httpd_static_bundle_t s_test_httpd_static_gz =
+{
+	.assets = s_test_httpd_static_gz_assets, .count = 2, .cache_control = "no-cache"
+};
+
+static httpd_uri_t s_test_httpd_static_gz_uri =
+{
+	.uri = "/gz/*", .method = HTTP_GET, .handler = httpd_static_handler, .user_ctx = (void *)&s_test_httpd_static_gz
+};
+
+/* What the sample did before, the uncompressed page from RAM */
+static char *s_static_raw;
+static size_t s_static_raw_len;
+
+static esp_err_t test_httpd_static_raw (httpd_req_t *req)
+{
+	return httpd_resp_send(req, s_static_raw, s_static_raw_len);
+}
+
+static httpd_uri_t s_test_httpd_static_raw_uri =
+{
+	.uri = "/raw/http_parser.c", .method = HTTP_GET, .handler = test_httpd_static_raw
+};
+
+static int test_httpd_static_hdr (test_httpd_response *resp, const char *field, const char *value)
+{
+	char line[256];
+
+	snprintf(line, sizeof(line), "%s: %s\n", field, value);
+
+	return strstr(resp->headers, line) != NULL;
+}
+
+/* The asset as stored, with its headers, Vary if the encoding was chosen */
+static int test_httpd_static_200 (test_httpd_response *resp, const httpd_static_asset_t *asset, int vary)
+{
+	return resp->status == 200 && resp->body_len == asset->len && memcmp(resp->body, asset->data, asset->len) == 0 &&
+			test_httpd_static_hdr(resp, "ETag", asset->etag) &&
+			test_httpd_static_hdr(resp, "Content-Type", asset->content_type) &&
+			test_httpd_static_hdr(resp, "Cache-Control", "no-cache") &&
+			test_httpd_static_hdr(resp, "Content-Encoding", "gzip") == asset->gzip &&
+			test_httpd_static_hdr(resp, "Vary", "Accept-Encoding") == vary;
+}
+
+static int test_httpd_static_304 (test_httpd_response *resp, const httpd_static_asset_t *asset, int vary)
+{
+	return resp->status == 304 && test_httpd_static_hdr(resp, "ETag", asset->etag) &&
+			strstr(resp->headers, "Content-Length") == NULL &&
+			test_httpd_static_hdr(resp, "Vary", "Accept-Encoding") == vary;
+}
+
+/* Which copy of a gzip asset an Accept-Encoding header gets */
+static int test_httpd_static_encoding (test_httpd_client *client, test_httpd_response *resp,
+										const httpd_static_asset_t *index)
+{
+	static const struct
+	{
+		const char *hdrs;
+		int gzip;
+	} encodings[] =
+	{
+		{ "", 0 },
+		{ "Accept-Encoding: identity\r\n", 0 },
+		{ "Accept-Encoding: GZIP\r\n", 1 },
+		{ "Accept-Encoding: deflate, x-gzip;q=0.5\r\n", 1 },
+		{ "Accept-Encoding: *\r\n", 1 },
+		{ "Accept-Encoding: gzip;q=0, *\r\n", 0 },
+		{ "Accept-Encoding: br, gzip ; q=0.000\r\n", 0 },
+		{ "Accept-Encoding: *;q=0\r\n", 0 },
+	};
+	char hdrs[256];
+	int i;
+
+	for (i = 0 ; i < sizeof(encodings) / sizeof(encodings[0]) ; i++)
+	{
+		const httpd_static_asset_t *asset = encodings[i].gzip ? index : index->identity;
+
+		if (test_httpd_request_hdrs(client, "/", encodings[i].hdrs, resp) < 0 || !test_httpd_static_200(resp, asset, 1))
+		{
+			printf("  check: \"%.*s\" not %s\n", (int)strcspn(encodings[i].hdrs, "\r"), encodings[i].hdrs,
+						encodings[i].gzip ? "gzip" : "identity");
+			return -1;
+		}
+	}
+
+	/* The tag of the copy the client gets is the one it revalidates */
+	snprintf(hdrs, sizeof(hdrs), "If-None-Match: %s\r\n", index->identity->etag);
+	if (test_httpd_request_hdrs(client, "/", hdrs, resp) < 0 || !test_httpd_static_304(resp, index->identity, 1))
+	{
+		printf("  check: identity ETag not 304\n");
+		return -1;
+	}
+	snprintf(hdrs, sizeof(hdrs), "If-None-Match: %s\r\n" TEST_HTTPD_STATIC_GZIP, index->identity->etag);
+	if (test_httpd_request_hdrs(client, "/", hdrs, resp) < 0 || !test_httpd_static_200(resp, index, 1))
+	{
+		printf("  check: identity ETag matched gzip\n");
+		return -1;
+	}
+
+	if (test_httpd_request(client, "/gz/only.txt", resp) < 0 || resp->status != 406 ||
+			!test_httpd_static_hdr(resp, "Vary", "Accept-Encoding") ||
+			test_httpd_request_hdrs(client, "/gz/only.txt", TEST_HTTPD_STATIC_GZIP, resp) < 0 ||
+			!test_httpd_static_200(resp, &s_test_httpd_static_gz_assets[0], 1))
+	{
+		printf("  check: gzip only asset not 406\n");
+		return -1;
+	}
+
+	if (test_httpd_request(client, "/gz/plain.txt", resp) < 0 ||
+			!test_httpd_static_200(resp, &s_test_httpd_static_gz_assets[1], 0) ||
+			test_httpd_request_hdrs(client, "/gz/plain.txt", TEST_HTTPD_STATIC_GZIP, resp) < 0 ||
+			!test_httpd_static_200(resp, &s_test_httpd_static_gz_assets[1], 0))
+	{
+		printf("  check: plain asset bad\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int test_httpd_static_check (test_httpd_client *client, test_httpd_response *resp)
+{
+	const httpd_static_asset_t *index = httpd_static_find(&test_httpd_www, "/index.html", 11);
+	const httpd_static_asset_t *large = httpd_static_find(&test_httpd_www, "/http_parser.c", 14);
+	char hdrs[256];
+	int i;
+
+	if (!index || !large || !index->gzip || !large->gzip || !index->identity || index->identity->gzip)
+	{
+		printf("  check: bundle bad\n");
+		return -1;
+	}
+
+	if (test_httpd_request_hdrs(client, "/", TEST_HTTPD_STATIC_GZIP, resp) < 0 ||
+			!test_httpd_static_200(resp, index, 1) ||
+			test_httpd_request_hdrs(client, "/index.html?lang=en", TEST_HTTPD_STATIC_GZIP, resp) < 0 ||
+			!test_httpd_static_200(resp, index, 1) ||
+			test_httpd_request_hdrs(client, "/http_parser.c", TEST_HTTPD_STATIC_GZIP, resp) < 0 ||
+			!test_httpd_static_200(resp, large, 1))
+	{
+		printf("  check: asset bad\n");
+		return -1;
+	}
+
+	/* Any of the listed tags, weak or not, or a wildcard is a match */
+	const char *matching[] = { "%s", "W/%s", "\"0123\", %s", "*" };
+	for (i = 0 ; i < sizeof(matching) / sizeof(matching[0]) ; i++)
+	{
+		char inm[128];
+
+		snprintf(inm, sizeof(inm), matching[i], index->etag);
+		snprintf(hdrs, sizeof(hdrs), "If-None-Match: %s\r\n" TEST_HTTPD_STATIC_GZIP, inm);
+		if (test_httpd_request_hdrs(client, "/", hdrs, resp) < 0 || !test_httpd_static_304(resp, index, 1))
+		{
+			printf("  check: %s not 304\n", inm);
+			return -1;
+		}
+	}
+
+	snprintf(hdrs, sizeof(hdrs), "If-None-Match: %s\r\n" TEST_HTTPD_STATIC_GZIP, large->etag);
+	if (test_httpd_request_hdrs(client, "/", hdrs, resp) < 0 || !test_httpd_static_200(resp, index, 1))
+	{
+		printf("  check: other ETag not 200\n");
+		return -1;
+	}
+
+	if (test_httpd_static_encoding(client, resp, index) < 0)
+		return -1;
+
+	if (test_httpd_request(client, "/missing.js", resp) < 0 || resp->status != 404)
+	{
+		printf("  check: missing asset not 404\n");
+		return -1;
+	}
+
+	printf("  check    gzip %d -> %d bytes, ETag %s, 304 on If-None-Match, 404, identity or 406 without gzip\n",
+				(int)s_static_raw_len, (int)large->len, large->etag);
+
+	return 0;
+}
+
+/* Bytes leaving the server per CPU-second of the server task, and bytes
+ * of content the client ends up with (0 when it revalidates its copy) */
+static int test_httpd_static_bench (const char *name, const char *uri, const char *hdrs, size_t content_len)
+{
+	test_httpd_client client;
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	double cpu;
+	double start;
+	double elapsed;
+	int ret = 0;
+	int i;
+
+	if (test_httpd_connect(&client) < 0 || test_httpd_request_hdrs(&client, uri, hdrs, resp) < 0)
+	{
+		printf("  %s: first response bad\n", name);
+		ret = -1;
+		goto done;
+	}
+
+	cpu = test_httpd_server_cpu_us();
+	start = test_httpd_now_us();
+
+	for (i = 0 ; i < TEST_HTTPD_STATIC_REQUESTS ; i++)
+	{
+		if (test_httpd_request_hdrs(&client, uri, hdrs, resp) < 0)
+		{
+			printf("  %s: response %d bad\n", name, i);
+			ret = -1;
+			goto done;
+		}
+	}
+
+	cpu = test_httpd_server_cpu_us() - cpu;
+	elapsed = test_httpd_now_us() - start;
+
+	printf("  %-8s %6d body bytes  %7.1f MB/cpu-s sent  %7.1f MB/cpu-s of content  %5.1f us cpu/req  %6.0f req/s\n",
+				name, resp->body_len, (double)resp->body_len * TEST_HTTPD_STATIC_REQUESTS / cpu,
+				(double)content_len * TEST_HTTPD_STATIC_REQUESTS / cpu,
+				cpu / TEST_HTTPD_STATIC_REQUESTS, TEST_HTTPD_STATIC_REQUESTS * 1000000.0 / elapsed);
+
+done:
+	test_httpd_disconnect(&client);
+	free(resp);
+
+	return ret;
+}
+
+static int test_httpd_static (int argc, char *argv[])
+{
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	httpd_uri_t uris[3] = { s_test_httpd_static_raw_uri, s_test_httpd_static_gz_uri, s_test_httpd_static_uri };
+	test_httpd_client client;
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	const httpd_static_asset_t *large = httpd_static_find(&test_httpd_www, "/http_parser.c", 14);
+	char hdrs[192];
+	FILE *fp;
+	int ret;
+
+	printf("static:\n");
+
+	fp = fopen(TEST_HTTPD_STATIC_RAW, "rb");
+	if (!fp)
+	{
+		printf("  %s: %s\n", TEST_HTTPD_STATIC_RAW, strerror(errno));
+		free(resp);
+		return -1;
+	}
+	s_static_raw = malloc(TEST_HTTPD_BODY_SIZE);
+	s_static_raw_len = fread(s_static_raw, 1, TEST_HTTPD_BODY_SIZE, fp);
+	fclose(fp);
+
+	config.uri_match_fn = httpd_uri_match_wildcard;
+
+	if (test_httpd_start(&config, uris, 3) < 0)
+	{
+		free(s_static_raw);
+		free(resp);
+		return -1;
+	}
+
+	ret = test_httpd_connect(&client);
+	if (ret == 0)
+	{
+		ret = test_httpd_static_check(&client, resp);
+		test_httpd_disconnect(&client);
+	}
+
+	snprintf(hdrs, sizeof(hdrs), "If-None-Match: %s\r\n" TEST_HTTPD_STATIC_GZIP, large->etag);
+
+	if (ret == 0)
+		ret |= test_httpd_static_bench("raw", "/raw/http_parser.c", "", s_static_raw_len);
+	if (ret == 0)
+		ret |= test_httpd_static_bench("identity", "/http_parser.c", "", s_static_raw_len);
+	if (ret == 0)
+		ret |= test_httpd_static_bench("gzip", "/http_parser.c", TEST_HTTPD_STATIC_GZIP, s_static_raw_len);
+	if (ret == 0)
+		ret |= test_httpd_static_bench("304", "/http_parser.c", hdrs, 0);
+
+	test_httpd_stop();
+	free(s_static_raw);
+	free(resp);
+
+	return ret;
+}
+
+/* WebSocket */
+
+#define TEST_HTTPD_WS_KEY			"dGhlIHNhbXBsZSBub25jZQ=="
+#define TEST_HTTPD_WS_ACCEPT		"s3pPLMBiTxaQ9kYGzzhZRbK+xOo="	/* RFC6455 Section 1.3 */
+#define TEST_HTTPD_WS_CHUNK_SIZE	1024
+#define TEST_HTTPD_WS_MAX_LEN		(70 * 1024)
+#define TEST_HTTPD_WS_CLIENTS		8
+#define TEST_HTTPD_WS_FRAMES		20000
+#define TEST_HTTPD_WS_BCAST_FRAMES	1000
+
+/* What the server made of the binary messages since the last "sync" */
+static struct
+{
+	unsigned int msgs;
+	size_t bytes;
+	uint32_t hash;
+	size_t expect;
+	int bad_offset;
+	char cmd[64];
+	size_t cmd_len;
+} s_ws;
+
+static uint8_t s_ws_frame_buf[TEST_HTTPD_WS_MAX_LEN];
+
+/* FNV-1a, carried on over messages */
+static uint32_t test_httpd_ws_hash (uint32_t hash, const uint8_t *data, size_t len)
+{
+	while (len-- > 0)
+		hash = (hash ^ *data++) * 16777619;
+
+	return hash;
+}
+
+static void test_httpd_ws_reset (void)
+{
+	memset(&s_ws, 0, sizeof(s_ws));
+	s_ws.hash = 2166136261;
+}
+
+static void test_httpd_ws_sent (esp_err_t err, int socket, void *arg)
+{
+	if (err != ESP_OK)
+		(*(int *)arg)++;
+}
+
+/* Text messages are commands:
+ *   sync                  reply "<messages> <bytes> <hash>" and start over
+ *   bcast <n> <len>       broadcast n binary frames of len bytes to every client
+ *   each <n> <len>        the same with one httpd_ws_send_frame_async() per client */
+static esp_err_t test_httpd_ws_command (httpd_req_t *req)
+{
+	httpd_ws_frame_t frame = { .type = HTTPD_WS_TYPE_BINARY, .payload = s_ws_frame_buf };
+	char reply[64];
+	int fds[TEST_HTTPD_WS_CLIENTS + 1];
+	size_t fd_count;
+	unsigned int len;
+	int failed = 0;
+	int n;
+	int i;
+	int j;
+
+	s_ws.cmd[s_ws.cmd_len] = '\0';
+	s_ws.cmd_len = 0;
+
+	if (strcmp(s_ws.cmd, "sync") == 0)
+	{
+		snprintf(reply, sizeof(reply), "%u %u %08x", s_ws.msgs, (unsigned int)s_ws.bytes,
+					s_ws.bad_offset ? 0 : s_ws.hash);
+		test_httpd_ws_reset();
+
+		frame.type = HTTPD_WS_TYPE_TEXT;
+		frame.payload = (uint8_t *)reply;
+		frame.len = strlen(reply);
+		return httpd_ws_send_frame(req, &frame);
+	}
+
+	if (sscanf(s_ws.cmd + 5, "%d %u", &n, &len) != 2 || len > TEST_HTTPD_WS_MAX_LEN)
+		return ESP_FAIL;
+
+	frame.len = len;
+
+	for (i = 0 ; i < frame.len ; i++)
+		s_ws_frame_buf[i] = i;
+
+	if (strncmp(s_ws.cmd, "bcast ", 6) == 0)
+	{
+		for (i = 0 ; i < n ; i++)
+			httpd_ws_broadcast_frame_async(req->handle, NULL, 0, &frame, test_httpd_ws_sent, &failed);
+	}
+	else
+	{
+		fd_count = sizeof(fds) / sizeof(fds[0]);
+		httpd_get_client_list(req->handle, &fd_count, fds);
+
+		for (i = 0 ; i < n ; i++)
+		{
+			for (j = 0 ; j < fd_count ; j++)
+			{
+				if (httpd_ws_get_fd_info(req->handle, fds[j]) == HTTPD_WS_CLIENT_WEBSOCKET &&
+						httpd_ws_send_frame_async(req->handle, fds[j], &frame) != ESP_OK)
+					failed++;
+			}
+		}
+	}
+
+	return failed ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t test_httpd_ws_chunk (httpd_req_t *req, httpd_ws_frame_t *chunk, size_t offset, void *arg)
+{
+	if (chunk->type == HTTPD_WS_TYPE_TEXT)
+	{
+		if (s_ws.cmd_len + chunk->len >= sizeof(s_ws.cmd))
+			return ESP_FAIL;
+
+		memcpy(s_ws.cmd + s_ws.cmd_len, chunk->payload, chunk->len);
+		s_ws.cmd_len += chunk->len;
+
+		return chunk->final ? test_httpd_ws_command(req) : ESP_OK;
+	}
+
+	if (offset != s_ws.expect)
+		s_ws.bad_offset = 1;
+
+	s_ws.hash = test_httpd_ws_hash(s_ws.hash, chunk->payload, chunk->len);
+	s_ws.bytes += chunk->len;
+	s_ws.expect = offset + chunk->len;
+
+	if (chunk->final)
+	{
+		s_ws.msgs++;
+		s_ws.expect = 0;
+	}
+
+	return ESP_OK;
+}
+
+/* Messages through a small buffer, a chunk at a time */
+static esp_err_t test_httpd_ws_stream (httpd_req_t *req)
+{
+	uint8_t buf[TEST_HTTPD_WS_CHUNK_SIZE];
+
+	if (req->method == HTTP_GET)
+		return ESP_OK;
+
+	return httpd_ws_recv_frame_stream(req, buf, sizeof(buf), test_httpd_ws_chunk, NULL);
+}
+
+/* Unfragmented messages the usual way, asking for the length first */
+static esp_err_t test_httpd_ws_frame (httpd_req_t *req)
+{
+	static uint8_t buf[TEST_HTTPD_WS_MAX_LEN];
+	httpd_ws_frame_t frame;
+	esp_err_t ret;
+
+	if (req->method == HTTP_GET)
+		return ESP_OK;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.payload = buf;
+
+	ret = httpd_ws_recv_frame(req, &frame, 0);
+	if (ret == ESP_OK)
+		ret = httpd_ws_recv_frame(req, &frame, sizeof(buf));
+	if (ret != ESP_OK)
+		return ret;
+
+	frame.final = true;
+	return test_httpd_ws_chunk(req, &frame, 0, NULL);
+}
+
+static httpd_uri_t s_test_httpd_ws_uris[] =
+{
+	{ .uri = "/ws", .method = HTTP_GET, .handler = test_httpd_ws_stream, .is_websocket = true },
+	{ .uri = "/ws/frame", .method = HTTP_GET, .handler = test_httpd_ws_frame, .is_websocket = true },
+};
+
+static int test_httpd_ws_open (test_httpd_client *client, const char *uri, test_httpd_response *resp)
+{
+	if (test_httpd_connect(client) < 0)
+		return -1;
+
+	if (test_httpd_request_hdrs(client, uri, "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+								"Sec-WebSocket-Key: " TEST_HTTPD_WS_KEY "\r\nSec-WebSocket-Version: 13\r\n", resp) < 0 ||
+			resp->status != 101 || !strstr(resp->headers, "Sec-WebSocket-Accept: " TEST_HTTPD_WS_ACCEPT "\n"))
+	{
+		test_httpd_disconnect(client);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Appends a masked client frame to out, returns its length */
+static size_t test_httpd_ws_build (uint8_t *out, int opcode, int fin, const uint8_t *data, size_t len, uint32_t key)
+{
+	uint8_t mask[4] = { key >> 24, key >> 16, key >> 8, key };
+	size_t pos = 0;
+	size_t i;
+
+	out[pos++] = (fin ? 0x80 : 0) | opcode;
+
+	if (len < 126)
+		out[pos++] = 0x80 | len;
+	else if (len <= 0xffff)
+	{
+		out[pos++] = 0x80 | 126;
+		out[pos++] = len >> 8;
+		out[pos++] = len;
+	}
+	else
+	{
+		out[pos++] = 0x80 | 127;
+		for (i = 0 ; i < 8 ; i++)
+			out[pos++] = (uint64_t)len >> (56 - i * 8);
+	}
+
+	memcpy(out + pos, mask, sizeof(mask));
+	pos += sizeof(mask);
+
+	for (i = 0 ; i < len ; i++)
+		out[pos + i] = data[i] ^ mask[i % 4];
+
+	return pos + len;
+}
+
+static int test_httpd_ws_send (test_httpd_client *client, int opcode, int fin, const void *data, size_t len)
+{
+	static uint8_t frame[TEST_HTTPD_WS_MAX_LEN + 14];
+	static uint32_t key = 0x12345678;
+
+	len = test_httpd_ws_build(frame, opcode, fin, data, len, key);
+	key = key * 1103515245 + 12345;
+
+	return write(client->fd, frame, len) == len ? 0 : -1;
+}
+
+/* A server frame, returns the payload length */
+static int test_httpd_ws_recv (test_httpd_client *client, int *opcode, uint8_t *buf, int size)
+{
+	uint8_t hdr[8];
+	uint64_t len;
+	int i;
+
+	if (test_httpd_read(client, (char *)hdr, 2) < 0 || (hdr[1] & 0x80))
+		return -1;
+
+	*opcode = hdr[0] & 0x0f;
+	len = hdr[1] & 0x7f;
+
+	if (len >= 126)
+	{
+		int n = (len == 126) ? 2 : 8;
+
+		if (test_httpd_read(client, (char *)hdr, n) < 0)
+			return -1;
+
+		for (len = 0, i = 0 ; i < n ; i++)
+			len = (len << 8) | hdr[i];
+	}
+
+	if (len > size || test_httpd_read(client, (char *)buf, len) < 0)
+		return -1;
+
+	return len;
+}
+
+/* Sends "sync" and checks what the server made of the messages since the last one */
+static int test_httpd_ws_sync (test_httpd_client *client, unsigned int msgs, size_t bytes, uint32_t hash)
+{
+	char expect[64];
+	char reply[64];
+	int opcode;
+	int len;
+
+	if (test_httpd_ws_send(client, HTTPD_WS_TYPE_TEXT, 1, "sync", 4) < 0 ||
+			(len = test_httpd_ws_recv(client, &opcode, (uint8_t *)reply, sizeof(reply) - 1)) < 0 ||
+			opcode != HTTPD_WS_TYPE_TEXT)
+		return -1;
+
+	reply[len] = '\0';
+	snprintf(expect, sizeof(expect), "%u %u %08x", msgs, (unsigned int)bytes, hash);
+
+	if (strcmp(reply, expect) != 0)
+	{
+		printf("  sync: %s, expected %s\n", reply, expect);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int test_httpd_ws_check (test_httpd_response *resp)
+{
+	static const size_t sizes[] = { 0, 1, 3, 4, 5, 7, 125, 126, 255, 256, 257, 1000, 65535, 65536, 70000 };
+	uint8_t *data = malloc(TEST_HTTPD_WS_MAX_LEN);
+	test_httpd_client client;
+	uint32_t hash;
+	size_t bytes;
+	int u;
+	int i;
+	int ret = -1;
+
+	for (i = 0 ; i < TEST_HTTPD_WS_MAX_LEN ; i++)
+		data[i] = (i * 7) ^ (i >> 8);
+
+	/* Both ways of receiving, at every length encoding and unmask alignment */
+	for (u = 0 ; u < 2 ; u++)
+	{
+		if (test_httpd_ws_open(&client, s_test_httpd_ws_uris[u].uri, resp) < 0)
+		{
+			printf("  check: %s handshake bad\n", s_test_httpd_ws_uris[u].uri);
+			goto done;
+		}
+
+		hash = 2166136261;
+		bytes = 0;
+		for (i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; i++)
+		{
+			/* odd offsets into data, so unmasking starts at any alignment */
+			if (test_httpd_ws_send(&client, HTTPD_WS_TYPE_BINARY, 1, data + i, sizes[i]) < 0)
+				break;
+			hash = test_httpd_ws_hash(hash, data + i, sizes[i]);
+			bytes += sizes[i];
+		}
+
+		if (i < sizeof(sizes) / sizeof(sizes[0]) ||
+				test_httpd_ws_sync(&client, sizeof(sizes) / sizeof(sizes[0]), bytes, hash) < 0)
+		{
+			printf("  check: %s messages bad\n", s_test_httpd_ws_uris[u].uri);
+			test_httpd_disconnect(&client);
+			goto done;
+		}
+
+		test_httpd_disconnect(&client);
+	}
+
+	/* A message in fragments, with a PING in between, in one write */
+	{
+		static const size_t frags[] = { 100, 1000, 0, 37 };
+		uint8_t *out = malloc(4096);
+		size_t out_len = 0;
+		size_t pos = 0;
+		uint8_t pong[16];
+		int opcode;
+		int len;
+
+		for (i = 0 ; i < sizeof(frags) / sizeof(frags[0]) ; i++)
+		{
+			out_len += test_httpd_ws_build(out + out_len, i ? HTTPD_WS_TYPE_CONTINUE : HTTPD_WS_TYPE_BINARY,
+											i == sizeof(frags) / sizeof(frags[0]) - 1, data + pos, frags[i], 0xa5c3e1f7 + i);
+			pos += frags[i];
+			if (i == 1)
+				out_len += test_httpd_ws_build(out + out_len, HTTPD_WS_TYPE_PING, 1, (const uint8_t *)"ping", 4, 0x01020304);
+		}
+
+		ret = -1;
+		if (test_httpd_ws_open(&client, "/ws", resp) < 0 || write(client.fd, out, out_len) != out_len ||
+				(len = test_httpd_ws_recv(&client, &opcode, pong, sizeof(pong))) != 4 ||
+				opcode != HTTPD_WS_TYPE_PONG || memcmp(pong, "ping", 4) != 0 ||
+				test_httpd_ws_sync(&client, 1, pos, test_httpd_ws_hash(2166136261, data, pos)) < 0)
+			printf("  check: fragmented message bad\n");
+		else
+			ret = 0;
+
+		test_httpd_disconnect(&client);
+		free(out);
+		if (ret < 0)
+			goto done;
+	}
+
+	printf("  check    %d messages of 0 to %d bytes both ways, fragments around a PING, through %d bytes\n",
+				(int)(sizeof(sizes) / sizeof(sizes[0])), (int)sizes[sizeof(sizes) / sizeof(sizes[0]) - 1],
+				TEST_HTTPD_WS_CHUNK_SIZE);
+	ret = 0;
+
+done:
+	free(data);
+
+	return ret;
+}
+
+/* Frames received per second and server CPU per frame, the client
+ * writing them in batches so that it keeps ahead of the server */
+static int test_httpd_ws_bench (const char *uri, size_t len)
+{
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	size_t batch_len = 64 * (len + 14);
+	uint8_t *batch = malloc(batch_len);
+	uint8_t *data = malloc(len);
+	test_httpd_client client;
+	double cpu;
+	double start;
+	double elapsed;
+	uint32_t hash = 2166136261;
+	size_t pos;
+	int ret = -1;
+	int i;
+
+	for (i = 0 ; i < len ; i++)
+		data[i] = i;
+
+	if (test_httpd_ws_open(&client, uri, resp) < 0)
+	{
+		printf("  %s: handshake bad\n", uri);
+		goto done;
+	}
+
+	cpu = test_httpd_server_cpu_us();
+	start = test_httpd_now_us();
+
+	for (i = 0 ; i < TEST_HTTPD_WS_FRAMES ; i += 64)
+	{
+		int n;
+
+		for (pos = 0, n = 0 ; n < 64 ; n++)
+		{
+			pos += test_httpd_ws_build(batch + pos, HTTPD_WS_TYPE_BINARY, 1, data, len, 0x9e3779b9 * (i + n + 1));
+			hash = test_httpd_ws_hash(hash, data, len);
+		}
+
+		if (write(client.fd, batch, pos) != pos)
+			break;
+	}
+
+	if (i < TEST_HTTPD_WS_FRAMES || test_httpd_ws_sync(&client, i, (size_t)i * len, hash) < 0)
+	{
+		printf("  %s: frames bad\n", uri);
+		test_httpd_disconnect(&client);
+		goto done;
+	}
+
+	cpu = test_httpd_server_cpu_us() - cpu;
+	elapsed = test_httpd_now_us() - start;
+
+	printf("  %-9s %5d byte frames  %8.0f frames/s  %5.2f us cpu/frame\n",
+				uri, (int)len, i * 1000000.0 / elapsed, cpu / i);
+
+	test_httpd_disconnect(&client);
+	ret = 0;
+
+done:
+	free(data);
+	free(batch);
+	free(resp);
+
+	return ret;
+}
+
+/* Frames sent to every client per second, server CPU and send() calls per client frame */
+static int test_httpd_ws_bench_bcast (test_httpd_client *clients, const char *cmd, size_t len)
+{
+	uint8_t *buf = malloc(len);
+	char line[64];
+	unsigned int sends;
+	double cpu;
+	double start;
+	double elapsed;
+	int opcode;
+	int ret = 0;
+	int i;
+	int j;
+
+	sends = host_send_count;
+	cpu = test_httpd_server_cpu_us();
+	start = test_httpd_now_us();
+
+	snprintf(line, sizeof(line), "%s %d %d", cmd, TEST_HTTPD_WS_BCAST_FRAMES, (int)len);
+	if (test_httpd_ws_send(&clients[0], HTTPD_WS_TYPE_TEXT, 1, line, strlen(line)) < 0)
+		ret = -1;
+
+	for (i = 0 ; ret == 0 && i < TEST_HTTPD_WS_CLIENTS ; i++)
+	{
+		for (j = 0 ; j < TEST_HTTPD_WS_BCAST_FRAMES ; j++)
+		{
+			if (test_httpd_ws_recv(&clients[i], &opcode, buf, len) != len || opcode != HTTPD_WS_TYPE_BINARY ||
+					buf[len - 1] != (uint8_t)(len - 1))
+			{
+				printf("  %s: client %d frame %d bad\n", cmd, i, j);
+				ret = -1;
+				break;
+			}
+		}
+	}
+
+	if (ret == 0)
+	{
+		cpu = test_httpd_server_cpu_us() - cpu;
+		elapsed = test_httpd_now_us() - start;
+		sends = host_send_count - sends;
+
+		printf("  %-9s %5d byte frames  %8.0f frames/s  %5.2f us cpu/frame  %.1f send/frame  to %d clients\n",
+					cmd, (int)len, TEST_HTTPD_WS_BCAST_FRAMES * TEST_HTTPD_WS_CLIENTS * 1000000.0 / elapsed,
+					cpu / (TEST_HTTPD_WS_BCAST_FRAMES * TEST_HTTPD_WS_CLIENTS),
+					(double)sends / (TEST_HTTPD_WS_BCAST_FRAMES * TEST_HTTPD_WS_CLIENTS), TEST_HTTPD_WS_CLIENTS);
+	}
+
+	free(buf);
+
+	return ret;
+}
+
+static int test_httpd_ws (int argc, char *argv[])
+{
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	test_httpd_client *clients = calloc(TEST_HTTPD_WS_CLIENTS, sizeof(test_httpd_client));
+	test_httpd_response *resp = malloc(sizeof(test_httpd_response));
+	int ret;
+	int i;
+
+	printf("ws:\n");
+
+	for (i = 0 ; i < TEST_HTTPD_WS_CLIENTS ; i++)
+		clients[i].fd = -1;
+
+	test_httpd_ws_reset();
+	config.max_open_sockets = TEST_HTTPD_WS_CLIENTS + 1;
+
+	if (test_httpd_start(&config, s_test_httpd_ws_uris, 2) < 0)
+	{
+		free(clients);
+		free(resp);
+		return -1;
+	}
+
+	ret = test_httpd_ws_check(resp);
+
+	if (ret == 0)
+		ret |= test_httpd_ws_bench("/ws", 64);
+	if (ret == 0)
+		ret |= test_httpd_ws_bench("/ws/frame", 64);
+	if (ret == 0)
+		ret |= test_httpd_ws_bench("/ws", 1024);
+	if (ret == 0)
+		ret |= test_httpd_ws_bench("/ws/frame", 1024);
+
+	for (i = 0 ; ret == 0 && i < TEST_HTTPD_WS_CLIENTS ; i++)
+	{
+		if (test_httpd_ws_open(&clients[i], "/ws", resp) < 0)
+		{
+			printf("  client %d: handshake bad\n", i);
+			ret = -1;
+		}
+	}
+
+	if (ret == 0)
+		ret |= test_httpd_ws_bench_bcast(clients, "bcast", 64);
+	if (ret == 0)
+		ret |= test_httpd_ws_bench_bcast(clients, "each", 64);
+	if (ret == 0)
+		ret |= test_httpd_ws_bench_bcast(clients, "bcast", 1024);
+	if (ret == 0)
+		ret |= test_httpd_ws_bench_bcast(clients, "each", 1024);
+
+	for (i = 0 ; i < TEST_HTTPD_WS_CLIENTS ; i++)
+	{
+		if (clients[i].fd >= 0)
+			test_httpd_disconnect(&clients[i]);
+	}
+
+	test_httpd_stop();
+
+	free(clients);
+	free(resp);
+
+	return ret;
+}
+
+static const struct
+{
+	const char *name;
+	int (*func) (int argc, char *argv[]);
+} s_test_httpd_cmds[] =
+{
+	{ "respond", test_httpd_respond },
+	{ "sessions", test_httpd_sessions },
+	{ "uri", test_httpd_uri },
+	{ "static", test_httpd_static },
+	{ "ws", test_httpd_ws },
+};
+
+int main (int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0 ; i < sizeof(s_test_httpd_cmds) / sizeof(s_test_httpd_cmds[0]) ; i++)
+	{
+		if (argc > 1 && strcmp(argv[1], s_test_httpd_cmds[i].name) != 0)
+			continue;
+
+		ret |= s_test_httpd_cmds[i].func(argc - 1, argv + 1);
+	}
+
+	printf("%s\n", ret ? "FAIL" : "PASS");
+
+	return ret ? 1 : 0;
+}
@@ -1642,6 +1642,47 @@ typedef void (*transfer_complete_cb)(esp_err_t err, int socket, void *arg);
  */
 esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t max_len);
 
+/**
+ * @brief Function prototype for receiving the parts of a WebSocket message
+ *
+ * @param[in] req       Current request
+ * @param[in] chunk     Part of the message: payload points into the buffer given to
+ *                      httpd_ws_recv_frame_stream(), len is the number of bytes in it,
+ *                      type is the type of the message and final is set on its last part
+ * @param[in] offset    Offset of the part in the message
+ * @param[in] arg       User data passed to httpd_ws_recv_frame_stream()
+ * @return
+ *  - ESP_OK   : To receive the rest of the message
+ *  - other    : To stop, httpd_ws_recv_frame_stream() returns this
+ */
+typedef esp_err_t (*httpd_ws_chunk_func_t)(httpd_req_t *req, httpd_ws_frame_t *chunk, size_t offset, void *arg);
+
+/**
+ * @brief Receive a WebSocket message of any length through a buffer of the caller
+ *
+ * The message is received into buf, unmasked there, and passed to the callback
+ * every time buf is full and once more at its end. A fragmented message is
+ * received with all of its fragments, so the callback sees one stream of data
+ * whatever the framing. Control frames in between the fragments are answered as
+ * usual, or passed to the callback as parts of their own if the URI handler
+ * takes control frames. Nothing is allocated, and the frame length does not have
+ * to be asked for first.
+ *
+ * @param[in]   req         Current request
+ * @param[in]   buf         Buffer for the parts of the message
+ * @param[in]   buf_len     Length of buf
+ * @param[in]   cb          Callback receiving the parts of the message
+ * @param[in]   arg         User data passed to cb
+ * @return
+ *  - ESP_OK                    : On successful
+ *  - ESP_FAIL                  : Socket errors occurs
+ *  - ESP_ERR_INVALID_STATE     : No handshake done, unmasked frame, or the message was cut short
+ *  - ESP_ERR_INVALID_ARG       : Argument is invalid (null or non-WebSocket)
+ *  - other                     : Returned by cb
+ */
+esp_err_t httpd_ws_recv_frame_stream(httpd_req_t *req, uint8_t *buf, size_t buf_len,
+                                     httpd_ws_chunk_func_t cb, void *arg);
+
 /**
  * @brief Construct and send a WebSocket frame
  * @param[in]   req     Current request
@@ -1671,6 +1712,27 @@ esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *pkt);
  */
 esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame);
 
+/**
+ * @brief Low level send of one WebSocket frame to many clients
+ *
+ * The frame is built once, and a small frame goes to each client in a single send.
+ * Like httpd_ws_send_frame_async(), call it from a URI handler or a function
+ * queued with httpd_queue_work.
+ *
+ * @param[in] handle    Server instance data
+ * @param[in] fds       Socket descriptors of the clients, or NULL for every WebSocket client
+ * @param[in] fd_count  Number of descriptors in fds
+ * @param[in] frame     WebSocket frame
+ * @param[in] callback  Callback invoked for every client with the outcome, may be NULL
+ * @param[in] arg       User data passed to callback
+ * @return
+ *  - ESP_OK                    : The frame was sent to every client
+ *  - ESP_FAIL                  : A client was not an active WebSocket client, or sending to it failed
+ *  - ESP_ERR_INVALID_ARG       : Argument is invalid
+ */
+esp_err_t httpd_ws_broadcast_frame_async(httpd_handle_t handle, const int *fds, size_t fd_count,
+                                         httpd_ws_frame_t *frame, transfer_complete_cb callback, void *arg);
+
 /**
  * @brief Checks the supplied socket descriptor if it belongs to any active client
  * of this server instance and if the websoket protocol is active
@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef _HTTPD_STATIC_H_
+#define _HTTPD_STATIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_http_server.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   A file of a static asset bundle
+ *
+ * Bundles are generated by tools/httpd_bundle.py as const data, which stays
+ * in flash and is sent from there as it is.
+ */
+typedef struct httpd_static_asset {
+    const char    *path;            /*!< URI path, e.g. "/index.html" */
+    const char    *content_type;    /*!< Value of the Content-Type header */
+    const char    *etag;            /*!< Strong ETag of data, including the quotes */
+    const uint8_t *data;            /*!< Content as sent */
+    size_t         len;             /*!< Length of data */
+    bool           gzip;            /*!< data is gzip compressed, sent with Content-Encoding: gzip */
+    const struct httpd_static_asset *identity;  /*!< Uncompressed copy of a gzip asset for clients
+                                                     without gzip, NULL if the bundle keeps none */
+} httpd_static_asset_t;
+
+/**
+ * @brief   A static asset bundle, to be passed as user_ctx of httpd_static_handler()
+ */
+typedef struct httpd_static_bundle {
+    const httpd_static_asset_t *assets; /*!< Assets sorted by path */
+    size_t      count;                  /*!< Number of assets */
+    const char *cache_control;          /*!< Value of the Cache-Control header, NULL for none */
+} httpd_static_bundle_t;
+
+/**
+ * @brief   Find the asset of a bundle for a URI path
+ *
+ * @param[in] bundle  Asset bundle
+ * @param[in] path    URI path, not necessarily null terminated
+ * @param[in] len     Length of path
+ *
+ * @return
+ *  - Asset : if found
+ *  - NULL  : otherwise
+ */
+const httpd_static_asset_t *httpd_static_find(const httpd_static_bundle_t *bundle, const char *path, size_t len);
+
+/**
+ * @brief   URI handler serving the assets of the bundle passed as user_ctx
+ *
+ * Register it for GET with a wildcard URI covering the bundle, and
+ * httpd_uri_match_wildcard() as uri_match_fn, or with the URI of a single
+ * asset. A request whose If-None-Match header matches the ETag of the asset
+ * is answered with 304 Not Modified. Otherwise the asset is sent from where
+ * it is stored, without being copied or decompressed.
+ *
+ * A gzip asset goes only to clients whose Accept-Encoding takes gzip. Others
+ * get its identity copy if the bundle keeps one, or 406 Not Acceptable.
+ *
+ * @param[in] req   The request being responded to
+ *
+ * @return
+ *  - ESP_OK    : asset, 304, 404 or 406 response sent
+ *  - ESP_FAIL  : sending failed, the socket should be closed
+ */
+esp_err_t httpd_static_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ! _HTTPD_STATIC_H_ */
@@ -21,4 +21,5 @@ CSRCS += \
 	httpd_uri.c \
 	httpd_txrx.c \
 	httpd_main.c \
+	httpd_static.c \
 	ctrl_sock.c
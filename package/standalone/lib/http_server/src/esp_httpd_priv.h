@@ -27,6 +27,28 @@ extern "C" {
 /* Calculate the maximum size needed for the scratch buffer */
 #define HTTPD_SCRATCH_BUF  MAX(HTTPD_MAX_REQ_HDR_LEN, HTTPD_MAX_URI_LEN)
 
+/* Size of the buffer in which the status line, headers and a small body of a response
+ * (or the framing and data of a chunk) are assembled, so that they go out in one send.
+ * Set to 0 to send every part separately */
+#ifndef CONFIG_HTTPD_RESP_BUF_LEN
+#define CONFIG_HTTPD_RESP_BUF_LEN  512
+#endif
+
+/* Largest WebSocket frame payload that is copied behind its header on the stack,
+ * so that the frame goes out in one send. Larger payloads are sent on their own */
+#ifndef CONFIG_HTTPD_WS_TX_COALESCE_LEN
+#define CONFIG_HTTPD_WS_TX_COALESCE_LEN  128
+#endif
+
+/* Sessions are looked up by descriptor in a table covering every descriptor
+ * select() can watch, i.e. FD_SETSIZE entries starting at HTTPD_SOCK_FD_BASE */
+#ifdef LWIP_SOCKET_OFFSET
+#define HTTPD_SOCK_FD_BASE  LWIP_SOCKET_OFFSET
+#else
+#define HTTPD_SOCK_FD_BASE  0
+#endif
+#define HTTPD_SOCK_FD_MAP_LEN  FD_SETSIZE
+
 /* Formats a log string to prepend context function name */
 #define LOG_FMT(x)      "%s: " x, __func__
 
@@ -61,6 +83,9 @@ struct sock_db {
     bool lru_socket;                        /*!< Flag indicating LRU socket */
     char pending_data[PARSER_BLOCK_SIZE];   /*!< Buffer for pending data to be received */
     size_t pending_len;                     /*!< Length of pending data to be received */
+    struct sock_db *lru_prev;               /*!< More recently used session, NULL for the most recent one */
+    struct sock_db *lru_next;               /*!< Less recently used session, or next slot while on the free list */
+    struct sock_db *ready_next;             /*!< Next session to be processed in the current server loop */
 #ifdef CONFIG_HTTPD_WS_SUPPORT
     bool ws_handshake_done;                 /*!< True if it has done WebSocket handshake (if this socket is a valid WS) */
     bool ws_close;                          /*!< Set to true to close the socket later (when WS Close frame received) */
@@ -87,11 +112,15 @@ struct httpd_req_aux {
         const char *field;
         const char *value;
     } *resp_hdrs;                                   /*!< Additional headers in response packet */
+    char           *resp_buf;                       /*!< Response assembly buffer of CONFIG_HTTPD_RESP_BUF_LEN bytes */
+    size_t          resp_len;                       /*!< Bytes assembled in resp_buf and not yet sent */
     struct http_parser_url url_parse_res;           /*!< URL parsing result, used for retrieving URL elements */
 #ifdef CONFIG_HTTPD_WS_SUPPORT
     bool ws_handshake_detect;                       /*!< WebSocket handshake detection flag */
     httpd_ws_type_t ws_type;                        /*!< WebSocket frame type */
     bool ws_final;                                  /*!< WebSocket FIN bit (final frame or not) */
+    bool ws_masked;                                 /*!< WebSocket MASK bit (set by conforming clients) */
+    size_t ws_len;                                  /*!< WebSocket payload length of this frame */
     uint8_t mask_key[4];                            /*!< WebSocket mask key for this payload */
 #endif
 };
@@ -111,7 +140,14 @@ struct httpd_data {
     struct thread_data hd_td;               /*!< Information for the HTTPD thread */
     struct sock_db *hd_sd;                  /*!< The socket database */
     int hd_sd_active_count;                 /*!< The number of the active sockets */
+    struct sock_db **hd_sd_map;             /*!< Active sessions indexed by fd - HTTPD_SOCK_FD_BASE */
+    struct sock_db *hd_sd_free;             /*!< Free list of unused session slots */
+    struct sock_db *hd_sd_lru_head;         /*!< Most recently used active session */
+    struct sock_db *hd_sd_lru_tail;         /*!< Least recently used active session */
+    fd_set hd_sd_fdset;                     /*!< Descriptors of all active sessions */
+    int hd_sd_max_fd;                       /*!< Highest descriptor in hd_sd_fdset, -1 if none */
     httpd_uri_t **hd_calls;                 /*!< Registered URI handlers */
+    struct httpd_uri_node *hd_uri_trie;     /*!< URI handlers compiled for lookup, NULL to search hd_calls */
     struct httpd_req hd_req;                /*!< The current HTTPD request */
     struct httpd_req_aux hd_req_aux;        /*!< Additional data about the HTTPD request kept unexposed */
     uint64_t lru_counter;                   /*!< LRU counter */
@@ -216,12 +252,14 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session);
 void httpd_sess_free_ctx(void **ctx, httpd_free_ctx_fn_t free_fn);
 
 /**
- * @brief   Add descriptors present in the socket database to an fdset and
+ * @brief   Copy the descriptors present in the socket database to an fdset and
  *          update the value of maxfd which are needed by the select function
  *          for looking through all available sockets for incoming data.
+ *          The set is maintained as sessions come and go, so this does not
+ *          depend on the number of session slots.
  *
  * @param[in]  hd    Server instance data
- * @param[out] fdset File descriptor set to be updated.
+ * @param[out] fdset File descriptor set to be overwritten.
  * @param[out] maxfd Maximum value among all file descriptors.
  */
 void httpd_sess_set_descriptors(struct httpd_data *hd, fd_set *fdset, int *maxfd);
@@ -290,6 +328,26 @@ void httpd_sess_close_all(struct httpd_data *hd);
  * @{
  */
 
+/**
+ * @brief   Finds the handler registered for a URI and method. Handlers registered
+ *          earlier take precedence when several of them match.
+ *
+ * @param[in]  hd      Server instance data
+ * @param[in]  uri     URI path, not necessarily null terminated
+ * @param[in]  uri_len Length of the URI path
+ * @param[in]  method  HTTP method of the request
+ * @param[out] err     Set to HTTPD_404_NOT_FOUND or HTTPD_405_METHOD_NOT_ALLOWED
+ *                     if no handler is found, to 0 otherwise. May be NULL.
+ *
+ * @return
+ *  - Handler : if found
+ *  - NULL    : otherwise
+ */
+httpd_uri_t *httpd_find_uri_handler(struct httpd_data *hd,
+                                    const char *uri, size_t uri_len,
+                                    httpd_method_t method,
+                                    httpd_err_code_t *err);
+
 /**
  * @brief   For an HTTP request, searches through all the registered URI handlers
  *          and invokes the appropriate one if found
@@ -508,8 +566,8 @@ int httpd_default_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len,
 esp_err_t httpd_ws_respond_server_handshake(httpd_req_t *req, const char *supported_subprotocol);
 
 /**
- * @brief   This function is for getting a frame type
- *          and responding a WebSocket control frame automatically
+ * @brief   This function is for receiving the header of a frame, which gives
+ *          its type, and responding a WebSocket control frame automatically
  *
  * @param[in] req    Pointer to handshake request that will be handled
  * @return
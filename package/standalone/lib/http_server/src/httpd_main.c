@@ -23,11 +23,6 @@ static const int DEFAULT_KEEP_ALIVE_IDLE = 5;
 static const int DEFAULT_KEEP_ALIVE_INTERVAL= 5;
 static const int DEFAULT_KEEP_ALIVE_COUNT= 3;
 
-typedef struct {
-    fd_set *fdset;
-    struct httpd_data *hd;
-} process_session_context_t;
-
 static const int TAG = TT_SDK_HTTPD;
 
 static esp_err_t httpd_accept_conn(struct httpd_data *hd, int listen_fd)
@@ -156,13 +151,11 @@ esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_
     }
     size_t max_fds = *fds;
     *fds = 0;
-    for (int i = 0; i < hd->config.max_open_sockets; ++i) {
-        if (hd->hd_sd[i].fd != -1) {
-            if (*fds < max_fds) {
-                client_fds[(*fds)++] = hd->hd_sd[i].fd;
-            } else {
-                return ESP_ERR_INVALID_ARG;
-            }
+    for (struct sock_db *session = hd->hd_sd_lru_head; session; session = session->lru_next) {
+        if (*fds < max_fds) {
+            client_fds[(*fds)++] = session->fd;
+        } else {
+            return ESP_ERR_INVALID_ARG;
         }
     }
     return ESP_OK;
@@ -217,34 +210,37 @@ static void httpd_process_ctrl_msg(struct httpd_data *hd)
 #endif
 }
 
-// Called for each session from httpd_server
-static int httpd_process_session(struct sock_db *session, void *context)
+// Called from httpd_server for the active sessions
+static void httpd_process_sessions(struct httpd_data *hd, fd_set *fdset)
 {
-    if ((!session) || (!context)) {
-        return 0;
-    }
-
-    if (session->fd < 0) {
-        return 1;
+    /* Collect the sessions with data first, as processing a session
+     * moves it to the head of the LRU list being walked */
+    struct sock_db *ready = NULL;
+    struct sock_db **tail = &ready;
+    for (struct sock_db *session = hd->hd_sd_lru_head; session; session = session->lru_next) {
+        if (FD_ISSET(session->fd, fdset) || httpd_sess_pending(hd, session)) {
+            *tail = session;
+            tail = &session->ready_next;
+        }
     }
+    *tail = NULL;
 
-    process_session_context_t *ctx = (process_session_context_t *)context;
-    int fd = session->fd;
-
-    if (FD_ISSET(fd, ctx->fdset) || httpd_sess_pending(ctx->hd, session)) {
-        V(TAG, LOG_FMT("processing socket %d"), fd);
-        if (httpd_sess_process(ctx->hd, session) != ESP_OK) {
-            httpd_sess_delete(ctx->hd, session); // Delete session
+    while (ready) {
+        struct sock_db *session = ready;
+        ready = session->ready_next;
+        V(TAG, LOG_FMT("processing socket %d"), session->fd);
+        if (httpd_sess_process(hd, session) != ESP_OK) {
+            httpd_sess_delete(hd, session); // Delete session
         }
     }
-    return 1;
 }
 
 /* Manage in-coming connection or data requests */
 static esp_err_t httpd_server(struct httpd_data *hd)
 {
     fd_set read_set;
-    FD_ZERO(&read_set);
+    int tmp_max_fd;
+    httpd_sess_set_descriptors(hd, &read_set, &tmp_max_fd);
     if (hd->config.lru_purge_enable || httpd_is_sess_available(hd)) {
         /* Only listen for new connections if server has capacity to
          * handle more (or when LRU purge is enabled, in which case
@@ -253,8 +249,6 @@ static esp_err_t httpd_server(struct httpd_data *hd)
     }
     FD_SET(hd->ctrl_fd, &read_set);
 
-    int tmp_max_fd;
-    httpd_sess_set_descriptors(hd, &read_set, &tmp_max_fd);
     int maxfd = MAX(hd->listen_fd, tmp_max_fd);
     tmp_max_fd = maxfd;
     maxfd = MAX(hd->ctrl_fd, tmp_max_fd);
@@ -279,11 +273,7 @@ static esp_err_t httpd_server(struct httpd_data *hd)
 
     /* Case1: Do we have any activity on the current data
      * sessions? */
-    process_session_context_t context = {
-        .fdset = &read_set,
-        .hd = hd
-    };
-    httpd_sess_enum(hd, httpd_process_session, &context);
+    httpd_process_sessions(hd, &read_set);
 
     /* Case2: Do we have any incoming connection requests to
      * process? */
@@ -412,19 +402,42 @@ static struct httpd_data *httpd_create(const httpd_config_t *config)
         free(hd);
         return NULL;
     }
+    hd->hd_sd_map = calloc(HTTPD_SOCK_FD_MAP_LEN, sizeof(struct sock_db *));
+    if (!hd->hd_sd_map) {
+        E(TAG, LOG_FMT("Failed to allocate memory for HTTP session map"));
+        free(hd->hd_sd);
+        free(hd->hd_calls);
+        free(hd);
+        return NULL;
+    }
     struct httpd_req_aux *ra = &hd->hd_req_aux;
     ra->resp_hdrs = calloc(config->max_resp_headers, sizeof(struct resp_hdr));
     if (!ra->resp_hdrs) {
         E(TAG, LOG_FMT("Failed to allocate memory for HTTP response headers"));
+        free(hd->hd_sd_map);
         free(hd->hd_sd);
         free(hd->hd_calls);
         free(hd);
         return NULL;
     }
+#if CONFIG_HTTPD_RESP_BUF_LEN > 0
+    ra->resp_buf = malloc(CONFIG_HTTPD_RESP_BUF_LEN);
+    if (!ra->resp_buf) {
+        E(TAG, LOG_FMT("Failed to allocate memory for HTTP response buffer"));
+        free(ra->resp_hdrs);
+        free(hd->hd_sd_map);
+        free(hd->hd_sd);
+        free(hd->hd_calls);
+        free(hd);
+        return NULL;
+    }
+#endif
     hd->err_handler_fns = calloc(HTTPD_ERR_CODE_MAX, sizeof(httpd_err_handler_func_t));
     if (!hd->err_handler_fns) {
         E(TAG, LOG_FMT("Failed to allocate memory for HTTP error handlers"));
+        free(ra->resp_buf);
         free(ra->resp_hdrs);
+        free(hd->hd_sd_map);
         free(hd->hd_sd);
         free(hd->hd_calls);
         free(hd);
@@ -440,7 +453,9 @@ static void httpd_delete(struct httpd_data *hd)
     struct httpd_req_aux *ra = &hd->hd_req_aux;
     /* Free memory of httpd instance data */
     free(hd->err_handler_fns);
+    free(ra->resp_buf);
     free(ra->resp_hdrs);
+    free(hd->hd_sd_map);
     free(hd->hd_sd);
 
     /* Free registered URI handlers */
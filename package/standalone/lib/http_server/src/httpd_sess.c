@@ -14,28 +14,6 @@
 
 static const int TAG = TT_SDK_HTTPD;
 
-typedef enum {
-    HTTPD_TASK_NONE = 0,
-    HTTPD_TASK_INIT,            // Init session
-    HTTPD_TASK_GET_ACTIVE,      // Get active session (fd!=-1)
-    HTTPD_TASK_GET_FREE,        // Get free session slot (fd<0)
-    HTTPD_TASK_FIND_FD,         // Find session with specific fd
-    HTTPD_TASK_SET_DESCRIPTOR,  // Set descriptor
-    HTTPD_TASK_DELETE_INVALID,  // Delete invalid session
-    HTTPD_TASK_FIND_LOWEST_LRU, // Find session with lowest lru
-    HTTPD_TASK_CLOSE            // Close session
-} task_t;
-
-typedef struct {
-    task_t task;
-    int fd;
-    fd_set *fdset;
-    int max_fd;
-    struct httpd_data *hd;
-    uint64_t lru_counter;
-    struct sock_db    *session;
-} enum_context_t;
-
 void httpd_sess_enum(struct httpd_data *hd, httpd_session_enum_function enum_function, void *context)
 {
     if ((!hd) || (!hd->hd_sd) || (!hd->config.max_open_sockets)) {
@@ -59,73 +37,48 @@ static int fd_is_valid(int fd)
     return fcntl(fd, F_GETFD, 0) != -1 || errno != EBADF;
 }
 
-static int enum_function(struct sock_db *session, void *context)
+// Check if a FD can be kept in the session map (and in an fd_set)
+static bool fd_in_map(int fd)
 {
-    if ((!session) || (!context)) {
-        return 0;
-    }
-    enum_context_t *ctx = (enum_context_t *) context;
-    int found = 0;
-    switch (ctx->task) {
-    // Initialize session
-    case HTTPD_TASK_INIT:
-        session->fd = -1;
-        session->ctx = NULL;
-        break;
-    // Get active session
-    case HTTPD_TASK_GET_ACTIVE:
-        found = (session->fd != -1);
-        break;
-    // Get free slot
-    case HTTPD_TASK_GET_FREE:
-        found = (session->fd < 0);
-        break;
-    // Find fd
-    case HTTPD_TASK_FIND_FD:
-        found = (session->fd == ctx->fd);
-        break;
-    // Set descriptor
-    case HTTPD_TASK_SET_DESCRIPTOR:
-        if (session->fd != -1) {
-            FD_SET(session->fd, ctx->fdset);
-            if (session->fd > ctx->max_fd) {
-                ctx->max_fd = session->fd;
-            }
-        }
-        break;
-    // Delete invalid session
-    case HTTPD_TASK_DELETE_INVALID:
-        if (!fd_is_valid(session->fd)) {
-            E(TAG, LOG_FMT("Closing invalid socket %d"), session->fd);
-            httpd_sess_delete(ctx->hd, session);
-        }
-        break;
-    // Find lowest lru
-    case HTTPD_TASK_FIND_LOWEST_LRU:
-        // Found free slot - no need to check other sessions
-        if (session->fd == -1) {
-            return 0;
-        }
-        // Check/update lowest lru
-        if (session->lru_counter < ctx->lru_counter) {
-            ctx->lru_counter = session->lru_counter;
-            ctx->session = session;
-        }
-        break;
-    case HTTPD_TASK_CLOSE:
-        if (session->fd != -1) {
-            V(TAG, LOG_FMT("cleaning up socket %d"), session->fd);
-            httpd_sess_delete(ctx->hd, session);
-        }
-        break;
-    default:
-        return 0;
+    return (fd >= HTTPD_SOCK_FD_BASE) && (fd - HTTPD_SOCK_FD_BASE < HTTPD_SOCK_FD_MAP_LEN);
+}
+
+static void httpd_sess_lru_unlink(struct httpd_data *hd, struct sock_db *session)
+{
+    if (session->lru_prev) {
+        session->lru_prev->lru_next = session->lru_next;
+    } else {
+        hd->hd_sd_lru_head = session->lru_next;
+    }
+    if (session->lru_next) {
+        session->lru_next->lru_prev = session->lru_prev;
+    } else {
+        hd->hd_sd_lru_tail = session->lru_prev;
     }
-    if (found) {
-        ctx->session = session;
-        return 0;
+    session->lru_prev = NULL;
+    session->lru_next = NULL;
+}
+
+static void httpd_sess_lru_push(struct httpd_data *hd, struct sock_db *session)
+{
+    session->lru_prev = NULL;
+    session->lru_next = hd->hd_sd_lru_head;
+    if (hd->hd_sd_lru_head) {
+        hd->hd_sd_lru_head->lru_prev = session;
+    } else {
+        hd->hd_sd_lru_tail = session;
+    }
+    hd->hd_sd_lru_head = session;
+}
+
+// Mark session as the most recently used one
+static void httpd_sess_touch(struct httpd_data *hd, struct sock_db *session)
+{
+    session->lru_counter = ++hd->lru_counter;
+    if (hd->hd_sd_lru_head != session) {
+        httpd_sess_lru_unlink(hd, session);
+        httpd_sess_lru_push(hd, session);
     }
-    return 1;
 }
 
 static void httpd_sess_close(void *arg)
@@ -146,14 +99,7 @@ static void httpd_sess_close(void *arg)
 
 struct sock_db *httpd_sess_get_free(struct httpd_data *hd)
 {
-    if ((!hd) || (hd->hd_sd_active_count == hd->config.max_open_sockets)) {
-        return NULL;
-    }
-    enum_context_t context = {
-        .task = HTTPD_TASK_GET_FREE
-    };
-    httpd_sess_enum(hd, enum_function, &context);
-    return context.session;
+    return hd ? hd->hd_sd_free : NULL;
 }
 
 bool httpd_is_sess_available(struct httpd_data *hd)
@@ -173,12 +119,10 @@ struct sock_db *httpd_sess_get(struct httpd_data *hd, int sockfd)
         return hd->hd_req_aux.sd;
     }
 
-    enum_context_t context = {
-        .task = HTTPD_TASK_FIND_FD,
-        .fd = sockfd
-    };
-    httpd_sess_enum(hd, enum_function, &context);
-    return context.session;
+    if (!fd_in_map(sockfd)) {
+        return NULL;
+    }
+    return hd->hd_sd_map[sockfd - HTTPD_SOCK_FD_BASE];
 }
 
 esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd)
@@ -190,11 +134,17 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd)
         return ESP_FAIL;
     }
 
+    if (!fd_in_map(newfd)) {
+        E(TAG, LOG_FMT("fd = %d is out of select() range"), newfd);
+        return ESP_FAIL;
+    }
+
     struct sock_db *session = httpd_sess_get_free(hd);
     if (!session) {
         V(TAG, LOG_FMT("unable to launch session for fd = %d"), newfd);
         return ESP_FAIL;
     }
+    hd->hd_sd_free = session->lru_next;
 
     // Clear session data
     memset(session, 0, sizeof (struct sock_db));
@@ -203,6 +153,14 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd)
     session->send_fn = httpd_default_send;
     session->recv_fn = httpd_default_recv;
 
+    // Index the session and make it the most recently used one
+    hd->hd_sd_map[newfd - HTTPD_SOCK_FD_BASE] = session;
+    httpd_sess_lru_push(hd, session);
+    FD_SET(newfd, &hd->hd_sd_fdset);
+    if (newfd > hd->hd_sd_max_fd) {
+        hd->hd_sd_max_fd = newfd;
+    }
+
     // increment number of sessions
     hd->hd_sd_active_count++;
 
@@ -326,24 +284,23 @@ void httpd_sess_set_transport_ctx(httpd_handle_t handle, int sockfd, void *ctx,
 
 void httpd_sess_set_descriptors(struct httpd_data *hd, fd_set *fdset, int *maxfd)
 {
-    enum_context_t context = {
-        .task = HTTPD_TASK_SET_DESCRIPTOR,
-        .max_fd = -1,
-        .fdset = fdset
-    };
-    httpd_sess_enum(hd, enum_function, &context);
+    *fdset = hd->hd_sd_fdset;
     if (maxfd) {
-        *maxfd = context.max_fd;
+        *maxfd = hd->hd_sd_max_fd;
     }
 }
 
 void httpd_sess_delete_invalid(struct httpd_data *hd)
 {
-    enum_context_t context = {
-        .task = HTTPD_TASK_DELETE_INVALID,
-        .hd = hd
-    };
-    httpd_sess_enum(hd, enum_function, &context);
+    struct sock_db *session = hd->hd_sd_lru_head;
+    while (session) {
+        struct sock_db *next = session->lru_next;
+        if (!fd_is_valid(session->fd)) {
+            E(TAG, LOG_FMT("Closing invalid socket %d"), session->fd);
+            httpd_sess_delete(hd, session);
+        }
+        session = next;
+    }
 }
 
 void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
@@ -373,8 +330,20 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
     // clear all contexts
     httpd_sess_clear_ctx(session);
 
+    // Drop the session from the map and the fd_set
+    int fd = session->fd;
+    hd->hd_sd_map[fd - HTTPD_SOCK_FD_BASE] = NULL;
+    FD_CLR(fd, &hd->hd_sd_fdset);
+    if (fd == hd->hd_sd_max_fd) {
+        while ((--fd >= HTTPD_SOCK_FD_BASE) && (!hd->hd_sd_map[fd - HTTPD_SOCK_FD_BASE]));
+        hd->hd_sd_max_fd = (fd >= HTTPD_SOCK_FD_BASE) ? fd : -1;
+    }
+
     // mark session slot as available
     session->fd = -1;
+    httpd_sess_lru_unlink(hd, session);
+    session->lru_next = hd->hd_sd_free;
+    hd->hd_sd_free = session;
 
     // decrement number of sessions
     hd->hd_sd_active_count--;
@@ -386,10 +355,26 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
 
 void httpd_sess_init(struct httpd_data *hd)
 {
-    enum_context_t context = {
-        .task = HTTPD_TASK_INIT
-    };
-    httpd_sess_enum(hd, enum_function, &context);
+    if ((!hd) || (!hd->hd_sd) || (!hd->config.max_open_sockets)) {
+        return;
+    }
+
+    memset(hd->hd_sd_map, 0, HTTPD_SOCK_FD_MAP_LEN * sizeof(struct sock_db *));
+    FD_ZERO(&hd->hd_sd_fdset);
+    hd->hd_sd_max_fd = -1;
+    hd->hd_sd_lru_head = NULL;
+    hd->hd_sd_lru_tail = NULL;
+    hd->hd_sd_free = NULL;
+
+    // Chain all slots on the free list, lowest slot first
+    for (int i = hd->config.max_open_sockets - 1; i >= 0; i--) {
+        struct sock_db *session = &hd->hd_sd[i];
+        session->fd = -1;
+        session->ctx = NULL;
+        session->lru_prev = NULL;
+        session->lru_next = hd->hd_sd_free;
+        hd->hd_sd_free = session;
+    }
 }
 
 bool httpd_sess_pending(struct httpd_data *hd, struct sock_db *session)
@@ -426,7 +411,7 @@ esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session)
         return ESP_FAIL;
     }
     V(TAG, LOG_FMT("success"));
-    session->lru_counter = ++hd->lru_counter;
+    httpd_sess_touch(hd, session);
     return ESP_OK;
 }
 
@@ -438,13 +423,9 @@ esp_err_t httpd_sess_update_lru_counter(httpd_handle_t handle, int sockfd)
 
     struct httpd_data *hd = (struct httpd_data *) handle;
 
-    enum_context_t context = {
-        .task = HTTPD_TASK_FIND_FD,
-        .fd = sockfd
-    };
-    httpd_sess_enum(hd, enum_function, &context);
-    if (context.session) {
-        context.session->lru_counter = ++hd->lru_counter;
+    struct sock_db *session = httpd_sess_get(hd, sockfd);
+    if (session) {
+        httpd_sess_touch(hd, session);
         return ESP_OK;
     }
     return ESP_ERR_NOT_FOUND;
@@ -452,18 +433,14 @@ esp_err_t httpd_sess_update_lru_counter(httpd_handle_t handle, int sockfd)
 
 esp_err_t httpd_sess_close_lru(struct httpd_data *hd)
 {
-    enum_context_t context = {
-        .task = HTTPD_TASK_FIND_LOWEST_LRU,
-        .lru_counter = UINT64_MAX,
-        .fd = -1
-    };
-    httpd_sess_enum(hd, enum_function, &context);
-    if (!context.session) {
+    // Free slot available - no need to close anything
+    struct sock_db *session = hd->hd_sd_lru_tail;
+    if (hd->hd_sd_free || !session) {
         return ESP_OK;
     }
-    V(TAG, LOG_FMT("Closing session with fd %d"), context.session->fd);
-    context.session->lru_socket = true;
-    return httpd_sess_trigger_close_(hd, context.session);
+    V(TAG, LOG_FMT("Closing session with fd %d"), session->fd);
+    session->lru_socket = true;
+    return httpd_sess_trigger_close_(hd, session);
 }
 
 esp_err_t httpd_sess_trigger_close_(httpd_handle_t handle, struct sock_db *session)
@@ -485,9 +462,8 @@ esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
 
 void httpd_sess_close_all(struct httpd_data *hd)
 {
-    enum_context_t context = {
-        .task = HTTPD_TASK_CLOSE,
-        .hd = hd
-    };
-    httpd_sess_enum(hd, enum_function, &context);
+    while (hd->hd_sd_lru_head) {
+        V(TAG, LOG_FMT("cleaning up socket %d"), hd->hd_sd_lru_head->fd);
+        httpd_sess_delete(hd, hd->hd_sd_lru_head);
+    }
 }
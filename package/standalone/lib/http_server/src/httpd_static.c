@@ -0,0 +1,249 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <util_trace.h>
+#include <esp_err.h>
+
+#include <esp_http_server.h>
+#include <httpd_static.h>
+#include "esp_httpd_priv.h"
+
+static const int TAG = TT_SDK_HTTPD;
+
+/* Longest If-None-Match header checked, longer lists are treated as not matching */
+#define HTTPD_STATIC_INM_LEN    128
+
+/* Longest Accept-Encoding header checked, codings past it are not seen */
+#define HTTPD_STATIC_AE_LEN     64
+
+/* Compare a path of known length with a null terminated asset path, like strcmp() */
+static int httpd_static_path_cmp(const char *path, size_t len, const char *asset_path)
+{
+    int ret = strncmp(path, asset_path, len);
+    if (ret == 0 && asset_path[len] != '\0') {
+        return -1;
+    }
+    return ret;
+}
+
+const httpd_static_asset_t *httpd_static_find(const httpd_static_bundle_t *bundle, const char *path, size_t len)
+{
+    size_t lo = 0;
+    size_t hi = bundle->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int ret = httpd_static_path_cmp(path, len, bundle->assets[mid].path);
+        if (ret == 0) {
+            return &bundle->assets[mid];
+        }
+        if (ret < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+/* Check an If-None-Match list against an ETag, using the weak comparison
+ * the header calls for, i.e. ignoring W/ */
+static bool httpd_static_etag_match(const char *list, const char *etag)
+{
+    const size_t etag_len = strlen(etag);
+    const char *p = list;
+
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        if (strncmp(p, "W/", 2) == 0) {
+            p += 2;
+        }
+
+        const char *end = p;
+        while (*end && *end != ',') {
+            end++;
+        }
+        size_t len = end - p;
+        while (len && (p[len - 1] == ' ' || p[len - 1] == '\t')) {
+            len--;
+        }
+
+        if ((len == 1 && *p == '*') || (len == etag_len && memcmp(p, etag, len) == 0)) {
+            return true;
+        }
+        p = end;
+    }
+    return false;
+}
+
+/* A q-value of 0, i.e. "0" optionally followed by "." and zeros */
+static bool httpd_static_qvalue_zero(const char *q)
+{
+    if (*q++ != '0') {
+        return false;
+    }
+    while (*q == '.' || *q == '0') {
+        q++;
+    }
+    return *q == '\0' || *q == ',' || *q == ';' || *q == ' ' || *q == '\t';
+}
+
+/* Check an Accept-Encoding list for gzip. A gzip entry decides over *,
+ * and no header at all means identity only, as clients without gzip send */
+static bool httpd_static_accepts_gzip(httpd_req_t *req)
+{
+    char ae[HTTPD_STATIC_AE_LEN];
+    int gzip = -1;
+    int any = -1;
+
+    esp_err_t ret = httpd_req_get_hdr_value_str(req, "Accept-Encoding", ae, sizeof(ae));
+    if (ret != ESP_OK && ret != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return false;
+    }
+
+    const char *p = ae;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+
+        const char *end = p;
+        while (*end && *end != ',' && *end != ';' && *end != ' ' && *end != '\t') {
+            end++;
+        }
+        size_t len = end - p;
+        int *coding = NULL;
+        if ((len == 4 && strncasecmp(p, "gzip", 4) == 0) || (len == 6 && strncasecmp(p, "x-gzip", 6) == 0)) {
+            coding = &gzip;
+        } else if (len == 1 && *p == '*') {
+            coding = &any;
+        }
+
+        /* Of the parameters only q matters */
+        bool accepted = true;
+        for (p = end; *p && *p != ','; p++) {
+            if (*p != ';') {
+                continue;
+            }
+            do {
+                p++;
+            } while (*p == ' ' || *p == '\t');
+            if ((*p == 'q' || *p == 'Q') && p[1] == '=') {
+                accepted = !httpd_static_qvalue_zero(p + 2);
+            }
+        }
+
+        if (coding) {
+            *coding = accepted;
+        }
+    }
+    return gzip >= 0 ? gzip : any > 0;
+}
+
+static bool httpd_static_not_modified(httpd_req_t *req, const httpd_static_asset_t *asset)
+{
+    char inm[HTTPD_STATIC_INM_LEN];
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) != ESP_OK) {
+        return false;
+    }
+    return httpd_static_etag_match(inm, asset->etag);
+}
+
+/* A 304 carries no body and must not announce a zero Content-Length,
+ * so it is written here rather than through httpd_resp_send() */
+static esp_err_t httpd_static_send_304(httpd_req_t *req, const httpd_static_bundle_t *bundle,
+                                       const httpd_static_asset_t *asset, bool vary)
+{
+    char hdr[HTTPD_STATIC_INM_LEN + 96];
+    int len;
+
+    len = snprintf(hdr, sizeof(hdr), "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n%s%s%s%s\r\n",
+                   asset->etag, vary ? "Vary: Accept-Encoding\r\n" : "",
+                   bundle->cache_control ? "Cache-Control: " : "",
+                   bundle->cache_control ? bundle->cache_control : "",
+                   bundle->cache_control ? "\r\n" : "");
+    if (len < 0 || len >= sizeof(hdr)) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+
+    for (int sent = 0; sent < len; ) {
+        int ret = httpd_send(req, hdr + sent, len - sent);
+        if (ret <= 0) {
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+        sent += ret;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_static_handler(httpd_req_t *req)
+{
+    const httpd_static_bundle_t *bundle = req->user_ctx;
+    size_t path_len = strcspn(req->uri, "?#");
+
+    const httpd_static_asset_t *asset = httpd_static_find(bundle, req->uri, path_len);
+    if (!asset) {
+        V(TAG, LOG_FMT("no asset for %s"), req->uri);
+        return httpd_resp_send_404(req);
+    }
+
+    /* Only a gzip asset depends on Accept-Encoding, and only its responses say so */
+    bool vary = asset->gzip;
+    if (asset->gzip && !httpd_static_accepts_gzip(req)) {
+        if (!asset->identity) {
+            V(TAG, LOG_FMT("%s only stored gzip"), asset->path);
+            httpd_resp_set_status(req, "406 Not Acceptable");
+            httpd_resp_set_type(req, HTTPD_TYPE_TEXT);
+            httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+            return httpd_resp_sendstr(req, "Resource only available gzip encoded") == ESP_OK ? ESP_OK : ESP_FAIL;
+        }
+        asset = asset->identity;
+    }
+
+    if (httpd_static_not_modified(req, asset)) {
+        V(TAG, LOG_FMT("%s not modified"), asset->path);
+        return httpd_static_send_304(req, bundle, asset, vary) == ESP_OK ? ESP_OK : ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, asset->content_type);
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    if (asset->gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
+    if (vary) {
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+    if (bundle->cache_control) {
+        httpd_resp_set_hdr(req, "Cache-Control", bundle->cache_control);
+    }
+
+    /* The body goes to the socket straight from the bundle, the TCP stack
+     * takes it in pieces as its send buffer drains */
+    return httpd_resp_send(req, (const char *)asset->data, asset->len) == ESP_OK ? ESP_OK : ESP_FAIL;
+}
@@ -223,6 +223,65 @@ esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
     return ESP_OK;
 }
 
+/* Send out what has been assembled in the response buffer */
+static esp_err_t httpd_resp_flush(httpd_req_t *r)
+{
+    struct httpd_req_aux *ra = r->aux;
+    size_t len = ra->resp_len;
+
+    ra->resp_len = 0;
+    if (len == 0) {
+        return ESP_OK;
+    }
+    return httpd_send_all(r, ra->resp_buf, len);
+}
+
+/* Append to the response buffer. The buffer is flushed when buf doesn't fit,
+ * and anything too large to be gathered at all is sent as it is */
+static esp_err_t httpd_resp_append(httpd_req_t *r, const char *buf, size_t buf_len)
+{
+    struct httpd_req_aux *ra = r->aux;
+
+    if (buf_len == 0) {
+        return ESP_OK;
+    }
+    if (buf_len > CONFIG_HTTPD_RESP_BUF_LEN - ra->resp_len) {
+        if (httpd_resp_flush(r) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (buf_len >= CONFIG_HTTPD_RESP_BUF_LEN) {
+            return httpd_send_all(r, buf, buf_len);
+        }
+    }
+    memcpy(ra->resp_buf + ra->resp_len, buf, buf_len);
+    ra->resp_len += buf_len;
+    return ESP_OK;
+}
+
+/* Append the essential headers in ra->scratch, the additional headers
+ * based on set_header and the end of the header section */
+static esp_err_t httpd_resp_append_hdrs(httpd_req_t *r)
+{
+    struct httpd_req_aux *ra = r->aux;
+    const char *colon_separator = ": ";
+    const char *cr_lf_seperator = "\r\n";
+
+    if (httpd_resp_append(r, ra->scratch, strlen(ra->scratch)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
+        if (httpd_resp_append(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK ||
+            httpd_resp_append(r, colon_separator, strlen(colon_separator)) != ESP_OK ||
+            httpd_resp_append(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK ||
+            httpd_resp_append(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+
+    return httpd_resp_append(r, cr_lf_seperator, strlen(cr_lf_seperator));
+}
+
 esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
 {
     if (r == NULL) {
@@ -235,8 +294,6 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
 
     struct httpd_req_aux *ra = r->aux;
     const char *httpd_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     if (buf_len == HTTPD_RESP_USE_STRLEN) {
         buf_len = strlen(buf);
@@ -251,42 +308,23 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
         return ESP_ERR_HTTPD_RESP_HDR;
     }
 
-    /* Sending essential headers */
-    if (httpd_send_all(r, ra->scratch, strlen(ra->scratch)) != ESP_OK) {
+    /* Headers and a body that fits in the response buffer go out in one send */
+    if (httpd_resp_append_hdrs(r) != ESP_OK) {
+        ra->resp_len = 0;
         return ESP_ERR_HTTPD_RESP_SEND;
     }
 
-    /* Sending additional headers based on set_header */
-    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-        /* Send header field */
-        if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send ': ' */
-        if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send header value */
-        if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send CR + LF */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+    /* Sending content */
+    if (buf && buf_len) {
+        if (httpd_resp_append(r, buf, buf_len) != ESP_OK) {
+            ra->resp_len = 0;
             return ESP_ERR_HTTPD_RESP_SEND;
         }
     }
 
-    /* End header section */
-    if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+    if (httpd_resp_flush(r) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
-
-    /* Sending content */
-    if (buf && buf_len) {
-        if (httpd_send_all(r, buf, buf_len) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-    }
     return ESP_OK;
 }
 
@@ -306,8 +344,6 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
 
     struct httpd_req_aux *ra = r->aux;
     const char *httpd_chunked_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
@@ -319,53 +355,33 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
             return ESP_ERR_HTTPD_RESP_HDR;
         }
 
-        /* Sending essential headers */
-        if (httpd_send_all(r, ra->scratch, strlen(ra->scratch)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-
-        /* Sending additional headers based on set_header */
-        for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-            /* Send header field */
-            if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send ': ' */
-            if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send header value */
-            if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send CR + LF */
-            if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-        }
-
-        /* End header section */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+        /* The headers go out together with the first chunk */
+        if (httpd_resp_append_hdrs(r) != ESP_OK) {
+            ra->resp_len = 0;
             return ESP_ERR_HTTPD_RESP_SEND;
         }
         ra->first_chunk_sent = true;
     }
 
-    /* Sending chunked content */
+    /* Chunk size line, chunk data and the end of chunk are sent together */
     char len_str[10];
     snprintf(len_str, sizeof(len_str), "%lx\r\n", (long)buf_len);
-    if (httpd_send_all(r, len_str, strlen(len_str)) != ESP_OK) {
+    if (httpd_resp_append(r, len_str, strlen(len_str)) != ESP_OK) {
+        ra->resp_len = 0;
         return ESP_ERR_HTTPD_RESP_SEND;
     }
 
     if (buf) {
-        if (httpd_send_all(r, buf, (size_t) buf_len) != ESP_OK) {
+        if (httpd_resp_append(r, buf, (size_t) buf_len) != ESP_OK) {
+            ra->resp_len = 0;
             return ESP_ERR_HTTPD_RESP_SEND;
         }
     }
 
     /* Indicate end of chunk */
-    if (httpd_send_all(r, "\r\n", strlen("\r\n")) != ESP_OK) {
+    if (httpd_resp_append(r, "\r\n", strlen("\r\n")) != ESP_OK ||
+        httpd_resp_flush(r) != ESP_OK) {
+        ra->resp_len = 0;
         return ESP_ERR_HTTPD_RESP_SEND;
     }
 
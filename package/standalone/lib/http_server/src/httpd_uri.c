@@ -79,13 +79,254 @@ bool httpd_uri_match_wildcard(const char *template, const char *uri, size_t len)
     }
 }
 
+/* URI router
+ *
+ * The registered URIs are compiled into a radix trie, so that finding the
+ * handler for a request costs time proportional to the URI length rather
+ * than to the number of handlers. Every node holds the fragment of URI that
+ * leads to it from its parent and the routes of the handlers whose URI ends
+ * there. With httpd_uri_match_wildcard() a trailing '*' makes a prefix route
+ * and an optional character marked by '?' adds a route for the URI without
+ * it. A custom uri_match_fn can't be compiled, handlers are then tried one
+ * by one as before.
+ */
+struct httpd_uri_route {
+    struct httpd_uri_route *next;   /*!< Next route ending at the same node */
+    httpd_uri_t *handler;           /*!< Registered handler */
+    int index;                      /*!< Position of the handler in hd_calls, the lowest one wins */
+    bool prefix;                    /*!< Also matches URIs continuing past the node */
+};
+
+struct httpd_uri_node {
+    struct httpd_uri_node *child;   /*!< First child */
+    struct httpd_uri_node *next;    /*!< Next sibling, whose fragment starts with another character */
+    struct httpd_uri_route *routes; /*!< Routes ending at this node, in hd_calls order */
+    size_t len;                     /*!< Length of the fragment */
+    char frag[];                    /*!< Fragment of URI leading to this node */
+};
+
+static bool httpd_uri_router_usable(struct httpd_data *hd)
+{
+    return (!hd->config.uri_match_fn) || (hd->config.uri_match_fn == httpd_uri_match_wildcard);
+}
+
+static struct httpd_uri_node *httpd_uri_node_new(const char *frag, size_t len)
+{
+    struct httpd_uri_node *node = calloc(1, sizeof(struct httpd_uri_node) + len);
+    if (node) {
+        memcpy(node->frag, frag, len);
+        node->len = len;
+    }
+    return node;
+}
+
+static void httpd_uri_node_free(struct httpd_uri_node *node)
+{
+    while (node) {
+        struct httpd_uri_node *next = node->next;
+        while (node->routes) {
+            struct httpd_uri_route *route = node->routes;
+            node->routes = route->next;
+            free(route);
+        }
+        httpd_uri_node_free(node->child);
+        free(node);
+        node = next;
+    }
+}
+
+/* Returns the node for key, adding it if missing */
+static struct httpd_uri_node *httpd_uri_node_insert(struct httpd_uri_node *root, const char *key, size_t len)
+{
+    struct httpd_uri_node *node = root;
+    size_t pos = 0;
+
+    while (pos < len) {
+        struct httpd_uri_node **link = &node->child;
+        while (*link && (*link)->frag[0] != key[pos]) {
+            link = &(*link)->next;
+        }
+
+        struct httpd_uri_node *child = *link;
+        if (!child) {
+            child = httpd_uri_node_new(key + pos, len - pos);
+            if (child) {
+                *link = child;
+            }
+            return child;
+        }
+
+        size_t common = 1;
+        while (common < child->len && pos + common < len && child->frag[common] == key[pos + common]) {
+            common++;
+        }
+
+        if (common < child->len) {
+            /* Split the child where the key diverges from its fragment */
+            struct httpd_uri_node *mid = httpd_uri_node_new(child->frag, common);
+            if (!mid) {
+                return NULL;
+            }
+            mid->next = child->next;
+            mid->child = child;
+            child->next = NULL;
+            child->len -= common;
+            memmove(child->frag, child->frag + common, child->len);
+            *link = mid;
+            child = mid;
+        }
+
+        node = child;
+        pos += common;
+    }
+    return node;
+}
+
+static esp_err_t httpd_uri_route_add(struct httpd_uri_node *root, const char *key, size_t len,
+                                     int index, bool prefix, httpd_uri_t *handler)
+{
+    struct httpd_uri_node *node = httpd_uri_node_insert(root, key, len);
+    if (!node) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+
+    struct httpd_uri_route *route = calloc(1, sizeof(struct httpd_uri_route));
+    if (!route) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    route->handler = handler;
+    route->index = index;
+    route->prefix = prefix;
+
+    /* Handlers are added in hd_calls order, so appending keeps the list sorted */
+    struct httpd_uri_route **link = &node->routes;
+    while (*link) {
+        link = &(*link)->next;
+    }
+    *link = route;
+    return ESP_OK;
+}
+
+/* Compile hd_calls[index] into the trie */
+static esp_err_t httpd_uri_router_add(struct httpd_data *hd, int index)
+{
+    httpd_uri_t *handler = hd->hd_calls[index];
+    const char *template = handler->uri;
+    const size_t tpl_len = strlen(template);
+
+    if (!hd->config.uri_match_fn) {
+        return httpd_uri_route_add(hd->hd_uri_trie, template, tpl_len, index, false, handler);
+    }
+
+    /* Same template syntax as httpd_uri_match_wildcard() */
+    const char last = (const char) (tpl_len > 0 ? template[tpl_len - 1] : 0);
+    const char prevlast = (const char) (tpl_len > 1 ? template[tpl_len - 2] : 0);
+    const bool asterisk = last == '*' || (prevlast == '*' && last == '?');
+    const bool quest = last == '?' || (prevlast == '?' && last == '*');
+
+    if (tpl_len < asterisk + quest*2) {
+        /* Invalid template, never matches */
+        return ESP_OK;
+    }
+
+    size_t exact_match_chars = tpl_len - (asterisk + quest*2);
+    if (!quest) {
+        return httpd_uri_route_add(hd->hd_uri_trie, template, exact_match_chars, index, asterisk, handler);
+    }
+
+    /* Without the optional character the URI must end there, with it the asterisk applies */
+    esp_err_t ret = httpd_uri_route_add(hd->hd_uri_trie, template, exact_match_chars, index, false, handler);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return httpd_uri_route_add(hd->hd_uri_trie, template, exact_match_chars + 1, index, asterisk, handler);
+}
+
+static void httpd_uri_router_free(struct httpd_data *hd)
+{
+    httpd_uri_node_free(hd->hd_uri_trie);
+    hd->hd_uri_trie = NULL;
+}
+
+/* (Re)compile all registered handlers. If memory runs out the trie
+ * is dropped and lookups go through hd_calls until the next change */
+static void httpd_uri_router_build(struct httpd_data *hd)
+{
+    httpd_uri_router_free(hd);
+    if (!httpd_uri_router_usable(hd)) {
+        return;
+    }
+
+    hd->hd_uri_trie = httpd_uri_node_new("", 0);
+    if (!hd->hd_uri_trie) {
+        return;
+    }
+
+    for (int i = 0; i < hd->config.max_uri_handlers && hd->hd_calls[i]; i++) {
+        if (httpd_uri_router_add(hd, i) != ESP_OK) {
+            E(TAG, LOG_FMT("no memory to compile URI handlers"));
+            httpd_uri_router_free(hd);
+            return;
+        }
+    }
+}
+
+static httpd_uri_t *httpd_uri_router_find(struct httpd_data *hd,
+                                          const char *uri, size_t uri_len,
+                                          httpd_method_t method,
+                                          httpd_err_code_t *err)
+{
+    const struct httpd_uri_node *node = hd->hd_uri_trie;
+    const struct httpd_uri_route *found = NULL;
+    bool uri_found = false;
+    size_t pos = 0;
+
+    while (1) {
+        for (const struct httpd_uri_route *route = node->routes; route; route = route->next) {
+            if (!route->prefix && pos != uri_len) {
+                continue;
+            }
+            uri_found = true;
+            if (route->handler->method == method) {
+                if (!found || route->index < found->index) {
+                    found = route;
+                }
+                break;
+            }
+        }
+
+        if (pos == uri_len) {
+            break;
+        }
+
+        const struct httpd_uri_node *child = node->child;
+        while (child && child->frag[0] != uri[pos]) {
+            child = child->next;
+        }
+        if (!child || child->len > uri_len - pos || memcmp(child->frag, uri + pos, child->len) != 0) {
+            break;
+        }
+        node = child;
+        pos += child->len;
+    }
+
+    if (err) {
+        *err = found ? 0 : (uri_found ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND);
+    }
+    return found ? found->handler : NULL;
+}
+
 /* Find handler with matching URI and method, and set
  * appropriate error code if URI or method not found */
-static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
-                                           const char *uri, size_t uri_len,
-                                           httpd_method_t method,
-                                           httpd_err_code_t *err)
+httpd_uri_t *httpd_find_uri_handler(struct httpd_data *hd,
+                                    const char *uri, size_t uri_len,
+                                    httpd_method_t method,
+                                    httpd_err_code_t *err)
 {
+    if (hd->hd_uri_trie && httpd_uri_router_usable(hd)) {
+        return httpd_uri_router_find(hd, uri, uri_len, method, err);
+    }
+
     if (err) {
         *err = HTTPD_404_NOT_FOUND;
     }
@@ -173,6 +414,14 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
             }
 #endif
             V(TAG, LOG_FMT("[%d] installed %s"), i, uri_handler->uri);
+
+            /* Compile the new handler, or everything if there is no trie yet */
+            if (!hd->hd_uri_trie) {
+                httpd_uri_router_build(hd);
+            } else if (httpd_uri_router_add(hd, i) != ESP_OK) {
+                E(TAG, LOG_FMT("no memory to compile URI handlers"));
+                httpd_uri_router_free(hd);
+            }
             return ESP_OK;
         }
         V(TAG, LOG_FMT("[%d] exists %s"), i, hd->hd_calls[i]->uri);
@@ -211,6 +460,7 @@ esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle,
             }
             /* Nullify the following non null entry */
             hd->hd_calls[i-1] = NULL;
+            httpd_uri_router_build(hd);
             return ESP_OK;
         }
     }
@@ -254,6 +504,8 @@ esp_err_t httpd_unregister_uri(httpd_handle_t handle, const char *uri)
 
     if (!found) {
         E(TAG, LOG_FMT("no handler found for URI %s"), uri);
+    } else {
+        httpd_uri_router_build(hd);
     }
     return (found ? ESP_OK : ESP_ERR_NOT_FOUND);
 }
@@ -270,6 +522,7 @@ void httpd_unregister_all_uri_handlers(struct httpd_data *hd)
         free(hd->hd_calls[i]);
         hd->hd_calls[i] = NULL;
     }
+    httpd_uri_router_free(hd);
 }
 
 esp_err_t httpd_uri(struct httpd_data *hd)
@@ -11,6 +11,7 @@
 #include <string.h>
 //#include <sys/random.h>
 #include <esp_log.h>
+#include <util_trace.h>
 #include <esp_err.h>
 #include <mbedtls/sha1.h>
 #include <mbedtls/base64.h>
@@ -46,6 +47,18 @@ static const int TAG = TT_SDK_HTTPD;
 #define HTTPD_WS_MASK_BIT       0x80U
 #define HTTPD_WS_LENGTH_BITS    0x7fU
 
+/* Longest frame headers: a client's has 2 bytes, 8 bytes of length and a
+ * 4 bytes mask key, the server's has no mask key */
+#define HTTPD_WS_MAX_HEADER_LEN     14
+#define HTTPD_WS_MAX_TX_HEADER_LEN  10
+
+/* Control frames have a payload of at most 125 bytes */
+#define HTTPD_WS_MAX_CONTROL_LEN    125
+
+/* Whether the payload is sent in one go with the header */
+#define HTTPD_WS_TX_COALESCED(frame) \
+    ((frame)->len > 0 && (frame)->payload != NULL && (frame)->len <= CONFIG_HTTPD_WS_TX_COALESCE_LEN)
+
 /*
  * The magic GUID string used for handshake
  * Please refer to RFC6455 Section 1.3 for more details.
@@ -229,17 +242,119 @@ static esp_err_t httpd_ws_check_req(httpd_req_t *req)
     return ESP_OK;
 }
 
-static esp_err_t httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key)
+/* Unmasks len bytes in place, which start at byte pos of the payload. The bulk
+ * is done a 32 bit word at a time, with the key rotated to line up with the words */
+static void httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key, size_t pos)
 {
-    if (len < 1 || !payload) {
-        E(TAG, LOG_FMT("Invalid payload provided"));
-        return ESP_ERR_INVALID_ARG;
+    /* Bytes up to the first word boundary */
+    while (len > 0 && ((uintptr_t)payload & 3U)) {
+        *payload++ ^= mask_key[pos++ & 3U];
+        len--;
+    }
+
+    if (len >= 4) {
+        uint8_t key_bytes[4] = {
+            mask_key[pos & 3U], mask_key[(pos + 1) & 3U], mask_key[(pos + 2) & 3U], mask_key[(pos + 3) & 3U]
+        };
+        uint32_t key;
+        memcpy(&key, key_bytes, sizeof(key));
+
+        for (; len >= 4; len -= 4, payload += 4) {
+            uint32_t word;
+            memcpy(&word, payload, sizeof(word));
+            word ^= key;
+            memcpy(payload, &word, sizeof(word));
+        }
     }
 
-    for (size_t idx = 0; idx < len; idx++) {
-        payload[idx] = (payload[idx] ^ mask_key[idx % 4]);
+    /* Whole words leave pos in phase for the last bytes */
+    while (len > 0) {
+        *payload++ ^= mask_key[pos++ & 3U];
+        len--;
+    }
+}
+
+/* Length of the frame header starting with these 2 bytes */
+static size_t httpd_ws_header_len(const uint8_t *header_buf)
+{
+    size_t len = 2;
+    uint8_t init_len = header_buf[1] & HTTPD_WS_LENGTH_BITS;
+
+    if (init_len == 126) {
+        len += 2;
+    } else if (init_len == 127) {
+        len += 8;
     }
+    if (header_buf[1] & HTTPD_WS_MASK_BIT) {
+        len += 4;
+    }
+    return len;
+}
+
+/* Receives the header of the next frame into the request aux.
+ * Every read asks for the longest header, so the header normally comes in one
+ * recv(), and whatever followed it is put back to the pending data */
+static esp_err_t httpd_ws_recv_header(httpd_req_t *req)
+{
+    struct httpd_req_aux *aux = req->aux;
+    uint8_t header_buf[HTTPD_WS_MAX_HEADER_LEN];
+    size_t header_len = 2;
+    size_t got = 0;
 
+    while (got < header_len) {
+        /* Halting after pending data, so that recv() doesn't wait for more than was sent */
+        int read_len = httpd_recv_with_opt(req, (char *)header_buf + got, sizeof(header_buf) - got, true);
+        if (read_len <= 0) {
+            E(TAG, LOG_FMT("Failed to receive frame header"));
+            return ESP_FAIL;
+        }
+        got += read_len;
+        if (got >= 2) {
+            header_len = httpd_ws_header_len(header_buf);
+        }
+    }
+
+    /* The last read alone went past the header. If it was taken from the pending
+     * data, the bytes are still in place in front of what is left of it */
+    if (got > header_len) {
+        if (aux->sd->pending_len > 0) {
+            aux->sd->pending_len += got - header_len;
+        } else {
+            httpd_unrecv(req, (char *)header_buf + header_len, got - header_len);
+        }
+    }
+
+    /* Please refer to RFC6455 Section 5.2 for more details */
+    aux->ws_final = (header_buf[0] & HTTPD_WS_FIN_BIT) != 0;
+    aux->ws_type = (header_buf[0] & HTTPD_WS_OPCODE_BITS);
+    aux->ws_masked = (header_buf[1] & HTTPD_WS_MASK_BIT) != 0;
+
+    const uint8_t *ext = header_buf + 2;
+    uint8_t init_len = header_buf[1] & HTTPD_WS_LENGTH_BITS;
+    if (init_len < 126) {
+        /* Case 1: If length is 0-125, then this length bit is 7 bits */
+        aux->ws_len = init_len;
+    } else if (init_len == 126) {
+        /* Case 2: If length byte is 126, then this frame's length bit is 16 bits */
+        aux->ws_len = ((size_t)ext[0] << 8U) | ext[1];
+        ext += 2;
+    } else {
+        /* Case 3: If length is byte 127, then this frame's length bit is 64 bits */
+        uint64_t len64 = 0;
+        for (int idx = 0; idx < 8; idx++) {
+            len64 = (len64 << 8U) | ext[idx];
+        }
+        ext += 8;
+        if (len64 > SIZE_MAX) {
+            E(TAG, LOG_FMT("WS frame too long"));
+            return ESP_ERR_INVALID_SIZE;
+        }
+        aux->ws_len = len64;
+    }
+
+    if (aux->ws_masked) {
+        memcpy(aux->mask_key, ext, sizeof(aux->mask_key));
+    }
     return ESP_OK;
 }
 
@@ -262,59 +377,12 @@ esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t
     }
     /* If frame len is 0, will get frame len from req. Otherwise regard frame len already achieved by calling httpd_ws_recv_frame before */
     if (frame->len == 0) {
-        /* Assign the frame info from the previous reading */
+        /* Assign the frame info from the header, received with the frame type */
         frame->type = aux->ws_type;
         frame->final = aux->ws_final;
+        frame->len = aux->ws_len;
 
-        /* Grab the second byte */
-        uint8_t second_byte = 0;
-        if (httpd_recv_with_opt(req, (char *)&second_byte, sizeof(second_byte), false) <= 0) {
-            E(TAG, LOG_FMT("Failed to receive the second byte"));
-            return ESP_FAIL;
-        }
-
-        /* Parse the second byte */
-        /* Please refer to RFC6455 Section 5.2 for more details */
-        bool masked = (second_byte & HTTPD_WS_MASK_BIT) != 0;
-
-        /* Interpret length */
-        uint8_t init_len = second_byte & HTTPD_WS_LENGTH_BITS;
-        if (init_len < 126) {
-            /* Case 1: If length is 0-125, then this length bit is 7 bits */
-            frame->len = init_len;
-        } else if (init_len == 126) {
-            /* Case 2: If length byte is 126, then this frame's length bit is 16 bits */
-            uint8_t length_bytes[2] = { 0 };
-            if (httpd_recv_with_opt(req, (char *)length_bytes, sizeof(length_bytes), false) <= 0) {
-                E(TAG, LOG_FMT("Failed to receive 2 bytes length"));
-                return ESP_FAIL;
-            }
-
-            frame->len = ((uint32_t)(length_bytes[0] << 8U) | (length_bytes[1]));
-        } else if (init_len == 127) {
-            /* Case 3: If length is byte 127, then this frame's length bit is 64 bits */
-            uint8_t length_bytes[8] = { 0 };
-            if (httpd_recv_with_opt(req, (char *)length_bytes, sizeof(length_bytes), false) <= 0) {
-                E(TAG, LOG_FMT("Failed to receive 2 bytes length"));
-                return ESP_FAIL;
-            }
-
-            frame->len = (((uint64_t)length_bytes[0] << 56U) |
-                    ((uint64_t)length_bytes[1] << 48U) |
-                    ((uint64_t)length_bytes[2] << 40U) |
-                    ((uint64_t)length_bytes[3] << 32U) |
-                    ((uint64_t)length_bytes[4] << 24U) |
-                    ((uint64_t)length_bytes[5] << 16U) |
-                    ((uint64_t)length_bytes[6] <<  8U) |
-                    ((uint64_t)length_bytes[7]));
-        }
-        /* If this frame is masked, dump the mask as well */
-        if (masked) {
-            if (httpd_recv_with_opt(req, (char *)aux->mask_key, sizeof(aux->mask_key), false) <= 0) {
-                E(TAG, LOG_FMT("Failed to receive mask key"));
-                return ESP_FAIL;
-            }
-        } else {
+        if (!aux->ws_masked) {
             /* If the WS frame from client to server is not masked, it should be rejected.
              * Please refer to RFC6455 Section 5.2 for more details. */
             E(TAG, LOG_FMT("WS frame is not properly masked."));
@@ -352,85 +420,303 @@ esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t
             E(TAG, LOG_FMT("Failed to receive payload"));
             return ESP_FAIL;
         }
+        /* Unmask payload while it is still in cache */
+        httpd_ws_unmask_payload(frame->payload + offset, read_len, aux->mask_key, offset);
+
         offset += read_len;
         left_len -= read_len;
 
         V(TAG, "Frame length: %d, Bytes Read: %d", frame->len, offset);
     }
 
-    /* Unmask payload */
-    httpd_ws_unmask_payload(frame->payload, frame->len, aux->mask_key);
-
     return ESP_OK;
 }
 
-esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
+/* Hands the received part of a message over to the callback */
+static esp_err_t httpd_ws_stream_chunk(httpd_req_t *req, httpd_ws_frame_t *chunk, size_t *offset,
+                                       httpd_ws_chunk_func_t cb, void *arg)
+{
+    esp_err_t ret = cb(req, chunk, *offset, arg);
+
+    *offset += chunk->len;
+    chunk->len = 0;
+    return ret;
+}
+
+/* Handles a control frame that came in between the fragments of a message */
+static esp_err_t httpd_ws_stream_control(httpd_req_t *req, httpd_ws_frame_t *chunk, size_t *offset,
+                                         httpd_ws_chunk_func_t cb, void *arg)
+{
+    struct httpd_req_aux *aux = req->aux;
+    uint8_t frame_buf[HTTPD_WS_MAX_CONTROL_LEN];
+    httpd_ws_frame_t frame;
+    esp_err_t ret;
+
+    memset(&frame, 0, sizeof(httpd_ws_frame_t));
+    frame.payload = frame_buf;
+
+    if (!aux->ws_final || httpd_ws_recv_frame(req, &frame, sizeof(frame_buf)) != ESP_OK) {
+        E(TAG, LOG_FMT("Cannot receive the full control frame"));
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (aux->sd->ws_control_frames) {
+        /* The handler takes control frames, pass it on after the data before it */
+        ret = ESP_OK;
+        if (chunk->len > 0) {
+            ret = httpd_ws_stream_chunk(req, chunk, offset, cb, arg);
+        }
+        if (ret == ESP_OK) {
+            ret = cb(req, &frame, 0, arg);
+        }
+    } else if (frame.type == HTTPD_WS_TYPE_PING) {
+        frame.type = HTTPD_WS_TYPE_PONG;
+        ret = httpd_ws_send_frame(req, &frame);
+    } else if (frame.type == HTTPD_WS_TYPE_CLOSE) {
+        frame.len = 0;
+        frame.payload = NULL;
+        ret = httpd_ws_send_frame(req, &frame);
+    } else {
+        ret = ESP_OK;
+    }
+
+    if (ret == ESP_OK && frame.type == HTTPD_WS_TYPE_CLOSE) {
+        /* The rest of the message is never coming */
+        aux->sd->ws_close = true;
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    return ret;
+}
+
+esp_err_t httpd_ws_recv_frame_stream(httpd_req_t *req, uint8_t *buf, size_t buf_len,
+                                     httpd_ws_chunk_func_t cb, void *arg)
 {
     esp_err_t ret = httpd_ws_check_req(req);
     if (ret != ESP_OK) {
         return ret;
     }
-    return httpd_ws_send_frame_async(req->handle, httpd_req_to_sockfd(req), frame);
-}
 
-esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
-{
-    if (!frame) {
+    if (!buf || buf_len == 0 || !cb) {
         E(TAG, LOG_FMT("Argument is invalid"));
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Prepare Tx buffer - maximum length is 14, which includes 2 bytes header, 8 bytes length, 4 bytes mask key */
+    struct httpd_req_aux *aux = req->aux;
+    httpd_ws_frame_t chunk;
+    size_t offset = 0;
+
+    memset(&chunk, 0, sizeof(httpd_ws_frame_t));
+    chunk.type = aux->ws_type;
+    chunk.payload = buf;
+
+    while (1) {
+        if (!aux->ws_masked) {
+            E(TAG, LOG_FMT("WS frame is not properly masked."));
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        /* Fill buf, across the fragments of the message, and unmask it where it is */
+        size_t left_len = aux->ws_len;
+        size_t pos = 0;
+        while (left_len > 0) {
+            int read_len = httpd_recv_with_opt(req, (char *)buf + chunk.len, MIN(left_len, buf_len - chunk.len), false);
+            if (read_len <= 0) {
+                E(TAG, LOG_FMT("Failed to receive payload"));
+                return ESP_FAIL;
+            }
+            httpd_ws_unmask_payload(buf + chunk.len, read_len, aux->mask_key, pos);
+
+            pos += read_len;
+            left_len -= read_len;
+            chunk.len += read_len;
+
+            /* A full buf that ends the message is the final chunk */
+            if (chunk.len == buf_len && (left_len > 0 || !aux->ws_final)) {
+                ret = httpd_ws_stream_chunk(req, &chunk, &offset, cb, arg);
+                if (ret != ESP_OK) {
+                    return ret;
+                }
+            }
+        }
+
+        if (aux->ws_final) {
+            break;
+        }
+
+        /* Next fragment, control frames may come in between */
+        do {
+            ret = httpd_ws_recv_header(req);
+            if (ret != ESP_OK) {
+                return ESP_FAIL;
+            }
+            if (aux->ws_type == HTTPD_WS_TYPE_CONTINUE) {
+                break;
+            }
+            if (aux->ws_type < HTTPD_WS_TYPE_CLOSE) {
+                E(TAG, LOG_FMT("WS message interrupted by a new one"));
+                return ESP_ERR_INVALID_STATE;
+            }
+            ret = httpd_ws_stream_control(req, &chunk, &offset, cb, arg);
+        } while (ret == ESP_OK);
+
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    chunk.final = true;
+    return httpd_ws_stream_chunk(req, &chunk, &offset, cb, arg);
+}
+
+esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
+{
+    esp_err_t ret = httpd_ws_check_req(req);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return httpd_ws_send_frame_async(req->handle, httpd_req_to_sockfd(req), frame);
+}
+
+/* Puts the frame header into tx_buf, followed by the payload if it fits in
+ * CONFIG_HTTPD_WS_TX_COALESCE_LEN, and returns the length of that */
+static size_t httpd_ws_prepare_tx(uint8_t *tx_buf, const httpd_ws_frame_t *frame)
+{
     uint8_t tx_len = 0;
-    uint8_t header_buf[10] = {0 };
+    memset(tx_buf, 0, HTTPD_WS_MAX_TX_HEADER_LEN);
     /* Set the `FIN` bit by default if message is not fragmented. Else, set it as per the `final` field */
-    header_buf[0] |= (!frame->fragmented) ? HTTPD_WS_FIN_BIT : (frame->final? HTTPD_WS_FIN_BIT: HTTPD_WS_CONTINUE);
-    header_buf[0] |= frame->type; /* Type (opcode): 4 bits */
+    tx_buf[0] |= (!frame->fragmented) ? HTTPD_WS_FIN_BIT : (frame->final? HTTPD_WS_FIN_BIT: HTTPD_WS_CONTINUE);
+    tx_buf[0] |= frame->type; /* Type (opcode): 4 bits */
 
     if (frame->len <= 125) {
-        header_buf[1] = frame->len & 0x7fU; /* Length for 7 bits */
+        tx_buf[1] = frame->len & 0x7fU; /* Length for 7 bits */
         tx_len = 2;
     } else if (frame->len > 125 && frame->len < UINT16_MAX) {
-        header_buf[1] = 126;                /* Length for 16 bits */
-        header_buf[2] = (frame->len >> 8U) & 0xffU;
-        header_buf[3] = frame->len & 0xffU;
+        tx_buf[1] = 126;                /* Length for 16 bits */
+        tx_buf[2] = (frame->len >> 8U) & 0xffU;
+        tx_buf[3] = frame->len & 0xffU;
         tx_len = 4;
     } else {
-        header_buf[1] = 127;                /* Length for 64 bits */
+        tx_buf[1] = 127;                /* Length for 64 bits */
         uint8_t shift_idx = sizeof(uint64_t) - 1; /* Shift index starts at 7 */
         uint64_t len64 = frame->len; /* Raise variable size to make sure we won't shift by more bits
                                       * than the length has (to avoid undefined behaviour) */
         for (int8_t idx = 2; idx <= 9; idx++) {
             /* Now do shifting (be careful of endianness, i.e. when buffer index is 2, frame length shift index is 7) */
-            header_buf[idx] = (len64 >> (shift_idx * 8)) & 0xffU;
+            tx_buf[idx] = (len64 >> (shift_idx * 8)) & 0xffU;
             shift_idx--;
         }
         tx_len = 10;
     }
 
     /* WebSocket server does not required to mask response payload, so leave the MASK bit as 0. */
-    header_buf[1] &= (~HTTPD_WS_MASK_BIT);
+    tx_buf[1] &= (~HTTPD_WS_MASK_BIT);
+
+    if (HTTPD_WS_TX_COALESCED(frame)) {
+        memcpy(tx_buf + tx_len, frame->payload, frame->len);
+        return tx_len + frame->len;
+    }
+    return tx_len;
+}
+
+/* Sends a frame prepared by httpd_ws_prepare_tx() to one client */
+static esp_err_t httpd_ws_send_tx(struct httpd_data *hd, struct sock_db *sess, const uint8_t *tx_buf, size_t tx_len,
+                                  const httpd_ws_frame_t *frame)
+{
+    while (tx_len > 0) {
+        int ret = sess->send_fn(hd, sess->fd, (const char *)tx_buf, tx_len, 0);
+        if (ret < 0) {
+            E(TAG, LOG_FMT("Failed to send WS header"));
+            return ESP_FAIL;
+        }
+        tx_buf += ret;
+        tx_len -= ret;
+    }
+
+    /* Send off payload, unless it went with the header */
+    if (frame->len > 0 && frame->payload != NULL && !HTTPD_WS_TX_COALESCED(frame)) {
+        const char *payload = (const char *)frame->payload;
+        size_t left_len = frame->len;
+        while (left_len > 0) {
+            int ret = sess->send_fn(hd, sess->fd, payload, left_len, 0);
+            if (ret < 0) {
+                E(TAG, LOG_FMT("Failed to send WS payload"));
+                return ESP_FAIL;
+            }
+            payload += ret;
+            left_len -= ret;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+    if (!frame) {
+        E(TAG, LOG_FMT("Argument is invalid"));
+        return ESP_ERR_INVALID_ARG;
+    }
 
     struct sock_db *sess = httpd_sess_get(hd, fd);
     if (!sess) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Send off header */
-    if (sess->send_fn(hd, fd, (const char *)header_buf, tx_len, 0) < 0) {
-        E(TAG, LOG_FMT("Failed to send WS header"));
-        return ESP_FAIL;
+    /* Prepare Tx buffer - maximum header length is 10, which includes 2 bytes header and 8 bytes length */
+    uint8_t tx_buf[HTTPD_WS_MAX_TX_HEADER_LEN + CONFIG_HTTPD_WS_TX_COALESCE_LEN];
+    size_t tx_len = httpd_ws_prepare_tx(tx_buf, frame);
+
+    return httpd_ws_send_tx(hd, sess, tx_buf, tx_len, frame);
+}
+
+/* Sends a broadcast frame to one client, and reports the outcome */
+static esp_err_t httpd_ws_broadcast_to(struct httpd_data *hd, struct sock_db *sess, int fd,
+                                       const uint8_t *tx_buf, size_t tx_len, const httpd_ws_frame_t *frame,
+                                       transfer_complete_cb callback, void *arg)
+{
+    esp_err_t err = ESP_ERR_INVALID_ARG;
+
+    if (sess && sess->ws_handshake_done && !sess->ws_close) {
+        err = httpd_ws_send_tx(hd, sess, tx_buf, tx_len, frame);
+    }
+    if (callback) {
+        callback(err, fd, arg);
     }
+    return err;
+}
 
-    /* Send off payload */
-    if(frame->len > 0 && frame->payload != NULL) {
-        if (sess->send_fn(hd, fd, (const char *)frame->payload, frame->len, 0) < 0) {
-            E(TAG, LOG_FMT("Failed to send WS payload"));
-            return ESP_FAIL;
-        }
+esp_err_t httpd_ws_broadcast_frame_async(httpd_handle_t handle, const int *fds, size_t fd_count,
+                                         httpd_ws_frame_t *frame, transfer_complete_cb callback, void *arg)
+{
+    struct httpd_data *hd = (struct httpd_data *) handle;
+    if (!hd || !frame || (!fds && fd_count > 0)) {
+        E(TAG, LOG_FMT("Argument is invalid"));
+        return ESP_ERR_INVALID_ARG;
     }
 
-    return ESP_OK;
+    /* The frame is prepared once for all of the clients */
+    uint8_t tx_buf[HTTPD_WS_MAX_TX_HEADER_LEN + CONFIG_HTTPD_WS_TX_COALESCE_LEN];
+    size_t tx_len = httpd_ws_prepare_tx(tx_buf, frame);
+    esp_err_t ret = ESP_OK;
+
+    if (fds) {
+        for (size_t i = 0; i < fd_count; i++) {
+            struct sock_db *sess = httpd_sess_get(hd, fds[i]);
+            if (httpd_ws_broadcast_to(hd, sess, fds[i], tx_buf, tx_len, frame, callback, arg) != ESP_OK) {
+                ret = ESP_FAIL;
+            }
+        }
+    } else {
+        for (struct sock_db *sess = hd->hd_sd_lru_head; sess; sess = sess->lru_next) {
+            if (!sess->ws_handshake_done || sess->ws_close) {
+                continue;
+            }
+            if (httpd_ws_broadcast_to(hd, sess, sess->fd, tx_buf, tx_len, frame, callback, arg) != ESP_OK) {
+                ret = ESP_FAIL;
+            }
+        }
+    }
+    return ret;
 }
 
 esp_err_t httpd_ws_get_frame_type(httpd_req_t *req)
@@ -452,23 +738,18 @@ esp_err_t httpd_ws_get_frame_type(httpd_req_t *req)
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Read the first byte from the frame to get the FIN flag and Opcode */
-    /* Please refer to RFC6455 Section 5.2 for more details */
-    uint8_t first_byte = 0;
-    if (httpd_recv_with_opt(req, (char *)&first_byte, sizeof(first_byte), false) <= 0) {
-        /* If the recv() return code is <= 0, then this socket FD is invalid (i.e. a broken connection) */
+    /* Read the frame header to get the FIN flag, Opcode, length and mask key */
+    if (httpd_ws_recv_header(req) != ESP_OK) {
+        /* If the header cannot be received, then this socket FD is invalid (i.e. a broken connection) */
         /* Here we mark it as a Close message and close it later. */
-        E(TAG, LOG_FMT("Failed to read header byte (socket FD invalid), closing socket now"));
+        E(TAG, LOG_FMT("Failed to read frame header (socket FD invalid), closing socket now"));
         aux->ws_final = true;
         aux->ws_type = HTTPD_WS_TYPE_CLOSE;
+        aux->ws_len = 0;
         return ESP_OK;
     }
 
-    V(TAG, LOG_FMT("First byte received: 0x%02X"), first_byte);
-
-    /* Decode the FIN flag and Opcode from the byte */
-    aux->ws_final = (first_byte & HTTPD_WS_FIN_BIT) != 0;
-    aux->ws_type = (first_byte & HTTPD_WS_OPCODE_BITS);
+    V(TAG, LOG_FMT("Frame header received: type %d, length %d"), aux->ws_type, aux->ws_len);
 
     /* If userspace requests control frames, do not deal with the control frames */
     if (!sd->ws_control_frames) {
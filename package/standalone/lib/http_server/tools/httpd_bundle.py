@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright (c) 2022 Newracom, Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""Bundle static web assets into a C source for httpd_static_handler().
+
+Every file under the input directories becomes an asset at its relative path,
+with an index.html also served for its directory. A file given on its own is
+served at its name. Files are gzip compressed when that makes them smaller,
+and get a strong ETag derived from the bytes that are actually sent. The
+output only holds const data, so the bundle stays in flash.
+
+A gzip asset is only sent to clients that accept gzip. With --identity the
+uncompressed file is kept as well for the others, which otherwise get 406.
+
+    httpd_bundle.py -o www_bundle.c -n www_bundle www/
+
+declares 'const httpd_static_bundle_t www_bundle'. The command is recorded in
+the output, run it again from the same directory to regenerate it.
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import shlex
+import sys
+
+CONTENT_TYPES = {
+    '.html': 'text/html',
+    '.htm': 'text/html',
+    '.css': 'text/css',
+    '.js': 'application/javascript',
+    '.json': 'application/json',
+    '.svg': 'image/svg+xml',
+    '.png': 'image/png',
+    '.jpg': 'image/jpeg',
+    '.jpeg': 'image/jpeg',
+    '.gif': 'image/gif',
+    '.ico': 'image/x-icon',
+    '.txt': 'text/plain',
+    '.c': 'text/plain',
+    '.h': 'text/plain',
+    '.woff2': 'font/woff2',
+}
+
+# Already compressed formats are stored as they are
+NO_GZIP = {'.png', '.jpg', '.jpeg', '.gif', '.woff2'}
+
+
+def collect(inputs, prefix):
+    files = []
+    for top in inputs:
+        if os.path.isfile(top):
+            files.append((prefix + '/' + os.path.basename(top), top))
+            continue
+        for root, subdirs, names in os.walk(top):
+            subdirs.sort()
+            for name in sorted(names):
+                path = os.path.join(root, name)
+                rel = os.path.relpath(path, top).replace(os.sep, '/')
+                files.append((prefix + '/' + rel, path))
+    return files
+
+
+def encode(path, data, min_ratio):
+    ext = os.path.splitext(path)[1].lower()
+    if ext in NO_GZIP:
+        return data, False
+    # mtime 0 keeps the output, and so the ETag, reproducible
+    packed = gzip.compress(data, compresslevel=9, mtime=0)
+    if len(packed) <= len(data) * min_ratio:
+        return packed, True
+    return data, False
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('\t' + ' '.join('0x%02x,' % b for b in data[i:i + 16]))
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('inputs', nargs='+', help='directories holding the assets, or single files')
+    parser.add_argument('-o', '--output', required=True, help='C source to write')
+    parser.add_argument('-n', '--name', required=True, help='name of the httpd_static_bundle_t')
+    parser.add_argument('-p', '--prefix', default='', help='URI prefix of the assets, e.g. /static')
+    parser.add_argument('-c', '--cache-control', default='no-cache',
+                        help='Cache-Control header, empty for none (default: %(default)s)')
+    parser.add_argument('--min-ratio', type=float, default=0.9,
+                        help='keep gzip only below this size ratio (default: %(default)s)')
+    parser.add_argument('--identity', action='store_true',
+                        help='also keep gzip assets uncompressed, for clients without gzip')
+    args = parser.parse_args()
+
+    prefix = args.prefix.rstrip('/')
+    assets = []
+    identities = []
+    total_raw = 0
+    total_stored = 0
+
+    for index, (uri, path) in enumerate(collect(args.inputs, prefix)):
+        with open(path, 'rb') as f:
+            raw = f.read()
+        data, gz = encode(path, raw, args.min_ratio)
+        etag = '\\"%s\\"' % hashlib.sha256(data).hexdigest()[:16]
+        ctype = CONTENT_TYPES.get(os.path.splitext(path)[1].lower(), 'application/octet-stream')
+        sym = '%s_%d' % (args.name, index)
+        identity = None
+        if gz and args.identity:
+            # the other representation needs a tag of its own
+            identity = len(identities)
+            raw_etag = '\\"%s\\"' % hashlib.sha256(raw).hexdigest()[:16]
+            identities.append((uri, sym + '_identity', ctype, raw_etag, raw))
+            total_stored += len(raw)
+        assets.append((uri, sym, ctype, etag, data, gz, identity))
+        if uri.endswith('/index.html'):
+            assets.append((uri[:-len('index.html')], sym, ctype, etag, data, gz, identity))
+        total_raw += len(raw)
+        total_stored += len(data)
+
+    # httpd_static_find() does a binary search with strcmp() order
+    assets.sort(key=lambda a: a[0].encode())
+    for a, b in zip(assets, assets[1:]):
+        if a[0] == b[0]:
+            sys.exit('%s: duplicate asset %s' % (sys.argv[0], a[0]))
+
+    out = []
+    command = ' '.join(shlex.quote(arg) for arg in sys.argv)
+    out.append('/* Generated by httpd_bundle.py, do not edit. Regenerate with')
+    out.append(' *   %s' % command)
+    out.append(' */')
+    out.append('')
+    out.append('#include <httpd_static.h>')
+    out.append('')
+    emitted = set()
+    for uri, sym, ctype, etag, data, gz, identity in assets:
+        if sym in emitted:
+            continue
+        emitted.add(sym)
+        out.append('/* %s, %d bytes%s */' % (uri, len(data), ' gzip' if gz else ''))
+        out.append('static const uint8_t %s[] = {' % sym)
+        out.append(c_bytes(data))
+        out.append('};')
+        out.append('')
+    for uri, sym, ctype, etag, data in identities:
+        out.append('/* %s, %d bytes */' % (uri, len(data)))
+        out.append('static const uint8_t %s[] = {' % sym)
+        out.append(c_bytes(data))
+        out.append('};')
+        out.append('')
+    if identities:
+        out.append('static const httpd_static_asset_t %s_identities[] = {' % args.name)
+        for uri, sym, ctype, etag, data in identities:
+            out.append('\t{ "%s", "%s", "%s", %s, sizeof(%s), false },' % (uri, ctype, etag, sym, sym))
+        out.append('};')
+        out.append('')
+    out.append('static const httpd_static_asset_t %s_assets[] = {' % args.name)
+    for uri, sym, ctype, etag, data, gz, identity in assets:
+        out.append('\t{ "%s", "%s", "%s", %s, sizeof(%s), %s%s },'
+                   % (uri, ctype, etag, sym, sym, 'true' if gz else 'false',
+                      '' if identity is None else ', &%s_identities[%d]' % (args.name, identity)))
+    out.append('};')
+    out.append('')
+    out.append('const httpd_static_bundle_t %s = {' % args.name)
+    out.append('\t.assets = %s_assets,' % args.name)
+    out.append('\t.count = sizeof(%s_assets) / sizeof(%s_assets[0]),' % (args.name, args.name))
+    out.append('\t.cache_control = %s,' % ('"%s"' % args.cache_control if args.cache_control else 'NULL'))
+    out.append('};')
+
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+    print('%s: %d assets, %d bytes stored for %d bytes' % (args.output, len(emitted) + len(identities),
+                                                          total_stored, total_raw))
+
+
+if __name__ == '__main__':
+    main()
@@ -2562,6 +2562,11 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
   } else {
     SYS_ARCH_UNPROTECT(lev);
   }
+#if defined(NRC_LWIP) && defined(LWIP_HOOK_SOCKETS_EVENT)
+  if (check_waiters) {
+    LWIP_HOOK_SOCKETS_EVENT(s, (int)evt);
+  }
+#endif /* NRC_LWIP && LWIP_HOOK_SOCKETS_EVENT */
   done_socket(sock);
 }
 
@@ -353,7 +353,11 @@ udp_input(struct pbuf *p, struct netif *inp)
       } else
 #endif /* LWIP_UDPLITE */
       {
+#ifdef NRC_LWIP
+        if (udphdr->chksum != 0 && !(p->flags & PBUF_FLAG_L4_CHKSUM_OK)) {
+#else
         if (udphdr->chksum != 0) {
+#endif /* NRC_LWIP */
           if (ip_chksum_pseudo(p, IP_PROTO_UDP, p->tot_len,
                                ip_current_src_addr(),
                                ip_current_dest_addr()) != 0) {
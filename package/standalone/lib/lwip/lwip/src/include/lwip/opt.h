@@ -3205,6 +3205,23 @@
 #define LWIP_HOOK_SOCKETS_GETSOCKOPT(s, sock, level, optname, optval, optlen, err)
 #endif
 
+/**
+ * LWIP_HOOK_SOCKETS_EVENT(s, evt)
+ * Called from the socket event callback when a socket may have become
+ * readable, writable or failed, i.e. whenever select() waiters would be
+ * checked. Lets a task wait for socket events without sitting in select().
+ * Core lock is held when this hook is called, so it must not block.
+ * Signature:\code{.c}
+ *   void my_hook(int s, int evt)
+ * \endcode
+ * Arguments:
+ * - s: socket file descriptor
+ * - evt: NETCONN_EVT_RCVPLUS, NETCONN_EVT_SENDPLUS or NETCONN_EVT_ERROR
+ */
+#ifdef __DOXYGEN__
+#define LWIP_HOOK_SOCKETS_EVENT(s, evt)
+#endif
+
 /**
  * LWIP_HOOK_NETCONN_EXTERNAL_RESOLVE(name, addr, addrtype, err)
  * Called from netconn APIs (not usable with callback apps) allowing an
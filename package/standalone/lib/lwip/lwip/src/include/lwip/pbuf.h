@@ -181,6 +181,11 @@ typedef enum {
 #define PBUF_FLAG_LLMCAST   0x10U
 /** indicates this pbuf includes a TCP FIN flag */
 #define PBUF_FLAG_TCP_FIN   0x20U
+#ifdef NRC_LWIP
+/** indicates the netif driver verified the TCP/UDP checksum of this packet
+    while copying it in, so the stack does not need to sum the payload again */
+#define PBUF_FLAG_L4_CHKSUM_OK 0x40U
+#endif /* NRC_LWIP */
 
 /** Main packet buffer struct */
 struct pbuf {
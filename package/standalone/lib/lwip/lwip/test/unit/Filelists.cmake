@@ -12,6 +12,7 @@ set(LWIP_TESTDIR ${LWIP_DIR}/test/unit)
 set(LWIP_TESTFILES
 	${LWIP_TESTDIR}/lwip_unittests.c
 	${LWIP_TESTDIR}/api/test_sockets.c
+	${LWIP_TESTDIR}/chksum/test_chksum.c
 	${LWIP_TESTDIR}/arch/sys_arch.c
 	${LWIP_TESTDIR}/core/test_def.c
 	${LWIP_TESTDIR}/core/test_mem.c
@@ -29,3 +30,22 @@ set(LWIP_TESTFILES
 	${LWIP_TESTDIR}/tcp/test_tcp.c
 	${LWIP_TESTDIR}/udp/test_udp.c
 )
+
+# Checksum engine from the port
+list(APPEND LWIP_INCLUDE_DIRS ${LWIP_DIR}/../port/include/arch)
+list(APPEND LWIP_TESTFILES ${LWIP_DIR}/../port/nrc_chksum.c)
+
+# NAT add-on from the port. LWIP_NAT is only enabled for the NAT test build
+# (-DLWIP_NAT_TEST=ON), the other suites run without it
+if (LWIP_NAT_TEST)
+	set(LWIP_NATDIR ${LWIP_DIR}/../port/lwip-nat)
+	list(APPEND LWIP_DEFINITIONS LWIP_NAT_TEST=1)
+	list(APPEND LWIP_INCLUDE_DIRS ${LWIP_DIR}/../port/include/lwip-nat)
+	list(APPEND LWIP_TESTFILES
+		${LWIP_TESTDIR}/nat/test_nat.c
+		${LWIP_NATDIR}/nat.c
+		${LWIP_NATDIR}/nat_proto_icmp4.c
+		${LWIP_NATDIR}/nat_proto_tcp.c
+		${LWIP_NATDIR}/nat_proto_udp.c
+	)
+endif (LWIP_NAT_TEST)
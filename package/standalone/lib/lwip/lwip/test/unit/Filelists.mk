@@ -32,6 +32,7 @@
 TESTDIR=$(LWIPDIR)/../test/unit
 TESTFILES=$(TESTDIR)/lwip_unittests.c \
 	$(TESTDIR)/api/test_sockets.c \
+	$(TESTDIR)/chksum/test_chksum.c \
 	$(TESTDIR)/arch/sys_arch.c \
 	$(TESTDIR)/core/test_def.c \
 	$(TESTDIR)/core/test_mem.c \
@@ -49,3 +50,18 @@ TESTFILES=$(TESTDIR)/lwip_unittests.c \
 	$(TESTDIR)/tcp/test_tcp.c \
 	$(TESTDIR)/udp/test_udp.c
 
+# Checksum engine from the port
+TESTFLAGS+=-I$(LWIPDIR)/../../port/include/arch
+TESTFILES+=$(LWIPDIR)/../../port/nrc_chksum.c
+
+# NAT add-on from the port. LWIP_NAT is only enabled for the NAT test build
+# (make LWIP_NAT_TEST=1), the other suites run without it
+ifeq ($(LWIP_NAT_TEST),1)
+NATDIR=$(LWIPDIR)/../../port/lwip-nat
+TESTFLAGS+=-DLWIP_NAT_TEST=1 -I$(LWIPDIR)/../../port/include/lwip-nat
+TESTFILES+=$(TESTDIR)/nat/test_nat.c \
+	$(NATDIR)/nat.c \
+	$(NATDIR)/nat_proto_icmp4.c \
+	$(NATDIR)/nat_proto_tcp.c \
+	$(NATDIR)/nat_proto_udp.c
+endif
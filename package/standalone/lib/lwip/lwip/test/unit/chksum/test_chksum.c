@@ -0,0 +1,262 @@
+#include "test_chksum.h"
+
+#include "lwip/inet_chksum.h"
+
+#include "nrc_chksum.h"
+
+#include <string.h>
+#include <time.h>
+
+/* TCP_MSS of the port */
+#define TEST_CHKSUM_MSS     2896
+#define TEST_CHKSUM_BUFSIZE 3000
+#define TEST_CHKSUM_BYTES   (16 * 1024 * 1024)
+
+static u8_t test_src[TEST_CHKSUM_BUFSIZE + 8];
+static u8_t test_dst[TEST_CHKSUM_BUFSIZE + 8];
+
+/*
+ * Copies of the three LWIP_CHKSUM_ALGORITHM versions from inet_chksum.c,
+ * so that one run can compare all of them against the port engine.
+ */
+static u16_t
+test_chksum_alg1(const void *dataptr, int len)
+{
+  u32_t acc;
+  u16_t src;
+  const u8_t *octetptr;
+
+  acc = 0;
+  octetptr = (const u8_t *)dataptr;
+  while (len > 1) {
+    src = (*octetptr) << 8;
+    octetptr++;
+    src |= (*octetptr);
+    octetptr++;
+    acc += src;
+    len -= 2;
+  }
+  if (len > 0) {
+    src = (*octetptr) << 8;
+    acc += src;
+  }
+  acc = (acc >> 16) + (acc & 0x0000ffffUL);
+  if ((acc & 0xffff0000UL) != 0) {
+    acc = (acc >> 16) + (acc & 0x0000ffffUL);
+  }
+  return lwip_htons((u16_t)acc);
+}
+
+static u16_t
+test_chksum_alg2(const void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const u16_t *ps;
+  u16_t t = 0;
+  u32_t sum = 0;
+  int odd = ((mem_ptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  ps = (const u16_t *)(const void *)pb;
+  while (len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+
+  if (len > 0) {
+    ((u8_t *)&t)[0] = *(const u8_t *)ps;
+  }
+
+  sum += t;
+  sum = FOLD_U32T(sum);
+  sum = FOLD_U32T(sum);
+  if (odd) {
+    sum = SWAP_BYTES_IN_WORD(sum);
+  }
+  return (u16_t)sum;
+}
+
+static u16_t
+test_chksum_alg3(const void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const u16_t *ps;
+  u16_t t = 0;
+  const u32_t *pl;
+  u32_t sum = 0, tmp;
+  int odd = ((mem_ptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  ps = (const u16_t *)(const void *)pb;
+  if (((mem_ptr_t)ps & 3) && len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+
+  pl = (const u32_t *)(const void *)ps;
+  while (len > 7)  {
+    tmp = sum + *pl++;
+    if (tmp < sum) {
+      tmp++;
+    }
+    sum = tmp + *pl++;
+    if (sum < tmp) {
+      sum++;
+    }
+    len -= 8;
+  }
+  sum = FOLD_U32T(sum);
+
+  ps = (const u16_t *)pl;
+  while (len > 1) {
+    sum += *ps++;
+    len -= 2;
+  }
+  if (len > 0) {
+    ((u8_t *)&t)[0] = *(const u8_t *)ps;
+  }
+
+  sum += t;
+  sum = FOLD_U32T(sum);
+  sum = FOLD_U32T(sum);
+  if (odd) {
+    sum = SWAP_BYTES_IN_WORD(sum);
+  }
+  return (u16_t)sum;
+}
+
+typedef u16_t (*test_chksum_fn)(const void *data, int len);
+
+static const struct {
+  test_chksum_fn fn;
+  const char *name;
+} test_chksum_algs[] = {
+  { test_chksum_alg1, "alg 1" },
+  { test_chksum_alg2, "alg 2" },
+  { test_chksum_alg3, "alg 3" },
+  { nrc_lwip_chksum, "nrc" }
+};
+
+static double
+test_chksum_mbps(test_chksum_fn fn, int len)
+{
+  int i, n = TEST_CHKSUM_BYTES / len;
+  volatile u16_t sink = 0;
+  clock_t start = clock();
+  double secs;
+
+  for (i = 0; i < n; i++) {
+    sink ^= fn(test_src, len);
+  }
+  secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+  LWIP_UNUSED_ARG(sink);
+  return secs > 0 ? (double)n * len / secs / 1e6 : 0;
+}
+
+/* Setups/teardown functions */
+
+static void
+chksum_setup(void)
+{
+  size_t i;
+
+  srand(0x7292);
+  for (i = 0; i < sizeof(test_src); i++) {
+    test_src[i] = (u8_t)rand();
+  }
+}
+
+static void
+chksum_teardown(void)
+{
+}
+
+
+/* Test functions */
+
+/* Same result as every lwIP algorithm for every length and alignment */
+START_TEST(test_chksum_matches_ref)
+{
+  int len, off;
+  size_t i;
+  u16_t sum;
+  LWIP_UNUSED_ARG(_i);
+
+  for (off = 0; off < 4; off++) {
+    for (len = 0; len <= 300; len++) {
+      sum = nrc_lwip_chksum(test_src + off, len);
+      for (i = 0; i < LWIP_ARRAYSIZE(test_chksum_algs); i++) {
+        fail_unless(test_chksum_algs[i].fn(test_src + off, len) == sum);
+      }
+    }
+    sum = nrc_lwip_chksum(test_src + off, TEST_CHKSUM_MSS);
+    for (i = 0; i < LWIP_ARRAYSIZE(test_chksum_algs); i++) {
+      fail_unless(test_chksum_algs[i].fn(test_src + off, TEST_CHKSUM_MSS) == sum);
+    }
+  }
+}
+END_TEST
+
+/* Copy and checksum for every combination of source/destination alignment */
+START_TEST(test_chksum_copy)
+{
+  int len, soff, doff;
+  u16_t sum;
+  LWIP_UNUSED_ARG(_i);
+
+  for (soff = 0; soff < 4; soff++) {
+    for (doff = 0; doff < 4; doff++) {
+      for (len = 0; len <= 100; len++) {
+        memset(test_dst, 0xa5, sizeof(test_dst));
+        sum = nrc_lwip_chksum_copy(test_dst + doff, test_src + soff, (u16_t)len);
+        fail_unless(sum == test_chksum_alg1(test_src + soff, len));
+        fail_unless(memcmp(test_dst + doff, test_src + soff, len) == 0);
+        /* Nothing written behind the copy */
+        fail_unless(test_dst[doff + len] == 0xa5);
+      }
+    }
+  }
+}
+END_TEST
+
+/* Throughput of the lwIP algorithms against the port engine */
+START_TEST(test_chksum_bench)
+{
+  static const int sizes[] = { 64, 128, 256, 512, 1024, 1460, 2896 };
+  size_t i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  printf("chksum MB/s:  size");
+  for (j = 0; j < LWIP_ARRAYSIZE(test_chksum_algs); j++) {
+    printf(" %8s", test_chksum_algs[j].name);
+  }
+  printf("\n");
+  for (i = 0; i < LWIP_ARRAYSIZE(sizes); i++) {
+    printf("              %4d", sizes[i]);
+    for (j = 0; j < LWIP_ARRAYSIZE(test_chksum_algs); j++) {
+      printf(" %8.1f", test_chksum_mbps(test_chksum_algs[j].fn, sizes[i]));
+    }
+    printf("\n");
+  }
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+chksum_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_chksum_matches_ref),
+    TESTFUNC(test_chksum_copy),
+    TESTFUNC(test_chksum_bench)
+  };
+  return create_suite("CHKSUM", tests, sizeof(tests)/sizeof(testfunc), chksum_setup, chksum_teardown);
+}
@@ -15,6 +15,8 @@
 #include "mdns/test_mdns.h"
 #include "mqtt/test_mqtt.h"
 #include "api/test_sockets.h"
+#include "nat/test_nat.h"
+#include "chksum/test_chksum.h"
 
 #include "lwip/init.h"
 #if !NO_SYS
@@ -76,7 +78,11 @@ int main(void)
     dhcp_suite,
     mdns_suite,
     mqtt_suite,
-    sockets_suite
+    sockets_suite,
+#ifdef LWIP_NAT_TEST
+    nat_suite,
+#endif
+    chksum_suite
   };
   size_t num = sizeof(suites)/sizeof(void*);
   LWIP_ASSERT("No suites defined", num > 0);
@@ -80,6 +80,11 @@
 /* netif tests want to test this, so enable: */
 #define LWIP_NETIF_EXT_STATUS_CALLBACK  1
 
+/* The NAT add-on from the port is only enabled for the NAT test build */
+#ifdef LWIP_NAT_TEST
+#define LWIP_NAT                        1
+#endif
+
 /* Check lwip_stats.mem.illegal instead of asserting */
 #define LWIP_MEM_ILLEGAL_FREE(msg)      /* to nothing */
 
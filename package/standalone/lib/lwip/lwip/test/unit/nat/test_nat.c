@@ -0,0 +1,324 @@
+#include "test_nat.h"
+
+#include "lwip/udp.h"
+#include "lwip/ip.h"
+#include "lwip/prot/udp.h"
+#include "lwip/inet_chksum.h"
+
+#include "nat/nat.h"
+#include "nat/nat_proto_udp.h"
+
+#include <time.h>
+
+#if !LWIP_NAT || !LWIP_UDP
+#error "This tests needs LWIP_NAT and LWIP_UDP enabled"
+#endif
+
+#define TEST_NAT_SMALL_CNT  16
+#define TEST_NAT_ROUNDS     64
+
+static struct netif test_int_netif, test_ext_netif;
+static ip4_addr_t test_int_ipaddr, test_int_netmask;
+static ip4_addr_t test_ext_ipaddr, test_ext_netmask, test_ext_gw;
+static ip4_addr_t test_remote_ipaddr;
+
+/* outbound port assigned by the NAT for each inside connection */
+static u16_t test_nat_ports[LWIP_NAT_UDP_MAX];
+
+/* Helper functions */
+static err_t
+test_nat_netif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  LWIP_UNUSED_ARG(ipaddr);
+  return ERR_OK;
+}
+
+static err_t
+test_nat_netif_init(struct netif *netif)
+{
+  netif->output = test_nat_netif_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_LINK_UP;
+  return ERR_OK;
+}
+
+/* Run all NAT entries into their timeout, releasing them from the tick path */
+static void
+test_nat_expire_all(void)
+{
+  int i;
+
+  for (i = 0; i <= LWIP_NAT_UDP_TICKS + 1; i++) {
+    nat_timer_tick(NULL);
+  }
+}
+
+static void
+test_nat_set_addrs(const ip4_addr_t *src, const ip4_addr_t *dest)
+{
+  ip_addr_copy_from_ip4(ip_data.current_iphdr_src, *src);
+  ip_addr_copy_from_ip4(ip_data.current_iphdr_dest, *dest);
+}
+
+static struct pbuf *
+test_nat_udp_packet(void)
+{
+  struct pbuf *p = pbuf_alloc(PBUF_RAW, UDP_HLEN, PBUF_RAM);
+  struct udp_hdr *udphdr;
+
+  EXPECT_RETNULL(p != NULL);
+  udphdr = (struct udp_hdr *)p->payload;
+  memset(udphdr, 0, UDP_HLEN);
+  udphdr->len = lwip_htons(UDP_HLEN);
+  /* no checksum, so udp_prerouting_pcb() does not verify it */
+  udphdr->chksum = 0;
+  return p;
+}
+
+static void
+test_nat_inside_host(ip4_addr_t *addr, int i)
+{
+  IP4_ADDR(addr, 192, 168, 0, 2 + (i % 250));
+}
+
+/* Forward packets for cnt new inside connections, recording the NAT ports */
+static void
+test_nat_udp_fill(struct pbuf *p, int first, int cnt)
+{
+  struct udp_hdr *udphdr = (struct udp_hdr *)p->payload;
+  struct nat_pcb *pcb;
+  ip4_addr_t host;
+  int i;
+
+  for (i = first; i < first + cnt; i++) {
+    test_nat_inside_host(&host, i);
+    test_nat_set_addrs(&host, &test_remote_ipaddr);
+    udphdr->src = lwip_htons(10000 + i);
+    udphdr->dest = lwip_htons(53);
+    pcb = udp_prerouting_pcb(p, &test_int_netif, &test_ext_netif);
+    EXPECT_RET(pcb != NULL);
+    test_nat_ports[i] = pcb->udp.local_port;
+    udp_prerouting_nat(p, pcb, 1);
+  }
+}
+
+/*
+ * Look up the return traffic of the first cnt connections, as received on
+ * the outbound interface. Returns the average cost per lookup in ns.
+ */
+static double
+test_nat_udp_lookup(struct pbuf *p, int cnt)
+{
+  struct udp_hdr *udphdr = (struct udp_hdr *)p->payload;
+  struct nat_pcb *pcb;
+  clock_t start;
+  int i, round;
+
+  test_nat_set_addrs(&test_remote_ipaddr, &test_ext_ipaddr);
+  udphdr->src = lwip_htons(53);
+
+  start = clock();
+  for (round = 0; round < TEST_NAT_ROUNDS; round++) {
+    for (i = 0; i < cnt; i++) {
+      udphdr->dest = lwip_htons(test_nat_ports[i]);
+      pcb = udp_prerouting_pcb(p, &test_ext_netif, NULL);
+      EXPECT_RETX(pcb != NULL, 0);
+      EXPECT_RETX(pcb->nat_udp.nat_local_port == 10000 + i, 0);
+    }
+  }
+  return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC /
+         ((double)TEST_NAT_ROUNDS * cnt);
+}
+
+/* Setups/teardown functions */
+
+static void
+nat_setup(void)
+{
+  IP4_ADDR(&test_int_ipaddr, 192, 168, 0, 1);
+  IP4_ADDR(&test_int_netmask, 255, 255, 255, 0);
+  netif_add(&test_int_netif, &test_int_ipaddr, &test_int_netmask,
+            IP4_ADDR_ANY4, NULL, test_nat_netif_init, NULL);
+
+  IP4_ADDR(&test_ext_ipaddr, 10, 0, 0, 2);
+  IP4_ADDR(&test_ext_netmask, 255, 255, 255, 0);
+  IP4_ADDR(&test_ext_gw, 10, 0, 0, 1);
+  netif_add(&test_ext_netif, &test_ext_ipaddr, &test_ext_netmask,
+            &test_ext_gw, NULL, test_nat_netif_init, NULL);
+
+  netif_set_up(&test_int_netif);
+  netif_set_up(&test_ext_netif);
+
+  IP4_ADDR(&test_remote_ipaddr, 8, 8, 8, 8);
+}
+
+static void
+nat_teardown(void)
+{
+  test_nat_expire_all();
+  /* All NAT entries must have been handed back by the tick */
+  fail_unless(udp_pcbs == NULL);
+
+  netif_remove(&test_int_netif);
+  netif_remove(&test_ext_netif);
+  ip_addr_set_zero(&ip_data.current_iphdr_src);
+  ip_addr_set_zero(&ip_data.current_iphdr_dest);
+}
+
+
+/* Test functions */
+
+/* Return traffic is matched to the connection that created the entry */
+START_TEST(test_nat_udp_map)
+{
+  struct pbuf *p;
+  struct udp_hdr *udphdr;
+  struct nat_pcb *pcb, *pcb2;
+  ip4_addr_t host;
+  LWIP_UNUSED_ARG(_i);
+
+  p = test_nat_udp_packet();
+  EXPECT_RET(p != NULL);
+  udphdr = (struct udp_hdr *)p->payload;
+
+  test_nat_inside_host(&host, 0);
+  test_nat_set_addrs(&host, &test_remote_ipaddr);
+  udphdr->src = lwip_htons(10000);
+  udphdr->dest = lwip_htons(53);
+  pcb = udp_prerouting_pcb(p, &test_int_netif, &test_ext_netif);
+  fail_unless(pcb != NULL);
+  fail_unless(pcb->nat_udp.nat_local_port == 10000);
+  fail_unless(ip4_addr_cmp(ip_2_ip4(&pcb->ip.local_ip), &test_ext_ipaddr));
+
+  /* Same connection again must not create a new entry */
+  pcb2 = udp_prerouting_pcb(p, &test_int_netif, &test_ext_netif);
+  fail_unless(pcb2 == pcb);
+
+  /* Reply from the remote side */
+  test_nat_set_addrs(&test_remote_ipaddr, &test_ext_ipaddr);
+  udphdr->src = lwip_htons(53);
+  udphdr->dest = lwip_htons(pcb->udp.local_port);
+  pcb2 = udp_prerouting_pcb(p, &test_ext_netif, NULL);
+  fail_unless(pcb2 == pcb);
+
+  /* Wrong remote port is not matched */
+  udphdr->src = lwip_htons(54);
+  pcb2 = udp_prerouting_pcb(p, &test_ext_netif, NULL);
+  fail_unless(pcb2 == NULL);
+
+  pbuf_free(p);
+}
+END_TEST
+
+/* Entries are reclaimed by nat_timer_tick() once they timed out */
+START_TEST(test_nat_udp_expire)
+{
+  struct pbuf *p;
+  struct udp_hdr *udphdr;
+  struct nat_pcb *pcb;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  p = test_nat_udp_packet();
+  EXPECT_RET(p != NULL);
+  udphdr = (struct udp_hdr *)p->payload;
+
+  test_nat_udp_fill(p, 0, 1);
+  test_nat_set_addrs(&test_remote_ipaddr, &test_ext_ipaddr);
+  udphdr->src = lwip_htons(53);
+  udphdr->dest = lwip_htons(test_nat_ports[0]);
+
+  for (i = 0; i < LWIP_NAT_UDP_TICKS; i++) {
+    nat_timer_tick(NULL);
+  }
+  pcb = udp_prerouting_pcb(p, &test_ext_netif, NULL);
+  fail_unless(pcb != NULL);
+  fail_unless(udp_pcbs != NULL);
+
+  nat_timer_tick(NULL);
+  pcb = udp_prerouting_pcb(p, &test_ext_netif, NULL);
+  fail_unless(pcb == NULL);
+  fail_unless(udp_pcbs == NULL);
+
+  pbuf_free(p);
+}
+END_TEST
+
+/*
+ * Fill the whole table and compare the per packet lookup cost against a
+ * nearly empty table. With the hash index both must be in the same range.
+ */
+START_TEST(test_nat_udp_lookup_cost)
+{
+  struct pbuf *p;
+  double small_ns, full_ns;
+  LWIP_UNUSED_ARG(_i);
+
+  p = test_nat_udp_packet();
+  EXPECT_RET(p != NULL);
+
+  test_nat_udp_fill(p, 0, TEST_NAT_SMALL_CNT);
+  small_ns = test_nat_udp_lookup(p, TEST_NAT_SMALL_CNT);
+
+  test_nat_udp_fill(p, TEST_NAT_SMALL_CNT,
+                    LWIP_NAT_UDP_MAX - TEST_NAT_SMALL_CNT);
+  full_ns = test_nat_udp_lookup(p, LWIP_NAT_UDP_MAX);
+
+  printf("NAT UDP lookup: %d entries %.1f ns/packet, %d entries %.1f ns/packet\n",
+         TEST_NAT_SMALL_CNT, small_ns, LWIP_NAT_UDP_MAX, full_ns);
+  /* A linear walk would be about LWIP_NAT_UDP_MAX / TEST_NAT_SMALL_CNT slower */
+  fail_unless(full_ns < 16 * small_ns + 100);
+
+  pbuf_free(p);
+}
+END_TEST
+
+/* 0x0000 and 0xffff are both zero in one's complement */
+#define TEST_NAT_CHKSUM_EQ(a, b) \
+  ((a) == (b) || ((a) == 0xffff && (b) == 0) || ((a) == 0 && (b) == 0xffff))
+
+/* Incremental update gives the same checksum as summing the new data */
+START_TEST(test_nat_update_chksum)
+{
+  u16_t data[20];
+  u16_t chksum, chksum_udp, expect;
+  u32_t new_addr;
+  int i, j, off;
+  LWIP_UNUSED_ARG(_i);
+
+  srand(1624);
+  for (i = 0; i < 1000; i++) {
+    for (j = 0; j < (int)LWIP_ARRAYSIZE(data); j++) {
+      data[j] = (u16_t)rand();
+    }
+    chksum = inet_chksum(data, sizeof(data));
+    chksum_udp = chksum ? chksum : 0xffff;
+
+    /* Rewrite an address (2 words) */
+    off = rand() % (LWIP_ARRAYSIZE(data) - 3);
+    new_addr = (u32_t)rand() << 1;
+    update_chksum(&chksum, &data[off], &new_addr, 2);
+    update_chksum_udp(&chksum_udp, &data[off], &new_addr, 2);
+    memcpy(&data[off], &new_addr, sizeof(new_addr));
+    expect = inet_chksum(data, sizeof(data));
+    fail_unless(TEST_NAT_CHKSUM_EQ(chksum, expect));
+    fail_unless(TEST_NAT_CHKSUM_EQ(chksum_udp, expect));
+    fail_unless(chksum_udp != 0);
+  }
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+nat_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_nat_udp_map),
+    TESTFUNC(test_nat_udp_expire),
+    TESTFUNC(test_nat_udp_lookup_cost),
+    TESTFUNC(test_nat_update_chksum)
+  };
+  return create_suite("NAT", tests, sizeof(tests)/sizeof(testfunc), nat_setup, nat_teardown);
+}
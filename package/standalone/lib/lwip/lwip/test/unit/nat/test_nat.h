@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_NAT_H
+#define LWIP_HDR_TEST_NAT_H
+
+#include "../lwip_check.h"
+
+Suite* nat_suite(void);
+
+#endif
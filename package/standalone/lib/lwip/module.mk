@@ -124,6 +124,7 @@ NETIFFILES= \
 LWIP_PORTING = \
 	sys_arch.c \
 	wlif.c \
+	nrc_chksum.c \
 	nrc_ping.c \
 	nrc_iperf.c \
 	nrc_lwip.c
@@ -0,0 +1,17 @@
+#ifndef __NRC_CHKSUM_H__
+#define __NRC_CHKSUM_H__
+
+#include <stdint.h>
+
+/*
+ * Internet checksum routines of the port.
+ *
+ * nrc_lwip_chksum() follows the lwIP LWIP_CHKSUM contract: it returns the
+ * folded 16-bit one's complement sum of the data in network byte order,
+ * not inverted. nrc_lwip_chksum_copy() copies len bytes from src to dst
+ * and returns the same sum computed over the copied data.
+ */
+uint16_t nrc_lwip_chksum(const void *dataptr, int len);
+uint16_t nrc_lwip_chksum_copy(void *dst, const void *src, uint16_t len);
+
+#endif /* __NRC_CHKSUM_H__ */
@@ -33,6 +33,11 @@
 
 #include "nat/natopts.h"
 
+/* Without a driver that verifies checksums on copy, always verify here */
+#ifndef PBUF_FLAG_L4_CHKSUM_OK
+#define PBUF_FLAG_L4_CHKSUM_OK 0
+#endif
+
 struct netif;
 struct udp_pcb;
 
@@ -102,6 +107,11 @@ struct nat_icmp_pcb {
 
 struct nat_pcb {
 	struct nat_pcb *next;
+	/* Hash chains, see struct nat_pcb_table */
+	struct nat_pcb *ext_next;
+	struct nat_pcb *int_next;
+	u16_t ext_bucket;
+	u16_t int_bucket;
 	ip_addr_t nat_local_ip;
 	u8_t ext_netif_idx;
 	u8_t int_netif_idx;
@@ -122,9 +132,54 @@ struct nat_pcb {
 	};
 };
 
+/*
+ * Per protocol connection tracking table.
+ *
+ * Entries live in a static storage pool and sit on either the free or
+ * the used list. Used entries are additionally indexed by two hash
+ * tables so lookups do not depend on the number of tracked connections:
+ *
+ *  - ext_hash: outside view (ext_netif_idx, remote, local_ip/local_port),
+ *    used for packets arriving on the outbound interface.
+ *  - int_hash: inside view (ext_netif_idx, remote, nat_local_ip/
+ *    nat_local_port), used for packets forwarded from the NAT network.
+ *
+ * Expired entries are reclaimed from nat_timer_tick(), not while
+ * looking up packets.
+ */
+struct nat_pcb_table {
+	u8_t *storage;
+	size_t pcb_sz;
+	u16_t count;
+	u16_t hash_mask;	/* hash size - 1, size must be a power of 2 */
+	struct nat_pcb **ext_hash;
+	struct nat_pcb **int_hash;
+	/* Unlink pcb from lwIP core lists, may be NULL */
+	void (*release)(struct nat_pcb *pcb);
+
+	struct nat_pcb *used;
+	struct nat_pcb *free;
+	u16_t used_cnt;
+	u8_t initialized;
+};
+
+#define NAT_PCB_TABLE_INIT(_storage, _pcb_sz, _count, _ext_hash, _int_hash, _release) { \
+	.storage = (_storage), \
+	.pcb_sz = (_pcb_sz), \
+	.count = (_count), \
+	.hash_mask = LWIP_ARRAYSIZE(_ext_hash) - 1, \
+	.ext_hash = (_ext_hash), \
+	.int_hash = (_int_hash), \
+	.release = (_release), \
+}
+
+#define nat_pcb_table_ext_head(table, hash) \
+	((table)->ext_hash[(hash) & (table)->hash_mask])
+#define nat_pcb_table_int_head(table, hash) \
+	((table)->int_hash[(hash) & (table)->hash_mask])
+
 void nat_init(void);
 void nat_timer_tick(void *arg);
-void nat_pcb_take_oldest(struct nat_pcb **free, struct nat_pcb **used, u8_t limit);
 int nat_pcb_timedout(struct nat_pcb *pcb);
 void nat_pcb_refresh(struct nat_pcb *pcb, u8_t ticks);
 
@@ -133,6 +188,13 @@ void update_chksum_udp(u16_t *hc, const void *orig, const void *new, int short_w
 
 struct nat_pcb *nat_pcb_init_mem(u8_t *storage, size_t len, size_t count);
 
+u32_t nat_hash(u8_t netif_idx, const ip_addr_t *remote, const ip_addr_t *addr,
+			u32_t id);
+struct nat_pcb *nat_pcb_table_alloc(struct nat_pcb_table *table, u8_t limit);
+void nat_pcb_table_insert(struct nat_pcb_table *table, struct nat_pcb *pcb,
+			u32_t ext_hash, u32_t int_hash);
+void nat_pcb_table_expire(struct nat_pcb_table *table);
+
 int nat_rule_check(struct netif *inp, struct netif *forwardp);
 err_t nat_rule_add(struct nat_rule *new_rule);
 err_t nat_rule_remove(struct nat_rule *old_rule);
@@ -44,10 +44,9 @@
 #endif
 
 /*
- * The NAT tick value is updated every tick period. Each time it passes
- * 128, all the NAT entries are walked and anything past expiration is
- * proactively removed. Default is 15 seconds, giving a max timeout of
- * 32 minutes.
+ * The NAT tick value is updated every tick period. On each tick, all the
+ * NAT entries are walked and anything past expiration is removed. Default
+ * is 15 seconds, giving a max timeout of 32 minutes.
  */
 #ifndef LWIP_NAT_TICK_PERIOD_MS
 #define LWIP_NAT_TICK_PERIOD_MS		15000
@@ -71,6 +70,14 @@
 #define LWIP_NAT_TCP_MAX 1024
 #endif
 
+/*
+ * Number of buckets in each of the two TCP NAT hash indexes, must be a
+ * power of 2.
+ */
+#ifndef LWIP_NAT_TCP_HASH_SIZE
+#define LWIP_NAT_TCP_HASH_SIZE		256
+#endif
+
 /*
  * How long a TCP NAT entry lives, defaults to 30 minutes. NB, tick number
  * must be less than 128
@@ -96,6 +103,10 @@
 #define LWIP_NAT_UDP_MAX 		1024
 #endif
 
+#ifndef LWIP_NAT_UDP_HASH_SIZE
+#define LWIP_NAT_UDP_HASH_SIZE		256
+#endif
+
 #ifndef LWIP_NAT_UDP_TICKS
 #define LWIP_NAT_UDP_TICKS		(30 * 60 * 1000 / LWIP_NAT_TICK_PERIOD_MS)
 #endif
@@ -108,6 +119,10 @@
 #define LWIP_NAT_ICMP4_MAX		64
 #endif
 
+#ifndef LWIP_NAT_ICMP4_HASH_SIZE
+#define LWIP_NAT_ICMP4_HASH_SIZE	16
+#endif
+
 /* How long an ICMP NAT entry lives, defaults to 30 seconds */
 #ifndef LWIP_NAT_ICMP_TICKS
 #define LWIP_NAT_ICMP_TICKS		(30 * 1000 / LWIP_NAT_TICK_PERIOD_MS)
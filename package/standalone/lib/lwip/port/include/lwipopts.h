@@ -65,6 +65,11 @@ extern int ip4_input_nat(struct pbuf *p, struct netif *inp);
 
 #define LWIP_HOOK_IP4_INPUT		ip4_input_nat
 #endif /* SUPPORT_ETHERNET_ACCESSPOINT */
+
+/* Socket event notification for tasks not blocked in select() */
+extern void nrc_lwip_socket_event(int s, int evt);
+
+#define LWIP_HOOK_SOCKETS_EVENT		nrc_lwip_socket_event
 #if LWIP_BRIDGE
 #define BRIDGEIF_PORT_NETIFS_OUTPUT_DIRECT 1
 #define BRIDGEIF_MAX_PORTS 2
@@ -269,6 +274,18 @@ a lot of data that needs to be copied, this should be set high. */
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
 #define PBUF_POOL_BUFSIZE       1600
 
+/* LWIP_NRC_RX_ZERO_COPY==1: hand received frames to lwIP in the modem
+   buffer (lwif_input_sysbuf) instead of copying them into PBUF_POOL.
+   Off by default: the modem library still delivers frames through
+   lwif_input(), so nothing reaches lwif_input_sysbuf() yet. */
+#define LWIP_NRC_RX_ZERO_COPY   0
+
+/* LWIP_NRC_RX_ZERO_COPY_NUM: the number of modem buffers lwIP may hold at
+   once. Frames beyond this are copied so the modem keeps receiving. */
+#define LWIP_NRC_RX_ZERO_COPY_NUM 8
+
+#define LWIP_SUPPORT_CUSTOM_PBUF 1
+
 /* PBUF_LINK_HLEN: the number of bytes that should be allocated for a
    link level header. */
 #define PBUF_LINK_HLEN          16
@@ -374,8 +391,10 @@ a lot of data that needs to be copied, this should be set high. */
 //#define LWIP_PROVIDE_ERRNO 1
 #define LWIP_ERRNO_STDINCLUDE 1
 
-/* Used with IP headers only */
-#define LWIP_CHKSUM_ALGORITHM 1
+/* Word-wise checksum engine of the port (nrc_chksum.c) */
+#include "nrc_chksum.h"
+#define LWIP_CHKSUM			nrc_lwip_chksum
+#define LWIP_CHKSUM_COPY(dst, src, len)	nrc_lwip_chksum_copy(dst, src, len)
 
 /* LWIP_STATS==1: Enable statistics collection in lwip_stats.  */
 #define LWIP_STATS 1
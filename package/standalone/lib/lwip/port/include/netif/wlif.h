@@ -6,4 +6,21 @@
 err_t wlif_init( struct netif *netif );
 void lwif_input(struct nrc_wpa_if* intf, void *buffer, int data_len);
 
+/*
+ * Receive a frame that lies contiguously in the modem buffer buf. buf is
+ * always consumed: with LWIP_NRC_RX_ZERO_COPY the frame is handed to lwIP
+ * in place and buf is discarded when the pbuf is freed, otherwise (or if
+ * the frame has to be rewritten) it is copied and buf discarded at once.
+ */
+void lwif_input_sysbuf(struct nrc_wpa_if* intf, SYS_BUF *buf, void *frame, int data_len);
+
+struct lwif_rx_stats {
+	uint32_t zero_copy;	/* frames passed up in the modem buffer */
+	uint32_t copy;		/* frames copied into PBUF_POOL */
+	uint32_t copy_rewrite;	/* copied because the header is rewritten */
+	uint32_t copy_busy;	/* copied because all zero-copy slots were in use */
+};
+
+void lwif_get_rx_stats(struct lwif_rx_stats *stats);
+
 #endif /* __WLIF_H__ */
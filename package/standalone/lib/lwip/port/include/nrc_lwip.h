@@ -135,6 +135,13 @@ bool initialize_sntp(void);
 void wifi_nd6_restart_netif( int vif );
 #endif
 
+/*
+ * Register a function called from the tcpip thread whenever a socket may
+ * have become ready (evt is a NETCONN_EVT_*). It must not block. Pass
+ * NULL to unregister.
+ */
+void nrc_lwip_set_socket_event_cb(void (*cb)(int s, int evt));
+
 extern struct netif *nrc_netif[];
 
 #ifdef __cplusplus
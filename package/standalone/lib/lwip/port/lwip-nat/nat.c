@@ -25,6 +25,7 @@
  * OF SUCH DAMAGE.
  */
 #include <lwip/timeouts.h>
+#include <lwip/inet_chksum.h>
 #include "nat/nat.h"
 #include "nat/nat_proto_udp.h"
 #include "nat/nat_proto_tcp.h"
@@ -34,23 +35,23 @@
 static u8_t nat_timeout_tick;
 static struct nat_rule *nat_rules;
 
+/*
+ * Incremental checksum update (RFC 1624, eqn. 3): HC' = ~(~HC + ~m + m')
+ *
+ * The sums of the old and new data come from the port checksum engine;
+ * inet_chksum() already returns the complemented sum ~m.
+ */
 void
 update_chksum(u16_t *_hc, const void *_orig, const void *_new, int n)
 {
-	const u16_t *orig = _orig;
-	const u16_t *new = _new;
-	u16_t hc = ~*_hc;
-	while (n--) {
-		/* HC' = ~(~HC + ~m + m') */
-		u32_t s;
-		s = (u32_t) hc + ((~*orig) & 0xffff) + *new;
-		while (s & 0xffff0000)
-			s = (s & 0xffff) + (s >> 16);
-		hc = s;
-		orig++;
-		new++;
-	}
-	*_hc = ~hc;
+	u32_t acc;
+
+	acc = (u16_t) ~*_hc;
+	acc += inet_chksum(_orig, n * 2);
+	acc += (u16_t) ~inet_chksum(_new, n * 2);
+	acc = FOLD_U32T(acc);
+	acc = FOLD_U32T(acc);
+	*_hc = (u16_t) ~acc;
 }
 
 void
@@ -63,37 +64,6 @@ update_chksum_udp(u16_t *hc, const void *orig, const void *new, int n)
 		*hc = 0xffff;
 }
 
-#if LWIP_NAT_USE_OLDEST
-static u8_t
-nat_pcb_remaining(struct nat_pcb *pcb)
-{
-	return pcb->timeout - nat_timeout_tick;
-}
-
-void
-nat_pcb_take_oldest(struct nat_pcb **free, struct nat_pcb **used, u8_t limit)
-{
-	struct nat_pcb *pcb, **prev = used;
-	struct nat_pcb **oldest_prev = NULL, *oldest = NULL;
-	u8_t oldest_remaining = 0;
-
-	for (pcb = *used; pcb; prev = &pcb->next, pcb = pcb->next) {
-		u8_t remaining = nat_pcb_remaining(pcb);
-		if (remaining < limit && oldest_remaining < remaining) {
-			oldest = pcb;
-			oldest_remaining = remaining;
-			oldest_prev = prev;
-		}
-	}
-
-	if (oldest) {
-		*oldest_prev = oldest->next;
-		oldest->next = *free;
-		*free = oldest;
-	}
-}
-#endif
-
 int
 nat_pcb_timedout(struct nat_pcb *pcb)
 {
@@ -107,21 +77,25 @@ nat_pcb_refresh(struct nat_pcb *pcb, u8_t ticks)
 	pcb->timeout = nat_timeout_tick + ticks;
 }
 
+/*
+ * Expired entries are reclaimed on every tick. Entries past their
+ * timeout are skipped by lookups, so the packet path never has to walk
+ * the used lists. Reclaiming every tick also keeps the 8 bit timeout
+ * from wrapping around on expired entries.
+ */
 void
 nat_timer_tick(void *arg)
 {
 	nat_timeout_tick++;
-	if (!(nat_timeout_tick & 0x7f)) {
 #if LWIP_TCP
-		nat_tcp_expire();
+	nat_tcp_expire();
 #endif
 #if LWIP_UDP
-		nat_udp_expire();
+	nat_udp_expire();
 #endif
 #if LWIP_IPV4 && LWIP_ICMP && LWIP_NAT_ICMP
-		nat_icmp4_expire();
+	nat_icmp4_expire();
 #endif
-	}
 }
 
 #if LWIP_TIMERS
@@ -162,6 +136,170 @@ nat_pcb_init_mem(u8_t *storage, size_t len, size_t count)
 	return first;
 }
 
+static u32_t
+nat_hash_word(u32_t h, u32_t w)
+{
+	h = (h ^ w) * 0x9e3779b1UL;
+	return h ^ (h >> 16);
+}
+
+static u32_t
+nat_hash_addr(u32_t h, const ip_addr_t *addr)
+{
+#if LWIP_IPV6
+	if (IP_IS_V6(addr)) {
+		const ip6_addr_t *addr6 = ip_2_ip6(addr);
+		int i;
+		for (i = 0; i < 4; i++)
+			h = nat_hash_word(h, addr6->addr[i]);
+		return h;
+	}
+#endif
+	return nat_hash_word(h, ip4_addr_get_u32(ip_2_ip4(addr)));
+}
+
+/*
+ * Hash a connection as seen from one side of the NAT. id carries the
+ * protocol specific part of the key (ports, ICMP type and id).
+ */
+u32_t
+nat_hash(u8_t netif_idx, const ip_addr_t *remote, const ip_addr_t *addr,
+		u32_t id)
+{
+	u32_t h = netif_idx;
+
+	h = nat_hash_addr(h, remote);
+	h = nat_hash_addr(h, addr);
+	return nat_hash_word(h, id);
+}
+
+static void
+nat_pcb_table_hash_remove(struct nat_pcb **head, struct nat_pcb *pcb,
+			size_t next_offset)
+{
+	struct nat_pcb **prev;
+
+	for (prev = head; *prev; ) {
+		struct nat_pcb **next = (struct nat_pcb **)
+					(((u8_t *) *prev) + next_offset);
+		if (*prev == pcb) {
+			*prev = *next;
+			*next = NULL;
+			return;
+		}
+		prev = next;
+	}
+}
+
+/* Remove a used entry from the hash tables and hand it back to lwIP */
+static void
+nat_pcb_table_release(struct nat_pcb_table *table, struct nat_pcb *pcb)
+{
+	nat_pcb_table_hash_remove(&table->ext_hash[pcb->ext_bucket], pcb,
+				offsetof(struct nat_pcb, ext_next));
+	nat_pcb_table_hash_remove(&table->int_hash[pcb->int_bucket], pcb,
+				offsetof(struct nat_pcb, int_next));
+	if (table->release)
+		table->release(pcb);
+	table->used_cnt--;
+}
+
+#if LWIP_NAT_USE_OLDEST
+static u8_t
+nat_pcb_remaining(struct nat_pcb *pcb)
+{
+	return pcb->timeout - nat_timeout_tick;
+}
+
+static void
+nat_pcb_take_oldest(struct nat_pcb_table *table, u8_t limit)
+{
+	struct nat_pcb *pcb, **prev = &table->used;
+	struct nat_pcb **oldest_prev = NULL, *oldest = NULL;
+	u8_t oldest_remaining = 0;
+
+	for (pcb = table->used; pcb; prev = &pcb->next, pcb = pcb->next) {
+		u8_t remaining = nat_pcb_remaining(pcb);
+		if (remaining < limit && oldest_remaining < remaining) {
+			oldest = pcb;
+			oldest_remaining = remaining;
+			oldest_prev = prev;
+		}
+	}
+
+	if (oldest) {
+		*oldest_prev = oldest->next;
+		nat_pcb_table_release(table, oldest);
+		oldest->next = table->free;
+		table->free = oldest;
+	}
+}
+#endif
+
+/*
+ * Find a free entry for a new connection. The entry stays on the free
+ * list until it is handed to nat_pcb_table_insert(), so the caller can
+ * simply drop it if setting up the connection fails. limit is passed
+ * on to the LWIP_NAT_USE_OLDEST eviction.
+ */
+struct nat_pcb *
+nat_pcb_table_alloc(struct nat_pcb_table *table, u8_t limit)
+{
+	if (!table->initialized) {
+		table->free = nat_pcb_init_mem(table->storage,
+					table->pcb_sz, table->count);
+		table->initialized = 1;
+	}
+
+	/* Entries may have timed out since the last tick */
+	if (!table->free)
+		nat_pcb_table_expire(table);
+#if LWIP_NAT_USE_OLDEST
+	if (!table->free)
+		nat_pcb_take_oldest(table, limit);
+#endif
+	return table->free;
+}
+
+void
+nat_pcb_table_insert(struct nat_pcb_table *table, struct nat_pcb *pcb,
+			u32_t ext_hash, u32_t int_hash)
+{
+	LWIP_ASSERT("nat pcb not taken from the free list", pcb == table->free);
+
+	/* Remove from free list, add to used list */
+	table->free = pcb->next;
+	pcb->next = table->used;
+	table->used = pcb;
+	table->used_cnt++;
+
+	pcb->ext_bucket = ext_hash & table->hash_mask;
+	pcb->ext_next = table->ext_hash[pcb->ext_bucket];
+	table->ext_hash[pcb->ext_bucket] = pcb;
+
+	pcb->int_bucket = int_hash & table->hash_mask;
+	pcb->int_next = table->int_hash[pcb->int_bucket];
+	table->int_hash[pcb->int_bucket] = pcb;
+}
+
+void
+nat_pcb_table_expire(struct nat_pcb_table *table)
+{
+	struct nat_pcb *pcb, *next, **prev = &table->used;
+
+	for (pcb = table->used; pcb; pcb = next) {
+		next = pcb->next;
+		if (nat_pcb_timedout(pcb)) {
+			*prev = next;
+			nat_pcb_table_release(table, pcb);
+			pcb->next = table->free;
+			table->free = pcb;
+			continue;
+		}
+		prev = &pcb->next;
+	}
+}
+
 int
 nat_rule_check(struct netif *inp, struct netif *forwardp)
 {
@@ -34,11 +34,13 @@
 #define LWIP_NAT_ICMP_PCB_SZ offsetof(struct nat_pcb, icmp.end)
 
 #if LWIP_ICMP && LWIP_NAT && LWIP_NAT_ICMP
-static int nat_icmp4_pcbs_initialized;
 static u8_t nat_icmp4_storage[LWIP_NAT_ICMP_PCB_SZ * LWIP_NAT_ICMP4_MAX];
+static struct nat_pcb *nat_icmp4_ext_hash[LWIP_NAT_ICMP4_HASH_SIZE];
+static struct nat_pcb *nat_icmp4_int_hash[LWIP_NAT_ICMP4_HASH_SIZE];
 
-static struct nat_pcb *nat_icmp4_used;
-static struct nat_pcb *nat_icmp4_free;
+static struct nat_pcb_table nat_icmp4_table = NAT_PCB_TABLE_INIT(nat_icmp4_storage,
+		LWIP_NAT_ICMP_PCB_SZ, LWIP_NAT_ICMP4_MAX,
+		nat_icmp4_ext_hash, nat_icmp4_int_hash, NULL);
 
 static const u8_t icmp_type_map[] = {
 	[ICMP_ECHO] = ICMP_ER,
@@ -50,26 +52,18 @@ static const u8_t icmp_type_map[] = {
 #define ICMP4_TYPE_COOKIE(type, code) (((u16_t)(type) << 8) | (u16_t)(code))
 #define ICMP4_ID_COOKIE(id, seqno) (((u32_t)(id) << 16) | (u32_t)(seqno))
 
+#define NAT_ICMP4_KEY(type, id) ((u32_t)(type) ^ (id))
+
 static struct nat_pcb *
 nat_icmp4_new(u8_t ext_netif_idx, u8_t int_netif_idx, const ip_addr_t *remote,
 	const ip_addr_t *local, const ip_addr_t *nat, u16_t type, u32_t id)
 {
 	struct nat_pcb *pcb;
 
-	if (!nat_icmp4_pcbs_initialized) {
-		nat_icmp4_free = nat_pcb_init_mem(nat_icmp4_storage,
-					LWIP_NAT_ICMP_PCB_SZ, LWIP_NAT_ICMP4_MAX);
-		nat_icmp4_pcbs_initialized = 1;
-	}
-
-#if LWIP_NAT_USE_OLDEST
-	if (!nat_icmp4_free)
-		nat_pcb_take_oldest(&nat_icmp4_free, &nat_icmp4_used,
+	pcb = nat_pcb_table_alloc(&nat_icmp4_table,
 			LWIP_NAT_ICMP_TICKS - LWIP_NAT_ICMP_USE_OLDEST_LIMIT);
-#endif
-	if (!nat_icmp4_free)
+	if (!pcb)
 		return NULL;
-	pcb = nat_icmp4_free;
 
 	pcb->icmp.type = type;
 	pcb->icmp.id = id;
@@ -80,52 +74,57 @@ nat_icmp4_new(u8_t ext_netif_idx, u8_t int_netif_idx, const ip_addr_t *remote,
 	ip_addr_set(&pcb->ip.remote_ip, remote);
 	ip_addr_set(&pcb->ip.local_ip, local);
 
-	nat_icmp4_free = pcb->next;
-	pcb->next = nat_icmp4_used;
-	nat_icmp4_used = pcb;
+	nat_pcb_table_insert(&nat_icmp4_table, pcb,
+		nat_hash(ext_netif_idx, remote, local, NAT_ICMP4_KEY(type, id)),
+		nat_hash(ext_netif_idx, remote, nat, NAT_ICMP4_KEY(type, id)));
 
 	return pcb;
 }
 
+/*
+ * Look up a NAT entry either by its outbound address (local) or by its
+ * address on the NAT network (nat). Exactly one of them must be given.
+ */
 static struct nat_pcb *
 nat_icmp4_walk(u8_t ext_netif_idx, u8_t int_netif_idx, const ip_addr_t *remote,
 	const ip_addr_t *local, const ip_addr_t *nat, u16_t type, u32_t id)
 {
-	struct nat_pcb *pcb, *next, **prev = &nat_icmp4_used;
-	int n = 0;
-
-	for (pcb = nat_icmp4_used; pcb; pcb = next) {
-		next = pcb->next;
-		if (nat_pcb_timedout(pcb)) {
-			*prev = next;
-			pcb->next = nat_icmp4_free;
-			nat_icmp4_free = pcb;
-			continue;
+	struct nat_pcb *pcb;
+
+	if (local) {
+		u32_t hash = nat_hash(ext_netif_idx, remote, local,
+					NAT_ICMP4_KEY(type, id));
+		for (pcb = nat_pcb_table_ext_head(&nat_icmp4_table, hash); pcb;
+		     pcb = pcb->ext_next) {
+			if (ext_netif_idx == pcb->ext_netif_idx &&
+			    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
+			    type == pcb->icmp.type && id == pcb->icmp.id &&
+			    ip_addr_cmp(local, &pcb->ip.local_ip) &&
+			    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
+			    !nat_pcb_timedout(pcb))
+				return pcb;
 		}
-		n++;
-		if (ext_netif_idx == pcb->ext_netif_idx &&
-		    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
-		    type == pcb->icmp.type && id == pcb->icmp.id &&
-		    (!local || ip_addr_cmp(local, &pcb->ip.local_ip)) &&
-		    (!nat || ip_addr_cmp(nat, &pcb->nat_local_ip)) &&
-		    ip_addr_cmp(remote, &pcb->ip.remote_ip)) {
-			if (n > 16) {
-				/* If it's far down the list, move it to head */
-				*prev = next;
-				pcb->next = nat_icmp4_used;
-				nat_icmp4_used = pcb;
-			}
-			break;
+	} else if (nat) {
+		u32_t hash = nat_hash(ext_netif_idx, remote, nat,
+					NAT_ICMP4_KEY(type, id));
+		for (pcb = nat_pcb_table_int_head(&nat_icmp4_table, hash); pcb;
+		     pcb = pcb->int_next) {
+			if (ext_netif_idx == pcb->ext_netif_idx &&
+			    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
+			    type == pcb->icmp.type && id == pcb->icmp.id &&
+			    ip_addr_cmp(nat, &pcb->nat_local_ip) &&
+			    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
+			    !nat_pcb_timedout(pcb))
+				return pcb;
 		}
-		prev = &pcb->next;
 	}
-	return pcb;
+	return NULL;
 }
 
 void
 nat_icmp4_expire(void)
 {
-	nat_icmp4_walk(0xff, 0xff, NULL, NULL, NULL, 0, 0);
+	nat_pcb_table_expire(&nat_icmp4_table);
 }
 
 #if LWIP_NAT_ICMP_IP
@@ -35,11 +35,15 @@
 
 #define LWIP_NAT_TCP_PCB_SZ offsetof(struct nat_pcb, nat_tcp.end)
 
-static int nat_tcp_pcbs_initialized;
 static u8_t nat_tcp_storage[LWIP_NAT_TCP_PCB_SZ * LWIP_NAT_TCP_MAX];
+static struct nat_pcb *nat_tcp_ext_hash[LWIP_NAT_TCP_HASH_SIZE];
+static struct nat_pcb *nat_tcp_int_hash[LWIP_NAT_TCP_HASH_SIZE];
 
-static struct nat_pcb *nat_tcp_used;
-static struct nat_pcb *nat_tcp_free;
+static void nat_tcp_release(struct nat_pcb *pcb);
+
+static struct nat_pcb_table nat_tcp_table = NAT_PCB_TABLE_INIT(nat_tcp_storage,
+		LWIP_NAT_TCP_PCB_SZ, LWIP_NAT_TCP_MAX,
+		nat_tcp_ext_hash, nat_tcp_int_hash, nat_tcp_release);
 
 static u16_t nat_tcp_port = LWIP_NAT_TCP_LOCAL_PORT_RANGE_START;
 
@@ -49,6 +53,15 @@ tcp_unlink(struct tcp_pcb *pcb)
 	TCP_RMV(&tcp_listen_pcbs.pcbs, pcb);
 }
 
+static void
+nat_tcp_release(struct nat_pcb *pcb)
+{
+	tcp_unlink(&pcb->tcp);
+}
+
+#define NAT_TCP_PORTS(remote_port, port) \
+	(((u32_t)(remote_port) << 16) | (u32_t)(port))
+
 static struct nat_pcb *
 nat_tcp_new(u8_t ext_netif_idx, u8_t int_netif_idx, const ip_addr_t *remote, u16_t remote_port,
 			const ip_addr_t *local,
@@ -58,23 +71,10 @@ nat_tcp_new(u8_t ext_netif_idx, u8_t int_netif_idx, const ip_addr_t *remote, u16
 	err_t err;
 	u16_t n = LWIP_NAT_TCP_LOCAL_PORT_RANGE_END - LWIP_NAT_TCP_LOCAL_PORT_RANGE_START;
 
-	if (!nat_tcp_pcbs_initialized) {
-		nat_tcp_free = nat_pcb_init_mem(nat_tcp_storage,
-					LWIP_NAT_TCP_PCB_SZ, LWIP_NAT_TCP_MAX);
-		nat_tcp_pcbs_initialized = 1;
-	}
-
-#if LWIP_NAT_USE_OLDEST
-	if (!nat_tcp_free) {
-		nat_pcb_take_oldest(&nat_tcp_free, &nat_tcp_used,
+	pcb = nat_pcb_table_alloc(&nat_tcp_table,
 			LWIP_NAT_TCP_TICKS - LWIP_NAT_TCP_USE_OLDEST_LIMIT);
-		if (nat_tcp_free)
-			tcp_unlink(&nat_tcp_free->tcp);
-	}
-#endif
-	if (!nat_tcp_free)
+	if (!pcb)
 		return NULL;
-	pcb = nat_tcp_free;
 
 	/* Initialize fields used by LWIP */
 	pcb->tcp.next = NULL;
@@ -107,59 +107,65 @@ again:
 	pcb->int_netif_idx = int_netif_idx;
 	ip_addr_set(&pcb->nat_local_ip, nat);
 	ip_addr_set(&pcb->ip.remote_ip, remote);
+	nat_pcb_refresh(pcb, LWIP_NAT_TCP_TICKS);
 
-	/* Remove from free list, add to used list */
-	nat_tcp_free = pcb->next;
-	pcb->next = nat_tcp_used;
-	nat_tcp_used = pcb;
+	nat_pcb_table_insert(&nat_tcp_table, pcb,
+		nat_hash(ext_netif_idx, remote, &pcb->ip.local_ip,
+			NAT_TCP_PORTS(remote_port, pcb->tcp.local_port)),
+		nat_hash(ext_netif_idx, remote, nat,
+			NAT_TCP_PORTS(remote_port, nat_port)));
 
 	return pcb;
 }
 
+/*
+ * Look up a NAT entry either by its outbound address (local) or by its
+ * address on the NAT network (nat). Exactly one of them must be given.
+ */
 static struct nat_pcb *
 nat_tcp_walk(u8_t ext_netif_idx, u8_t int_netif_idx,
 		const ip_addr_t *remote, u16_t remote_port,
 		const ip_addr_t *local, u16_t local_port,
 		const ip_addr_t *nat, u16_t nat_port)
 {
-	struct nat_pcb *pcb, *next, **prev = &nat_tcp_used;
-	int n = 0;
-
-	for (pcb = nat_tcp_used; pcb; pcb = next) {
-		next = pcb->next;
-		if (nat_pcb_timedout(pcb)) {
-			tcp_unlink(&pcb->tcp);
-			*prev = next;
-			pcb->next = nat_tcp_free;
-			nat_tcp_free = pcb;
-			continue;
+	struct nat_pcb *pcb;
+
+	if (local) {
+		u32_t hash = nat_hash(ext_netif_idx, remote, local,
+					NAT_TCP_PORTS(remote_port, local_port));
+		for (pcb = nat_pcb_table_ext_head(&nat_tcp_table, hash); pcb;
+		     pcb = pcb->ext_next) {
+			if (ext_netif_idx == pcb->ext_netif_idx &&
+			    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
+			    local_port == pcb->tcp.local_port &&
+			    remote_port == pcb->tcp.remote_port &&
+			    ip_addr_cmp(local, &pcb->ip.local_ip) &&
+			    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
+			    !nat_pcb_timedout(pcb))
+				return pcb;
 		}
-		n++;
-		if (ext_netif_idx == pcb->ext_netif_idx &&
-		    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
-		   (!local || (ip_addr_cmp(local, &pcb->ip.local_ip) &&
-		     local_port == pcb->tcp.local_port)) &&
-		    (!nat  || (ip_addr_cmp(nat, &pcb->nat_local_ip) &&
-		     nat_port == pcb->nat_tcp.nat_local_port)) &&
-		    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
-		    remote_port == pcb->tcp.remote_port) {
-			if (n > 16) {
-				/* If it's far down the list, move it to head */
-				*prev = next;
-				pcb->next = nat_tcp_used;
-				nat_tcp_used = pcb;
-			}
-			break;
+	} else if (nat) {
+		u32_t hash = nat_hash(ext_netif_idx, remote, nat,
+					NAT_TCP_PORTS(remote_port, nat_port));
+		for (pcb = nat_pcb_table_int_head(&nat_tcp_table, hash); pcb;
+		     pcb = pcb->int_next) {
+			if (ext_netif_idx == pcb->ext_netif_idx &&
+			    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
+			    nat_port == pcb->nat_tcp.nat_local_port &&
+			    remote_port == pcb->tcp.remote_port &&
+			    ip_addr_cmp(nat, &pcb->nat_local_ip) &&
+			    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
+			    !nat_pcb_timedout(pcb))
+				return pcb;
 		}
-		prev = &pcb->next;
 	}
-	return pcb;
+	return NULL;
 }
 
 void
 nat_tcp_expire(void)
 {
-	nat_tcp_walk(0xff, 0xff, NULL, 0, NULL, 0, NULL, 0);
+	nat_pcb_table_expire(&nat_tcp_table);
 }
 
 #if LWIP_ICMP && LWIP_NAT_ICMP_IP
@@ -249,7 +255,8 @@ tcp_prerouting_pcb(struct pbuf *p, struct netif *inp, struct netif *forwardp)
 
 #if CHECKSUM_CHECK_TCP
 	IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_TCP)
-		if (ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len,
+		if (!(p->flags & PBUF_FLAG_L4_CHKSUM_OK) &&
+		    ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len,
 				ip_current_src_addr(), ip_current_dest_addr()))
 			return NULL;
 #endif
@@ -34,11 +34,15 @@
 
 #define LWIP_NAT_UDP_PCB_SZ offsetof(struct nat_pcb, nat_udp.end)
 
-static int nat_udp_pcbs_initialized;
 static u8_t nat_udp_storage[LWIP_NAT_UDP_PCB_SZ * LWIP_NAT_UDP_MAX];
+static struct nat_pcb *nat_udp_ext_hash[LWIP_NAT_UDP_HASH_SIZE];
+static struct nat_pcb *nat_udp_int_hash[LWIP_NAT_UDP_HASH_SIZE];
 
-static struct nat_pcb *nat_udp_used;
-static struct nat_pcb *nat_udp_free;
+static void nat_udp_release(struct nat_pcb *pcb);
+
+static struct nat_pcb_table nat_udp_table = NAT_PCB_TABLE_INIT(nat_udp_storage,
+		LWIP_NAT_UDP_PCB_SZ, LWIP_NAT_UDP_MAX,
+		nat_udp_ext_hash, nat_udp_int_hash, nat_udp_release);
 
 static u16_t nat_udp_port = LWIP_NAT_UDP_LOCAL_PORT_RANGE_START;
 
@@ -57,6 +61,15 @@ udp_unlink(struct udp_pcb *pcb)
 	}
 }
 
+static void
+nat_udp_release(struct nat_pcb *pcb)
+{
+	udp_unlink(&pcb->udp);
+}
+
+#define NAT_UDP_PORTS(remote_port, port) \
+	(((u32_t)(remote_port) << 16) | (u32_t)(port))
+
 static struct nat_pcb *
 nat_udp_new(u8_t ext_netif_idx, u8_t int_netif_idx,
 	const ip_addr_t *remote, u16_t remote_port, const ip_addr_t *local,
@@ -66,23 +79,10 @@ nat_udp_new(u8_t ext_netif_idx, u8_t int_netif_idx,
 	err_t err;
 	u16_t n = LWIP_NAT_UDP_LOCAL_PORT_RANGE_END - LWIP_NAT_UDP_LOCAL_PORT_RANGE_START;
 
-	if (!nat_udp_pcbs_initialized) {
-		nat_udp_free = nat_pcb_init_mem(nat_udp_storage,
-					LWIP_NAT_UDP_PCB_SZ, LWIP_NAT_UDP_MAX);
-		nat_udp_pcbs_initialized = 1;
-	}
-
-#if LWIP_NAT_USE_OLDEST
-	if (!nat_udp_free) {
-		nat_pcb_take_oldest(&nat_udp_free, &nat_udp_used,
+	pcb = nat_pcb_table_alloc(&nat_udp_table,
 			LWIP_NAT_UDP_TICKS - LWIP_NAT_UDP_USE_OLDEST_LIMIT);
-		if (nat_udp_free)
-			udp_unlink(&nat_udp_free->udp);
-	}
-#endif
-	if (!nat_udp_free)
+	if (!pcb)
 		return NULL;
-	pcb = nat_udp_free;
 
 	/* Initialize LWIP fields to make this a valid udp_pcb */
 	pcb->udp.next = NULL;
@@ -108,60 +108,66 @@ again:
 	pcb->int_netif_idx = int_netif_idx;
 	ip_addr_set(&pcb->nat_local_ip, nat);
 	ip_addr_set(&pcb->ip.remote_ip, remote);
+	nat_pcb_refresh(pcb, LWIP_NAT_UDP_TICKS);
 
-	/* Remove from free list, add to used list */
-	nat_udp_free = pcb->next;
-	pcb->next = nat_udp_used;
-	nat_udp_used = pcb;
+	nat_pcb_table_insert(&nat_udp_table, pcb,
+		nat_hash(ext_netif_idx, remote, &pcb->ip.local_ip,
+			NAT_UDP_PORTS(remote_port, pcb->udp.local_port)),
+		nat_hash(ext_netif_idx, remote, nat,
+			NAT_UDP_PORTS(remote_port, nat_port)));
 
 	return pcb;
 }
 
-/* Search for the matching NAT entry, removing stale ones as we go */
+/*
+ * Search for the matching NAT entry either by its outbound address (local)
+ * or by its address on the NAT network (nat). Exactly one of them must be
+ * given.
+ */
 static struct nat_pcb *
 nat_udp_walk(u8_t ext_netif_idx, u8_t int_netif_idx,
 		const ip_addr_t *remote, u16_t remote_port,
 		const ip_addr_t *local, u16_t local_port,
 		const ip_addr_t *nat, u16_t nat_port)
 {
-	struct nat_pcb *pcb, *next, **prev = &nat_udp_used;
-	int n = 0;
-
-	for (pcb = nat_udp_used; pcb; pcb = next) {
-		next = pcb->next;
-		if (nat_pcb_timedout(pcb)) {
-			udp_unlink(&pcb->udp);
-			*prev = next;
-			pcb->next = nat_udp_free;
-			nat_udp_free = pcb;
-			continue;
+	struct nat_pcb *pcb;
+
+	if (local) {
+		u32_t hash = nat_hash(ext_netif_idx, remote, local,
+					NAT_UDP_PORTS(remote_port, local_port));
+		for (pcb = nat_pcb_table_ext_head(&nat_udp_table, hash); pcb;
+		     pcb = pcb->ext_next) {
+			if (ext_netif_idx == pcb->ext_netif_idx &&
+			    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
+			    local_port == pcb->udp.local_port &&
+			    remote_port == pcb->udp.remote_port &&
+			    ip_addr_cmp(local, &pcb->ip.local_ip) &&
+			    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
+			    !nat_pcb_timedout(pcb))
+				return pcb;
 		}
-		n++;
-		if (ext_netif_idx == pcb->ext_netif_idx &&
-		    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
-		    (!local || (ip_addr_cmp(local, &pcb->ip.local_ip) &&
-		     local_port == pcb->udp.local_port)) &&
-		    (!nat || (ip_addr_cmp(nat, &pcb->nat_local_ip) &&
-		     nat_port == pcb->nat_udp.nat_local_port)) &&
-		    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
-		    remote_port == pcb->udp.remote_port) {
-			if (n > 16) {
-				/* If it's far down the list, move it to head */
-				*prev = next;
-				pcb->next = nat_udp_used;
-				nat_udp_used = pcb;
-			}
-			break;
+	} else if (nat) {
+		u32_t hash = nat_hash(ext_netif_idx, remote, nat,
+					NAT_UDP_PORTS(remote_port, nat_port));
+		for (pcb = nat_pcb_table_int_head(&nat_udp_table, hash); pcb;
+		     pcb = pcb->int_next) {
+			if (ext_netif_idx == pcb->ext_netif_idx &&
+			    (!int_netif_idx || int_netif_idx == pcb->int_netif_idx) &&
+			    nat_port == pcb->nat_udp.nat_local_port &&
+			    remote_port == pcb->udp.remote_port &&
+			    ip_addr_cmp(nat, &pcb->nat_local_ip) &&
+			    ip_addr_cmp(remote, &pcb->ip.remote_ip) &&
+			    !nat_pcb_timedout(pcb))
+				return pcb;
 		}
-		prev = &pcb->next;
 	}
-	return pcb;
+	return NULL;
 }
 
 void
 nat_udp_expire(void)
 {
-	nat_udp_walk(0xff, 0xff, NULL, 0, NULL, 0, NULL, 0);
+	nat_pcb_table_expire(&nat_udp_table);
 }
 
 #if LWIP_ICMP && LWIP_NAT_ICMP_IP
@@ -236,7 +242,7 @@ udp_prerouting_pcb(struct pbuf *p, struct netif *inp, struct netif *forwardp)
 	 */
 #if CHECKSUM_CHECK_UDP
 	IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_UDP)
-		if (udphdr->chksum != 0)
+		if (udphdr->chksum != 0 && !(p->flags & PBUF_FLAG_L4_CHKSUM_OK))
 			if (ip_chksum_pseudo(p, IP_PROTO_UDP, p->tot_len,
 			    ip_current_src_addr(),
 			    ip_current_dest_addr()) != 0)
@@ -8,10 +8,20 @@
 #include "lwip/timeouts.h"
 #include "lwip/stats.h"
 #include "lwip/snmp.h"
+#include "lwip/memp.h"
 #include "netif/etharp.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+#include "lwip/prot/udp.h"
+#include "nrc_chksum.h"
 #include "driver_nrc.h"
 #include "driver_nrc_tx.h"
 #include "nrc_lwip.h"
+#include "netif/wlif.h"
+#include "lmac_common.h"
+#include "util_cmd.h"
 #if LWIP_IPV6
 #include "lwip/ethip6.h"
 #endif
@@ -66,6 +76,20 @@ err_t low_level_init(struct netif *netif)
 }
 /*-----------------------------------------------------------*/
 
+/*
+ * Transmit buffers handed to nrc_transmit_from_8023_mb() per frame. The
+ * driver copies them into modem buffers before returning, so pbuf
+ * payloads are passed by reference. Fragments shorter than
+ * LWIF_TX_COPY_THRESHOLD (e.g. separately allocated protocol headers) are
+ * gathered into a bounce buffer instead, as is the tail of any chain
+ * longer than LWIF_TX_MAX_FRAGS.
+ */
+#define LWIF_TX_MAX_FRAGS                   ( 10 )
+#define LWIF_TX_COPY_THRESHOLD              ( 64 )
+
+/* linkoutput is serialized by the tcpip thread, one bounce buffer is enough */
+static uint8_t lwif_tx_bounce[netifMTU + SIZEOF_ETH_HDR + SIZEOF_VLAN_HDR];
+
 /*
  * low_level_output(): Should do the actual transmission of the packet. The
  * packet is contained in the pbuf that is passed to the function. This pbuf
@@ -75,22 +99,56 @@ err_t low_level_init(struct netif *netif)
 static err_t low_level_output( struct netif *netif, struct pbuf *p )
 {
 	struct pbuf *q;
-	err_t xReturn = ERR_OK;
-	const int MAX_FRAME_NUM = 10;
-	uint8_t *frames[MAX_FRAME_NUM];
-	uint16_t frame_len[MAX_FRAME_NUM];
+	uint8_t *frames[LWIF_TX_MAX_FRAGS];
+	uint16_t frame_len[LWIF_TX_MAX_FRAGS];
+	uint16_t used = 0;
+	bool in_bounce = false;
 	int i = 0;
+	int ret;
 
 	for( q = p; q != NULL; q = q->next ) {
-		frames[i] = q->payload;
-		frame_len[i] = q->len;
-		i++;
+		if (q->len == 0)
+			continue;
+
+		/* Pass by reference unless it is tiny or we are out of slots */
+		if (q->len >= LWIF_TX_COPY_THRESHOLD && i < LWIF_TX_MAX_FRAGS - 1) {
+			frames[i] = q->payload;
+			frame_len[i] = q->len;
+			i++;
+			in_bounce = false;
+			continue;
+		}
+
+		if (used + q->len > sizeof(lwif_tx_bounce)) {
+			E(TT_NET, "[%s] frame too long to gather (%d)\n", __func__, p->tot_len);
+			LINK_STATS_INC(link.lenerr);
+			LINK_STATS_INC(link.drop);
+			return ERR_BUF;
+		}
+
+		/* Extend the last entry if it already ends in the bounce buffer */
+		if (!in_bounce) {
+			frames[i] = &lwif_tx_bounce[used];
+			frame_len[i] = 0;
+			i++;
+			in_bounce = true;
+		}
+		MEMCPY(&lwif_tx_bounce[used], q->payload, q->len);
+		frame_len[i - 1] += q->len;
+		used += q->len;
+	}
+
+	V(TT_NET, "[%s] netif->num = %d, output frames = %d, tot_len = %d...\n", __func__, netif->num, i, p->tot_len);
+	ret = nrc_transmit_from_8023_mb(netif->num, frames, frame_len, i);
+	if (ret < 0) {
+		/* No modem buffer or credit: tell lwIP rather than drop silently */
+		LINK_STATS_INC(link.memerr);
+		LINK_STATS_INC(link.drop);
+		return ERR_MEM;
 	}
-	V(TT_NET, "[%s] netif->num = %d, output frames = %d, frame_len = %d...\n", __func__, netif->num, i, frame_len[0]);
-	xReturn = nrc_transmit_from_8023_mb(netif->num, frames, frame_len, i);
 	LINK_STATS_INC(link.xmit);
 
-	return  xReturn;
+	return ERR_OK;
 }
 
 #if 0 // not referenced
@@ -135,38 +193,135 @@ void lwif_input_from_net80211_pbuf(struct pbuf* p)
 }
 #endif
 
-void lwif_input(struct nrc_wpa_if* intf, void *buffer, int data_len)
+static struct lwif_rx_stats lwif_rx_stats;
+
+#if LWIP_NRC_RX_ZERO_COPY
+/* Modem receive buffer lent to lwIP as a PBUF_REF payload */
+struct lwif_rx_pbuf {
+	struct pbuf_custom pc;
+	SYS_BUF *buf;
+};
+
+LWIP_MEMPOOL_DECLARE(LWIF_RX_PBUF, LWIP_NRC_RX_ZERO_COPY_NUM,
+			sizeof(struct lwif_rx_pbuf), "LWIF_RX_PBUF");
+static bool lwif_rx_pool_ready;
+
+/*
+ * A STA bridging without 4-address rewrites the destination MAC of
+ * received ARP/IP frames. The modem buffer may still be referenced by the
+ * driver (e.g. relayed broadcasts), so such frames are copied first.
+ */
+static bool lwif_rx_rewrites(struct nrc_wpa_if* intf)
 {
-	struct eth_hdr *ethhdr;
-	struct netif *netif = nrc_netif[intf->vif_id];
-	struct pbuf *p = NULL, *q;
-	int remain = data_len;
-	int offset = 0;
-	int len = data_len;
-	struct etharp_hdr *arp_hdr;
-	struct ip_hdr *ip_hdr;
+#if defined(SUPPORT_ETHERNET_ACCESSPOINT)
+	return !intf->is_ap && !nrc_get_use_4address() &&
+		nrc_eth_get_network_mode() == NRC_NETWORK_MODE_BRIDGE;
+#else
+	return false;
+#endif
+}
+#endif /* LWIP_NRC_RX_ZERO_COPY */
 
-	V(TT_NET, "[%s] input length = %d...\n", __func__, data_len);
-	p = pbuf_alloc( PBUF_RAW, len, PBUF_POOL );
+#if LWIP_IPV4
+/*
+ * Returns the offset of the TCP/UDP segment in an unfragmented IPv4 frame
+ * whose transport checksum can be verified while it is copied in, 0 if
+ * the frame has to be left to the stack.
+ */
+static int lwif_l4_chksum_offset(const uint8_t *frame, int len, u16_t *l4_len)
+{
+	const struct eth_hdr *ethhdr = (const struct eth_hdr *)frame;
+	const struct ip_hdr *iphdr = (const struct ip_hdr *)(frame + SIZEOF_ETH_HDR);
+	const struct udp_hdr *udphdr;
+	u16_t hlen, tot_len;
+	int l4_off;
 
-	if( p != NULL )
-	{
-		for( q = p; q != NULL; (q = q->next)&&remain )
-		{
-			/* Read enough bytes to fill this pbuf in the chain. The
-			   available data in the pbuf is given by the q->len variable. */
-			memcpy(q->payload, (uint8_t*)buffer + offset, q->len);
-			remain -= q->len;
-			offset += q->len;
-		}
-		LINK_STATS_INC(link.recv);
+	if (len < SIZEOF_ETH_HDR + IP_HLEN || ethhdr->type != PP_HTONS(ETHTYPE_IP))
+		return 0;
+	if (IPH_V(iphdr) != 4 || (IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)))
+		return 0;
+
+	hlen = IPH_HL_BYTES(iphdr);
+	tot_len = lwip_ntohs(IPH_LEN(iphdr));
+	if (hlen < IP_HLEN || tot_len <= hlen || SIZEOF_ETH_HDR + tot_len > len)
+		return 0;
+
+	l4_off = SIZEOF_ETH_HDR + hlen;
+	*l4_len = tot_len - hlen;
+
+	switch (IPH_PROTO(iphdr)) {
+	case IP_PROTO_TCP:
+		return *l4_len >= TCP_HLEN ? l4_off : 0;
+	case IP_PROTO_UDP:
+		udphdr = (const struct udp_hdr *)(frame + l4_off);
+		/* A zero UDP checksum is not checked by lwIP anyway */
+		return (*l4_len >= UDP_HLEN && udphdr->chksum != 0) ? l4_off : 0;
+	default:
+		return 0;
 	}
-	else
-	{
-		LINK_STATS_INC(link.memerr);
-		LINK_STATS_INC(link.drop);
+}
+
+/* Add the IPv4 pseudo header to the segment sum and check the result */
+static int lwif_l4_chksum_ok(const struct ip_hdr *iphdr, u16_t l4_len, u16_t sum)
+{
+	u32_t src = iphdr->src.addr;
+	u32_t dest = iphdr->dest.addr;
+	u32_t acc = sum;
+
+	acc += (src & 0xffffUL) + (src >> 16);
+	acc += (dest & 0xffffUL) + (dest >> 16);
+	acc += (u32_t)lwip_htons((u16_t)IPH_PROTO(iphdr));
+	acc += (u32_t)lwip_htons(l4_len);
+	acc = FOLD_U32T(acc);
+	acc = FOLD_U32T(acc);
+	return acc == 0xffff;
+}
+#endif /* LWIP_IPV4 */
+
+/*
+ * Copy a received frame into a PBUF_POOL chain. Frames that fit one pbuf
+ * have their TCP/UDP checksum computed by the copy itself; if it is good,
+ * the pbuf is flagged so lwIP (and NAT) skip summing the payload again.
+ */
+static void lwif_copy_frame(struct pbuf *p, const uint8_t *frame, int len)
+{
+	struct pbuf *q;
+	int offset = 0;
+#if LWIP_IPV4
+	u16_t l4_len, sum;
+	int l4_off;
+
+	if (p->next == NULL &&
+	    (l4_off = lwif_l4_chksum_offset(frame, len, &l4_len)) > 0) {
+		uint8_t *payload = (uint8_t *)p->payload;
+
+		MEMCPY(payload, frame, l4_off);
+		sum = nrc_lwip_chksum_copy(payload + l4_off, frame + l4_off, l4_len);
+		/* Ethernet padding behind the IP datagram */
+		MEMCPY(payload + l4_off + l4_len, frame + l4_off + l4_len,
+					len - l4_off - l4_len);
+		if (lwif_l4_chksum_ok((struct ip_hdr *)(payload + SIZEOF_ETH_HDR),
+					l4_len, sum))
+			p->flags |= PBUF_FLAG_L4_CHKSUM_OK;
 		return;
 	}
+#endif /* LWIP_IPV4 */
+
+	for (q = p; q != NULL && offset < len; q = q->next) {
+		/* Read enough bytes to fill this pbuf in the chain. The
+		   available data in the pbuf is given by the q->len variable. */
+		MEMCPY(q->payload, frame + offset, q->len);
+		offset += q->len;
+	}
+}
+
+/* Pass a received frame up to lwIP, p is consumed */
+static void lwif_input_pbuf(struct nrc_wpa_if* intf, struct pbuf *p)
+{
+	struct eth_hdr *ethhdr;
+	struct netif *netif = nrc_netif[intf->vif_id];
+	struct etharp_hdr *arp_hdr;
+	struct ip_hdr *ip_hdr;
 
 	/* points to packet payload, which starts with an Ethernet header */
 	ethhdr = p->payload;
@@ -249,6 +404,106 @@ pbuf_free:
 			break;
 	}
 }
+
+void lwif_input(struct nrc_wpa_if* intf, void *buffer, int data_len)
+{
+	struct pbuf *p = NULL;
+	int len = data_len;
+
+	V(TT_NET, "[%s] input length = %d...\n", __func__, data_len);
+	p = pbuf_alloc( PBUF_RAW, len, PBUF_POOL );
+
+	if( p != NULL )
+	{
+		lwif_copy_frame(p, (const uint8_t *)buffer, data_len);
+		LINK_STATS_INC(link.recv);
+		lwif_rx_stats.copy++;
+	}
+	else
+	{
+		LINK_STATS_INC(link.memerr);
+		LINK_STATS_INC(link.drop);
+		return;
+	}
+
+	lwif_input_pbuf(intf, p);
+}
+
+#if LWIP_NRC_RX_ZERO_COPY
+/* Return the modem buffer once lwIP drops its last reference */
+static void lwif_rx_pbuf_free(struct pbuf *p)
+{
+	struct lwif_rx_pbuf *rx = (struct lwif_rx_pbuf *)p;
+	SYS_BUF *buf = rx->buf;
+
+	LWIP_MEMPOOL_FREE(LWIF_RX_PBUF, rx);
+	discard(buf);
+}
+#endif /* LWIP_NRC_RX_ZERO_COPY */
+
+void lwif_input_sysbuf(struct nrc_wpa_if* intf, SYS_BUF *buf, void *frame, int data_len)
+{
+#if LWIP_NRC_RX_ZERO_COPY
+	struct lwif_rx_pbuf *rx;
+	struct pbuf *p;
+
+	V(TT_NET, "[%s] input length = %d...\n", __func__, data_len);
+	if (lwif_rx_rewrites(intf)) {
+		lwif_rx_stats.copy_rewrite++;
+		goto copy;
+	}
+
+	rx = (struct lwif_rx_pbuf *)LWIP_MEMPOOL_ALLOC(LWIF_RX_PBUF);
+	if (rx == NULL) {
+		/* Don't let lwIP sit on more modem buffers, copy instead */
+		lwif_rx_stats.copy_busy++;
+		goto copy;
+	}
+
+	rx->pc.custom_free_function = lwif_rx_pbuf_free;
+	rx->buf = buf;
+	p = pbuf_alloced_custom(PBUF_RAW, data_len, PBUF_REF, &rx->pc,
+				frame, data_len);
+	LINK_STATS_INC(link.recv);
+	lwif_rx_stats.zero_copy++;
+	lwif_input_pbuf(intf, p);
+	return;
+
+copy:
+#endif /* LWIP_NRC_RX_ZERO_COPY */
+	lwif_input(intf, frame, data_len);
+	discard(buf);
+}
+
+void lwif_get_rx_stats(struct lwif_rx_stats *stats)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	*stats = lwif_rx_stats;
+	SYS_ARCH_UNPROTECT(lev);
+}
+
+#if defined(INCLUDE_USE_CLI)
+static int cmd_show_lwif_rx(cmd_tbl_t *t, int argc, char *argv[])
+{
+	struct lwif_rx_stats stats;
+
+	lwif_get_rx_stats(&stats);
+	system_printf("zero_copy    : %u\n", stats.zero_copy);
+	system_printf("copy         : %u\n", stats.copy);
+	system_printf("copy_rewrite : %u\n", stats.copy_rewrite);
+	system_printf("copy_busy    : %u\n", stats.copy_busy);
+
+	return CMD_RET_SUCCESS;
+}
+
+SUBCMD(show,
+	  lwif_rx,
+	  cmd_show_lwif_rx,
+	  "show lwIP RX zero-copy and copy counters",
+	  "show lwif_rx");
+#endif /* INCLUDE_USE_CLI */
 #include "standalone.h"
 
 err_t wlif_init( struct netif *netif )
@@ -287,6 +542,14 @@ err_t wlif_init( struct netif *netif )
 	/* set MAC hardware address length to be used by lwIP */
 	netif->hwaddr_len = 6;
 
+#if LWIP_NRC_RX_ZERO_COPY
+	/* Shared by all interfaces, must not be reset once frames are lent out */
+	if (!lwif_rx_pool_ready) {
+		LWIP_MEMPOOL_INIT(LWIF_RX_PBUF);
+		lwif_rx_pool_ready = true;
+	}
+#endif /* LWIP_NRC_RX_ZERO_COPY */
+
 	/* initialize the hardware */
 	low_level_init(netif);
 
@@ -0,0 +1,154 @@
+#include <string.h>
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#include "nrc_chksum.h"
+
+/*
+ * Word-wise Internet checksum.
+ *
+ * The data is summed as 32-bit words into a 64-bit accumulator, so carries
+ * only have to be folded once at the end. Leading bytes are consumed until
+ * the pointer is word aligned. If that took an odd number of bytes, the
+ * sum is byte swapped at the end (RFC 1071, byte order independence).
+ */
+
+#define NRC_CHKSUM_FOLD64(acc) \
+	do { \
+		(acc) = ((acc) & 0xffffffffULL) + ((acc) >> 32); \
+		(acc) = ((acc) & 0xffffffffULL) + ((acc) >> 32); \
+	} while (0)
+
+static uint16_t nrc_chksum_fold(uint64_t acc, int odd)
+{
+	uint32_t sum;
+
+	NRC_CHKSUM_FOLD64(acc);
+	sum = (uint32_t)acc;
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	if (odd)
+		sum = SWAP_BYTES_IN_WORD(sum);
+	return (uint16_t)sum;
+}
+
+/* Sum the bytes in front of the first word boundary */
+static const uint8_t *nrc_chksum_head(const uint8_t *pb, int *len,
+				uint64_t *acc, int *odd)
+{
+	uint16_t t = 0;
+
+	if (((uintptr_t)pb & 1) && *len > 0) {
+		/* Start with the odd byte in the high half (network order) */
+		((uint8_t *)&t)[1] = *pb++;
+		(*len)--;
+		*acc += t;
+		*odd = 1;
+	}
+	if (((uintptr_t)pb & 2) && *len >= 2) {
+		*acc += *(const uint16_t *)pb;
+		pb += 2;
+		*len -= 2;
+	}
+	return pb;
+}
+
+/* Sum the bytes behind the last full word */
+static void nrc_chksum_tail(const uint8_t *pb, int len, uint64_t *acc)
+{
+	uint16_t t = 0;
+
+	if (len >= 2) {
+		*acc += *(const uint16_t *)pb;
+		pb += 2;
+		len -= 2;
+	}
+	if (len > 0) {
+		((uint8_t *)&t)[0] = *pb;
+		*acc += t;
+	}
+}
+
+uint16_t nrc_lwip_chksum(const void *dataptr, int len)
+{
+	const uint8_t *pb = (const uint8_t *)dataptr;
+	const uint32_t *pw;
+	uint64_t acc = 0;
+	int odd = 0;
+
+	pb = nrc_chksum_head(pb, &len, &acc, &odd);
+	pw = (const uint32_t *)pb;
+
+	while (len >= 32) {
+		acc += pw[0];
+		acc += pw[1];
+		acc += pw[2];
+		acc += pw[3];
+		acc += pw[4];
+		acc += pw[5];
+		acc += pw[6];
+		acc += pw[7];
+		pw += 8;
+		len -= 32;
+	}
+	while (len >= 4) {
+		acc += *pw++;
+		len -= 4;
+	}
+
+	nrc_chksum_tail((const uint8_t *)pw, len, &acc);
+	return nrc_chksum_fold(acc, odd);
+}
+
+uint16_t nrc_lwip_chksum_copy(void *dst, const void *src, uint16_t len)
+{
+	const uint8_t *ps = (const uint8_t *)src;
+	uint8_t *pd = (uint8_t *)dst;
+	const uint32_t *ws;
+	uint32_t *wd;
+	uint64_t acc = 0;
+	int remain = len;
+	int odd = 0;
+	uint16_t head;
+
+	/* Source and destination can't be word aligned at the same time */
+	if (((uintptr_t)ps ^ (uintptr_t)pd) & 3) {
+		MEMCPY(dst, src, len);
+		return nrc_lwip_chksum(dst, len);
+	}
+
+	ps = nrc_chksum_head(ps, &remain, &acc, &odd);
+	head = len - remain;
+	MEMCPY(pd, src, head);
+	pd += head;
+
+	ws = (const uint32_t *)ps;
+	wd = (uint32_t *)pd;
+	while (remain >= 16) {
+		uint32_t w0 = ws[0], w1 = ws[1], w2 = ws[2], w3 = ws[3];
+
+		wd[0] = w0;
+		wd[1] = w1;
+		wd[2] = w2;
+		wd[3] = w3;
+		acc += w0;
+		acc += w1;
+		acc += w2;
+		acc += w3;
+		ws += 4;
+		wd += 4;
+		remain -= 16;
+	}
+	while (remain >= 4) {
+		uint32_t w = *ws++;
+
+		*wd++ = w;
+		acc += w;
+		remain -= 4;
+	}
+
+	MEMCPY(wd, ws, remain);
+	nrc_chksum_tail((const uint8_t *)ws, remain, &acc);
+	return nrc_chksum_fold(acc, odd);
+}
@@ -964,6 +964,22 @@ bool delete_wifi_bridge_interface(void)
 }
 #endif /* LWIP_BRIDGE */
 
+static void (*socket_event_cb)(int s, int evt);
+
+void nrc_lwip_set_socket_event_cb(void (*cb)(int s, int evt))
+{
+	socket_event_cb = cb;
+}
+
+/* LWIP_HOOK_SOCKETS_EVENT */
+void nrc_lwip_socket_event(int s, int evt)
+{
+	void (*cb)(int s, int evt) = socket_event_cb;
+
+	if (cb)
+		cb(s, evt);
+}
+
 u64_t rtc_offset = 0;
 
 void set_rtc_utc_offset(u32_t t, u32_t us)
@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "spi_flash_emulation.h"
+#include "hal_sflash.h"
+
+static SpiFlashEmulator *s_emulator = nullptr;
+
+SpiFlashEmulator::SpiFlashEmulator(uint32_t baseAddress, size_t size)
+    : mBaseAddress(baseAddress), mData(size, 0xff), mFailCountdown(-1), mFailed(false)
+{
+    clearStats();
+    s_emulator = this;
+}
+
+SpiFlashEmulator::~SpiFlashEmulator()
+{
+    s_emulator = nullptr;
+}
+
+bool SpiFlashEmulator::inRange(uint32_t address, size_t size) const
+{
+    return address >= mBaseAddress && address - mBaseAddress + size <= mData.size();
+}
+
+bool SpiFlashEmulator::powerCut()
+{
+    if (mFailCountdown < 0) {
+        return false;
+    }
+
+    if (mFailCountdown-- == 0) {
+        mFailed = true;
+    }
+
+    return mFailed;
+}
+
+bool SpiFlashEmulator::read(uint32_t address, uint8_t *buffer, size_t size)
+{
+    if (!inRange(address, size)) {
+        return false;
+    }
+
+    mStats.readOps++;
+    mStats.readBytes += size;
+
+    memcpy(buffer, &mData[address - mBaseAddress], size);
+    return true;
+}
+
+bool SpiFlashEmulator::write(uint32_t address, const uint8_t *buffer, size_t size)
+{
+    if (!inRange(address, size) || mFailed) {
+        return false;
+    }
+
+    bool torn = powerCut();
+
+    size_t len = torn ? (size / 2) & ~3 : size;
+    uint8_t *dst = &mData[address - mBaseAddress];
+
+    mStats.writeOps++;
+    mStats.writeBytes += len;
+
+    for (size_t i = 0; i < len; ++i) {
+        if ((dst[i] & buffer[i]) != buffer[i]) {
+            mStats.programErrors++;
+        }
+        dst[i] &= buffer[i];
+    }
+
+    return !torn;
+}
+
+bool SpiFlashEmulator::erase(uint32_t address, size_t size)
+{
+    if (!inRange(address, size) || (address - mBaseAddress) % SECTOR_SIZE || size % SECTOR_SIZE) {
+        return false;
+    }
+
+    if (mFailed) {
+        return false;
+    }
+
+    if (powerCut()) {
+        return false;
+    }
+
+    mStats.eraseOps++;
+    mStats.eraseSectors += size / SECTOR_SIZE;
+
+    memset(&mData[address - mBaseAddress], 0xff, size);
+    return true;
+}
+
+void SpiFlashEmulator::eraseAll()
+{
+    memset(mData.data(), 0xff, mData.size());
+}
+
+void SpiFlashEmulator::clearStats()
+{
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+/**********************************************************************************************/
+
+extern "C" bool nrc_sf_erase(uint32_t address, size_t size)
+{
+    return s_emulator && s_emulator->erase(address, size);
+}
+
+extern "C" uint32_t nrc_sf_read(uint32_t address, uint8_t *buffer, size_t size)
+{
+    return (s_emulator && s_emulator->read(address, buffer, size)) ? size : 0;
+}
+
+extern "C" uint32_t nrc_sf_write(uint32_t address, uint8_t *buffer, size_t size)
+{
+    return (s_emulator && s_emulator->write(address, buffer, size)) ? size : 0;
+}
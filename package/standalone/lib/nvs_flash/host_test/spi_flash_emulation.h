@@ -0,0 +1,106 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+ * NOR flash emulator behind nrc_sf_read(), nrc_sf_write() and nrc_sf_erase().
+ *
+ * Programming can only clear bits and erasing works on whole sectors, as on the real part.
+ * failAfter(n) cuts the power after n more write/erase calls: the next write programs only
+ * the first half of its data, the next erase leaves the sector as it was, and both fail
+ * like every later call until clearFailure() restores the power.
+ */
+class SpiFlashEmulator
+{
+public:
+    struct Stats {
+        size_t readOps;
+        size_t readBytes;
+        size_t writeOps;
+        size_t writeBytes;
+        size_t eraseOps;
+        size_t eraseSectors;
+        size_t programErrors;   /* writes that tried to set a cleared bit */
+    };
+
+    static const uint32_t SECTOR_SIZE = 4096;
+
+    SpiFlashEmulator(uint32_t baseAddress, size_t size);
+    ~SpiFlashEmulator();
+
+    bool read(uint32_t address, uint8_t *buffer, size_t size);
+    bool write(uint32_t address, const uint8_t *buffer, size_t size);
+    bool erase(uint32_t address, size_t size);
+
+    void eraseAll();
+
+    const Stats &stats() const
+    {
+        return mStats;
+    }
+
+    void clearStats();
+
+    void failAfter(int count)
+    {
+        mFailCountdown = count;
+    }
+
+    void clearFailure()
+    {
+        mFailCountdown = -1;
+        mFailed = false;
+    }
+
+    bool failed() const
+    {
+        return mFailed;
+    }
+
+    uint32_t baseAddress() const
+    {
+        return mBaseAddress;
+    }
+
+    size_t size() const
+    {
+        return mData.size();
+    }
+
+protected:
+    bool inRange(uint32_t address, size_t size) const;
+    bool powerCut();
+
+    uint32_t mBaseAddress;
+    std::vector<uint8_t> mData;
+    Stats mStats;
+    int mFailCountdown;
+    bool mFailed;
+};
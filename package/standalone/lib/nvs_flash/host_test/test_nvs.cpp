@@ -0,0 +1,1066 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "nvs_partition.hpp"
+#include "nvs_partition_manager.hpp"
+#include "nvs_storage.hpp"
+#include "spi_flash_emulation.h"
+
+/*
+ * Host test of the NVS library, Storage runs on the real NVSPartition over an emulated
+ * flash of the production size (lib/nvs_flash/include/nvs.h: MIN_PARTITION_SIZE).
+ *
+ *   commit    : flash traffic of nvs_set_*() and nvs_commit()
+ *   powerfail : cut the power at every flash write/erase of an update sequence and check
+ *               that each key reads back its old or new value after the next init
+ *   lookup    : key lookups per second with and without the item index (benchmark)
+ *   index     : item index overflow, and recovery once items were erased
+ *   cache     : flash reads of init and lookups against the read cache size (benchmark)
+ *   batch     : flash traffic and time of individual sets against one batch (benchmark)
+ *   batchfail : cut the power at every flash write/erase of a sequence of batches and check
+ *               that each batch is either fully applied or not at all after the next init
+ *   boot      : init time and flash reads of full and fast boot against the fill level (benchmark)
+ *
+ * powerfail and batchfail run with full and with fast boot.
+ */
+
+#define TEST_NVS_NAMESPACE		"test"
+#define TEST_NVS_SECTORS		(MIN_PARTITION_SIZE / SPI_FLASH_SEC_SIZE)
+#define TEST_NVS_ROUNDS			40
+#define TEST_NVS_FLASH_SIZE		(64 * SPI_FLASH_SEC_SIZE)
+
+static SpiFlashEmulator s_flash(SF_USER_CONFIG_1, TEST_NVS_FLASH_SIZE);
+static uint32_t s_cache_sectors = 0;
+static bool s_fast_boot = false;
+
+static nvs_err_t test_nvs_init(void)
+{
+    nvs_flash_set_fast_boot(s_fast_boot);
+    return nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, TEST_NVS_SECTORS, s_cache_sectors);
+}
+
+static void test_nvs_idle(void)
+{
+    bool pending = true;
+
+    while (pending && nvs_flash_idle(&pending) == NVS_OK) {
+    }
+}
+
+static void test_nvs_deinit(void)
+{
+    nvs_flash_deinit();
+}
+
+static void test_nvs_print_stats(const char *name, const SpiFlashEmulator::Stats &stats)
+{
+    printf("  %-20s : read %zu (%zu bytes), write %zu (%zu bytes), erase %zu (%zu sectors)\n",
+            name, stats.readOps, stats.readBytes, stats.writeOps, stats.writeBytes,
+            stats.eraseOps, stats.eraseSectors);
+}
+
+/**********************************************************************************************/
+
+static int test_nvs_commit(int argc, char *argv[])
+{
+    nvs_handle_t handle;
+    char key[16];
+    int ret = 0;
+
+    s_flash.eraseAll();
+
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READWRITE, &handle) != NVS_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    printf("NVS commit, %d sectors\n", TEST_NVS_SECTORS);
+
+    for (int i = 0; i < 16; ++i) {
+        snprintf(key, sizeof(key), "key%d", i);
+
+        s_flash.clearStats();
+        nvs_set_i32(handle, key, i);
+        if (i == 0) {
+            test_nvs_print_stats("nvs_set_i32", s_flash.stats());
+        }
+
+        s_flash.clearStats();
+        nvs_set_str(handle, "name", key);
+        if (i == 0) {
+            test_nvs_print_stats("nvs_set_str", s_flash.stats());
+        }
+
+        s_flash.clearStats();
+        if (nvs_commit(handle) != NVS_OK) {
+            printf("nvs_commit failed\n");
+            ret = 1;
+        }
+        if (i == 0) {
+            test_nvs_print_stats("nvs_commit", s_flash.stats());
+        }
+
+        if (s_flash.stats().writeOps || s_flash.stats().eraseOps) {
+            test_nvs_print_stats("nvs_commit", s_flash.stats());
+            ret = 1;
+        }
+    }
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    printf("%s\n", ret ? "FAIL" : "PASS");
+    return ret;
+}
+
+/**********************************************************************************************/
+
+enum TEST_NVS_OP
+{
+    TEST_NVS_SET_I32 = 0,
+    TEST_NVS_SET_STR,
+    TEST_NVS_SET_BLOB,
+    TEST_NVS_ERASE_KEY,
+};
+
+struct test_nvs_value
+{
+    bool present;
+    std::string data;
+};
+
+struct test_nvs_op
+{
+    int op;
+    const char *key;
+    test_nvs_value value;
+};
+
+static const char *s_test_nvs_keys[] = { "count", "name", "blob", "temp" };
+#define TEST_NVS_KEYS       (sizeof(s_test_nvs_keys) / sizeof(s_test_nvs_keys[0]))
+
+static std::vector<test_nvs_op> test_nvs_updates(void)
+{
+    std::vector<test_nvs_op> ops;
+
+    for (int round = 0; round < TEST_NVS_ROUNDS; ++round) {
+        int32_t count = round;
+        std::string name = "name-" + std::to_string(round);
+        std::string blob(1000 + (round % 4) * 1500, '\0');
+
+        for (size_t i = 0; i < blob.size(); ++i) {
+            blob[i] = (char) (round * 31 + i);
+        }
+
+        ops.push_back({ TEST_NVS_SET_I32, "count", { true, std::string((char *) &count, sizeof(count)) } });
+        ops.push_back({ TEST_NVS_SET_STR, "name", { true, name } });
+        ops.push_back({ TEST_NVS_SET_BLOB, "blob", { true, blob } });
+
+        if (round % 2 == 0) {
+            ops.push_back({ TEST_NVS_SET_I32, "temp", { true, std::string((char *) &count, sizeof(count)) } });
+        } else {
+            ops.push_back({ TEST_NVS_ERASE_KEY, "temp", { false, "" } });
+        }
+    }
+
+    return ops;
+}
+
+static nvs_err_t test_nvs_apply(nvs_handle_t handle, const test_nvs_op &op)
+{
+    switch (op.op) {
+    case TEST_NVS_SET_I32:
+        return nvs_set_i32(handle, op.key, *(const int32_t *) op.value.data.data());
+
+    case TEST_NVS_SET_STR:
+        return nvs_set_str(handle, op.key, op.value.data.c_str());
+
+    case TEST_NVS_SET_BLOB:
+        return nvs_set_blob(handle, op.key, op.value.data.data(), op.value.data.size());
+
+    case TEST_NVS_ERASE_KEY:
+        return nvs_erase_key(handle, op.key);
+    }
+
+    return NVS_FAIL;
+}
+
+static bool test_nvs_read(nvs_handle_t handle, const char *key, test_nvs_value &value)
+{
+    int32_t i32;
+    size_t len = 0;
+    nvs_err_t err;
+
+    value.present = false;
+    value.data.clear();
+
+    if (strcmp(key, "count") == 0 || strcmp(key, "temp") == 0) {
+        err = nvs_get_i32(handle, key, &i32);
+        if (err == NVS_OK) {
+            value.data.assign((char *) &i32, sizeof(i32));
+        }
+    } else if (strcmp(key, "name") == 0) {
+        err = nvs_get_str(handle, key, NULL, &len);
+        if (err == NVS_OK) {
+            value.data.resize(len);
+            err = nvs_get_str(handle, key, &value.data[0], &len);
+            value.data.resize(len - 1);
+        }
+    } else {
+        err = nvs_get_blob(handle, key, NULL, &len);
+        if (err == NVS_OK) {
+            value.data.resize(len);
+            err = nvs_get_blob(handle, key, &value.data[0], &len);
+        }
+    }
+
+    if (err == NVS_OK) {
+        value.present = true;
+    } else if (err != NVS_ERR_NVS_NOT_FOUND) {
+        return false;
+    }
+
+    return true;
+}
+
+static bool test_nvs_equal(const test_nvs_value &a, const test_nvs_value &b)
+{
+    return a.present == b.present && a.data == b.data;
+}
+
+/*
+ * Returns 1 if the power was cut during the updates, 0 if they all completed and -1 on error.
+ */
+static int test_nvs_powerfail_run(const std::vector<test_nvs_op> &ops, int fail_at, size_t *done)
+{
+    test_nvs_value expected[TEST_NVS_KEYS];
+    const test_nvs_op *pending = nullptr;
+    nvs_handle_t handle;
+    bool cut;
+
+    s_flash.eraseAll();
+    s_flash.clearFailure();
+
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READWRITE, &handle) != NVS_OK) {
+        printf("[%d] init failed\n", fail_at);
+        return -1;
+    }
+
+    for (size_t i = 0; i < TEST_NVS_KEYS; ++i) {
+        expected[i].present = false;
+    }
+
+    s_flash.failAfter(fail_at);
+
+    for (*done = 0; *done < ops.size(); ++*done) {
+        const test_nvs_op &op = ops[*done];
+
+        if (test_nvs_apply(handle, op) != NVS_OK || nvs_commit(handle) != NVS_OK) {
+            pending = &op;
+            break;
+        }
+
+        for (size_t i = 0; i < TEST_NVS_KEYS; ++i) {
+            if (strcmp(s_test_nvs_keys[i], op.key) == 0) {
+                expected[i] = op.value;
+            }
+        }
+    }
+
+    cut = s_flash.failed();
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    /* power on */
+    s_flash.clearFailure();
+
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READWRITE, &handle) != NVS_OK) {
+        printf("[%d] init after power cut failed\n", fail_at);
+        return -1;
+    }
+
+    /* with fast boot, half of the checks run before the deferred work is done */
+    if (s_fast_boot && fail_at % 2) {
+        test_nvs_idle();
+    }
+
+    int ret = cut ? 1 : 0;
+
+    if (!cut && pending) {
+        printf("[%d] update %zu failed without a power cut\n", fail_at, *done);
+        ret = -1;
+    }
+
+    for (size_t i = 0; i < TEST_NVS_KEYS && ret >= 0; ++i) {
+        const char *key = s_test_nvs_keys[i];
+        test_nvs_value value;
+
+        if (!test_nvs_read(handle, key, value)) {
+            printf("[%d] %s: read failed\n", fail_at, key);
+            ret = -1;
+        } else if (test_nvs_equal(value, expected[i])) {
+            continue;
+        } else if (pending && strcmp(pending->key, key) == 0 && test_nvs_equal(value, pending->value)) {
+            continue;
+        } else {
+            printf("[%d] %s: neither the old nor the new value after update %zu\n", fail_at, key, *done);
+            ret = -1;
+        }
+    }
+
+    /* the storage has to take new writes after the recovery */
+    if (ret >= 0) {
+        int32_t check = 0;
+
+        if (nvs_set_i32(handle, "check", fail_at) != NVS_OK ||
+                nvs_get_i32(handle, "check", &check) != NVS_OK || check != fail_at) {
+            printf("[%d] write after recovery failed\n", fail_at);
+            ret = -1;
+        }
+    }
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    return ret;
+}
+
+static int test_nvs_powerfail(int argc, char *argv[])
+{
+    std::vector<test_nvs_op> ops = test_nvs_updates();
+    size_t done;
+    int errors = 0;
+    int fail_at;
+    int ret;
+
+    s_cache_sectors = (argc > 1) ? atoi(argv[1]) : 0;
+
+    printf("NVS power fail, %d sectors, %u cache sectors, %zu updates\n", TEST_NVS_SECTORS, s_cache_sectors, ops.size());
+
+    for (int fast = 0; fast < 2; ++fast) {
+        s_fast_boot = fast;
+
+        for (fail_at = 0 ; ; ++fail_at) {
+            ret = test_nvs_powerfail_run(ops, fail_at, &done);
+            if (ret < 0) {
+                errors++;
+            } else if (ret == 0) {
+                break;
+            }
+        }
+
+        printf("  %s: power cut at %d flash writes/erases, %d errors\n", fast ? "fast boot" : "full boot", fail_at, errors);
+    }
+    printf("%s\n", errors ? "FAIL" : "PASS");
+
+    s_cache_sectors = 0;
+    s_fast_boot = false;
+
+    return errors ? 1 : 0;
+}
+
+/**********************************************************************************************/
+
+static double test_nvs_elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#define TEST_NVS_LOOKUP_SECTORS		32
+#define TEST_NVS_LOOKUP_NAMESPACES	8
+
+static int test_nvs_lookup_run(size_t keys, size_t indexSize)
+{
+    nvs::NVSPartition partition(SF_USER_CONFIG_1, TEST_NVS_LOOKUP_SECTORS * SPI_FLASH_SEC_SIZE);
+    nvs::Storage storage(&partition);
+    uint8_t ns[TEST_NVS_LOOKUP_NAMESPACES];
+    char name[16];
+    size_t lookups = 0;
+    int32_t value;
+
+    s_flash.eraseAll();
+
+    if (storage.init(0, TEST_NVS_LOOKUP_SECTORS, indexSize) != NVS_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < TEST_NVS_LOOKUP_NAMESPACES; ++i) {
+        snprintf(name, sizeof(name), "ns%zu", i);
+        if (storage.createOrOpenNamespace(name, true, ns[i]) != NVS_OK) {
+            printf("namespace failed\n");
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < keys; ++i) {
+        snprintf(name, sizeof(name), "key%zu", i);
+        if (storage.writeItem(ns[i % TEST_NVS_LOOKUP_NAMESPACES], name, (int32_t) i) != NVS_OK) {
+            printf("write failed\n");
+            return 1;
+        }
+    }
+
+    /* hits */
+    s_flash.clearStats();
+    auto start = std::chrono::steady_clock::now();
+    do {
+        for (size_t i = 0; i < keys; ++i, ++lookups) {
+            snprintf(name, sizeof(name), "key%zu", i);
+            if (storage.readItem(ns[i % TEST_NVS_LOOKUP_NAMESPACES], name, value) != NVS_OK || value != (int32_t) i) {
+                printf("read failed\n");
+                return 1;
+            }
+        }
+    } while (test_nvs_elapsed(start) < 0.2);
+    double hitRate = lookups / test_nvs_elapsed(start);
+    double hitReads = (double) s_flash.stats().readOps / lookups;
+
+    /* misses */
+    lookups = 0;
+    s_flash.clearStats();
+    start = std::chrono::steady_clock::now();
+    do {
+        for (size_t i = 0; i < keys; ++i, ++lookups) {
+            snprintf(name, sizeof(name), "none%zu", i);
+            if (storage.readItem(ns[i % TEST_NVS_LOOKUP_NAMESPACES], name, value) != NVS_ERR_NVS_NOT_FOUND) {
+                printf("miss failed\n");
+                return 1;
+            }
+        }
+    } while (test_nvs_elapsed(start) < 0.2);
+    double missRate = lookups / test_nvs_elapsed(start);
+    double missReads = (double) s_flash.stats().readOps / lookups;
+
+    const nvs::ItemIndex& index = storage.getItemIndex();
+
+    printf("  %5zu %6zu %6zu %7zu  %9.0f %6.2f  %9.0f %6.2f\n",
+            keys, index.size(), index.used(), index.memorySize(), hitRate, hitReads, missRate, missReads);
+
+    return 0;
+}
+
+static int test_nvs_lookup(int argc, char *argv[])
+{
+    const size_t keys[] = { 50, 100, 200, 400, 800 };
+    const size_t indexSize[] = { 0, nvs::ItemIndex::DEFAULT_SIZE, 1024 };
+    int ret = 0;
+
+    printf("NVS lookup, %d sectors, %d namespaces\n", TEST_NVS_LOOKUP_SECTORS, TEST_NVS_LOOKUP_NAMESPACES);
+    printf("   keys  index   used  memory   hit/s  reads   miss/s  reads\n");
+
+    for (size_t i = 0; i < sizeof(indexSize) / sizeof(indexSize[0]); ++i) {
+        for (size_t j = 0; j < sizeof(keys) / sizeof(keys[0]); ++j) {
+            ret |= test_nvs_lookup_run(keys[j], indexSize[i]);
+        }
+    }
+
+    return ret;
+}
+
+/**********************************************************************************************/
+
+#define TEST_NVS_INDEX_SECTORS		4
+#define TEST_NVS_INDEX_SIZE			64
+#define TEST_NVS_INDEX_KEYS			100
+#define TEST_NVS_INDEX_ROUNDS		8
+
+static int test_nvs_index_check(nvs::Storage &storage, uint8_t ns, size_t erased, int32_t round)
+{
+    char name[16];
+    int32_t value;
+
+    for (size_t i = 0; i < TEST_NVS_INDEX_KEYS; ++i) {
+        snprintf(name, sizeof(name), "key%zu", i);
+        nvs_err_t err = storage.readItem(ns, name, value);
+        if (i < erased ? err != NVS_ERR_NVS_NOT_FOUND : (err != NVS_OK || value != (int32_t) i + round)) {
+            printf("key%zu: err=%d value=%d\n", i, err, value);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Overflow the item index, with garbage collection copying items while it is full, then erase
+ * keys until all items fit again and check that the index is complete after the next lookup.
+ */
+static int test_nvs_index(int argc, char *argv[])
+{
+    nvs::NVSPartition partition(SF_USER_CONFIG_1, TEST_NVS_INDEX_SECTORS * SPI_FLASH_SEC_SIZE);
+    nvs::Storage storage(&partition);
+    const nvs::ItemIndex& index = storage.getItemIndex();
+    const size_t items = TEST_NVS_INDEX_KEYS + 1; /* and the namespace entry */
+    size_t erased = 0;
+    uint8_t ns;
+    char name[16];
+    int32_t round;
+    int32_t value;
+    int ret = 0;
+
+    s_flash.eraseAll();
+
+    if (storage.init(0, TEST_NVS_INDEX_SECTORS, TEST_NVS_INDEX_SIZE) != NVS_OK ||
+            storage.createOrOpenNamespace("index", true, ns) != NVS_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    for (round = 0; round < TEST_NVS_INDEX_ROUNDS; ++round) {
+        for (size_t i = 0; i < TEST_NVS_INDEX_KEYS; ++i) {
+            snprintf(name, sizeof(name), "key%zu", i);
+            if (storage.writeItem(ns, name, (int32_t) i + round) != NVS_OK) {
+                printf("write failed\n");
+                return 1;
+            }
+        }
+    }
+    --round;
+
+    printf("NVS index, %d sectors, %d nodes, %d keys\n",
+            TEST_NVS_INDEX_SECTORS, TEST_NVS_INDEX_SIZE, TEST_NVS_INDEX_KEYS);
+    printf("  full    : used %zu dropped %zu complete %d\n", index.used(), index.dropped(), index.isComplete());
+    if (index.isComplete() || index.used() + index.dropped() != items) {
+        ret = 1;
+    }
+    ret |= test_nvs_index_check(storage, ns, erased, round);
+
+    for (; erased < TEST_NVS_INDEX_KEYS / 2; ++erased) {
+        snprintf(name, sizeof(name), "key%zu", erased);
+        if (storage.eraseItem(ns, name) != NVS_OK) {
+            printf("erase failed\n");
+            return 1;
+        }
+    }
+
+    /* a miss refreshes the index */
+    storage.readItem(ns, "none", value);
+
+    s_flash.clearStats();
+    if (storage.readItem(ns, "none", value) != NVS_ERR_NVS_NOT_FOUND) {
+        ret = 1;
+    }
+    printf("  erased  : used %zu dropped %zu complete %d, miss reads %u\n",
+            index.used(), index.dropped(), index.isComplete(), (unsigned) s_flash.stats().readOps);
+    if (!index.isComplete() || index.used() != items - erased || s_flash.stats().readOps != 0) {
+        ret = 1;
+    }
+    ret |= test_nvs_index_check(storage, ns, erased, round);
+
+    printf("%s\n", ret ? "FAIL" : "PASS");
+
+    return ret;
+}
+
+/**********************************************************************************************/
+
+#define TEST_NVS_CACHE_KEYS		120
+
+static int test_nvs_cache_run(uint32_t cacheSectors)
+{
+    nvs_handle_t handle;
+    nvs_stats_t stats;
+    char key[16];
+    int32_t value;
+
+    s_flash.eraseAll();
+    s_cache_sectors = cacheSectors;
+
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READWRITE, &handle) != NVS_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    for (int i = 0; i < TEST_NVS_CACHE_KEYS; ++i) {
+        snprintf(key, sizeof(key), "key%d", i);
+        nvs_set_i32(handle, key, i);
+        if (i % 8 == 0) {
+            nvs_set_str(handle, key, "string value of some length");
+        }
+    }
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    s_flash.clearStats();
+    auto start = std::chrono::steady_clock::now();
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READONLY, &handle) != NVS_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+    double initTime = test_nvs_elapsed(start);
+    SpiFlashEmulator::Stats initStats = s_flash.stats();
+
+    s_flash.clearStats();
+    for (int i = 0; i < TEST_NVS_CACHE_KEYS; ++i) {
+        snprintf(key, sizeof(key), "key%d", i);
+        nvs_get_i32(handle, key, &value);
+        snprintf(key, sizeof(key), "none%d", i);
+        nvs_get_i32(handle, key, &value);
+    }
+    SpiFlashEmulator::Stats getStats = s_flash.stats();
+
+    nvs_get_stats(NULL, &stats);
+
+    printf("  %5u %7zu %8zu %8.0f %7zu %8zu %7zu %7zu\n", cacheSectors,
+            initStats.readOps, initStats.readBytes, initTime * 1e6,
+            getStats.readOps, getStats.readBytes, stats.cache_hits, stats.cache_misses);
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    s_cache_sectors = 0;
+    return 0;
+}
+
+static int test_nvs_cache(int argc, char *argv[])
+{
+    const uint32_t cacheSectors[] = { 0, 1, 2, 4 };
+    int ret = 0;
+
+    printf("NVS read cache, %d sectors, %d keys, %d lookups\n", TEST_NVS_SECTORS, TEST_NVS_CACHE_KEYS, TEST_NVS_CACHE_KEYS * 2);
+    printf("  cache  init reads    bytes   us      get reads    bytes    hits  misses\n");
+
+    for (size_t i = 0; i < sizeof(cacheSectors) / sizeof(cacheSectors[0]); ++i) {
+        ret |= test_nvs_cache_run(cacheSectors[i]);
+    }
+
+    return ret;
+}
+
+/**********************************************************************************************/
+
+#define TEST_NVS_BATCH_KEYS		50
+
+static int test_nvs_batch_run(const char *name, bool update, bool batched)
+{
+    nvs_handle_t handle;
+    nvs_batch_t batch;
+    char key[16];
+    int32_t value;
+    nvs_err_t err = NVS_OK;
+
+    s_flash.eraseAll();
+
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READWRITE, &handle) != NVS_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    if (update) {
+        for (int i = 0; i < TEST_NVS_BATCH_KEYS; ++i) {
+            snprintf(key, sizeof(key), "key%d", i);
+            nvs_set_i32(handle, key, -1);
+        }
+    }
+
+    s_flash.clearStats();
+    auto start = std::chrono::steady_clock::now();
+
+    if (batched) {
+        err = nvs_batch_begin(handle, &batch);
+        for (int i = 0; i < TEST_NVS_BATCH_KEYS && err == NVS_OK; ++i) {
+            snprintf(key, sizeof(key), "key%d", i);
+            err = nvs_batch_set_i32(batch, key, i);
+        }
+        if (err == NVS_OK) {
+            err = nvs_batch_commit(batch);
+        }
+    } else {
+        for (int i = 0; i < TEST_NVS_BATCH_KEYS && err == NVS_OK; ++i) {
+            snprintf(key, sizeof(key), "key%d", i);
+            err = nvs_set_i32(handle, key, i);
+        }
+    }
+
+    double elapsed = test_nvs_elapsed(start);
+    SpiFlashEmulator::Stats stats = s_flash.stats();
+
+    for (int i = 0; i < TEST_NVS_BATCH_KEYS && err == NVS_OK; ++i) {
+        snprintf(key, sizeof(key), "key%d", i);
+        err = nvs_get_i32(handle, key, &value);
+        if (err == NVS_OK && value != i) {
+            err = NVS_FAIL;
+        }
+    }
+
+    test_nvs_print_stats(name, stats);
+    printf("  %-20s   %.0f us\n", "", elapsed * 1e6);
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    if (err != NVS_OK) {
+        printf("%s: failed (0x%x)\n", name, err);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_nvs_batch(int argc, char *argv[])
+{
+    int ret = 0;
+
+    printf("NVS batch, %d sectors, %d keys\n", TEST_NVS_SECTORS, TEST_NVS_BATCH_KEYS);
+
+    ret |= test_nvs_batch_run("new, nvs_set_i32", false, false);
+    ret |= test_nvs_batch_run("new, nvs_batch", false, true);
+    ret |= test_nvs_batch_run("update, nvs_set_i32", true, false);
+    ret |= test_nvs_batch_run("update, nvs_batch", true, true);
+
+    printf("%s\n", ret ? "FAIL" : "PASS");
+
+    return ret;
+}
+
+#define TEST_NVS_BATCHFAIL_KEYS		20
+#define TEST_NVS_BATCHFAIL_FILL		100
+#define TEST_NVS_BATCHFAIL_ROUNDS	12
+
+struct test_nvs_batch_state
+{
+    int32_t keys[TEST_NVS_BATCHFAIL_KEYS];
+    std::string str;
+    bool erased;
+};
+
+/* state after the given round, -1 is the state before the first batch */
+static test_nvs_batch_state test_nvs_batch_state_of(int round)
+{
+    test_nvs_batch_state state;
+
+    for (int i = 0; i < TEST_NVS_BATCHFAIL_KEYS; ++i) {
+        state.keys[i] = (round + 1) * 100 + i;
+    }
+    state.str = "round-" + std::to_string(round) + std::string(((round + 3) % 3) * 40, 'x');
+    state.erased = ((round + 2) % 2 == 0);
+
+    return state;
+}
+
+static nvs_err_t test_nvs_batch_write(nvs_handle_t handle, const test_nvs_batch_state &state)
+{
+    nvs_batch_t batch;
+    char key[16];
+
+    nvs_err_t err = nvs_batch_begin(handle, &batch);
+    if (err != NVS_OK) {
+        return err;
+    }
+
+    for (int i = 0; i < TEST_NVS_BATCHFAIL_KEYS && err == NVS_OK; ++i) {
+        snprintf(key, sizeof(key), "k%d", i);
+        err = nvs_batch_set_i32(batch, key, state.keys[i]);
+    }
+    if (err == NVS_OK) {
+        err = nvs_batch_set_str(batch, "str", state.str.c_str());
+    }
+    if (err == NVS_OK) {
+        err = state.erased ? nvs_batch_erase_key(batch, "opt") : nvs_batch_set_i32(batch, "opt", 1);
+    }
+
+    if (err != NVS_OK) {
+        nvs_batch_abort(batch);
+        return err;
+    }
+    return nvs_batch_commit(batch);
+}
+
+static bool test_nvs_batch_check(nvs_handle_t handle, const test_nvs_batch_state &state)
+{
+    char key[16];
+    char str[128];
+    size_t len = sizeof(str);
+    int32_t value;
+
+    for (int i = 0; i < TEST_NVS_BATCHFAIL_KEYS; ++i) {
+        snprintf(key, sizeof(key), "k%d", i);
+        if (nvs_get_i32(handle, key, &value) != NVS_OK || value != state.keys[i]) {
+            return false;
+        }
+    }
+
+    if (nvs_get_str(handle, "str", str, &len) != NVS_OK || state.str != str) {
+        return false;
+    }
+
+    nvs_err_t err = nvs_get_i32(handle, "opt", &value);
+    return state.erased ? (err == NVS_ERR_NVS_NOT_FOUND) : (err == NVS_OK && value == 1);
+}
+
+/*
+ * Returns 1 if the power was cut during the batches, 0 if they all completed and -1 on error.
+ */
+static int test_nvs_batchfail_run(int fail_at)
+{
+    nvs_handle_t handle;
+    char key[16];
+    int round;
+
+    s_flash.eraseAll();
+    s_flash.clearFailure();
+
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READWRITE, &handle) != NVS_OK) {
+        printf("[%d] init failed\n", fail_at);
+        return -1;
+    }
+
+    /* fill most of the first page, so the batches cross page boundaries and later free pages */
+    for (int i = 0; i < TEST_NVS_BATCHFAIL_FILL; ++i) {
+        snprintf(key, sizeof(key), "fill%d", i);
+        nvs_set_i32(handle, key, i);
+    }
+    if (test_nvs_batch_write(handle, test_nvs_batch_state_of(-1)) != NVS_OK) {
+        printf("[%d] first batch failed\n", fail_at);
+        return -1;
+    }
+
+    s_flash.failAfter(fail_at);
+
+    for (round = 0; round < TEST_NVS_BATCHFAIL_ROUNDS; ++round) {
+        if (test_nvs_batch_write(handle, test_nvs_batch_state_of(round)) != NVS_OK) {
+            break;
+        }
+    }
+
+    bool cut = s_flash.failed();
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    /* power on */
+    s_flash.clearFailure();
+
+    if (test_nvs_init() != NVS_OK || nvs_open(TEST_NVS_NAMESPACE, NVS_READWRITE, &handle) != NVS_OK) {
+        printf("[%d] init after power cut failed\n", fail_at);
+        return -1;
+    }
+
+    /* with fast boot, half of the checks run before the deferred work is done */
+    if (s_fast_boot && fail_at % 2) {
+        test_nvs_idle();
+    }
+
+    int ret = cut ? 1 : 0;
+
+    if (!cut && round < TEST_NVS_BATCHFAIL_ROUNDS) {
+        printf("[%d] batch %d failed without a power cut\n", fail_at, round);
+        ret = -1;
+    } else if (!test_nvs_batch_check(handle, test_nvs_batch_state_of(round - 1)) &&
+            (round == TEST_NVS_BATCHFAIL_ROUNDS || !test_nvs_batch_check(handle, test_nvs_batch_state_of(round)))) {
+        printf("[%d] batch %d partially applied\n", fail_at, round);
+        ret = -1;
+    }
+
+    /* the storage has to take new batches after the recovery */
+    if (ret >= 0 && (test_nvs_batch_write(handle, test_nvs_batch_state_of(100)) != NVS_OK ||
+                !test_nvs_batch_check(handle, test_nvs_batch_state_of(100)))) {
+        printf("[%d] batch after recovery failed\n", fail_at);
+        ret = -1;
+    }
+
+    nvs_close(handle);
+    test_nvs_deinit();
+
+    return ret;
+}
+
+static int test_nvs_batchfail(int argc, char *argv[])
+{
+    int errors = 0;
+    int fail_at;
+    int ret;
+
+    printf("NVS batch power fail, %d sectors, %d batches of %d keys\n", TEST_NVS_SECTORS,
+            TEST_NVS_BATCHFAIL_ROUNDS, TEST_NVS_BATCHFAIL_KEYS + 2);
+
+    for (int fast = 0; fast < 2; ++fast) {
+        s_fast_boot = fast;
+
+        for (fail_at = 0 ; ; ++fail_at) {
+            ret = test_nvs_batchfail_run(fail_at);
+            if (ret < 0) {
+                errors++;
+            } else if (ret == 0) {
+                break;
+            }
+        }
+
+        printf("  %s: power cut at %d flash writes/erases, %d errors\n", fast ? "fast boot" : "full boot", fail_at, errors);
+    }
+    printf("%s\n", errors ? "FAIL" : "PASS");
+
+    s_fast_boot = false;
+
+    return errors ? 1 : 0;
+}
+
+/**********************************************************************************************/
+
+#define TEST_NVS_BOOT_SECTORS		32
+
+static int test_nvs_boot_run(size_t fill)
+{
+    nvs::NVSPartition partition(SF_USER_CONFIG_1, TEST_NVS_BOOT_SECTORS * SPI_FLASH_SEC_SIZE);
+    const size_t target = (TEST_NVS_BOOT_SECTORS - 1) * nvs::Page::ENTRY_COUNT * fill / 100;
+    nvs_stats_t stats = {};
+    char key[16];
+    uint8_t ns;
+    size_t keys = 0;
+    int32_t value;
+
+    s_flash.eraseAll();
+
+    {
+        nvs::Storage storage(&partition);
+
+        if (storage.init(0, TEST_NVS_BOOT_SECTORS) != NVS_OK ||
+                storage.createOrOpenNamespace(TEST_NVS_NAMESPACE, true, ns) != NVS_OK) {
+            printf("init failed\n");
+            return 1;
+        }
+
+        while (storage.fillStats(stats) == NVS_OK && stats.used_entries < target) {
+            snprintf(key, sizeof(key), "key%zu", keys);
+            if (storage.writeItem(ns, key, (int32_t) keys) != NVS_OK) {
+                printf("write failed\n");
+                return 1;
+            }
+            keys++;
+        }
+    }
+
+    for (int fast = 0; fast < 2; ++fast) {
+        nvs::Storage storage(&partition);
+        bool pending = true;
+        int ret = 0;
+
+        s_flash.clearStats();
+        auto start = std::chrono::steady_clock::now();
+        if (storage.init(0, TEST_NVS_BOOT_SECTORS, nvs::ItemIndex::DEFAULT_SIZE, fast) != NVS_OK) {
+            printf("init failed\n");
+            return 1;
+        }
+        double initTime = test_nvs_elapsed(start);
+        SpiFlashEmulator::Stats initStats = s_flash.stats();
+
+        /* open and read a key from the middle of the partition */
+        s_flash.clearStats();
+        start = std::chrono::steady_clock::now();
+        snprintf(key, sizeof(key), "key%zu", keys / 2);
+        if (storage.createOrOpenNamespace(TEST_NVS_NAMESPACE, false, ns) != NVS_OK ||
+                (keys && storage.readItem(ns, key, value) != NVS_OK)) {
+            ret = 1;
+        }
+        double getTime = test_nvs_elapsed(start);
+        SpiFlashEmulator::Stats getStats = s_flash.stats();
+
+        s_flash.clearStats();
+        while (pending && storage.idle(pending) == NVS_OK) {
+        }
+        SpiFlashEmulator::Stats idleStats = s_flash.stats();
+
+        for (size_t i = 0; i < keys && !ret; ++i) {
+            snprintf(key, sizeof(key), "key%zu", i);
+            if (storage.readItem(ns, key, value) != NVS_OK || value != (int32_t) i) {
+                ret = 1;
+            }
+        }
+
+        printf("  %3zu%% %5zu  %s %7zu %8zu %7.0f %7zu %7.0f %7zu\n", fill, keys, fast ? "fast" : "full",
+                initStats.readOps, initStats.readBytes, initTime * 1e6,
+                getStats.readOps, getTime * 1e6, idleStats.readOps);
+
+        if (ret) {
+            printf("  %s boot: wrong value\n", fast ? "fast" : "full");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_nvs_boot(int argc, char *argv[])
+{
+    const size_t fill[] = { 0, 25, 50, 75, 90 };
+    int ret = 0;
+
+    printf("NVS boot, %d sectors\n", TEST_NVS_BOOT_SECTORS);
+    printf("  fill  keys  boot  reads    bytes      us   get reads    us   idle reads\n");
+
+    for (size_t i = 0; i < sizeof(fill) / sizeof(fill[0]); ++i) {
+        ret |= test_nvs_boot_run(fill[i]);
+    }
+
+    printf("%s\n", ret ? "FAIL" : "PASS");
+
+    return ret;
+}
+
+/**********************************************************************************************/
+
+static const struct
+{
+    const char *name;
+    int (*func) (int argc, char *argv[]);
+} s_test_nvs_cmds[] =
+{
+    { "commit", test_nvs_commit },
+    { "powerfail", test_nvs_powerfail },
+    { "lookup", test_nvs_lookup },
+    { "index", test_nvs_index },
+    { "cache", test_nvs_cache },
+    { "batch", test_nvs_batch },
+    { "batchfail", test_nvs_batchfail },
+    { "boot", test_nvs_boot },
+};
+
+#define TEST_NVS_CMDS       (sizeof(s_test_nvs_cmds) / sizeof(s_test_nvs_cmds[0]))
+
+int main(int argc, char *argv[])
+{
+    int ret = 0;
+
+    for (size_t i = 0; i < TEST_NVS_CMDS; ++i) {
+        if (argc > 1 && strcmp(argv[1], s_test_nvs_cmds[i].name) != 0) {
+            continue;
+        }
+
+        ret |= s_test_nvs_cmds[i].func(argc - 1, argv + 1);
+    }
+
+    return ret;
+}
@@ -143,6 +143,11 @@ typedef struct {
  */
 typedef struct nvs_opaque_iterator_t *nvs_iterator_t;
 
+/**
+ * Opaque pointer type representing a batch of changes to the entries of a namespace
+ */
+typedef struct nvs_opaque_batch_t *nvs_batch_t;
+
 /**
  * @brief      Open non-volatile storage with a given namespace from the default NVS partition
  *
@@ -549,6 +554,153 @@ nvs_err_t nvs_commit(nvs_handle_t handle);
  */
 void nvs_close(nvs_handle_t handle);
 
+/**
+ * @brief      Start a batch of changes to the namespace of a handle
+ *
+ * The sets and erases made through a batch are only staged in RAM. nvs_batch_commit()
+ * writes all of them with one lock acquisition, appending the new entries one after
+ * another, and erases the entries they replace afterwards. Either all changes of the
+ * batch are applied or none, also if power is lost while the batch is committed.
+ *
+ * Only integer types and strings can be set in a batch.
+ *
+ * @param[in]  handle     Handle obtained from nvs_open function.
+ *                        Handles that were opened read only cannot be used.
+ * @param[out] out_batch  If successful (return code is zero), the batch will be
+ *                        returned in this argument.
+ *
+ * @return
+ *             - NVS_OK if the batch was created
+ *             - NVS_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - NVS_ERR_NVS_READ_ONLY if storage handle was opened as read only
+ *             - NVS_ERR_NO_MEM if memory could not be allocated for the batch
+ */
+nvs_err_t nvs_batch_begin(nvs_handle_t handle, nvs_batch_t *out_batch);
+
+/**@{*/
+/**
+ * @brief      stage int8_t value for given key in a batch
+ *
+ * A value staged earlier in the batch for the same key and type is replaced.
+ *
+ * @param[in]  batch   Batch obtained from nvs_batch_begin function.
+ * @param[in]  key     Key name. Maximal length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ * @param[in]  value   The value to set.
+ *
+ * @return
+ *             - NVS_OK if the value was staged
+ *             - NVS_ERR_INVALID_ARG if batch is NULL
+ *             - NVS_ERR_NVS_KEY_TOO_LONG if key name is too long
+ *             - NVS_ERR_NO_MEM if memory could not be allocated for the value
+ */
+nvs_err_t nvs_batch_set_i8 (nvs_batch_t batch, const char* key, int8_t value);
+
+/**
+ * @brief      stage uint8_t value for given key in a batch
+ *
+ * This function is the same as \c nvs_batch_set_i8 except for the data type.
+ */
+nvs_err_t nvs_batch_set_u8 (nvs_batch_t batch, const char* key, uint8_t value);
+
+/**
+ * @brief      stage int16_t value for given key in a batch
+ *
+ * This function is the same as \c nvs_batch_set_i8 except for the data type.
+ */
+nvs_err_t nvs_batch_set_i16 (nvs_batch_t batch, const char* key, int16_t value);
+
+/**
+ * @brief      stage uint16_t value for given key in a batch
+ *
+ * This function is the same as \c nvs_batch_set_i8 except for the data type.
+ */
+nvs_err_t nvs_batch_set_u16 (nvs_batch_t batch, const char* key, uint16_t value);
+
+/**
+ * @brief      stage int32_t value for given key in a batch
+ *
+ * This function is the same as \c nvs_batch_set_i8 except for the data type.
+ */
+nvs_err_t nvs_batch_set_i32 (nvs_batch_t batch, const char* key, int32_t value);
+
+/**
+ * @brief      stage uint32_t value for given key in a batch
+ *
+ * This function is the same as \c nvs_batch_set_i8 except for the data type.
+ */
+nvs_err_t nvs_batch_set_u32 (nvs_batch_t batch, const char* key, uint32_t value);
+
+/**
+ * @brief      stage int64_t value for given key in a batch
+ *
+ * This function is the same as \c nvs_batch_set_i8 except for the data type.
+ */
+nvs_err_t nvs_batch_set_i64 (nvs_batch_t batch, const char* key, int64_t value);
+
+/**
+ * @brief      stage uint64_t value for given key in a batch
+ *
+ * This function is the same as \c nvs_batch_set_i8 except for the data type.
+ */
+nvs_err_t nvs_batch_set_u64 (nvs_batch_t batch, const char* key, uint64_t value);
+
+/**
+ * @brief      stage a string for given key in a batch
+ *
+ * @return
+ *             - NVS_OK if the string was staged
+ *             - NVS_ERR_INVALID_ARG if batch is NULL
+ *             - NVS_ERR_NVS_KEY_TOO_LONG if key name is too long
+ *             - NVS_ERR_NVS_VALUE_TOO_LONG if the string does not fit into a page
+ *             - NVS_ERR_NO_MEM if memory could not be allocated for the string
+ */
+nvs_err_t nvs_batch_set_str (nvs_batch_t batch, const char* key, const char* value);
+/**@}*/
+
+/**
+ * @brief      stage the erasure of all entries with given key in a batch
+ *
+ * Values staged earlier in the batch for the key are dropped. Erasing a key
+ * which does not exist is not an error.
+ *
+ * @param[in]  batch   Batch obtained from nvs_batch_begin function.
+ * @param[in]  key     Key name. Maximal length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ *
+ * @return
+ *             - NVS_OK if the erasure was staged
+ *             - NVS_ERR_INVALID_ARG if batch is NULL
+ *             - NVS_ERR_NVS_KEY_TOO_LONG if key name is too long
+ *             - NVS_ERR_NO_MEM if memory could not be allocated
+ */
+nvs_err_t nvs_batch_erase_key(nvs_batch_t batch, const char* key);
+
+/**
+ * @brief      Apply all changes staged in a batch and release it
+ *
+ * @param[in]  batch   Batch obtained from nvs_batch_begin function.
+ *                     It should no longer be used after this call.
+ *
+ * @return
+ *             - NVS_OK if all changes have been written
+ *             - NVS_ERR_INVALID_ARG if batch is NULL
+ *             - NVS_ERR_NVS_INVALID_HANDLE if the handle of the batch has been closed
+ *             - NVS_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space for the
+ *               whole batch, nothing has been changed
+ *             - NVS_ERR_NVS_REMOVE_FAILED if erasing the replaced entries has failed.
+ *               The batch was written however, and it will be completed after
+ *               re-initialization of nvs, provided that flash operation doesn't fail again.
+ *             - other error codes from the underlying storage driver, nothing has been changed
+ */
+nvs_err_t nvs_batch_commit(nvs_batch_t batch);
+
+/**
+ * @brief      Drop all changes staged in a batch and release it
+ *
+ * @param[in]  batch   Batch obtained from nvs_batch_begin function.
+ *                     It should no longer be used after this call.
+ */
+void nvs_batch_abort(nvs_batch_t batch);
+
 /**
  * @note Info about storage space NVS.
  */
@@ -557,6 +709,8 @@ typedef struct {
     size_t free_entries;      /**< Amount of free entries. */
     size_t total_entries;     /**< Amount all available entries. */
     size_t namespace_count;   /**< Amount name space. */
+    size_t cache_hits;        /**< Flash sector reads served by the partition read cache. */
+    size_t cache_misses;      /**< Flash sector reads that went to the flash, 0 without the cache. */
 } nvs_stats_t;
 
 /**
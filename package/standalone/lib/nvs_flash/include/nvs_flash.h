@@ -77,6 +77,49 @@ nvs_err_t nvs_flash_init(void);
  */
 nvs_err_t nvs_flash_init_partition(const char *partition_label);
 
+/**
+ * @brief Initialize NVS flash storage with custom flash sector layout and read cache
+ *
+ * @param[in] partName      Label of the partition, "USER_CONFIG_1".
+ * @param[in] baseSector    Flash sector (units of 4096 bytes) offset to start NVS, relative to the partition.
+ * @param[in] sectorCount   Length (in flash sectors) of NVS region. NVS partition must be at least 3 sectors long.
+ * @param[in] cacheSectors  Number of 4096-byte flash sectors kept in the read cache, 0 disables it.
+ *
+ * @return
+ *      - ESP_OK if storage was successfully initialized.
+ *      - ESP_ERR_NVS_PART_NOT_FOUND if the partition is unknown
+ *      - ESP_ERR_NO_MEM in case memory could not be allocated for the internal structures or the cache
+ *      - one of the error codes from the underlying flash storage driver
+ */
+nvs_err_t nvs_flash_init_custom(const char *partName, uint32_t baseSector, uint32_t sectorCount, uint32_t cacheSectors);
+
+/**
+ * @brief Select fast boot for the partitions initialized afterwards
+ *
+ * In fast boot, initialization reads the page headers only. The items of a page are
+ * read the first time the page is accessed, namespaces are looked up when opened, and
+ * the removal of blob chunks left by an interrupted write is deferred to nvs_flash_idle()
+ * or to the next blob write. The default is CONFIG_NVS_FAST_BOOT.
+ *
+ * @param[in] enable    true to select fast boot
+ */
+void nvs_flash_set_fast_boot(bool enable);
+
+/**
+ * @brief Do one step of the work deferred by fast boot
+ *
+ * Meant to be called from an idle or low priority task until nothing is pending.
+ * Each call reads one page or does one cleanup pass per initialized partition, so
+ * it holds the NVS lock for a short time only.
+ *
+ * @param[out] pending  Set if work is left, may be NULL.
+ *
+ * @return
+ *      - NVS_OK on success
+ *      - one of the error codes from the underlying flash storage driver
+ */
+nvs_err_t nvs_flash_idle(bool *pending);
+
 /**
  * @brief Initialize NVS flash storage for the partition specified by partition pointer.
  *
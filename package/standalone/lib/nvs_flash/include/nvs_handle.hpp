@@ -29,6 +29,81 @@ enum class ItemType : uint8_t {
 };
 
 
+/**
+ * @brief A set of changes to the entries of a handle's scope, applied all together or not at all.
+ *
+ * Sets and erases are only staged in RAM until \ref commit is called. The changes are then written with one
+ * lock acquisition, appended to the pages one after another, and the replaced entries are erased afterwards.
+ * If power is lost during the commit, either all changes or none of them are present after re-initialization.
+ *
+ * Only integer types and strings can be set in a batch, blobs have to be written with \ref NVSHandle::set_blob.
+ *
+ * @note The batch must not be used after the handle it was created from has been destroyed.
+ */
+class NVSBatch {
+public:
+    virtual ~NVSBatch() { }
+
+    /**
+     * @brief      stage a value for given key
+     *
+     * A value staged earlier in this batch for the same key and type is replaced.
+     *
+     * @param[in]  key     Key name. Maximal length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+     * @param[in]  value   The value to set. Allowed types are the integral types declared in ItemType and enums.
+     *
+     * @return
+     *             - ESP_OK if the value was staged
+     *             - ESP_ERR_NVS_KEY_TOO_LONG if key name is too long
+     *             - ESP_ERR_NO_MEM if memory could not be allocated for the staged value
+     */
+    template<typename T>
+    nvs_err_t set_item(const char *key, T value);
+
+    /**
+     * @brief      stage a string for given key
+     *
+     * @return
+     *             - ESP_OK if the string was staged
+     *             - ESP_ERR_NVS_KEY_TOO_LONG if key name is too long
+     *             - ESP_ERR_NVS_VALUE_TOO_LONG if the string does not fit into a page
+     *             - ESP_ERR_NO_MEM if memory could not be allocated for the staged value
+     */
+    virtual nvs_err_t set_string(const char *key, const char* value) = 0;
+
+    /**
+     * @brief      stage the erasure of all entries with given key
+     *
+     * Values staged earlier in this batch for the key are dropped. Erasing a key which does not exist
+     * is not an error.
+     */
+    virtual nvs_err_t erase_item(const char* key) = 0;
+
+    /**
+     * @brief      apply all staged changes
+     *
+     * The batch is empty afterwards, whatever the result.
+     *
+     * @return
+     *             - ESP_OK if all changes have been written
+     *             - ESP_ERR_NVS_INVALID_HANDLE if the handle has been closed
+     *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space for the whole batch,
+     *               nothing has been changed
+     *             - ESP_ERR_NVS_REMOVE_FAILED if erasing the replaced entries has failed. The batch was
+     *               written however and will be completed after re-initialization of nvs.
+     *             - other error codes from the underlying storage driver, nothing has been changed
+     */
+    virtual nvs_err_t commit() = 0;
+
+    /**
+     * @brief      drop all staged changes
+     */
+    virtual void clear() = 0;
+
+protected:
+    virtual nvs_err_t set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) = 0;
+};
+
 /**
  * @brief A handle allowing nvs-entry related operations on the NVS.
  *
@@ -200,6 +275,19 @@ public:
      */
     virtual nvs_err_t get_used_entry_count(size_t& usedEntries) = 0;
 
+    /**
+     * @brief      Create an empty batch of changes to the entries in the scope of this handle.
+     *
+     * @param[out] err     optional result of the operation:
+     *             - ESP_OK if the batch was created
+     *             - ESP_ERR_NVS_INVALID_HANDLE if the handle has been closed
+     *             - ESP_ERR_NVS_READ_ONLY if the handle was opened as read only
+     *             - ESP_ERR_NO_MEM if memory could not be allocated for the batch
+     *
+     * @return unique pointer of the batch on success, an empty unique pointer otherwise
+     */
+    virtual std::unique_ptr<NVSBatch> begin_batch(nvs_err_t *err = nullptr) = 0;
+
 protected:
     virtual nvs_err_t set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) = 0;
 
@@ -275,6 +363,11 @@ nvs_err_t NVSHandle::get_item(const char *key, T &value) {
     return get_typed_item(itemTypeOf(value), key, &value, sizeof(value));
 }
 
+template<typename T>
+nvs_err_t NVSBatch::set_item(const char *key, T value) {
+    return set_typed_item(itemTypeOf(value), key, &value, sizeof(value));
+}
+
 } // nvs
 
 #endif // NVS_HANDLE_HPP_
@@ -12,6 +12,7 @@ SRCS += \
 	nvs_handle_locked.cpp \
 	nvs_handle_simple.cpp \
 	nvs_item_hash_list.cpp \
+	nvs_item_index.cpp \
 	nvs_page.cpp \
 	nvs_pagemanager.cpp \
 	nvs_storage.cpp \
@@ -44,6 +44,12 @@ private:
 
 uint32_t NVSHandleEntry::s_nvs_next_handle;
 
+struct nvs_opaque_batch_t
+{
+    nvs_handle_t handle;
+    std::unique_ptr<nvs::NVSBatch> batch;
+};
+
 extern "C" void nvs_dump(const char *partName);
 
 #ifndef LINUX_TARGET
@@ -114,6 +120,43 @@ extern "C" nvs_err_t nvs_flash_init_partition_ptr(uint32_t address, size_t size)
     return init_res;
 }
 
+extern "C" nvs_err_t nvs_flash_init_custom(const char *partName, uint32_t baseSector, uint32_t sectorCount, uint32_t cacheSectors)
+{
+    nvs_err_t lock_result = Lock::init();
+    if (lock_result != NVS_OK) {
+        return lock_result;
+    }
+    Lock lock;
+
+    return NVSPartitionManager::get_instance()->init_custom(partName, baseSector, sectorCount, cacheSectors);
+}
+
+extern "C" void nvs_flash_set_fast_boot(bool enable)
+{
+    if (Lock::init() != NVS_OK) {
+        return;
+    }
+    Lock lock;
+
+    NVSPartitionManager::get_instance()->set_fast_boot(enable);
+}
+
+extern "C" nvs_err_t nvs_flash_idle(bool *pending)
+{
+    nvs_err_t lock_result = Lock::init();
+    if (lock_result != NVS_OK) {
+        return lock_result;
+    }
+    Lock lock;
+
+    bool left;
+    nvs_err_t err = NVSPartitionManager::get_instance()->idle(left);
+    if (pending) {
+        *pending = left;
+    }
+    return err;
+}
+
 #ifndef LINUX_TARGET
 extern "C" nvs_err_t nvs_flash_init_partition(const char *part_name)
 {
@@ -371,6 +414,120 @@ extern "C" nvs_err_t nvs_set_blob(nvs_handle_t c_handle, const char* key, const
     return handle->set_blob(key, value, length);
 }
 
+extern "C" nvs_err_t nvs_batch_begin(nvs_handle_t c_handle, nvs_batch_t *out_batch)
+{
+    Lock lock;
+    NVS_LOGD(TAG, "[%s] %d", __func__, static_cast<int>(c_handle));
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != NVS_OK) {
+        return err;
+    }
+
+    std::unique_ptr<NVSBatch> batch = handle->begin_batch(&err);
+    if (!batch) {
+        return err;
+    }
+
+    nvs_batch_t entry = new (std::nothrow) nvs_opaque_batch_t;
+    if (!entry) {
+        return NVS_ERR_NO_MEM;
+    }
+    entry->handle = c_handle;
+    entry->batch = std::move(batch);
+    *out_batch = entry;
+
+    return NVS_OK;
+}
+
+template<typename T>
+static nvs_err_t nvs_batch_set(nvs_batch_t batch, const char* key, T value)
+{
+    if (batch == nullptr) {
+        return NVS_ERR_INVALID_ARG;
+    }
+    return batch->batch->set_item(key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_i8  (nvs_batch_t batch, const char* key, int8_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_u8  (nvs_batch_t batch, const char* key, uint8_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_i16 (nvs_batch_t batch, const char* key, int16_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_u16 (nvs_batch_t batch, const char* key, uint16_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_i32 (nvs_batch_t batch, const char* key, int32_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_u32 (nvs_batch_t batch, const char* key, uint32_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_i64 (nvs_batch_t batch, const char* key, int64_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_u64 (nvs_batch_t batch, const char* key, uint64_t value)
+{
+    return nvs_batch_set(batch, key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_set_str(nvs_batch_t batch, const char* key, const char* value)
+{
+    if (batch == nullptr) {
+        return NVS_ERR_INVALID_ARG;
+    }
+    return batch->batch->set_string(key, value);
+}
+
+extern "C" nvs_err_t nvs_batch_erase_key(nvs_batch_t batch, const char* key)
+{
+    if (batch == nullptr) {
+        return NVS_ERR_INVALID_ARG;
+    }
+    return batch->batch->erase_item(key);
+}
+
+extern "C" nvs_err_t nvs_batch_commit(nvs_batch_t batch)
+{
+    if (batch == nullptr) {
+        return NVS_ERR_INVALID_ARG;
+    }
+
+    Lock lock;
+    NVS_LOGD(TAG, "[%s] %d", __func__, static_cast<int>(batch->handle));
+    // the handle may have been closed since the batch was started
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(batch->handle, &handle);
+    if (err == NVS_OK) {
+        err = handle->commit_batch(*static_cast<NVSBatchSimple*>(batch->batch.get()));
+    }
+
+    delete batch;
+    return err;
+}
+
+extern "C" void nvs_batch_abort(nvs_batch_t batch)
+{
+    delete batch;
+}
 
 template<typename T>
 static nvs_err_t nvs_get(nvs_handle_t c_handle, const char* key, T* out_value)
@@ -477,6 +634,8 @@ extern "C" nvs_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats
     nvs_stats->free_entries     = 0;
     nvs_stats->total_entries    = 0;
     nvs_stats->namespace_count  = 0;
+    nvs_stats->cache_hits       = 0;
+    nvs_stats->cache_misses     = 0;
 
     pStorage = lookup_storage_from_name((part_name == nullptr) ? NVS_DEFAULT_PART_NAME : part_name);
     if (pStorage == nullptr) {
@@ -67,6 +67,25 @@ nvs_err_t NVSHandleLocked::get_used_entry_count(size_t& usedEntries) {
     return handle->get_used_entry_count(usedEntries);
 }
 
+std::unique_ptr<NVSBatch> NVSHandleLocked::begin_batch(nvs_err_t *err) {
+    Lock lock;
+    std::unique_ptr<NVSBatch> batch = handle->begin_batch(err);
+    if (!batch) {
+        return nullptr;
+    }
+
+    NVSBatchLocked *locked_batch = new (std::nothrow) NVSBatchLocked(static_cast<NVSBatchSimple*>(batch.get()));
+    if (!locked_batch) {
+        if (err) {
+            *err = NVS_ERR_NO_MEM;
+        }
+        return nullptr;
+    }
+
+    batch.release();
+    return std::unique_ptr<NVSBatch>(locked_batch);
+}
+
 nvs_err_t NVSHandleLocked::set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) {
     Lock lock;
     return handle->set_typed_item(datatype, key, data, dataSize);
@@ -77,4 +96,31 @@ nvs_err_t NVSHandleLocked::get_typed_item(ItemType datatype, const char *key, vo
     return handle->get_typed_item(datatype, key, data, dataSize);
 }
 
+NVSBatchLocked::NVSBatchLocked(NVSBatchSimple *batch) : batch(batch) { }
+
+NVSBatchLocked::~NVSBatchLocked() {
+    delete batch;
+}
+
+nvs_err_t NVSBatchLocked::set_string(const char *key, const char* value) {
+    return batch->set_string(key, value);
+}
+
+nvs_err_t NVSBatchLocked::erase_item(const char* key) {
+    return batch->erase_item(key);
+}
+
+nvs_err_t NVSBatchLocked::commit() {
+    Lock lock;
+    return batch->commit();
+}
+
+void NVSBatchLocked::clear() {
+    batch->clear();
+}
+
+nvs_err_t NVSBatchLocked::set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) {
+    return batch->set_typed_item(datatype, key, data, dataSize);
+}
+
 } // namespace nvs
@@ -57,6 +57,8 @@ public:
 
     nvs_err_t get_used_entry_count(size_t& usedEntries) override;
 
+    std::unique_ptr<NVSBatch> begin_batch(nvs_err_t *err = nullptr) override;
+
 protected:
     nvs_err_t set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) override;
 
@@ -66,6 +68,35 @@ private:
     NVSHandleSimple *handle;
 };
 
+/**
+ * @brief A class which behaves the same as the NVSBatch it decorates, except that commit() is locked.
+ *
+ * Staging changes only touches the batch itself, so the other member functions are not locked.
+ *
+ * @note this class becomes responsible for its internal NVSBatch object, i.e. it deletes the batch object on
+ * destruction
+ */
+class NVSBatchLocked : public NVSBatch {
+public:
+    NVSBatchLocked(NVSBatchSimple *batch);
+
+    virtual ~NVSBatchLocked();
+
+    nvs_err_t set_string(const char *key, const char* value) override;
+
+    nvs_err_t erase_item(const char* key) override;
+
+    nvs_err_t commit() override;
+
+    void clear() override;
+
+protected:
+    nvs_err_t set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) override;
+
+private:
+    NVSBatchSimple *batch;
+};
+
 } // namespace nvs
 
 #endif // NVS_HANDLE_LOCKED_HPP_
@@ -16,7 +16,6 @@
 #include "nvs_partition_manager.hpp"
 
 namespace nvs {
-static const char *TAG = "handle_simple";
 
 NVSHandleSimple::~NVSHandleSimple() {
     NVSPartitionManager::get_instance()->close_handle(this);
@@ -94,30 +93,10 @@ nvs_err_t NVSHandleSimple::commit()
 {
     if (!valid) return NVS_ERR_NVS_INVALID_HANDLE;
 
-    nvs_err_t err = NVS_OK;
-    uint8_t *buffer = nullptr;
-    const Partition *partition = mStoragePtr->getPart();
-    uint32_t address = mStoragePtr->getPartAddress();
-    size_t size = mStoragePtr->getPartSize();
-    NVS_LOGD(TAG, "[%s] Address: 0x%x, size: %d\n", __func__, address, size);
-
-    buffer = new (std::nothrow) uint8_t[size];
-    if (nrc_sf_read(address, buffer, size) == size) {
-        if (nrc_sf_erase(address, size)) {
-            if (nrc_sf_write(address, buffer, size) == size) {
-				err = NVS_OK;
-			} else {
-				err = NVS_FAIL;
-			}
-        } else {
-            err = NVS_FAIL;
-        }
-    } else {
-        err = NVS_FAIL;
-    }
-
-	delete [] buffer;
-    return err;
+    // Nothing to flush: set/erase calls program their entries straight into the
+    // append-only pages and a torn entry is discarded by Page::load() on the next
+    // boot, so every successful call is already durable when it returns.
+    return NVS_OK;
 }
 
 nvs_err_t NVSHandleSimple::get_used_entry_count(size_t& used_entries)
@@ -134,6 +113,44 @@ nvs_err_t NVSHandleSimple::get_used_entry_count(size_t& used_entries)
     return err;
 }
 
+std::unique_ptr<NVSBatch> NVSHandleSimple::begin_batch(nvs_err_t *err)
+{
+    nvs_err_t result = NVS_OK;
+    NVSBatchSimple *batch = nullptr;
+
+    if (!valid) {
+        result = NVS_ERR_NVS_INVALID_HANDLE;
+    } else if (mReadOnly) {
+        result = NVS_ERR_NVS_READ_ONLY;
+    } else {
+        batch = new (std::nothrow) NVSBatchSimple(this);
+        if (!batch) {
+            result = NVS_ERR_NO_MEM;
+        }
+    }
+
+    if (err) {
+        *err = result;
+    }
+    return std::unique_ptr<NVSBatch>(batch);
+}
+
+nvs_err_t NVSHandleSimple::commit_batch(NVSBatchSimple &batch)
+{
+    nvs_err_t err;
+
+    if (!valid) {
+        err = NVS_ERR_NVS_INVALID_HANDLE;
+    } else if (mReadOnly) {
+        err = NVS_ERR_NVS_READ_ONLY;
+    } else {
+        err = mStoragePtr->writeBatch(mNsIndex, batch.items());
+    }
+
+    batch.clear();
+    return err;
+}
+
 void NVSHandleSimple::debugDump() {
     return mStoragePtr->debugDump();
 }
@@ -158,4 +175,103 @@ const char *NVSHandleSimple::get_partition_name() const {
     return mStoragePtr->getPartName();
 }
 
+NVSBatchSimple::~NVSBatchSimple() {
+    clear();
+}
+
+nvs_err_t NVSBatchSimple::stage(ItemType datatype, const char *key, Storage::BatchItem *&item)
+{
+    if (key == nullptr || strlen(key) > Item::MAX_KEY_LENGTH) {
+        return NVS_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    auto it = std::find_if(mItems.begin(), mItems.end(), [=](const Storage::BatchItem& e) -> bool {
+        return e.datatype == datatype && strcmp(e.key, key) == 0;
+    });
+    if (it != mItems.end()) {
+        item = it;
+        return NVS_OK;
+    }
+
+    item = new (std::nothrow) Storage::BatchItem;
+    if (!item) {
+        return NVS_ERR_NO_MEM;
+    }
+    item->datatype = datatype;
+    strcpy(item->key, key);
+    mItems.push_back(item);
+    return NVS_OK;
+}
+
+nvs_err_t NVSBatchSimple::set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize)
+{
+    Storage::BatchItem *item;
+
+    assert(dataSize <= sizeof(item->value));
+    auto err = stage(datatype, key, item);
+    if (err != NVS_OK) {
+        return err;
+    }
+
+    memcpy(item->value, data, dataSize);
+    item->dataSize = dataSize;
+    return NVS_OK;
+}
+
+nvs_err_t NVSBatchSimple::set_string(const char *key, const char* str)
+{
+    Storage::BatchItem *item;
+    size_t size = strlen(str) + 1;
+
+    if (size > Page::CHUNK_MAX_SIZE) {
+        return NVS_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    char *copy = new (std::nothrow) char[size];
+    if (!copy) {
+        return NVS_ERR_NO_MEM;
+    }
+    memcpy(copy, str, size);
+
+    auto err = stage(nvs::ItemType::SZ, key, item);
+    if (err != NVS_OK) {
+        delete[] copy;
+        return err;
+    }
+
+    delete[] item->str;
+    item->str = copy;
+    item->dataSize = size;
+    return NVS_OK;
+}
+
+nvs_err_t NVSBatchSimple::erase_item(const char* key)
+{
+    if (key == nullptr || strlen(key) > Item::MAX_KEY_LENGTH) {
+        return NVS_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    for (auto it = mItems.begin(); it != mItems.end();) {
+        auto tmp = it;
+        ++it;
+        if (strcmp(tmp->key, key) == 0) {
+            mItems.erase(tmp);
+            delete static_cast<Storage::BatchItem*>(tmp);
+        }
+    }
+
+    Storage::BatchItem *item;
+    return stage(nvs::ItemType::ANY, key, item);
+}
+
+nvs_err_t NVSBatchSimple::commit()
+{
+    return mHandle->commit_batch(*this);
+}
+
+void NVSBatchSimple::clear()
+{
+    mItems.clearAndFreeNodes();
+}
+
 }
@@ -22,6 +22,8 @@
 
 namespace nvs {
 
+class NVSBatchSimple;
+
 /**
  * @brief This class implements NVSHandle according to the ESP32's flash and partitioning scheme.
  *
@@ -64,6 +66,10 @@ public:
 
     nvs_err_t get_used_entry_count(size_t &usedEntries) override;
 
+    std::unique_ptr<NVSBatch> begin_batch(nvs_err_t *err = nullptr) override;
+
+    nvs_err_t commit_batch(NVSBatchSimple &batch);
+
     nvs_err_t getItemDataSize(ItemType datatype, const char *key, size_t &dataSize);
 
     void debugDump();
@@ -102,6 +108,46 @@ private:
     uint8_t valid;
 };
 
+/**
+ * @brief This class implements NVSBatch for NVSHandleSimple.
+ *
+ * The changes are staged in a list which is handed to the storage object on commit.
+ */
+class NVSBatchSimple : public NVSBatch {
+public:
+    NVSBatchSimple(NVSHandleSimple *handle) : mHandle(handle) { }
+
+    ~NVSBatchSimple();
+
+    nvs_err_t set_typed_item(ItemType datatype, const char *key, const void *data, size_t dataSize) override;
+
+    nvs_err_t set_string(const char *key, const char *str) override;
+
+    nvs_err_t erase_item(const char *key) override;
+
+    nvs_err_t commit() override;
+
+    void clear() override;
+
+    Storage::TBatchItemList &items()
+    {
+        return mItems;
+    }
+
+private:
+    nvs_err_t stage(ItemType datatype, const char *key, Storage::BatchItem *&item);
+
+    /**
+     * The handle whose namespace the batch changes.
+     */
+    NVSHandleSimple *mHandle;
+
+    /**
+     * The staged sets and erases, in the order they were made.
+     */
+    Storage::TBatchItemList mItems;
+};
+
 } // nvs
 
 #endif // NVS_HANDLE_SIMPLE_HPP_
@@ -33,6 +33,19 @@ public:
     size_t find(size_t start, const Item& item);
     void clear();
 
+    /* Calls fn(hash, index) for every item in the list */
+    template <typename TFunc>
+    void forEach(TFunc fn)
+    {
+        for (auto it = mBlockList.begin(); it != mBlockList.end(); ++it) {
+            for (size_t i = 0; i < it->mCount; ++i) {
+                if (it->mNodes[i].mIndex != 0xff) {
+                    fn(it->mNodes[i].mHash, it->mNodes[i].mIndex);
+                }
+            }
+        }
+    }
+
 private:
     HashList(const HashList& other);
     const HashList& operator= (const HashList& rhs);
@@ -0,0 +1,196 @@
+#include "nvs_item_index.hpp"
+#include "nvs_page.hpp"
+
+namespace nvs
+{
+
+ItemIndex::ItemIndex()
+{
+    static_assert(sizeof(Node) == 8, "index node size should be 8 bytes");
+}
+
+ItemIndex::~ItemIndex()
+{
+    clear();
+}
+
+void ItemIndex::clear()
+{
+    delete [] mNodes;
+    delete [] mBuckets;
+
+    mPages = nullptr;
+    mPageCount = 0;
+    mNodes = nullptr;
+    mBuckets = nullptr;
+    mNodeCount = 0;
+    mBucketCount = 0;
+    mUsed = 0;
+    mDropped = 0;
+    mPendingPages = 0;
+    mFree = INVALID_NODE;
+}
+
+void ItemIndex::init(Page* pages, size_t pageCount, size_t size)
+{
+    clear();
+
+    if (size == 0 || size >= INVALID_NODE || pageCount >= UINT16_MAX) {
+        return;
+    }
+
+    size_t bucketCount = 1;
+    while (bucketCount < size) {
+        bucketCount <<= 1;
+    }
+
+    mNodes = new (std::nothrow) Node[size];
+    mBuckets = new (std::nothrow) uint16_t[bucketCount];
+    if (!mNodes || !mBuckets) {
+        /* the pages are searched without the index */
+        clear();
+        return;
+    }
+
+    mPages = pages;
+    mPageCount = pageCount;
+    mNodeCount = size;
+    mBucketCount = bucketCount;
+    reset();
+}
+
+void ItemIndex::reset()
+{
+    std::fill_n(mBuckets, mBucketCount, INVALID_NODE);
+
+    for (size_t i = 0; i < mNodeCount; ++i) {
+        mNodes[i].mNext = (i + 1 < mNodeCount) ? i + 1 : INVALID_NODE;
+    }
+    mFree = 0;
+    mUsed = 0;
+    mDropped = 0;
+}
+
+void ItemIndex::refresh()
+{
+    if (!mNodes || mDropped == 0 || mNodeCount - mUsed < mDropped) {
+        return;
+    }
+
+    reset();
+    for (size_t i = 0; i < mPageCount; ++i) {
+        mPages[i].indexItems();
+    }
+}
+
+void ItemIndex::insert(uint32_t hash_24, const Page* page, size_t index)
+{
+    if (!mNodes) {
+        return;
+    }
+
+    if (mFree == INVALID_NODE) {
+        ++mDropped;
+        return;
+    }
+
+    uint16_t* bucket = &mBuckets[hash_24 & (mBucketCount - 1)];
+    uint16_t node = mFree;
+
+    mFree = mNodes[node].mNext;
+    mNodes[node].mIndex = index;
+    mNodes[node].mHash = hash_24;
+    mNodes[node].mPage = page - mPages;
+    mNodes[node].mNext = *bucket;
+    *bucket = node;
+    ++mUsed;
+}
+
+void ItemIndex::unlink(uint16_t* link)
+{
+    uint16_t node = *link;
+
+    *link = mNodes[node].mNext;
+    mNodes[node].mNext = mFree;
+    mFree = node;
+    --mUsed;
+}
+
+size_t ItemIndex::eraseIf(uint16_t pageNumber, size_t index, bool anyIndex)
+{
+    size_t found = 0;
+
+    for (size_t i = 0; i < mBucketCount; ++i) {
+        uint16_t* link = &mBuckets[i];
+        while (*link != INVALID_NODE) {
+            Node& n = mNodes[*link];
+            if (n.mPage == pageNumber && (anyIndex || n.mIndex == index)) {
+                unlink(link);
+                ++found;
+            } else {
+                link = &n.mNext;
+            }
+        }
+    }
+
+    return found;
+}
+
+void ItemIndex::erase(const Item& item, const Page* page, size_t index)
+{
+    if (!mNodes) {
+        return;
+    }
+
+    const uint32_t hash_24 = hash(item);
+    const uint16_t pageNumber = page - mPages;
+
+    for (uint16_t* link = &mBuckets[hash_24 & (mBucketCount - 1)]; *link != INVALID_NODE; link = &mNodes[*link].mNext) {
+        Node& n = mNodes[*link];
+        if (n.mPage == pageNumber && n.mIndex == index) {
+            unlink(link);
+            return;
+        }
+    }
+
+    /* item read back with a bad crc, or else dropped when the index was full */
+    if (!eraseIf(pageNumber, index, false) && mDropped > 0) {
+        --mDropped;
+    }
+}
+
+void ItemIndex::erase(const Page* page, size_t itemCount)
+{
+    if (!mNodes) {
+        return;
+    }
+
+    const size_t erased = eraseIf(page - mPages, 0, true);
+    if (itemCount > erased) {
+        mDropped -= std::min(mDropped, itemCount - erased);
+    }
+}
+
+uint16_t ItemIndex::find(uint32_t hash, uint16_t node) const
+{
+    if (!mNodes) {
+        return INVALID_NODE;
+    }
+
+    node = (node == INVALID_NODE) ? mBuckets[hash & (mBucketCount - 1)] : mNodes[node].mNext;
+
+    for (; node != INVALID_NODE; node = mNodes[node].mNext) {
+        if (mNodes[node].mHash == hash) {
+            return node;
+        }
+    }
+
+    return INVALID_NODE;
+}
+
+Page* ItemIndex::page(uint16_t node) const
+{
+    return &mPages[mNodes[node].mPage];
+}
+
+} // namespace nvs
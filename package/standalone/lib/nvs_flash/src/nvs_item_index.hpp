@@ -0,0 +1,134 @@
+#ifndef nvs_item_index_h
+#define nvs_item_index_h
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+
+/* Number of items held by the index, 8 bytes each plus 2 bytes per hash bucket. 0 disables it. */
+#ifndef CONFIG_NVS_ITEM_INDEX_SIZE
+#define CONFIG_NVS_ITEM_INDEX_SIZE 256
+#endif
+
+namespace nvs
+{
+
+class Page;
+
+/**
+ * Index of the items of all pages. It maps the hash of <namespace, key, chunk index> (the one
+ * used by HashList) to the page and entry of the item, so a lookup reads one entry instead of
+ * searching every page. Pages keep it up to date along with their own HashList.
+ *
+ * The node pool is allocated once by init(). While items that did not fit are left out, the
+ * index is not complete and a lookup that misses has to fall back to searching the pages. The
+ * same holds while pages loaded lazily have not read their items yet. Once enough items have
+ * been erased for the left out ones to fit, refresh() adds the items of all pages again from
+ * their HashLists.
+ */
+class ItemIndex
+{
+public:
+    static const size_t DEFAULT_SIZE = CONFIG_NVS_ITEM_INDEX_SIZE;
+    static const uint16_t INVALID_NODE = 0xffff;
+
+    ItemIndex();
+    ~ItemIndex();
+
+    void init(Page* pages, size_t pageCount, size_t size);
+    void clear();
+
+    void insert(const Item& item, const Page* page, size_t index)
+    {
+        insert(hash(item), page, index);
+    }
+
+    void insert(uint32_t hash, const Page* page, size_t index);
+    void erase(const Item& item, const Page* page, size_t index);
+
+    /* Drops the nodes of a page that held itemCount items */
+    void erase(const Page* page, size_t itemCount);
+
+    /* Rebuilds the index if the items left out of it fit now */
+    void refresh();
+
+    /* First node with the given hash if node is INVALID_NODE, otherwise the next one after it. */
+    uint16_t find(uint32_t hash, uint16_t node = INVALID_NODE) const;
+
+    Page* page(uint16_t node) const;
+
+    size_t index(uint16_t node) const
+    {
+        return mNodes[node].mIndex;
+    }
+
+    void addPendingPage()
+    {
+        ++mPendingPages;
+    }
+
+    void removePendingPage()
+    {
+        --mPendingPages;
+    }
+
+    bool isComplete() const
+    {
+        return mNodes != nullptr && mDropped == 0 && mPendingPages == 0;
+    }
+
+    size_t size() const
+    {
+        return mNodeCount;
+    }
+
+    size_t used() const
+    {
+        return mUsed;
+    }
+
+    size_t dropped() const
+    {
+        return mDropped;
+    }
+
+    size_t memorySize() const
+    {
+        return mNodeCount * sizeof(Node) + mBucketCount * sizeof(uint16_t);
+    }
+
+    static uint32_t hash(const Item& item)
+    {
+        return item.calculateCrc32WithoutValue() & 0xffffff;
+    }
+
+private:
+    ItemIndex(const ItemIndex& other);
+    const ItemIndex& operator= (const ItemIndex& rhs);
+
+protected:
+    struct Node {
+        uint32_t mIndex : 8;
+        uint32_t mHash  : 24;
+        uint16_t mPage;
+        uint16_t mNext;
+    };
+
+    void unlink(uint16_t* link);
+    size_t eraseIf(uint16_t pageNumber, size_t index, bool anyIndex);
+    void reset();
+
+    Page* mPages = nullptr;
+    size_t mPageCount = 0;
+    Node* mNodes = nullptr;
+    uint16_t* mBuckets = nullptr;
+    size_t mNodeCount = 0;
+    size_t mBucketCount = 0;
+    size_t mUsed = 0;
+    size_t mDropped = 0;        /* items of loaded pages that are not in the index */
+    size_t mPendingPages = 0;
+    uint16_t mFree = INVALID_NODE;
+}; // class ItemIndex
+
+} // namespace nvs
+
+#endif /* nvs_item_index_h */
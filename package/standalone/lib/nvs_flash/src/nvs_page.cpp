@@ -23,6 +23,10 @@ namespace nvs
 {
 static const char* TAG = "Page";
 
+const char Page::BATCH_BEGIN_KEY[] = "nvs.batch";
+const char Page::BATCH_COMMIT_KEY[] = "nvs.commit";
+const char Page::BATCH_CONTINUE_KEY[] = "nvs.cont";
+
 Page::Page() : mPartition(nullptr) { }
 
 uint32_t Page::Header::calculateCrc32()
@@ -32,13 +36,14 @@ uint32_t Page::Header::calculateCrc32()
                     offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
 }
 
-nvs_err_t Page::load(Partition *partition, uint32_t sectorNumber)
+nvs_err_t Page::load(Partition *partition, uint32_t sectorNumber, ItemIndex *itemIndex, bool lazy)
 {
     if (partition == nullptr) {
         return NVS_ERR_INVALID_ARG;
     }
 
     mPartition = partition;
+    mItemIndex = itemIndex;
     mBaseAddress = sectorNumber * SEC_SIZE;
     mUsedEntryCount = 0;
     mErasedEntryCount = 0;
@@ -51,37 +56,13 @@ nvs_err_t Page::load(Partition *partition, uint32_t sectorNumber)
     }
     if (header.mState == PageState::UNINITIALIZED) {
         mState = header.mState;
-        // check if the whole page is really empty
-        // reading the whole page takes ~40 times less than erasing it
-        const int BLOCK_SIZE = 128;
-        uint32_t* block = new (std::nothrow) uint32_t[BLOCK_SIZE];
-		NVS_LOGD(TAG, "[%s] PageState::UNINITIALIZED...", __func__);
-
-        if (!block) {
-			NVS_LOGD(TAG, "[%s] block allocation failed, no mem...", __func__);
-			return NVS_ERR_NO_MEM;
-		}
-        for (uint32_t i = 0; i < SPI_FLASH_SEC_SIZE; i += 4 * BLOCK_SIZE) {
-			NVS_LOGD(TAG, "[%s] partition read addr 0x%x, block size * 4 = %d...", __func__, mBaseAddress + i, 4 * BLOCK_SIZE);
-            rc = mPartition->read(mBaseAddress + i, block, 4 * BLOCK_SIZE);
+        mBlankCheckPending = true;
+        if (!lazy) {
+            rc = checkBlank();
             if (rc != NVS_OK) {
-                mState = PageState::INVALID;
-                delete[] block;
-				NVS_LOGD(TAG, "[%s] partition read failed?...", __func__);
                 return rc;
             }
-            if (std::any_of(block, block + BLOCK_SIZE, [](uint32_t val) -> bool { return val != 0xffffffff; })) {
-                // page isn't as empty after all, mark it as corrupted
-                mState = PageState::CORRUPT;
-				NVS_LOGD(TAG, "[%s] partition corrupt...", __func__);
-                break;
-            }
-			NVS_LOGD(TAG, "[%s] i = %d, SPI_FLASH_SEC_SIZE", __func__, i, SPI_FLASH_SEC_SIZE);
         }
-		NVS_LOGD(TAG, "[%s] delete block...", __func__);
-        delete[] block;
-		NVS_LOGD(TAG, "[%s] unintialized block check done...", __func__);
-
     } else if (header.mCrc32 != header.calculateCrc32()) {
 		NVS_LOGD(TAG, "[%s] header crc error (%d != %d...", __func__, header.mCrc32, header.calculateCrc32());
         header.mState = PageState::CORRUPT;
@@ -102,6 +83,13 @@ nvs_err_t Page::load(Partition *partition, uint32_t sectorNumber)
         break;
 
     case PageState::FULL:
+        if (lazy) {
+            mItemsPending = true;
+            if (mItemIndex) {
+                mItemIndex->addPendingPage();
+            }
+        }
+        // fall through
     case PageState::ACTIVE:
     case PageState::FREEING:
 		NVS_LOGD(TAG, "[%s] Call mLoadEntryTable", __func__);
@@ -118,6 +106,78 @@ nvs_err_t Page::load(Partition *partition, uint32_t sectorNumber)
     return NVS_OK;
 }
 
+nvs_err_t Page::checkBlank()
+{
+    if (!mBlankCheckPending || mState != PageState::UNINITIALIZED) {
+        return NVS_OK;
+    }
+
+    // check if the whole page is really empty
+    // reading the whole page takes ~40 times less than erasing it
+    const int BLOCK_SIZE = 128;
+    uint32_t* block = new (std::nothrow) uint32_t[BLOCK_SIZE];
+	NVS_LOGD(TAG, "[%s] PageState::UNINITIALIZED...", __func__);
+
+    if (!block) {
+		NVS_LOGD(TAG, "[%s] block allocation failed, no mem...", __func__);
+		return NVS_ERR_NO_MEM;
+	}
+    for (uint32_t i = 0; i < SPI_FLASH_SEC_SIZE; i += 4 * BLOCK_SIZE) {
+        auto rc = mPartition->read(mBaseAddress + i, block, 4 * BLOCK_SIZE);
+        if (rc != NVS_OK) {
+            mState = PageState::INVALID;
+            delete[] block;
+			NVS_LOGD(TAG, "[%s] partition read failed?...", __func__);
+            return rc;
+        }
+        if (std::any_of(block, block + BLOCK_SIZE, [](uint32_t val) -> bool { return val != 0xffffffff; })) {
+            // page isn't as empty after all, mark it as corrupted
+            mState = PageState::CORRUPT;
+			NVS_LOGD(TAG, "[%s] partition corrupt...", __func__);
+            break;
+        }
+    }
+    delete[] block;
+    mBlankCheckPending = false;
+    return NVS_OK;
+}
+
+nvs_err_t Page::loadItems()
+{
+    if (!mItemsPending) {
+        return NVS_OK;
+    }
+    mItemsPending = false;
+    if (mItemIndex) {
+        mItemIndex->removePendingPage();
+    }
+
+    auto err = mLoadItems();
+    if (err != NVS_OK || mDuplicateItem == nullptr) {
+        return err;
+    }
+
+    const Item* item = mDuplicateItem;
+    mDuplicateItem = nullptr;
+    err = eraseDuplicate(item);
+    return (err == NVS_ERR_NVS_NOT_FOUND) ? NVS_OK : err;
+}
+
+nvs_err_t Page::eraseDuplicate(const Item* item)
+{
+    if (mItemsPending) {
+        mDuplicateItem = item;
+        return NVS_OK;
+    }
+
+    auto err = eraseItem(item->nsIndex, item->datatype, item->key, item->chunkIndex);
+    if (err == NVS_ERR_NVS_NOT_FOUND && item->datatype == ItemType::BLOB_IDX) {
+        // blob stored in the old format, see PageManager::load()
+        err = eraseItem(item->nsIndex, ItemType::BLOB, item->key, item->chunkIndex);
+    }
+    return err;
+}
+
 nvs_err_t Page::writeEntry(const Item& item)
 {
     nvs_err_t err;
@@ -240,7 +300,7 @@ nvs_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     // write first item
     size_t span = (totalSize + ENTRY_SIZE - 1) / ENTRY_SIZE;
     item = Item(nsIndex, datatype, span, key, chunkIdx);
-    err = mHashList.insert(item, mNextFreeEntry);
+    err = hashInsert(item, mNextFreeEntry);
 
     if (err != NVS_OK) {
         return err;
@@ -400,6 +460,18 @@ nvs_err_t Page::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key, u
     return eraseEntryAndSpan(index);
 }
 
+nvs_err_t Page::eraseItemAt(size_t itemIndex)
+{
+    auto err = loadItems();
+    if (err != NVS_OK) {
+        return err;
+    }
+    if (itemIndex >= ENTRY_COUNT || mEntryTable.get(itemIndex) != EntryState::WRITTEN) {
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
+    return eraseEntryAndSpan(itemIndex);
+}
+
 nvs_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -421,7 +493,7 @@ nvs_err_t Page::eraseEntryAndSpan(size_t index)
             return rc;
         }
         if (item.calculateCrc32() != item.crc32) {
-            mHashList.erase(index);
+            hashErase(item, index);
             rc = alterEntryState(index, EntryState::ERASED);
             --mUsedEntryCount;
             ++mErasedEntryCount;
@@ -429,7 +501,7 @@ nvs_err_t Page::eraseEntryAndSpan(size_t index)
                 return rc;
             }
         } else {
-            mHashList.erase(index);
+            hashErase(item, index);
             span = item.span;
             for (ptrdiff_t i = index + span - 1; i >= static_cast<ptrdiff_t>(index); --i) {
                 if (mEntryTable.get(i) == EntryState::WRITTEN) {
@@ -480,8 +552,41 @@ void Page::updateFirstUsedEntry(size_t index, size_t span)
     }
 }
 
+nvs_err_t Page::hashInsert(const Item& item, size_t index)
+{
+    auto err = mHashList.insert(item, index);
+    if (err == NVS_OK && mItemIndex) {
+        mItemIndex->insert(item, this, index);
+    }
+    return err;
+}
+
+void Page::hashErase(const Item& item, size_t index)
+{
+    /* an item missing from the HashList was not added to the index either */
+    if (mHashList.erase(index) && mItemIndex) {
+        mItemIndex->erase(item, this, index);
+    }
+}
+
+void Page::indexItems()
+{
+    if (!mItemIndex) {
+        return;
+    }
+
+    mHashList.forEach([this](uint32_t hash, size_t index) {
+        mItemIndex->insert(hash, this, index);
+    });
+}
+
 nvs_err_t Page::copyItems(Page& other)
 {
+    auto err = loadItems();
+    if (err != NVS_OK) {
+        return err;
+    }
+
     if (mFirstUsedEntry == INVALID_ENTRY) {
         return NVS_ERR_NVS_NOT_FOUND;
     }
@@ -503,12 +608,12 @@ nvs_err_t Page::copyItems(Page& other)
             readEntryIndex++;
             continue;
         }
-        auto err = readEntry(readEntryIndex, entry);
+        err = readEntry(readEntryIndex, entry);
         if (err != NVS_OK) {
             return err;
         }
 
-        err = other.mHashList.insert(entry, other.mNextFreeEntry);
+        err = other.hashInsert(entry, other.mNextFreeEntry);
         if (err != NVS_OK) {
             return err;
         }
@@ -645,7 +750,7 @@ nvs_err_t Page::mLoadEntryTable()
                 continue;
             }
 
-            err = mHashList.insert(item, i);
+            err = hashInsert(item, i);
             if (err != NVS_OK) {
                 mState = PageState::INVALID;
                 return err;
@@ -680,11 +785,13 @@ nvs_err_t Page::mLoadEntryTable()
             }
         }
 
-        // check that last item is not duplicate
-        if (lastItemIndex != INVALID_ENTRY) {
+        // check that last item is not duplicate, unless it belongs to an unfinished
+        // batch: Storage::init() then decides which of the two copies survives
+        if (lastItemIndex != INVALID_ENTRY &&
+                findItem(NS_INDEX, BATCH_MARKER_TYPE, BATCH_BEGIN_KEY) != NVS_OK) {
             size_t findItemIndex = 0;
             Item dupItem;
-            if (findItem(item.nsIndex, item.datatype, item.key, findItemIndex, dupItem) == NVS_OK) {
+            if (findItem(item.nsIndex, item.datatype, item.key, findItemIndex, dupItem, item.chunkIndex) == NVS_OK) {
                 if (findItemIndex < lastItemIndex) {
                     auto err = eraseEntryAndSpan(findItemIndex);
                     if (err != NVS_OK) {
@@ -696,56 +803,64 @@ nvs_err_t Page::mLoadEntryTable()
         }
     } else if (mState == PageState::FULL || mState == PageState::FREEING) {
         // We have already filled mHashList for page in active state.
-        // Do the same for the case when page is in full or freeing state.
-        Item item;
-        for (size_t i = mFirstUsedEntry; i < ENTRY_COUNT; ++i) {
-            if (mEntryTable.get(i) != EntryState::WRITTEN) {
-                continue;
-            }
+        // Do the same for the case when page is in full or freeing state,
+        // unless that is left to loadItems().
+        if (!mItemsPending) {
+            return mLoadItems();
+        }
+    }
 
-            auto err = readEntry(i, item);
-            if (err != NVS_OK) {
-                mState = PageState::INVALID;
-                return err;
-            }
+    return NVS_OK;
+}
 
-            if (item.crc32 != item.calculateCrc32()) {
-                err = eraseEntryAndSpan(i);
-                if (err != NVS_OK) {
-                    mState = PageState::INVALID;
-                    return err;
-                }
-                continue;
-            }
+nvs_err_t Page::mLoadItems()
+{
+    Item item;
+    for (size_t i = mFirstUsedEntry; i < ENTRY_COUNT; ++i) {
+        if (mEntryTable.get(i) != EntryState::WRITTEN) {
+            continue;
+        }
 
-            assert(item.span > 0);
+        auto err = readEntry(i, item);
+        if (err != NVS_OK) {
+            mState = PageState::INVALID;
+            return err;
+        }
 
-            err = mHashList.insert(item, i);
+        if (item.crc32 != item.calculateCrc32()) {
+            err = eraseEntryAndSpan(i);
             if (err != NVS_OK) {
                 mState = PageState::INVALID;
                 return err;
             }
+            continue;
+        }
 
-            size_t span = item.span;
+        assert(item.span > 0);
 
-            if (isVariableLengthType(item.datatype)) {
-                for (size_t j = i + 1; j < i + span; ++j) {
-                    if (mEntryTable.get(j) != EntryState::WRITTEN) {
-                        eraseEntryAndSpan(i);
-                        break;
-                    }
+        err = hashInsert(item, i);
+        if (err != NVS_OK) {
+            mState = PageState::INVALID;
+            return err;
+        }
+
+        size_t span = item.span;
+
+        if (isVariableLengthType(item.datatype)) {
+            for (size_t j = i + 1; j < i + span; ++j) {
+                if (mEntryTable.get(j) != EntryState::WRITTEN) {
+                    eraseEntryAndSpan(i);
+                    break;
                 }
             }
-
-            i += span - 1;
         }
 
+        i += span - 1;
     }
 
     return NVS_OK;
 }
 
-
 nvs_err_t Page::initialize()
 {
     assert(mState == PageState::UNINITIALIZED);
@@ -772,6 +887,11 @@ nvs_err_t Page::alterEntryState(size_t index, EntryState state)
     assert(index < ENTRY_COUNT);
     mEntryTable.set(index, state);
     size_t wordToWrite = mEntryTable.getWordIndex(index);
+    if (mHoldEntryStates) {
+        mDirtyWordBegin = std::min(mDirtyWordBegin, wordToWrite);
+        mDirtyWordEnd = std::max(mDirtyWordEnd, wordToWrite + 1);
+        return NVS_OK;
+    }
     uint32_t word = mEntryTable.data()[wordToWrite];
     auto rc = mPartition->write(mBaseAddress + ENTRY_TABLE_OFFSET + static_cast<uint32_t>(wordToWrite) * 4,
             &word, sizeof(word));
@@ -786,6 +906,14 @@ nvs_err_t Page::alterEntryRangeState(size_t begin, size_t end, EntryState state)
 {
     assert(end <= ENTRY_COUNT);
     assert(end > begin);
+    if (mHoldEntryStates) {
+        for (size_t i = begin; i < end; ++i) {
+            mEntryTable.set(i, state);
+        }
+        mDirtyWordBegin = std::min(mDirtyWordBegin, mEntryTable.getWordIndex(begin));
+        mDirtyWordEnd = std::max(mDirtyWordEnd, mEntryTable.getWordIndex(end - 1) + 1);
+        return NVS_OK;
+    }
     size_t wordIndex = mEntryTable.getWordIndex(end - 1);
     for (ptrdiff_t i = end - 1; i >= static_cast<ptrdiff_t>(begin); --i) {
         mEntryTable.set(i, state);
@@ -808,6 +936,27 @@ nvs_err_t Page::alterEntryRangeState(size_t begin, size_t end, EntryState state)
     return NVS_OK;
 }
 
+nvs_err_t Page::flushEntryStates()
+{
+    mHoldEntryStates = false;
+    if (mDirtyWordBegin >= mDirtyWordEnd) {
+        return NVS_OK;
+    }
+
+    size_t begin = mDirtyWordBegin;
+    size_t end = mDirtyWordEnd;
+    mDirtyWordBegin = SIZE_MAX;
+    mDirtyWordEnd = 0;
+
+    auto rc = mPartition->write(mBaseAddress + ENTRY_TABLE_OFFSET + static_cast<uint32_t>(begin) * 4,
+            mEntryTable.data() + begin, (end - begin) * 4);
+    if (rc != NVS_OK) {
+        mState = PageState::INVALID;
+        return rc;
+    }
+    return NVS_OK;
+}
+
 nvs_err_t Page::alterPageState(PageState state)
 {
     uint32_t state_val = static_cast<uint32_t>(state);
@@ -835,6 +984,11 @@ nvs_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
         return NVS_ERR_NVS_NOT_FOUND;
     }
 
+    auto rc = loadItems();
+    if (rc != NVS_OK) {
+        return rc;
+    }
+
     size_t findBeginIndex = itemIndex;
     if (findBeginIndex >= ENTRY_COUNT) {
         return NVS_ERR_NVS_NOT_FOUND;
@@ -886,47 +1040,88 @@ nvs_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
             next = i + item.span;
         }
 
-        if (nsIndex != NS_ANY && item.nsIndex != nsIndex) {
+        auto err = matchItem(item, nsIndex, datatype, key, chunkIdx, chunkStart);
+        if (err == NVS_ERR_NVS_NOT_FOUND) {
             continue;
         }
 
-        if (key != nullptr && strncmp(key, item.key, Item::MAX_KEY_LENGTH) != 0) {
-            continue;
-        }
-        /* For blob data, chunkIndex should match*/
-        if (chunkIdx != CHUNK_ANY
-                && datatype == ItemType::BLOB_DATA
-                && item.chunkIndex != chunkIdx) {
-            continue;
-        }
-        /* Blob-index will match the <ns,key> with blob data.
-         * Skip data chunks when searching for blob index*/
-        if (datatype == ItemType::BLOB_IDX
-                && item.chunkIndex != CHUNK_ANY) {
-            continue;
-        }
-        /* Match the version for blob-index*/
-        if (datatype == ItemType::BLOB_IDX
-                && chunkStart != VerOffset::VER_ANY
-                && item.blobIndex.chunkStart != chunkStart) {
-            continue;
-        }
+        itemIndex = i;
+
+        return err;
+    }
 
+    return NVS_ERR_NVS_NOT_FOUND;
+}
 
-        if (datatype != ItemType::ANY && item.datatype != datatype) {
-            if (key == nullptr && nsIndex == NS_ANY && chunkIdx == CHUNK_ANY) {
-                continue; // continue for bruteforce search on blob indices.
-            }
-            itemIndex = i;
-            return NVS_ERR_NVS_TYPE_MISMATCH;
+nvs_err_t Page::findItemAt(size_t itemIndex, uint8_t nsIndex, ItemType datatype, const char* key, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
+{
+    if (mState == PageState::CORRUPT || mState == PageState::INVALID || mState == PageState::UNINITIALIZED) {
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
+
+    auto rc = loadItems();
+    if (rc != NVS_OK) {
+        return rc;
+    }
+
+    if (itemIndex >= ENTRY_COUNT || mEntryTable.get(itemIndex) != EntryState::WRITTEN) {
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
+
+    rc = readEntry(itemIndex, item);
+    if (rc != NVS_OK) {
+        mState = PageState::INVALID;
+        return rc;
+    }
+
+    if (item.crc32 != item.calculateCrc32()) {
+        rc = eraseEntryAndSpan(itemIndex);
+        if (rc != NVS_OK) {
+            mState = PageState::INVALID;
+            return rc;
         }
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
 
-        itemIndex = i;
+    return matchItem(item, nsIndex, datatype, key, chunkIdx, chunkStart);
+}
 
-        return NVS_OK;
+nvs_err_t Page::matchItem(const Item& item, uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx, VerOffset chunkStart)
+{
+    if (nsIndex != NS_ANY && item.nsIndex != nsIndex) {
+        return NVS_ERR_NVS_NOT_FOUND;
     }
 
-    return NVS_ERR_NVS_NOT_FOUND;
+    if (key != nullptr && strncmp(key, item.key, Item::MAX_KEY_LENGTH) != 0) {
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
+    /* For blob data, chunkIndex should match*/
+    if (chunkIdx != CHUNK_ANY
+            && datatype == ItemType::BLOB_DATA
+            && item.chunkIndex != chunkIdx) {
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
+    /* Blob-index will match the <ns,key> with blob data.
+     * Skip data chunks when searching for blob index*/
+    if (datatype == ItemType::BLOB_IDX
+            && item.chunkIndex != CHUNK_ANY) {
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
+    /* Match the version for blob-index*/
+    if (datatype == ItemType::BLOB_IDX
+            && chunkStart != VerOffset::VER_ANY
+            && item.blobIndex.chunkStart != chunkStart) {
+        return NVS_ERR_NVS_NOT_FOUND;
+    }
+
+    if (datatype != ItemType::ANY && item.datatype != datatype) {
+        if (key == nullptr && nsIndex == NS_ANY && chunkIdx == CHUNK_ANY) {
+            return NVS_ERR_NVS_NOT_FOUND; // continue for bruteforce search on blob indices.
+        }
+        return NVS_ERR_NVS_TYPE_MISMATCH;
+    }
+
+    return NVS_OK;
 }
 
 nvs_err_t Page::getSeqNumber(uint32_t& seqNumber) const
@@ -969,6 +1164,21 @@ nvs_err_t Page::erase()
     mFirstUsedEntry = INVALID_ENTRY;
     mNextFreeEntry = INVALID_ENTRY;
     mState = PageState::UNINITIALIZED;
+    mBlankCheckPending = false;
+    mDuplicateItem = nullptr;
+    if (mItemsPending) {
+        mItemsPending = false;
+        if (mItemIndex) {
+            mItemIndex->removePendingPage();
+        }
+    }
+    if (mItemIndex) {
+        size_t itemCount = 0;
+        mHashList.forEach([&itemCount](uint32_t, size_t) {
+            ++itemCount;
+        });
+        mItemIndex->erase(this, itemCount);
+    }
     mHashList.clear();
     return NVS_OK;
 }
@@ -989,6 +1199,16 @@ nvs_err_t Page::markFull()
     return alterPageState(PageState::FULL);
 }
 
+size_t Page::getFreeEntryCount() const
+{
+    if (mState == PageState::UNINITIALIZED) {
+        return ENTRY_COUNT;
+    } else if (mState != PageState::ACTIVE || mNextFreeEntry >= ENTRY_COUNT) {
+        return 0;
+    }
+    return ENTRY_COUNT - mNextFreeEntry;
+}
+
 size_t Page::getVarDataTailroom() const
 {
     if (mState == PageState::UNINITIALIZED) {
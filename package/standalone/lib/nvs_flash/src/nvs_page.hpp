@@ -24,6 +24,7 @@
 #include "compressed_enum_table.hpp"
 #include "intrusive_list.h"
 #include "nvs_item_hash_list.hpp"
+#include "nvs_item_index.hpp"
 #include "partition.hpp"
 
 namespace nvs
@@ -56,6 +57,15 @@ public:
 
     static const uint8_t NVS_VERSION = 0xfd; // Decrement to upgrade
 
+    // Items of a batch are written between a begin and a commit marker, each further page
+    // of the batch starts with a continuation marker and the erased keys of the batch are
+    // recorded as tombstones. See Storage::writeBatch().
+    static const char BATCH_BEGIN_KEY[];
+    static const char BATCH_COMMIT_KEY[];
+    static const char BATCH_CONTINUE_KEY[];
+    static const ItemType BATCH_MARKER_TYPE = ItemType::U32;
+    static const ItemType BATCH_ERASE_TYPE = ItemType::U16;
+
     enum class PageState : uint32_t {
         // All bits set, default state after flash erase. Page has not been initialized yet.
         UNINITIALIZED = 0xffffffff,
@@ -85,7 +95,30 @@ public:
         return mState;
     }
 
-    nvs_err_t load(Partition *partition, uint32_t sectorNumber);
+    /**
+     * With lazy set, only the header and the entry state table of a full page are read here,
+     * its items are read by loadItems() on first access. The check that an uninitialized page
+     * is really empty is left to checkBlank().
+     */
+    nvs_err_t load(Partition *partition, uint32_t sectorNumber, ItemIndex *itemIndex = nullptr, bool lazy = false);
+
+    nvs_err_t loadItems();
+
+    /* Adds the items read so far to the item index, see ItemIndex::refresh() */
+    void indexItems();
+
+    bool isLoaded() const
+    {
+        return !mItemsPending;
+    }
+
+    nvs_err_t checkBlank();
+
+    /**
+     * Erase the older copy of an item left by a power loss, see PageManager::load().
+     * A page which isn't loaded yet erases it once it is.
+     */
+    nvs_err_t eraseDuplicate(const Item* item);
 
     nvs_err_t getSeqNumber(uint32_t& seqNumber) const;
 
@@ -105,6 +138,10 @@ public:
 
     nvs_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, size_t &itemIndex, Item& item, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    nvs_err_t findItemAt(size_t itemIndex, uint8_t nsIndex, ItemType datatype, const char* key, Item& item, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
+
+    nvs_err_t eraseItemAt(size_t itemIndex);
+
     template<typename T>
     nvs_err_t writeItem(uint8_t nsIndex, const char* key, const T& value)
     {
@@ -140,6 +177,19 @@ public:
     }
     size_t getVarDataTailroom() const ;
 
+    size_t getFreeEntryCount() const;
+
+    /**
+     * Keep entry state changes in RAM until flushEntryStates(), which programs
+     * all of them with one write to the entry state table.
+     */
+    void holdEntryStates()
+    {
+        mHoldEntryStates = true;
+    }
+
+    nvs_err_t flushEntryStates();
+
     nvs_err_t markFull();
 
     nvs_err_t markFreeing();
@@ -152,6 +202,11 @@ public:
 
     nvs_err_t calcEntries(nvs_stats_t &nvsStats);
 
+    static constexpr size_t getAlignmentForType(ItemType type)
+    {
+        return static_cast<uint8_t>(type) & 0x0f;
+    }
+
 protected:
 
     class Header
@@ -181,6 +236,8 @@ protected:
 
     nvs_err_t mLoadEntryTable();
 
+    nvs_err_t mLoadItems();
+
     nvs_err_t initialize();
 
     nvs_err_t alterEntryState(size_t index, EntryState state);
@@ -199,10 +256,11 @@ protected:
 
     void updateFirstUsedEntry(size_t index, size_t span);
 
-    static constexpr size_t getAlignmentForType(ItemType type)
-    {
-        return static_cast<uint8_t>(type) & 0x0f;
-    }
+    nvs_err_t hashInsert(const Item& item, size_t index);
+
+    void hashErase(const Item& item, size_t index);
+
+    static nvs_err_t matchItem(const Item& item, uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx, VerOffset chunkStart);
 
     uint32_t getEntryAddress(size_t entry) const
     {
@@ -224,12 +282,23 @@ protected:
     size_t mFirstUsedEntry = INVALID_ENTRY;
     uint16_t mUsedEntryCount = 0;
     uint16_t mErasedEntryCount = 0;
+    bool mHoldEntryStates = false;
+    bool mItemsPending = false;
+    bool mBlankCheckPending = false;
+    const Item* mDuplicateItem = nullptr;
+    size_t mDirtyWordBegin = SIZE_MAX;
+    size_t mDirtyWordEnd = 0;
 
     /**
      * This hash list stores hashes of namespace index, key, and ChunkIndex for quick lookup when searching items.
      */
     HashList mHashList;
 
+    /**
+     * Index of the items of all pages, shared with the other pages of the partition.
+     */
+    ItemIndex *mItemIndex = nullptr;
+
     Partition *mPartition;
 
     static const uint32_t HEADER_OFFSET = 0;
@@ -17,7 +17,7 @@ namespace nvs
 {
 static const char* TAG = "PageManager";
 
-nvs_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t sectorCount)
+nvs_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t sectorCount, size_t indexSize, bool lazy)
 {
     if (partition == nullptr) {
         return NVS_ERR_INVALID_ARG;
@@ -36,9 +36,11 @@ nvs_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
 		return NVS_ERR_NO_MEM;
 	}
 
+    mItemIndex.init(mPages.get(), sectorCount, indexSize);
+
     for (uint32_t i = 0; i < sectorCount; ++i) {
 		NVS_LOGD(TAG, "[%s] mPages[%d] loading...", __func__, i);
-        auto err = mPages[i].load(partition, baseSector + i);
+        auto err = mPages[i].load(partition, baseSector + i, &mItemIndex, lazy);
         if (err != NVS_OK) {
 			NVS_LOGD(TAG, "[%s] mPages[%d].load failed...", __func__, i);
             return err;
@@ -77,7 +79,16 @@ nvs_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
     }
 
     // if power went out after a new item for the given key was written,
-    // but before the old one was erased, we end up with a duplicate item
+    // but before the old one was erased, we end up with a duplicate item.
+    // Duplicates left by an unfinished batch are resolved by Storage::init().
+    bool batchPending = false;
+    for (auto it = TPageListIterator(&findBatchStart()); it != end(); ++it) {
+        if (it->findItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_BEGIN_KEY) == NVS_OK) {
+            batchPending = true;
+            break;
+        }
+    }
+
     Page& lastPage = back();
     size_t lastItemIndex = SIZE_MAX;
     Item item;
@@ -87,18 +98,28 @@ nvs_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
         lastItemIndex = itemIndex;
     }
 
-    if (lastItemIndex != SIZE_MAX) {
+    if (lastItemIndex != SIZE_MAX && !batchPending) {
         auto last = PageManager::TPageListIterator(&lastPage);
         TPageListIterator it;
 		NVS_LOGD(TAG, "[%s] lastItemIndex(%d) != SIZE_MAX(%d)", __func__, lastItemIndex, SIZE_MAX);
-        for (it = begin(); it != last; ++it) {
+        if (lazy) {
+            // pages which aren't loaded yet drop their copy once they are
+            mDuplicateItem = item;
+            for (it = begin(); it != last; ++it) {
+                if (it->state() != Page::PageState::FREEING) {
+                    it->eraseDuplicate(&mDuplicateItem);
+                }
+            }
+        } else {
+            for (it = begin(); it != last; ++it) {
 
-            if ((it->state() != Page::PageState::FREEING) &&
-                    (it->eraseItem(item.nsIndex, item.datatype, item.key, item.chunkIndex) == NVS_OK)) {
-                break;
+                if ((it->state() != Page::PageState::FREEING) &&
+                        (it->eraseItem(item.nsIndex, item.datatype, item.key, item.chunkIndex) == NVS_OK)) {
+                    break;
+                }
             }
         }
-        if ((it == last) && (item.datatype == ItemType::BLOB_IDX)) {
+        if (!lazy && (it == last) && (item.datatype == ItemType::BLOB_IDX)) {
             /* Rare case in which the blob was stored using old format, but power went just after writing
              * blob index during modification. Loop again and delete the old version blob*/
             for (it = begin(); it != last; ++it) {
@@ -164,6 +185,35 @@ nvs_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
 	return NVS_OK;
 }
 
+nvs_err_t PageManager::loadNextPage()
+{
+    for (auto it = begin(); it != end(); ++it) {
+        if (!it->isLoaded()) {
+            return it->loadItems();
+        }
+    }
+    return NVS_ERR_NVS_NOT_FOUND;
+}
+
+Page& PageManager::findBatchStart()
+{
+    // Pages added by a batch start with a continuation marker, so walk back from the
+    // last page until the begin marker or a page which isn't part of the batch. A page
+    // without items can be one the batch had just started to write to.
+    auto it = TPageListIterator(&back());
+    while (it != begin()) {
+        if (it->findItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_BEGIN_KEY) == NVS_OK) {
+            break;
+        }
+        if (it->getUsedEntryCount() != 0 &&
+                it->findItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_CONTINUE_KEY) != NVS_OK) {
+            break;
+        }
+        --it;
+    }
+    return *it;
+}
+
 nvs_err_t PageManager::requestNewPage()
 {
     if (mFreePageList.empty()) {
@@ -233,8 +283,12 @@ nvs_err_t PageManager::activatePage()
         return NVS_ERR_NVS_NOT_ENOUGH_SPACE;
     }
     Page* p = &mFreePageList.front();
+    auto err = p->checkBlank();
+    if (err != NVS_OK) {
+        return err;
+    }
     if (p->state() == Page::PageState::CORRUPT) {
-        auto err = p->erase();
+        err = p->erase();
         if (err != NVS_OK) {
             return err;
         }
@@ -31,7 +31,13 @@ public:
 
     PageManager() {}
 
-    nvs_err_t load(Partition *partition, uint32_t baseSector, uint32_t sectorCount);
+    nvs_err_t load(Partition *partition, uint32_t baseSector, uint32_t sectorCount, size_t indexSize = ItemIndex::DEFAULT_SIZE, bool lazy = false);
+
+    // Read the items of the oldest page which was loaded lazily, NVS_ERR_NVS_NOT_FOUND if none is left
+    nvs_err_t loadNextPage();
+
+    // First page an unfinished batch can have written to, see Storage::writeBatch()
+    Page& findBatchStart();
 
     TPageListIterator begin()
     {
@@ -52,6 +58,16 @@ public:
         return mPageCount;
     }
 
+    size_t getFreePageCount() const
+    {
+        return mFreePageList.size();
+    }
+
+    ItemIndex& getItemIndex()
+    {
+        return mItemIndex;
+    }
+
     nvs_err_t requestNewPage();
 
     nvs_err_t fillStats(nvs_stats_t& nvsStats);
@@ -69,9 +85,11 @@ protected:
     TPageList mPageList;
     TPageList mFreePageList;
     std::unique_ptr<Page[]> mPages;
+    ItemIndex mItemIndex;
     uint32_t mBaseSector;
     uint32_t mPageCount;
     uint32_t mSeqNumber;
+    Item mDuplicateItem;
 }; // class PageManager
 
 
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include "nvs_partition.hpp"
 
 namespace nvs {
@@ -24,6 +26,89 @@ NVSPartition::NVSPartition(uint32_t address, size_t size)
 	mSize = size;
 }
 
+NVSPartition::~NVSPartition()
+{
+	init_cache(0);
+}
+
+nvs_err_t NVSPartition::init_cache(size_t sectors)
+{
+	for (size_t i = 0; i < mCacheCount; i++) {
+		delete [] mCache[i].mData;
+	}
+	delete [] mCache;
+
+	mCache = nullptr;
+	mCacheCount = 0;
+	mCacheHits = 0;
+	mCacheMisses = 0;
+
+	if (sectors == 0) {
+		return NVS_OK;
+	}
+
+	mCache = new (std::nothrow) CacheSector[sectors];
+	if (mCache == nullptr) {
+		return NVS_ERR_NO_MEM;
+	}
+
+	for (size_t i = 0; i < sectors; i++) {
+		mCache[i].mOffset = UINT32_MAX;
+		mCache[i].mLastUse = 0;
+		mCache[i].mData = new (std::nothrow) uint8_t[CACHE_SECTOR_SIZE];
+		if (mCache[i].mData == nullptr) {
+			mCacheCount = i;
+			init_cache(0);
+			return NVS_ERR_NO_MEM;
+		}
+	}
+	mCacheCount = sectors;
+
+	return NVS_OK;
+}
+
+NVSPartition::CacheSector *NVSPartition::cache_lookup(uint32_t offset)
+{
+	CacheSector *victim = &mCache[0];
+
+	for (size_t i = 0; i < mCacheCount; i++) {
+		if (mCache[i].mOffset == offset) {
+			mCacheHits++;
+			mCache[i].mLastUse = ++mCacheClock;
+			return &mCache[i];
+		}
+
+		/* unused sectors have mLastUse 0 */
+		if (mCache[i].mLastUse < victim->mLastUse) {
+			victim = &mCache[i];
+		}
+	}
+
+	mCacheMisses++;
+	victim->mOffset = UINT32_MAX;
+	victim->mLastUse = 0;
+
+	NVS_LOGD(TAG, "[%s] nrc_sf_read caching addr = 0x%x...", __func__, mAddress + offset);
+	if (nrc_sf_read(mAddress + offset, victim->mData, CACHE_SECTOR_SIZE) != CACHE_SECTOR_SIZE) {
+		return nullptr;
+	}
+
+	victim->mOffset = offset;
+	victim->mLastUse = ++mCacheClock;
+	return victim;
+}
+
+void NVSPartition::cache_invalidate(size_t offset, size_t size)
+{
+	for (size_t i = 0; i < mCacheCount; i++) {
+		if (mCache[i].mOffset != UINT32_MAX &&
+				mCache[i].mOffset < offset + size && offset < mCache[i].mOffset + CACHE_SECTOR_SIZE) {
+			mCache[i].mOffset = UINT32_MAX;
+			mCache[i].mLastUse = 0;
+		}
+	}
+}
+
 const char *NVSPartition::get_partition_name()
 {
 	if (mAddress == SF_USER_CONFIG_1) {
@@ -37,6 +122,27 @@ nvs_err_t NVSPartition::read(size_t src_offset, void* dst, size_t size)
 {
 	uint32_t result = 0;
 
+	if (mCacheCount > 0) {
+		uint8_t *buf = (uint8_t *) dst;
+
+		while (size > 0) {
+			size_t offset = src_offset % CACHE_SECTOR_SIZE;
+			size_t len = std::min(size, CACHE_SECTOR_SIZE - offset);
+			CacheSector *sector = cache_lookup(src_offset - offset);
+
+			if (sector == nullptr) {
+				return NVS_FAIL;
+			}
+
+			memcpy(buf, sector->mData + offset, len);
+			buf += len;
+			src_offset += len;
+			size -= len;
+		}
+
+		return NVS_OK;
+	}
+
 	NVS_LOGD(TAG, "[%s] nrc_sf_read reading addr = 0x%x, size = %d...", __func__, mAddress + src_offset, size);
 	result = nrc_sf_read(mAddress + src_offset, (uint8_t *) dst, size);
 	NVS_LOGD(TAG, "[%s] nrc_sf_read returns = %d...", __func__, result);
@@ -55,6 +161,29 @@ nvs_err_t NVSPartition::write(size_t dst_offset, const void* src, size_t size)
 	result = nrc_sf_write(mAddress + dst_offset, (uint8_t *) src, size);
 	NVS_LOGD(TAG, "[%s] nrc_sf_read returns = %d...", __func__, result);
 
+	/* write through, programming can only clear bits */
+	for (size_t i = 0; i < mCacheCount; i++) {
+		CacheSector &sector = mCache[i];
+
+		if (sector.mOffset == UINT32_MAX ||
+				sector.mOffset >= dst_offset + size || dst_offset >= sector.mOffset + CACHE_SECTOR_SIZE) {
+			continue;
+		}
+
+		if (size != result) {
+			cache_invalidate(sector.mOffset, CACHE_SECTOR_SIZE);
+			continue;
+		}
+
+		size_t begin = std::max(dst_offset, (size_t) sector.mOffset);
+		size_t end = std::min(dst_offset + size, (size_t) sector.mOffset + CACHE_SECTOR_SIZE);
+		const uint8_t *data = (const uint8_t *) src + (begin - dst_offset);
+
+		for (size_t j = begin; j < end; j++) {
+			sector.mData[j - sector.mOffset] &= *data++;
+		}
+	}
+
 	if (size == result) {
 		return NVS_OK;
 	} else {
@@ -65,6 +194,7 @@ nvs_err_t NVSPartition::write(size_t dst_offset, const void* src, size_t size)
 nvs_err_t NVSPartition::erase_range(size_t dst_offset, size_t size)
 {
 	NVS_LOGD(TAG, "[%s] nrc_sf_erase erasing size = %d...", __func__, size);
+	cache_invalidate(dst_offset, size);
 	if (nrc_sf_erase(mAddress + dst_offset, size)) {
 		NVS_LOGD(TAG, "[%s] nrc_sf_erase ok...", __func__);
 		return NVS_OK;
@@ -84,4 +214,10 @@ uint32_t NVSPartition::get_size()
     return mSize;
 }
 
+void NVSPartition::get_cache_stats(size_t &hits, size_t &misses)
+{
+	hits = mCacheHits;
+	misses = mCacheMisses;
+}
+
 } // nvs
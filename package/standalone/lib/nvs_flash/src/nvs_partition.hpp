@@ -23,6 +23,11 @@
 
 #define PART_NAME_MAX_SIZE              16   /*!< maximum length of partition name (excluding null terminator) */
 
+/* Number of 4 KB flash sectors cached by the partitions nvs_flash_init() creates, 0 disables the cache. */
+#ifndef CONFIG_NVS_READ_CACHE_SECTORS
+#define CONFIG_NVS_READ_CACHE_SECTORS   0
+#endif
+
 namespace nvs {
 
 /**
@@ -41,7 +46,18 @@ public:
      */
     NVSPartition(uint32_t address, size_t size);
 
-    virtual ~NVSPartition() { }
+    virtual ~NVSPartition();
+
+    /**
+     * Allocate a read cache of the given number of flash sectors, replacing the current one.
+     * Reads are served from the least recently used set of whole sectors, write() and
+     * erase_range() keep it in sync with the flash.
+     *
+     * @return
+     *      - NVS_OK on success, also for 0 which disables the cache
+     *      - NVS_ERR_NO_MEM if the sectors could not be allocated
+     */
+    nvs_err_t init_cache(size_t sectors);
 
     const char *get_partition_name() override;
 
@@ -79,9 +95,29 @@ public:
      */
     uint32_t get_size() override;
 
+    void get_cache_stats(size_t &hits, size_t &misses) override;
+
+    static const size_t CACHE_SECTOR_SIZE = 0x1000;
+
 protected:
+    struct CacheSector {
+        uint32_t mOffset;       // partition offset of the sector, UINT32_MAX if unused
+        uint32_t mLastUse;
+        uint8_t *mData;
+    };
+
+    CacheSector *cache_lookup(uint32_t offset);
+
+    void cache_invalidate(size_t offset, size_t size);
+
 	uint32_t mAddress;
 	size_t mSize;
+
+    CacheSector *mCache = nullptr;
+    size_t mCacheCount = 0;
+    uint32_t mCacheClock = 0;
+    size_t mCacheHits = 0;
+    size_t mCacheMisses = 0;
 };
 
 } // nvs
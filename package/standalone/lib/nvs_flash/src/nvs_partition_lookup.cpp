@@ -1,4 +1,5 @@
 #include "nvs_partition_lookup.hpp"
+#include <cstring>
 
 #ifdef CONFIG_NVS_ENCRYPTION
 #include "nvs_encrypted_partition.hpp"
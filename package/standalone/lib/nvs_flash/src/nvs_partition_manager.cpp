@@ -58,6 +58,11 @@ nvs_err_t NVSPartitionManager::init_partition(const char *partition_label)
         goto error;
     }
 
+    result = p->init_cache(CONFIG_NVS_READ_CACHE_SECTORS);
+    if (result != NVS_OK) {
+        goto error;
+    }
+
     size = p->get_size();
 	NVS_LOGD(TAG, "[%s] calling init_custom...", __func__);
     result = init_custom(p, 0, size / SPI_FLASH_SEC_SIZE);
@@ -74,6 +79,37 @@ error:
     return result;
 }
 
+nvs_err_t NVSPartitionManager::init_custom(const char *partition_label, uint32_t baseSector, uint32_t sectorCount, size_t cacheSectors)
+{
+    if (strlen(partition_label) > NVS_PART_NAME_MAX_SIZE) {
+        return NVS_ERR_INVALID_ARG;
+    }
+
+    if (lookup_storage_from_name(partition_label)) {
+        return NVS_OK;
+    }
+
+    NVSPartition *p = nullptr;
+    nvs_err_t result = partition_lookup::lookup_nvs_partition(partition_label, &p);
+    if (result != NVS_OK) {
+        return result;
+    }
+
+    result = p->init_cache(cacheSectors);
+    if (result == NVS_OK) {
+        result = init_custom(p, baseSector, sectorCount);
+    }
+
+    if (result != NVS_OK) {
+        delete p;
+        return result;
+    }
+
+    nvs_partition_list.push_back(p);
+
+    return NVS_OK;
+}
+
 nvs_err_t NVSPartitionManager::init_custom(Partition *partition, uint32_t baseSector, uint32_t sectorCount)
 {
     Storage* new_storage = nullptr;
@@ -100,7 +136,7 @@ nvs_err_t NVSPartitionManager::init_custom(Partition *partition, uint32_t baseSe
         }
     }
 	NVS_LOGD(TAG, "[%s] Initialize storage by calling storage->init(%d, %d)...", __func__, baseSector, sectorCount);
-    nvs_err_t err = storage->init(baseSector, sectorCount);
+    nvs_err_t err = storage->init(baseSector, sectorCount, ItemIndex::DEFAULT_SIZE, fast_boot);
     if (new_storage != nullptr) {
         if (err == NVS_OK) {
 			NVS_LOGD(TAG, "[%s] Storage to list ...", __func__);
@@ -183,6 +219,22 @@ nvs_err_t NVSPartitionManager::deinit_partition(const char *partition_label)
     return NVS_OK;
 }
 
+nvs_err_t NVSPartitionManager::idle(bool& pending)
+{
+    pending = false;
+
+    for (auto it = nvs_storage_list.begin(); it != nvs_storage_list.end(); ++it) {
+        bool storagePending;
+        nvs_err_t err = it->idle(storagePending);
+        if (err != NVS_OK) {
+            return err;
+        }
+        pending = pending || storagePending;
+    }
+
+    return NVS_OK;
+}
+
 nvs_err_t NVSPartitionManager::open_handle(const char *part_name,
         const char *ns_name,
         nvs_open_mode_t open_mode,
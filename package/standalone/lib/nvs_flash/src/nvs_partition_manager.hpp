@@ -31,12 +31,21 @@ public:
 
     nvs_err_t init_custom(Partition *partition, uint32_t baseSector, uint32_t sectorCount);
 
+    nvs_err_t init_custom(const char *partition_label, uint32_t baseSector, uint32_t sectorCount, size_t cacheSectors);
+
 #ifdef CONFIG_NVS_ENCRYPTION
     nvs_err_t secure_init_partition(const char *part_name, nvs_sec_cfg_t* cfg);
 #endif
 
     nvs_err_t deinit_partition(const char *partition_label);
 
+    void set_fast_boot(bool enable)
+    {
+        fast_boot = enable;
+    }
+
+    nvs_err_t idle(bool& pending);
+
     Storage* lookup_storage_from_name(const char* name);
 
     nvs_err_t open_handle(const char *part_name, const char *ns_name, nvs_open_mode_t open_mode, NVSHandleSimple** handle);
@@ -55,6 +64,8 @@ protected:
     intrusive_list<nvs::Storage> nvs_storage_list;
 
     intrusive_list<nvs::NVSPartition> nvs_partition_list;
+
+    bool fast_boot = CONFIG_NVS_FAST_BOOT;
 };
 
 } // nvs
@@ -84,17 +84,31 @@ void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList)
     }
 }
 
-nvs_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
+nvs_err_t Storage::eraseOrphanBlobs()
 {
-	NVS_LOGD(TAG, "[%s] mPageManager.load(0x%x, %d, %d)", __func__, mPartition, baseSector, sectorCount);
-    auto err = mPageManager.load(mPartition, baseSector, sectorCount);
+    // Populate list of multi-page index entries.
+    TBlobIndexList blobIdxList;
+	NVS_LOGD(TAG, "[%s] populateBlobIndices...", __func__);
+    auto err = populateBlobIndices(blobIdxList);
     if (err != NVS_OK) {
-		NVS_LOGD(TAG, "[%s] error loading page...", __func__);
-        mState = StorageState::INVALID;
-        return err;
+		NVS_LOGD(TAG, "[%s] populateBlobIndices failed, no mem...", __func__);
+        blobIdxList.clearAndFreeNodes();
+        return NVS_ERR_NO_MEM;
     }
 
-    // load namespaces list
+    // Remove the entries for which there is no parent multi-page index.
+	NVS_LOGD(TAG, "[%s] erase Orphan Data Blobs...", __func__);
+	eraseOrphanDataBlobs(blobIdxList);
+	NVS_LOGD(TAG, "[%s] Purge the blob index list...", __func__);
+    // Purge the blob index list
+    blobIdxList.clearAndFreeNodes();
+
+    mOrphanBlobsPending = false;
+    return NVS_OK;
+}
+
+nvs_err_t Storage::loadNamespaces()
+{
 	NVS_LOGD(TAG, "[%s] load namespaces list...", __func__);
 	clearNamespaces();
     std::fill_n(mNamespaceUsage.data(), mNamespaceUsage.byteSize() / 4, 0);
@@ -106,50 +120,113 @@ nvs_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
 		p.getSeqNumber(seqNumber);
 		NVS_LOGD(TAG, "[%s] iterating pages seqNumber = %d...", __func__, seqNumber);
         while (p.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item) == NVS_OK) {
-            NamespaceEntry* entry = new (std::nothrow) NamespaceEntry;
-
-            if (!entry) {
-				NVS_LOGD(TAG, "[%s] entry %s...", __func__, entry->mName);
-                mState = StorageState::INVALID;
-				NVS_LOGD(TAG, "[%s] StorageState::INVALID, no memory...", __func__);
-                return NVS_ERR_NO_MEM;
+            auto err = addNamespace(item);
+            if (err != NVS_OK) {
+                return err;
             }
-
-            item.getKey(entry->mName, sizeof(entry->mName));
-            item.getValue(entry->mIndex);
-			NVS_LOGD(TAG, "[%s] name : %s, value index : %d", __func__, entry->mName, entry->mIndex);
-            mNamespaces.push_back(entry);
-            mNamespaceUsage.set(entry->mIndex, true);
             itemIndex += item.span;
         }
     }
     mNamespaceUsage.set(0, true);
     mNamespaceUsage.set(255, true);
+    mNamespacesPending = false;
+    return NVS_OK;
+}
+
+nvs_err_t Storage::addNamespace(Item& item)
+{
+    NamespaceEntry* entry = new (std::nothrow) NamespaceEntry;
+
+    if (!entry) {
+		NVS_LOGD(TAG, "[%s] NamespaceEntry allocation failed, no memory...", __func__);
+        return NVS_ERR_NO_MEM;
+    }
+
+    item.getKey(entry->mName, sizeof(entry->mName));
+    item.getValue(entry->mIndex);
+	NVS_LOGD(TAG, "[%s] name : %s, value index : %d", __func__, entry->mName, entry->mIndex);
+    mNamespaces.push_back(entry);
+    mNamespaceUsage.set(entry->mIndex, true);
+    return NVS_OK;
+}
+
+nvs_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount, size_t indexSize, bool fastBoot)
+{
+	NVS_LOGD(TAG, "[%s] mPageManager.load(0x%x, %d, %d)", __func__, mPartition, baseSector, sectorCount);
+    auto err = mPageManager.load(mPartition, baseSector, sectorCount, indexSize, fastBoot);
+    if (err != NVS_OK) {
+		NVS_LOGD(TAG, "[%s] error loading page...", __func__);
+        mState = StorageState::INVALID;
+        return err;
+    }
+
+    // apply or drop a batch interrupted by power loss
+    err = recoverBatch();
+    if (err != NVS_OK) {
+		NVS_LOGD(TAG, "[%s] error recovering batch...", __func__);
+        mState = StorageState::INVALID;
+        return err;
+    }
+
+    if (fastBoot) {
+        // namespaces are looked up on demand and orphan blob chunks are left to idle()
+        clearNamespaces();
+        std::fill_n(mNamespaceUsage.data(), mNamespaceUsage.byteSize() / 4, 0);
+        mNamespaceUsage.set(0, true);
+        mNamespaceUsage.set(255, true);
+        mNamespacesPending = true;
+        mOrphanBlobsPending = true;
+        mState = StorageState::ACTIVE;
+        return NVS_OK;
+    }
+
+    err = loadNamespaces();
+    if (err != NVS_OK) {
+        mState = StorageState::INVALID;
+		NVS_LOGD(TAG, "[%s] StorageState::INVALID, no memory...", __func__);
+        return err;
+    }
     mState = StorageState::ACTIVE;
 	NVS_LOGD(TAG, "[%s] StorageState::ACTIVE...", __func__);
-    // Populate list of multi-page index entries.
-    TBlobIndexList blobIdxList;
-	NVS_LOGD(TAG, "[%s] populateBlobIndices...", __func__);
-    err = populateBlobIndices(blobIdxList);
+
+    err = eraseOrphanBlobs();
     if (err != NVS_OK) {
-		NVS_LOGD(TAG, "[%s] populateBlobIndices failed, no mem...", __func__);
         mState = StorageState::INVALID;
-        return NVS_ERR_NO_MEM;
+        return err;
     }
 
-    // Remove the entries for which there is no parent multi-page index.
-	NVS_LOGD(TAG, "[%s] erase Orphan Data Blobs...", __func__);
-	eraseOrphanDataBlobs(blobIdxList);
-	NVS_LOGD(TAG, "[%s] Purge the blob index list...", __func__);
-    // Purge the blob index list
-    blobIdxList.clearAndFreeNodes();
-
 #ifdef DEBUG_STORAGE
     debugCheck();
 #endif
     return NVS_OK;
 }
 
+nvs_err_t Storage::idle(bool& pending)
+{
+    pending = false;
+    if (mState != StorageState::ACTIVE) {
+        return NVS_OK;
+    }
+
+    // one step per call, in the order the work is needed in
+    auto err = mPageManager.loadNextPage();
+    if (err != NVS_ERR_NVS_NOT_FOUND) {
+        pending = (err == NVS_OK);
+        return err;
+    }
+
+    if (mOrphanBlobsPending) {
+        err = eraseOrphanBlobs();
+        pending = (err == NVS_OK && mNamespacesPending);
+        return err;
+    }
+
+    if (mNamespacesPending) {
+        return loadNamespaces();
+    }
+    return NVS_OK;
+}
+
 bool Storage::isValid() const
 {
     return mState == StorageState::ACTIVE;
@@ -157,6 +234,29 @@ bool Storage::isValid() const
 
 nvs_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
 {
+    if (nsIndex != Page::NS_ANY && datatype != ItemType::ANY && key != nullptr) {
+        ItemIndex& index = mPageManager.getItemIndex();
+        const uint32_t hash = ItemIndex::hash(Item(nsIndex, datatype, 0, key, chunkIdx));
+
+        index.refresh();
+
+        uint16_t next;
+        for (uint16_t node = index.find(hash); node != ItemIndex::INVALID_NODE; node = next) {
+            Page* p = index.page(node);
+            size_t itemIndex = index.index(node);
+            // findItemAt() drops the node if the entry turns out to be corrupted
+            next = index.find(hash, node);
+            if (p->findItemAt(itemIndex, nsIndex, datatype, key, item, chunkIdx, chunkStart) == NVS_OK) {
+                page = p;
+                return NVS_OK;
+            }
+        }
+
+        if (index.isComplete()) {
+            return NVS_ERR_NVS_NOT_FOUND;
+        }
+    }
+
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         size_t itemIndex = 0;
         auto err = it->findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx, chunkStart);
@@ -176,6 +276,14 @@ nvs_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
     size_t offset = 0;
     nvs_err_t err = NVS_OK;
 
+    /* Chunks left by an interrupted write would be mistaken for the new ones */
+    if (mOrphanBlobsPending) {
+        err = eraseOrphanBlobs();
+        if (err != NVS_OK) {
+            return err;
+        }
+    }
+
     /* Check how much maximum data can be accommodated**/
     uint32_t max_pages = mPageManager.getPageCount() - 1;
 
@@ -397,6 +505,394 @@ nvs_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
     return NVS_OK;
 }
 
+/*
+ * A batch is written as
+ *
+ *   begin marker, items and erase tombstones, commit marker
+ *
+ * appended to the pages in order, while the items replaced or erased by the
+ * batch are left untouched until the commit marker is written. Only then the
+ * old items, the tombstones and the markers are erased. If power is lost
+ * before the commit marker, Storage::init() erases everything after the begin
+ * marker; if it is lost afterwards, init() finishes the erasures. Locating the
+ * batch by position relies on no page being freed while the begin marker
+ * exists, so reserveBatchPages() makes room for the whole batch up front.
+ * Each page the batch moves on to starts with a continuation marker, which
+ * lets PageManager::findBatchStart() find the batch without reading every page.
+ */
+nvs_err_t Storage::writeBatch(uint8_t nsIndex, TBatchItemList& items)
+{
+    if (mState != StorageState::ACTIVE) {
+        return NVS_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    // Like writeItem(), skip the values which are already stored
+    uint32_t count = 0;
+    for (auto it = items.begin(); it != items.end(); ++it) {
+        Page* findPage = nullptr;
+        Item item;
+
+        it->skip = (it->datatype != ItemType::ANY &&
+                findItem(nsIndex, it->datatype, it->key, findPage, item) == NVS_OK &&
+                findPage->cmpItem(nsIndex, it->datatype, it->key, it->data(), it->dataSize) == NVS_OK);
+        if (!it->skip) {
+            ++count;
+        }
+    }
+
+    if (count == 0) {
+        return NVS_OK;
+    }
+
+    auto err = reserveBatchPages(items);
+    if (err != NVS_OK) {
+        return err;
+    }
+
+    getCurrentPage().holdEntryStates();
+    err = appendBatchItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_BEGIN_KEY, &count, sizeof(count));
+
+    Page* beginPage = &getCurrentPage();
+    size_t beginIndex = 0;
+    if (err == NVS_OK) {
+        Item item;
+        err = beginPage->findItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_BEGIN_KEY, beginIndex, item);
+    }
+
+    for (auto it = items.begin(); it != items.end() && err == NVS_OK; ++it) {
+        if (it->skip) {
+            continue;
+        }
+        if (it->datatype == ItemType::ANY) {
+            uint16_t ns = nsIndex;
+            err = appendBatchItem(Page::NS_INDEX, Page::BATCH_ERASE_TYPE, it->key, &ns, sizeof(ns));
+        } else {
+            err = appendBatchItem(nsIndex, it->datatype, it->key, it->data(), it->dataSize);
+        }
+    }
+
+    nvs_err_t flushErr = getCurrentPage().flushEntryStates();
+    if (err == NVS_OK) {
+        err = flushErr;
+    }
+
+    // The state of the commit marker is the commit point, it is written on its own
+    if (err == NVS_OK) {
+        err = appendBatchItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_COMMIT_KEY, &count, sizeof(count));
+    }
+
+    if (err != NVS_OK) {
+        nvs_err_t rc = findBatchMarker(Page::BATCH_BEGIN_KEY, beginPage, beginIndex);
+        if (rc == NVS_OK) {
+            rc = rollbackBatch(beginPage, beginIndex);
+        } else if (rc == NVS_ERR_NVS_NOT_FOUND && getCurrentPage().state() != Page::PageState::INVALID) {
+            rc = NVS_OK;
+        }
+        if (rc != NVS_OK) {
+            // leave it to recoverBatch() on the next init
+            mState = StorageState::INVALID;
+        }
+        return err;
+    }
+
+    err = finishBatch(beginPage, beginIndex);
+    if (err != NVS_OK) {
+        // pages must not be freed before the batch is finished by recoverBatch()
+        mState = StorageState::INVALID;
+        return NVS_ERR_NVS_REMOVE_FAILED;
+    }
+
+#ifdef DEBUG_STORAGE
+    debugCheck();
+#endif
+    return NVS_OK;
+}
+
+nvs_err_t Storage::reserveBatchPages(TBatchItemList& items)
+{
+    auto countNewPages = [&]() -> size_t {
+        size_t freeEntries = getCurrentPage().getFreeEntryCount();
+        size_t newPages = 0;
+        auto add = [&](size_t span) {
+            if (span > freeEntries) {
+                ++newPages;
+                // continuation marker
+                freeEntries = Page::ENTRY_COUNT - 1;
+            }
+            freeEntries -= span;
+        };
+
+        add(1);
+        for (auto it = items.begin(); it != items.end(); ++it) {
+            if (it->skip) {
+                continue;
+            }
+            if (isVariableLengthType(it->datatype)) {
+                add(1 + (it->dataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE);
+            } else {
+                add(1);
+            }
+        }
+        add(1);
+        return newPages;
+    };
+
+    // Pages are taken from the free list without freeing any as long as
+    // two or more are left, so make sure that is the case for the whole batch
+    for (uint32_t i = 0; countNewPages() >= mPageManager.getFreePageCount(); ++i) {
+        if (i == mPageManager.getPageCount()) {
+            return NVS_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+
+        Page& page = getCurrentPage();
+        if (page.state() != Page::PageState::FULL) {
+            auto err = page.markFull();
+            if (err != NVS_OK) {
+                return err;
+            }
+        }
+        auto err = mPageManager.requestNewPage();
+        if (err != NVS_OK) {
+            return err;
+        }
+    }
+
+    return NVS_OK;
+}
+
+nvs_err_t Storage::appendBatchItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    Page& page = getCurrentPage();
+    auto err = page.writeItem(nsIndex, datatype, key, data, dataSize);
+    if (err != NVS_ERR_NVS_PAGE_FULL) {
+        return err;
+    }
+
+    err = page.flushEntryStates();
+    if (err != NVS_OK) {
+        return err;
+    }
+    if (page.state() != Page::PageState::FULL) {
+        err = page.markFull();
+        if (err != NVS_OK) {
+            return err;
+        }
+    }
+
+    // requestNewPage() would free a page otherwise
+    if (mPageManager.getFreePageCount() < 2) {
+        return NVS_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    err = mPageManager.requestNewPage();
+    if (err != NVS_OK) {
+        return err;
+    }
+
+    getCurrentPage().holdEntryStates();
+    uint32_t zero = 0;
+    err = getCurrentPage().writeItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_CONTINUE_KEY, &zero, sizeof(zero));
+    if (err == NVS_OK) {
+        err = getCurrentPage().writeItem(nsIndex, datatype, key, data, dataSize);
+    }
+    if (err == NVS_ERR_NVS_PAGE_FULL) {
+        return NVS_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    return err;
+}
+
+nvs_err_t Storage::findBatchMarker(const char* key, Page* &page, size_t& itemIndex)
+{
+    for (auto it = intrusive_list<Page>::iterator(&mPageManager.findBatchStart()); it != mPageManager.end(); ++it) {
+        Item item;
+        itemIndex = 0;
+        auto err = it->findItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, key, itemIndex, item);
+        if (err != NVS_ERR_NVS_NOT_FOUND) {
+            page = it;
+            return err;
+        }
+    }
+    return NVS_ERR_NVS_NOT_FOUND;
+}
+
+nvs_err_t Storage::eraseItemsBefore(Page* beginPage, size_t beginIndex, uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx)
+{
+    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
+        size_t itemIndex = 0;
+        Item item;
+        nvs_err_t err;
+        while ((err = it->findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx)) == NVS_OK) {
+            if (static_cast<Page*>(it) == beginPage && itemIndex >= beginIndex) {
+                break;
+            }
+            err = it->eraseItemAt(itemIndex);
+            if (err != NVS_OK) {
+                return err;
+            }
+            itemIndex += item.span;
+        }
+        if (err != NVS_OK && err != NVS_ERR_NVS_NOT_FOUND) {
+            return err;
+        }
+        if (static_cast<Page*>(it) == beginPage) {
+            break;
+        }
+    }
+    return NVS_OK;
+}
+
+nvs_err_t Storage::rollbackBatch(Page* beginPage, size_t beginIndex)
+{
+    size_t itemIndex = beginIndex + 1;
+    for (auto it = intrusive_list<Page>::iterator(beginPage); it != mPageManager.end(); ++it) {
+        Item item;
+        nvs_err_t err;
+        // a page which failed to write may hold items of the batch which can't be found
+        if (it->state() == Page::PageState::INVALID) {
+            return NVS_ERR_NVS_INVALID_STATE;
+        }
+        while ((err = it->findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item)) == NVS_OK) {
+            // continuation markers go last, findBatchStart() relies on them
+            if (item.nsIndex != Page::NS_INDEX || item.datatype != Page::BATCH_MARKER_TYPE ||
+                    strncmp(item.key, Page::BATCH_CONTINUE_KEY, sizeof(item.key)) != 0) {
+                err = it->eraseItemAt(itemIndex);
+                if (err != NVS_OK) {
+                    return err;
+                }
+            }
+            itemIndex += item.span;
+        }
+        if (err != NVS_ERR_NVS_NOT_FOUND) {
+            return err;
+        }
+        itemIndex = 0;
+    }
+
+    auto err = beginPage->eraseItemAt(beginIndex);
+    if (err != NVS_OK) {
+        return err;
+    }
+    return eraseBatchContinuations(beginPage);
+}
+
+nvs_err_t Storage::finishBatch(Page* beginPage, size_t beginIndex)
+{
+    const auto batchPages = intrusive_list<Page>::iterator(beginPage);
+    nvs_err_t err = NVS_OK;
+
+    // Erase what the batch replaces, then the tombstones, then the markers.
+    // Every step is repeated by recoverBatch() if power is lost before the next.
+    for (int step = 0; step < 2 && err == NVS_OK; ++step) {
+        for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
+            it->holdEntryStates();
+        }
+
+        size_t itemIndex = beginIndex + 1;
+        for (auto it = batchPages; it != mPageManager.end() && err == NVS_OK; ++it) {
+            Item item;
+            while ((err = it->findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item)) == NVS_OK) {
+                if (item.nsIndex != Page::NS_INDEX) {
+                    if (step == 0) {
+                        err = eraseItemsBefore(beginPage, beginIndex, item.nsIndex, item.datatype, item.key, item.chunkIndex);
+                    }
+                } else if (item.datatype == Page::BATCH_ERASE_TYPE) {
+                    if (step == 0) {
+                        uint16_t ns;
+                        item.getValue(ns);
+                        err = eraseItemsBefore(beginPage, beginIndex, ns, ItemType::ANY, item.key, Page::CHUNK_ANY);
+                    } else {
+                        err = it->eraseItemAt(itemIndex);
+                    }
+                }
+                if (err != NVS_OK) {
+                    break;
+                }
+                itemIndex += item.span;
+            }
+            if (err == NVS_ERR_NVS_NOT_FOUND) {
+                err = NVS_OK;
+            }
+            itemIndex = 0;
+        }
+
+        for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
+            nvs_err_t flushErr = it->flushEntryStates();
+            if (err == NVS_OK) {
+                err = flushErr;
+            }
+        }
+    }
+
+    if (err != NVS_OK) {
+        return err;
+    }
+
+    Page* commitPage;
+    size_t commitIndex;
+    err = findBatchMarker(Page::BATCH_COMMIT_KEY, commitPage, commitIndex);
+    if (err != NVS_OK) {
+        return err;
+    }
+
+    // the begin marker must go first, on its own
+    err = beginPage->eraseItemAt(beginIndex);
+    if (err != NVS_OK) {
+        return err;
+    }
+    err = commitPage->eraseItemAt(commitIndex);
+    if (err != NVS_OK) {
+        return err;
+    }
+    return eraseBatchContinuations(beginPage);
+}
+
+nvs_err_t Storage::eraseBatchContinuations(Page* firstPage)
+{
+    for (auto it = intrusive_list<Page>::iterator(firstPage); it != mPageManager.end(); ++it) {
+        auto err = it->eraseItem(Page::NS_INDEX, Page::BATCH_MARKER_TYPE, Page::BATCH_CONTINUE_KEY);
+        if (err != NVS_OK && err != NVS_ERR_NVS_NOT_FOUND) {
+            return err;
+        }
+    }
+    return NVS_OK;
+}
+
+nvs_err_t Storage::recoverBatch()
+{
+    Page* beginPage;
+    Page* commitPage;
+    size_t beginIndex;
+    size_t commitIndex;
+
+    auto err = findBatchMarker(Page::BATCH_BEGIN_KEY, beginPage, beginIndex);
+    if (err != NVS_OK && err != NVS_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+    bool begun = (err == NVS_OK);
+
+    err = findBatchMarker(Page::BATCH_COMMIT_KEY, commitPage, commitIndex);
+    if (err != NVS_OK && err != NVS_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+    bool committed = (err == NVS_OK);
+
+    if (!begun) {
+        // power went out after the begin marker was erased
+        if (committed) {
+            err = commitPage->eraseItemAt(commitIndex);
+            if (err != NVS_OK) {
+                return err;
+            }
+        }
+        return eraseBatchContinuations(&mPageManager.findBatchStart());
+    }
+
+    NVS_LOGD(TAG, "[%s] %s unfinished batch", __func__, committed ? "finishing" : "dropping");
+    if (!committed) {
+        return rollbackBatch(beginPage, beginIndex);
+    }
+    return finishBatch(beginPage, beginIndex);
+}
+
 nvs_err_t Storage::createOrOpenNamespace(const char* nsName, bool canCreate, uint8_t& nsIndex)
 {
     if (mState != StorageState::ACTIVE) {
@@ -408,6 +904,27 @@ nvs_err_t Storage::createOrOpenNamespace(const char* nsName, bool canCreate, uin
         NVS_LOGD(TAG, "[%s] nsName : %s, e.mName : %s", __func__, nsName, e.mName);
         return strncmp(nsName, e.mName, sizeof(e.mName) - 1) == 0;
     });
+    if (it == std::end(mNamespaces) && mNamespacesPending) {
+        // look the namespace up like any item, instead of reading the entries of every page
+        Page* findPage;
+        Item item;
+        auto err = findItem(Page::NS_INDEX, ItemType::U8, nsName, findPage, item);
+        if (err == NVS_OK) {
+            err = addNamespace(item);
+            if (err != NVS_OK) {
+                return err;
+            }
+            it = TNamespaces::iterator(&mNamespaces.back());
+        } else if (err != NVS_ERR_NVS_NOT_FOUND) {
+            return err;
+        } else if (canCreate) {
+            // a new namespace needs an index none of the others uses
+            err = loadNamespaces();
+            if (err != NVS_OK) {
+                return err;
+            }
+        }
+    }
     if (it == std::end(mNamespaces)) {
 		NVS_LOGD(TAG, "[%s] %s doesn't exist in mNamespaces", __func__, nsName);
         if (!canCreate) {
@@ -555,6 +1072,17 @@ nvs_err_t Storage::readItem(uint8_t nsIndex, ItemType datatype, const char* key,
     if (err != NVS_OK) {
         return err;
     }
+
+    if (!isVariableLengthType(datatype)) {
+        // the value is held by the entry findItem() has just read
+        if (dataSize != Page::getAlignmentForType(datatype)) {
+            return NVS_ERR_NVS_TYPE_MISMATCH;
+        }
+
+        memcpy(data, item.data, dataSize);
+        return NVS_OK;
+    }
+
     return findPage->readItem(nsIndex, datatype, key, data, dataSize);
 
 }
@@ -710,7 +1238,14 @@ void Storage::debugCheck()
 
 nvs_err_t Storage::fillStats(nvs_stats_t& nvsStats)
 {
+    if (mNamespacesPending) {
+        auto err = loadNamespaces();
+        if (err != NVS_OK) {
+            return err;
+        }
+    }
     nvsStats.namespace_count = mNamespaces.size();
+    mPartition->get_cache_stats(nvsStats.cache_hits, nvsStats.cache_misses);
     return mPageManager.fillStats(nvsStats);
 }
 
@@ -760,6 +1295,11 @@ bool Storage::findEntry(nvs_opaque_iterator_t* it, const char* namespace_name)
     it->nsIndex = Page::NS_ANY;
     it->page = mPageManager.begin();
 
+    // entries are reported with the name of their namespace
+    if (mNamespacesPending && loadNamespaces() != NVS_OK) {
+        return false;
+    }
+
     if (namespace_name != nullptr) {
         if(createOrOpenNamespace(namespace_name, false, it->nsIndex) != NVS_OK) {
             return false;
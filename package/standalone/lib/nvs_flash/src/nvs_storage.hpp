@@ -24,6 +24,11 @@
 
 //extern void dumpBytes(const uint8_t* data, size_t count);
 
+/* Initialize with only the page headers read, see Storage::init(). Selected at run time by nvs_flash_set_fast_boot(). */
+#ifndef CONFIG_NVS_FAST_BOOT
+#define CONFIG_NVS_FAST_BOOT 0
+#endif
+
 namespace nvs
 {
 
@@ -59,6 +64,33 @@ class Storage : public intrusive_list_node<Storage>
     typedef intrusive_list<BlobIndexNode> TBlobIndexList;
 
 public:
+    /**
+     * A set or an erase staged in a batch, see writeBatch().
+     */
+    struct BatchItem : public intrusive_list_node<BatchItem> {
+        public:
+            BatchItem() : datatype(ItemType::ANY), dataSize(0), str(nullptr), skip(false) { }
+
+            ~BatchItem()
+            {
+                delete[] str;
+            }
+
+            const void* data() const
+            {
+                return str ? static_cast<const void*>(str) : static_cast<const void*>(value);
+            }
+
+            ItemType datatype; // ItemType::ANY erases the key
+            char key[Item::MAX_KEY_LENGTH + 1];
+            uint8_t value[sizeof(uint64_t)];
+            size_t dataSize;
+            char* str;
+            bool skip;
+    };
+
+    typedef intrusive_list<BatchItem> TBatchItemList;
+
     ~Storage();
 
     Storage(Partition *partition) : mPartition(partition) {
@@ -67,7 +99,14 @@ public:
         }
     };
 
-    nvs_err_t init(uint32_t baseSector, uint32_t sectorCount);
+    /**
+     * With fastBoot set, only the page headers are read here. The items of a page are read on
+     * first access, namespaces are looked up on demand and orphan blob chunks are left to idle().
+     */
+    nvs_err_t init(uint32_t baseSector, uint32_t sectorCount, size_t indexSize = ItemIndex::DEFAULT_SIZE, bool fastBoot = false);
+
+    // Do one step of the work left by a fast boot init(), pending tells if any is left
+    nvs_err_t idle(bool& pending);
 
     bool isValid() const;
 
@@ -100,6 +139,8 @@ public:
 
     nvs_err_t eraseNamespace(uint8_t nsIndex);
 
+    nvs_err_t writeBatch(uint8_t nsIndex, TBatchItemList& items);
+
     const Partition *getPart() const
     {
         return mPartition;
@@ -125,6 +166,11 @@ public:
         return mPageManager.getBaseSector();
     }
 
+    const ItemIndex& getItemIndex()
+    {
+        return mPageManager.getItemIndex();
+    }
+
     nvs_err_t writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart);
 
     nvs_err_t readMultiPageBlob(uint8_t nsIndex, const char* key, void* data, size_t dataSize);
@@ -158,10 +204,32 @@ protected:
 
     void eraseOrphanDataBlobs(TBlobIndexList&);
 
+    nvs_err_t eraseOrphanBlobs();
+
+    nvs_err_t loadNamespaces();
+
+    nvs_err_t addNamespace(Item& item);
+
     void fillEntryInfo(Item &item, nvs_entry_info_t &info);
 
     nvs_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    nvs_err_t reserveBatchPages(TBatchItemList& items);
+
+    nvs_err_t appendBatchItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    nvs_err_t findBatchMarker(const char* key, Page* &page, size_t& itemIndex);
+
+    nvs_err_t eraseItemsBefore(Page* beginPage, size_t beginIndex, uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx);
+
+    nvs_err_t rollbackBatch(Page* beginPage, size_t beginIndex);
+
+    nvs_err_t finishBatch(Page* beginPage, size_t beginIndex);
+
+    nvs_err_t eraseBatchContinuations(Page* firstPage);
+
+    nvs_err_t recoverBatch();
+
 protected:
     Partition *mPartition;
     size_t mPageCount;
@@ -169,6 +237,8 @@ protected:
     TNamespaces mNamespaces;
     CompressedEnumTable<bool, 1, 256> mNamespaceUsage;
     StorageState mState = StorageState::INVALID;
+    bool mNamespacesPending = false;
+    bool mOrphanBlobsPending = false;
 };
 
 } // namespace nvs
@@ -20,19 +20,6 @@ extern "C" {
 
 #include "nvs_flash.h"
 
-/**
- * @brief Initialize NVS flash storage with custom flash sector layout
- *
- * @note  This API is intended to be used in unit tests.
- *
- * @param partName Partition name of the NVS partition as per partition table
- * @param baseSector Flash sector (units of 4096 bytes) offset to start NVS
- * @param sectorCount Length (in flash sectors) of NVS region.
- 					  NVS partition must be at least 3 sectors long.
- * @return NVS_OK if flash was successfully initialized
- */
-nvs_err_t nvs_flash_init_custom(const char *partName, uint32_t baseSector, uint32_t sectorCount);
-
 #ifdef CONFIG_NVS_ENCRYPTION
 /**
  * @brief Initialize NVS flash storage with custom flash sector layout
@@ -31,13 +31,17 @@ uint32_t Item::calculateCrc32() const
 
 uint32_t Item::calculateCrc32WithoutValue() const
 {
-    uint32_t result = 0xffffffff;
+    // util_crc_compute_crc32() can't continue a previous crc, so the fields are hashed from
+    // one buffer. Only used for the in-memory hash lists, nothing of it is stored on flash.
+    uint8_t buf[offsetof(Item, datatype) - offsetof(Item, nsIndex) + sizeof(key) + sizeof(chunkIndex)];
     const uint8_t* p = reinterpret_cast<const uint8_t*>(this);
-    result = util_crc_compute_crc32((uint8_t *) (p + offsetof(Item, nsIndex)),
-                      offsetof(Item, datatype) - offsetof(Item, nsIndex));
-    result = util_crc_compute_crc32((uint8_t *) (p + offsetof(Item, key)), sizeof(key));
-    result = util_crc_compute_crc32((uint8_t *) (p + offsetof(Item, chunkIndex)), sizeof(chunkIndex));
-    return result;
+    uint8_t* dst = buf;
+    memcpy(dst, p + offsetof(Item, nsIndex), offsetof(Item, datatype) - offsetof(Item, nsIndex));
+    dst += offsetof(Item, datatype) - offsetof(Item, nsIndex);
+    memcpy(dst, p + offsetof(Item, key), sizeof(key));
+    dst += sizeof(key);
+    memcpy(dst, p + offsetof(Item, chunkIndex), sizeof(chunkIndex));
+    return util_crc_compute_crc32(buf, sizeof(buf));
 }
 
 uint32_t Item::calculateCrc32(const uint8_t* data, size_t size)
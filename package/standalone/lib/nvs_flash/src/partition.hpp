@@ -48,6 +48,15 @@ public:
      * Return the partition size in bytes.
      */
     virtual uint32_t get_size() = 0;
+
+    /**
+     * Return the read cache hit and miss counts, both 0 if the partition has no cache.
+     */
+    virtual void get_cache_stats(size_t &hits, size_t &misses)
+    {
+        hits = 0;
+        misses = 0;
+    }
 };
 
 } // nvs
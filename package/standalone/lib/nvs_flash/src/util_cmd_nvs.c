@@ -30,6 +30,8 @@ static void nvs_cli_info()
 		system_printf("free entries    : %d\n", nvs_stats.free_entries);
 		system_printf("total entries   : %d\n", nvs_stats.total_entries);
 		system_printf("namespace count : %d\n", nvs_stats.namespace_count);
+		system_printf("cache hits      : %d\n", nvs_stats.cache_hits);
+		system_printf("cache misses    : %d\n", nvs_stats.cache_misses);
 		system_printf("=======================\n");
 	}
 }
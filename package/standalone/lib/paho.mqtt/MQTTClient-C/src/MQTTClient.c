@@ -27,8 +27,24 @@ static void NewMessageData(MessageData* md, MQTTString* aTopicName, MQTTMessage*
 }
 
 
+static struct InflightMessages* findInflight(MQTTClient* c, unsigned short id)
+{
+    int i;
+
+    for (i = 0; i < MAX_INFLIGHT_MESSAGES && id != 0; ++i) // 0 marks a free slot
+    {
+        if (c->inflight[i].id == id)
+            return &c->inflight[i];
+    }
+    return NULL;
+}
+
+
 static int getNextPacketId(MQTTClient *c) {
-    return c->next_packetid = (c->next_packetid == MAX_PACKET_ID) ? 1 : c->next_packetid + 1;
+    do
+        c->next_packetid = (c->next_packetid == MAX_PACKET_ID) ? 1 : c->next_packetid + 1;
+    while (findInflight(c, c->next_packetid) != NULL); // still awaiting its acks
+    return c->next_packetid;
 }
 
 static int sendPacket(MQTTClient* c, int length, Timer* timer)
@@ -37,11 +53,11 @@ static int sendPacket(MQTTClient* c, int length, Timer* timer)
 #if defined(INCLUDE_MQTT_FAST_CONN)
 	while (sent < length)
 	{
-		rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, 0);
+		rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length - sent, 0);
 #else
 	while (sent < length && !TimerIsExpired(timer))
 	{
-		rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, TimerLeftMS(timer));
+		rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length - sent, TimerLeftMS(timer));
 #endif /* defined(INCLUDE_MQTT_FAST_CONN) */
 		if (rc < 0){  // there was an error writing the data
 			system_printf("%s sendPacket loop error %d %d %d\n", __func__, rc, sent, length);
@@ -61,14 +77,91 @@ static int sendPacket(MQTTClient* c, int length, Timer* timer)
 }
 
 
+/* send an in-flight publish, or its PUBREL once the PUBREC arrived, and restart its retry timer */
+static int sendInflight(MQTTClient* c, struct InflightMessages* m, unsigned char dup, Timer* timer)
+{
+    MQTTString topic = MQTTString_initializer;
+    int len = 0;
+
+    topic.cstring = (char*)m->topicName;
+    if (m->pubrel)
+        len = MQTTSerialize_ack(c->buf, c->buf_size, PUBREL, 0, m->id);
+    else
+        len = MQTTSerialize_publish(c->buf, c->buf_size, dup, m->qos, m->retained, m->id,
+              topic, (unsigned char*)m->payload, m->payloadlen);
+    if (len <= 0)
+        return FAILURE;
+
+    TimerCountdownMS(&m->retry, c->command_timeout_ms);
+    return sendPacket(c, len, timer);
+}
+
+
+static void completeInflight(MQTTClient* c, struct InflightMessages* m, int rc)
+{
+    unsigned short id = m->id;
+
+    m->id = 0; // free the slot first, the handler sees the window it leaves
+    if (m->fp != NULL)
+        m->fp(m->context, id, rc);
+}
+
+
+static void ackInflight(MQTTClient* c, int packet_type)
+{
+    struct InflightMessages* m;
+    unsigned short mypacketid;
+    unsigned char dup, type;
+
+    if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
+        return;
+
+    if ((m = findInflight(c, mypacketid)) == NULL)
+        return; // not sent by MQTTPublishAsync
+
+    if (packet_type == PUBREC && m->qos == QOS2)
+    {
+        m->pubrel = 1; // cycle() has sent the PUBREL
+        TimerCountdownMS(&m->retry, c->command_timeout_ms);
+    }
+    else if ((packet_type == PUBACK && m->qos == QOS1) || (packet_type == PUBCOMP && m->pubrel))
+        completeInflight(c, m, SUCCESS);
+}
+
+
+static int retryInflight(MQTTClient* c)
+{
+    int i;
+
+    for (i = 0; i < MAX_INFLIGHT_MESSAGES; ++i)
+    {
+        struct InflightMessages* m = &c->inflight[i];
+
+        if (m->id == 0 || !TimerIsExpired(&m->retry))
+            continue;
+
+        if (m->retries++ >= MAX_PUBLISH_RETRIES)
+            completeInflight(c, m, FAILURE);
+        else
+        {
+            Timer timer;
+            TimerInit(&timer);
+            TimerCountdownMS(&timer, 1000);
+            if (sendInflight(c, m, 1, &timer) != SUCCESS)
+                return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+
 void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeout_ms,
 		unsigned char* sendbuf, size_t sendbuf_size, unsigned char* readbuf, size_t readbuf_size)
 {
     int i;
     c->ipstack = network;
 
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-        c->messageHandlers[i].topicFilter = 0;
+    MQTTTopicTrie_init(&c->messageHandlers);
     c->command_timeout_ms = command_timeout_ms;
     c->buf = sendbuf;
     c->buf_size = sendbuf_size;
@@ -78,6 +171,9 @@ void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeou
     c->cleansession = 0;
     c->ping_outstanding = 0;
     c->defaultMessageHandler = NULL;
+    for (i = 0; i < MAX_INFLIGHT_MESSAGES; ++i)
+        c->inflight[i].id = 0;
+    c->inflight_window = MAX_INFLIGHT_MESSAGES;
     c->next_packetid = 1;
     TimerInit(&c->last_sent);
     TimerInit(&c->last_received);
@@ -101,12 +197,15 @@ static int decodePacket(MQTTClient* c, int* value, int timeout)
 
         if (++len > MAX_NO_OF_REMAINING_LENGTH_BYTES)
         {
-            rc = MQTTPACKET_READ_ERROR; /* bad data */
+            len = MQTTPACKET_READ_ERROR; /* bad data */
             goto exit;
         }
         rc = c->ipstack->mqttread(c->ipstack, &i, 1, timeout);
         if (rc != 1)
+        {
+            len = MQTTPACKET_READ_ERROR;
             goto exit;
+        }
         *value += (i & 127) * multiplier;
         multiplier *= 128;
     } while ((i & 128) != 0);
@@ -120,15 +219,26 @@ static int readPacket(MQTTClient* c, Timer* timer)
     MQTTHeader header = {0};
     int len = 0;
     int rem_len = 0;
+    int rest_ms = 0;
 
     /* 1. read the header byte.  This has the packet type in it */
     int rc = c->ipstack->mqttread(c->ipstack, c->readbuf, 1, TimerLeftMS(timer));
     if (rc != 1)
         goto exit;
 
+    /* the rest of the packet is on its way, wait for it even if the timer was only a poll */
+    rest_ms = TimerLeftMS(timer);
+    if (rest_ms < MQTT_NETWORK_REST_TIMEOUT_MS)
+        rest_ms = MQTT_NETWORK_REST_TIMEOUT_MS;
+
+    /* once the header byte is taken, a short read leaves the stream out of sync */
     len = 1;
     /* 2. read the remaining length.  This is variable in itself */
-    decodePacket(c, &rem_len, TimerLeftMS(timer));
+    if (decodePacket(c, &rem_len, rest_ms) < 0)
+    {
+        rc = FAILURE;
+        goto exit;
+    }
     len += MQTTPacket_encode(c->readbuf + 1, rem_len); /* put the original remaining length back into the buffer */
 
     if (rem_len > (c->readbuf_size - len))
@@ -138,8 +248,8 @@ static int readPacket(MQTTClient* c, Timer* timer)
     }
 
     /* 3. read the rest of the buffer using a callback to supply the rest of the data */
-    if (rem_len > 0 && (rc = c->ipstack->mqttread(c->ipstack, c->readbuf + len, rem_len, TimerLeftMS(timer)) != rem_len)) {
-        rc = 0;
+    if (rem_len > 0 && c->ipstack->mqttread(c->ipstack, c->readbuf + len, rem_len, rest_ms) != rem_len) {
+        rc = FAILURE;
         goto exit;
     }
 
@@ -152,62 +262,18 @@ exit:
 }
 
 
-// assume topic filter and name is in correct format
-// # can only be at end
-// + and # can only be next to separator
-static char isTopicMatched(char* topicFilter, MQTTString* topicName)
-{
-    char* curf = topicFilter;
-    char* curn = topicName->lenstring.data;
-    char* curn_end = curn + topicName->lenstring.len;
-
-    while (*curf && curn < curn_end)
-    {
-        if (*curn == '/' && *curf != '/')
-            break;
-        if (*curf != '+' && *curf != '#' && *curf != *curn)
-            break;
-        if (*curf == '+')
-        {   // skip until we meet the next separator, or end of string
-            char* nextpos = curn + 1;
-            while (nextpos < curn_end && *nextpos != '/')
-                nextpos = ++curn + 1;
-        }
-        else if (*curf == '#')
-            curn = curn_end - 1;    // skip until end of string
-        curf++;
-        curn++;
-    };
-
-    return (curn == curn_end) && (*curf == '\0');
-}
-
-
 int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
 {
-    int i;
     int rc = FAILURE;
+    MessageData md;
 
-    // we have to find the right message handler - indexed by topic
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-    {
-        if (c->messageHandlers[i].topicFilter != 0 && (MQTTPacket_equals(topicName, (char*)c->messageHandlers[i].topicFilter) ||
-                isTopicMatched((char*)c->messageHandlers[i].topicFilter, topicName)))
-        {
-            if (c->messageHandlers[i].fp != NULL)
-            {
-                MessageData md;
-                NewMessageData(&md, topicName, message);
-                c->messageHandlers[i].fp(&md);
-                rc = SUCCESS;
-            }
-        }
-    }
+    NewMessageData(&md, topicName, message);
 
-    if (rc == FAILURE && c->defaultMessageHandler != NULL)
+    // we have to find the right message handlers - indexed by topic
+    if (MQTTTopicTrie_deliver(&c->messageHandlers, topicName, &md) > 0)
+        rc = SUCCESS;
+    else if (c->defaultMessageHandler != NULL)
     {
-        MessageData md;
-        NewMessageData(&md, topicName, message);
         c->defaultMessageHandler(&md);
         rc = SUCCESS;
     }
@@ -245,15 +311,20 @@ exit:
 
 void MQTTCleanSession(MQTTClient* c)
 {
-    int i = 0;
-
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-        c->messageHandlers[i].topicFilter = NULL;
+    MQTTTopicTrie_clear(&c->messageHandlers);
 }
 
 
 void MQTTCloseSession(MQTTClient* c)
 {
+    int i;
+
+    /* publishes in flight are not sent again after a reconnect, they fail */
+    for (i = 0; i < MAX_INFLIGHT_MESSAGES; ++i)
+    {
+        if (c->inflight[i].id != 0)
+            completeInflight(c, &c->inflight[i], FAILURE);
+    }
     c->ping_outstanding = 0;
     c->isconnected = 0;
     if (c->cleansession)
@@ -277,10 +348,12 @@ int cycle(MQTTClient* c, Timer* timer)
         case 0: /* timed out reading packet */
             break;
         case CONNACK:
-        case PUBACK:
         case SUBACK:
         case UNSUBACK:
             break;
+        case PUBACK:
+            ackInflight(c, packet_type);
+            break;
         case PUBLISH:
         {
             MQTTMessage msg;
@@ -322,10 +395,13 @@ int cycle(MQTTClient* c, Timer* timer)
                 rc = FAILURE; // there was a problem
             if (rc == FAILURE)
                 goto exit; // there was a problem
+            if (packet_type == PUBREC)
+                ackInflight(c, packet_type);
             break;
         }
 
         case PUBCOMP:
+            ackInflight(c, packet_type);
             break;
         case PINGRESP:
             c->ping_outstanding = 0;
@@ -336,6 +412,8 @@ int cycle(MQTTClient* c, Timer* timer)
         //check only keepalive FAILURE status so that previous FAILURE status can be considered as FAULT
         rc = FAILURE;
     }
+    else if (retryInflight(c) != SUCCESS)
+        rc = FAILURE;
 
 exit:
     if (rc == SUCCESS)
@@ -392,10 +470,16 @@ void MQTTRun(void* parm)
 		MutexLock(&c->mutex);
 #endif
 
+		/*
+		 * acks of pipelined publishes come in bursts, read on while the start of another packet is
+		 * already in the receive buffer. Every cycle gets a full timer, the rest of a packet and the
+		 * acks sent for it may still have to wait.
+		 */
+		do {
 #if !defined(INCLUDE_MEASURE_AIRTIME)
-		TimerCountdownMS(&timer, 300); /* Don't wait too long if no traffic is incoming */
+			TimerCountdownMS(&timer, 300); /* Don't wait too long if no traffic is incoming */
 #endif /* !defined(INCLUDE_MEASURE_AIRTIME) */
-		cycle(c, &timer);
+		} while (cycle(c, &timer) > 0 && NetworkRxPending(c->ipstack) > 0);
 #if defined(MQTT_TASK)
 		MutexUnlock(&c->mutex);
 #endif
@@ -427,6 +511,23 @@ int waitfor(MQTTClient* c, int packet_type, Timer* timer)
     return rc;
 }
 
+/* waitfor() the ack of one packet, acks of publishes still in flight can come first */
+static int waitforAck(MQTTClient* c, int packet_type, unsigned short id, Timer* timer)
+{
+    int rc = FAILURE;
+    unsigned short mypacketid;
+    unsigned char dup, type;
+
+    while ((rc = waitfor(c, packet_type, timer)) == packet_type)
+    {
+        if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
+            return FAILURE;
+        if (mypacketid == id)
+            break;
+    }
+    return rc;
+}
+
 int MQTTConnectWithResults(MQTTClient* c, MQTTPacket_connectData* options, MQTTConnackData* data)
 {
     
@@ -507,43 +608,8 @@ int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
 
 int MQTTSetMessageHandler(MQTTClient* c, const char* topicFilter, messageHandler messageHandler)
 {
-    int rc = FAILURE;
-    int i = -1;
-
-    /* first check for an existing matching slot */
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-    {
-        if (c->messageHandlers[i].topicFilter != NULL && strcmp(c->messageHandlers[i].topicFilter, topicFilter) == 0)
-        {
-            if (messageHandler == NULL) /* remove existing */
-            {
-                c->messageHandlers[i].topicFilter = NULL;
-                c->messageHandlers[i].fp = NULL;
-            }
-            rc = SUCCESS; /* return i when adding new subscription */
-            break;
-        }
-    }
-    /* if no existing, look for empty slot (unless we are removing) */
-    if (messageHandler != NULL) {
-        if (rc == FAILURE)
-        {
-            for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-            {
-                if (c->messageHandlers[i].topicFilter == NULL)
-                {
-                    rc = SUCCESS;
-                    break;
-                }
-            }
-        }
-        if (i < MAX_MESSAGE_HANDLERS)
-        {
-            c->messageHandlers[i].topicFilter = topicFilter;
-            c->messageHandlers[i].fp = messageHandler;
-        }
-    }
-    return rc;
+    /* adds, replaces or with a NULL handler removes the handler of the filter */
+    return MQTTTopicTrie_set(&c->messageHandlers, topicFilter, messageHandler);
 }
 
 
@@ -706,30 +772,22 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
 #endif /* defined(INCLUDE_MQTT_FAST_CONN) */
     if (message->qos == QOS1)
     {
-        if (waitfor(c, PUBACK, &timer) == PUBACK)
+        if (waitforAck(c, PUBACK, message->id, &timer) == PUBACK)
         {
 #if !defined(INCLUDE_MEASURE_AIRTIME)					            
             system_printf("[%s] PUBACK received\n", __func__);
 #endif /* !defined(INCLUDE_MEASURE_AIRTIME) */
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
-                rc = FAILURE;
         }
         else
             rc = FAILURE;
     }
     else if (message->qos == QOS2)
     {
-        if (waitfor(c, PUBCOMP, &timer) == PUBCOMP)
+        if (waitforAck(c, PUBCOMP, message->id, &timer) == PUBCOMP)
         {
 #if !defined(INCLUDE_MEASURE_AIRTIME)		            
             system_printf("[%s] PUBCOMP received\n", __func__);
 #endif /* !defined(INCLUDE_MEASURE_AIRTIME) */            
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
-                rc = FAILURE;
         }
         else
             rc = FAILURE;
@@ -747,6 +805,103 @@ exit:
 }
 
 
+int MQTTPublishAsync(MQTTClient* c, const char* topicName, MQTTMessage* message,
+       publishHandler handler, void* context)
+{
+    int rc = FAILURE;
+    Timer timer;
+    struct InflightMessages* m = NULL;
+    int i;
+
+#if defined(MQTT_TASK)
+	MutexLock(&c->mutex);
+#endif
+
+	if (!c->isconnected)
+		goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    if (message->qos == QOS0)
+    {
+        MQTTString topic = MQTTString_initializer;
+        int len = 0;
+
+        topic.cstring = (char *)topicName;
+        message->id = 0;
+        len = MQTTSerialize_publish(c->buf, c->buf_size, 0, QOS0, message->retained, 0,
+              topic, (unsigned char*)message->payload, message->payloadlen);
+        if (len > 0 && (rc = sendPacket(c, len, &timer)) == SUCCESS && handler != NULL)
+            handler(context, 0, SUCCESS);
+        goto exit;
+    }
+
+    /* wait for a free slot in the window, reading acks meanwhile */
+    while (m == NULL)
+    {
+        if (MQTTInflightCount(c) < c->inflight_window)
+        {
+            for (i = 0; m == NULL; ++i)
+            {
+                if (c->inflight[i].id == 0)
+                    m = &c->inflight[i];
+            }
+        }
+        else if (TimerIsExpired(&timer) || cycle(c, &timer) < 0 || !c->isconnected)
+        {
+            rc = FAILURE;
+            goto exit;
+        }
+    }
+
+    message->id = getNextPacketId(c);
+    m->qos = message->qos;
+    m->retained = message->retained;
+    m->pubrel = 0;
+    m->retries = 0;
+    m->topicName = topicName;
+    m->payload = message->payload;
+    m->payloadlen = message->payloadlen;
+    m->fp = handler;
+    m->context = context;
+    m->id = message->id;
+
+    if ((rc = sendInflight(c, m, 0, &timer)) != SUCCESS)
+        m->id = 0;
+
+exit:
+#if defined(MQTT_TASK)
+	MutexUnlock(&c->mutex);
+#endif
+
+    return rc;
+}
+
+
+int MQTTSetInflightWindow(MQTTClient* c, int window)
+{
+    if (window < 1 || window > MAX_INFLIGHT_MESSAGES)
+        return FAILURE;
+
+    c->inflight_window = window;
+    return SUCCESS;
+}
+
+
+int MQTTInflightCount(MQTTClient* c)
+{
+    int i, count = 0;
+
+    for (i = 0; i < MAX_INFLIGHT_MESSAGES; ++i)
+    {
+        if (c->inflight[i].id != 0)
+            count++;
+    }
+    return count;
+}
+
+
 int MQTTDisconnect(MQTTClient* c)
 {
     int rc = FAILURE;
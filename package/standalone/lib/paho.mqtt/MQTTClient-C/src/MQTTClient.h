@@ -36,6 +36,7 @@
 
 #include "MQTTNrcImpl.h"
 #include "MQTTPacket.h"
+#include "MQTTTopicTrie.h"
 
 #if defined(MQTTCLIENT_PLATFORM_HEADER)
 /* The following sequence of macros converts the MQTTCLIENT_PLATFORM_HEADER value
@@ -48,8 +49,12 @@
 
 #define MAX_PACKET_ID 65535 /* according to the MQTT specification - do not change! */
 
-#if !defined(MAX_MESSAGE_HANDLERS)
-#define MAX_MESSAGE_HANDLERS 15 /* redefinable - how many subscriptions do you want? */
+#if !defined(MAX_INFLIGHT_MESSAGES)
+#define MAX_INFLIGHT_MESSAGES 8 /* redefinable - how many QoS 1/2 publishes of MQTTPublishAsync can await their acks */
+#endif
+
+#if !defined(MAX_PUBLISH_RETRIES)
+#define MAX_PUBLISH_RETRIES 3 /* redefinable - retransmissions before an in-flight publish fails */
 #endif
 
 enum QoS { QOS0, QOS1, QOS2, SUBFAIL=0x80 };
@@ -103,6 +108,11 @@ typedef struct MQTTSubackData
 
 typedef void (*messageHandler)(MessageData*);
 
+/* Completion of MQTTPublishAsync, rc is SUCCESS once the last ack arrived and FAILURE if the
+ * publish was given up. It runs in the context which reads the acks, with the client locked, and
+ * must not call the client: the MQTT_TASK mutex is not recursive. Signal another task instead. */
+typedef void (*publishHandler)(void* context, unsigned short id, int rc);
+
 typedef struct MQTTClient
 {
     unsigned int next_packetid,
@@ -116,14 +126,26 @@ typedef struct MQTTClient
     int isconnected;
     int cleansession;
 
-    struct MessageHandlers
-    {
-        const char* topicFilter;
-        void (*fp) (MessageData*);
-    } messageHandlers[MAX_MESSAGE_HANDLERS];      /* Message handlers are indexed by subscription topic */
+    MQTTTopicTrie messageHandlers;      /* Message handlers are indexed by subscription topic */
 
     void (*defaultMessageHandler) (MessageData*);
 
+    struct InflightMessages
+    {
+        unsigned short id;              /* 0 if the slot is free */
+        unsigned char qos;
+        unsigned char retained;
+        unsigned char pubrel;           /* QoS 2 publish whose PUBREC arrived, PUBCOMP is awaited */
+        unsigned char retries;
+        const char* topicName;
+        void* payload;
+        size_t payloadlen;
+        Timer retry;
+        publishHandler fp;
+        void* context;
+    } inflight[MAX_INFLIGHT_MESSAGES];  /* publishes of MQTTPublishAsync awaiting their acks */
+    int inflight_window;
+
     Network* ipstack;
     Timer last_sent, last_received;
 #if defined(MQTT_TASK)
@@ -168,6 +190,34 @@ DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
  */
 DLLExport int MQTTPublish(MQTTClient* client, const char*, MQTTMessage*);
 
+/** MQTT Publish Async - send an MQTT publish packet without waiting for its acks.
+ *  QoS 1 and 2 publishes stay in flight until their last ack arrives, which may be out of order,
+ *  and are sent again with the DUP flag if it has not arrived within the command timeout.
+ *  If the in-flight window is full, acks are read until a slot is free.
+ *  The topic and payload must stay valid until the handler is called.
+ *  @param client - the client object to use
+ *  @param topic - the topic to publish to
+ *  @param message - the message to send, its id is set to the packet id
+ *  @param handler - called when the publish completes or fails, may be NULL
+ *  @param context - passed to the handler
+ *  @return success code, the handler is not called if the publish could not be sent
+ */
+DLLExport int MQTTPublishAsync(MQTTClient* client, const char* topic, MQTTMessage* message,
+    publishHandler handler, void* context);
+
+/** MQTT SetInflightWindow - set how many publishes of MQTTPublishAsync can await their acks
+ *  @param client - the client object to use
+ *  @param window - 1 to MAX_INFLIGHT_MESSAGES, 1 waits for each ack before the next publish
+ *  @return success code
+ */
+DLLExport int MQTTSetInflightWindow(MQTTClient* client, int window);
+
+/** MQTT InflightCount
+ *  @param client - the client object to use
+ *  @return number of publishes of MQTTPublishAsync awaiting their acks
+ */
+DLLExport int MQTTInflightCount(MQTTClient* client);
+
 /** MQTT SetMessageHandler - set or remove a per topic message handler
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter set the message handler for
@@ -229,6 +279,11 @@ DLLExport int MQTTStartTask(MQTTClient* client);
 
 DLLExport void MQTTCloseSession(MQTTClient* c);
 
+/** MQTT CleanSession - remove all message handlers
+ *  @param client - the client object to use
+ */
+DLLExport void MQTTCleanSession(MQTTClient* c);
+
 #if defined(__cplusplus)
      }
 #endif
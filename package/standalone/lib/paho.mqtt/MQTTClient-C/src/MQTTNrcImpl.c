@@ -116,14 +116,93 @@ void TimerInit(Timer* timer)
 	memset(&timer->xTimeOut, '\0', sizeof(timer->xTimeOut));
 }
 
-int nrc_sock_read(Network* n, unsigned char* buffer, int len, int timeout_ms)
+/*
+ * Read len bytes through recv_fn, which reads at most the given size within the given timeout,
+ * 0 only takes what has already arrived, and returns the number of bytes read, 0 on timeout or a
+ * negative error. Its last argument tells it that the read continues one whose first bytes have
+ * arrived, the rest is then usually there already.
+ * timeout_ms bounds the wait for the first bytes. Once they are in, the rest of this read is given
+ * at least MQTT_NETWORK_REST_TIMEOUT_MS however little the caller had left, so a poll never cuts
+ * a packet in half. This holds per call: the fixed header, the remaining length and the body of a
+ * packet are separate calls, and readPacket() in MQTTClient.c gives the ones continuing a packet
+ * at least that timeout as well.
+ * Whatever the transport has available is read into the receive buffer and later reads are served
+ * from it, so the fixed header, the remaining length and the rest of a packet cost one transport
+ * read instead of one each. Reads at least as large as the buffer go straight to the caller.
+ */
+static int network_read(Network* n, unsigned char* buffer, int len, int timeout_ms,
+				int (*recv_fn)(Network*, unsigned char*, int, int, int))
 {
-	int rc = 0;
+	int rest_ms = (timeout_ms > MQTT_NETWORK_REST_TIMEOUT_MS) ? timeout_ms : MQTT_NETWORK_REST_TIMEOUT_MS;
 	int recvlen = 0;
+	int rc = 0;
+
+	while (recvlen < len) {
+		int avail = n->rxtail - n->rxhead;
+
+		if (avail > 0) {
+			if (avail > len - recvlen)
+				avail = len - recvlen;
+			memcpy(buffer + recvlen, n->rxbuf + n->rxhead, avail);
+			n->rxhead += avail;
+			recvlen += avail;
+			continue;
+		}
+
+		n->rxhead = n->rxtail = 0;
+		if (len - recvlen >= n->rxbuf_size)
+			rc = recv_fn(n, buffer + recvlen, len - recvlen, recvlen ? rest_ms : timeout_ms, recvlen);
+		else
+			rc = recv_fn(n, n->rxbuf, n->rxbuf_size, recvlen ? rest_ms : timeout_ms, recvlen);
+
+		/* the bytes already read can't be put back, a stall mid-read is a hard failure */
+		if (rc <= 0)
+			return (rc == 0 && recvlen > 0) ? -1 : rc;
+
+		if (len - recvlen >= n->rxbuf_size)
+			recvlen += rc;
+		else
+			n->rxtail = rc;
+	}
+	return recvlen;
+}
+
+static void network_alloc_rxbuf(Network* n)
+{
+	if (n->rxbuf == NULL && MQTT_NETWORK_RX_BUFFER_SIZE > 0) {
+		n->rxbuf = (unsigned char*)pvPortMalloc(MQTT_NETWORK_RX_BUFFER_SIZE);
+		/* without a buffer reads go straight to the caller */
+		n->rxbuf_size = n->rxbuf ? MQTT_NETWORK_RX_BUFFER_SIZE : 0;
+	}
+	n->rxhead = n->rxtail = 0;
+}
+
+static void network_free_rxbuf(Network* n)
+{
+	if (n->rxbuf != NULL) {
+		vPortFree(n->rxbuf);
+		n->rxbuf = NULL;
+	}
+	n->rxbuf_size = 0;
+	n->rxhead = n->rxtail = 0;
+}
+
+static int nrc_sock_recv(Network* n, unsigned char* buffer, int len, int timeout_ms, int rest)
+{
+	int rc = 0;
 	int ret = -1;
 	fd_set fdset;
 	struct timeval tv;
 
+	/* take the rest of a packet without a select() if it is already here */
+	if (rest) {
+		rc = recv(n->my_socket, buffer, len, MSG_DONTWAIT);
+		if (rc > 0)
+			return rc;
+		if (rc == 0)
+			return -30;
+	}
+
 	FD_ZERO(&fdset);
 	FD_SET(n->my_socket, &fdset);
 
@@ -137,17 +216,17 @@ int nrc_sock_read(Network* n, unsigned char* buffer, int len, int timeout_ms)
 	} else if (ret == 0) {
 		/* timeout */
 		return ret;
-	} else if (ret == 1) {
-		do {
-			rc = recv(n->my_socket, buffer + recvlen, len - recvlen, 0);
-			if (rc > 0) {
-				recvlen += rc;
-			} else {
-				return -30;
-			}
-		} while (recvlen < len);
 	}
-	return recvlen;
+
+	rc = recv(n->my_socket, buffer, len, 0);
+	if (rc <= 0)
+		return -30;
+	return rc;
+}
+
+int nrc_sock_read(Network* n, unsigned char* buffer, int len, int timeout_ms)
+{
+	return network_read(n, buffer, len, timeout_ms, nrc_sock_recv);
 }
 
 int nrc_sock_write(Network* n, unsigned char* buffer, int len, int timeout_ms)
@@ -183,6 +262,15 @@ void NetworkInit(Network* n)
 	n->my_socket = -1;
 	n->mqttread = nrc_sock_read;
 	n->mqttwrite = nrc_sock_write;
+	n->rxbuf = NULL;
+	n->rxbuf_size = 0;
+	n->rxhead = n->rxtail = 0;
+}
+
+/* Bytes received ahead of the reader, the start of another packet may already be among them */
+int NetworkRxPending(Network* n)
+{
+	return n->rxtail - n->rxhead;
 }
 
 int NetworkConnect(Network* n, char* addr, int port)
@@ -247,6 +335,7 @@ int NetworkConnect(Network* n, char* addr, int port)
 		}
 
 		setsockopt(n->my_socket, IPPROTO_TCP, TCP_NODELAY, &opval, sizeof(opval));
+		network_alloc_rxbuf(n);
 	}
 	else {
 		oled_log(0, 0,  "[0:Network conn 5]");
@@ -261,6 +350,7 @@ int NetworkDisconnect(Network* n)
 
 	shutdown(sock, SHUT_RDWR);
 	close(sock);
+	network_free_rxbuf(n);
 
 	return 0;
 }
@@ -339,29 +429,44 @@ static int ssl_parse_crt(mbedtls_x509_crt *crt)
 }
 #endif
 
-int mqtt_ssl_read_all(Network *n, unsigned char *buffer, int len, int timeout_ms)
+static int mqtt_ssl_recv(Network *n, unsigned char *buffer, int len, int timeout_ms, int rest)
 {
-	size_t readLen = 0;
 	int ret = -1;
 	mqtt_ssl_t *ssl = (mqtt_ssl_t *)(n->my_socket);
 
+	/* mbedtls waits without limit on a read timeout of 0, so a poll checks for data first */
+	if (timeout_ms <= 0) {
+		fd_set fdset;
+		struct timeval tv = { 0, 0 };
+
+		if (mbedtls_ssl_get_bytes_avail(&ssl->ssl_ctx) == 0) {
+			FD_ZERO(&fdset);
+			FD_SET(ssl->net_ctx.fd, &fdset);
+			if (select(ssl->net_ctx.fd + 1, &fdset, NULL, NULL, &tv) <= 0)
+				return 0;
+		}
+		/* only part of a record may have arrived, give the rest time to follow */
+		timeout_ms = MQTT_NETWORK_REST_TIMEOUT_MS;
+	}
 	mbedtls_ssl_conf_read_timeout(&ssl->ssl_conf, timeout_ms);
-	while (readLen < len) {
-		ret = mbedtls_ssl_read(&ssl->ssl_ctx, (unsigned char *)(buffer + readLen), (len - readLen));
-		if (ret > 0) {
-			readLen += ret;
-		} else if (ret == 0) {
-			return -2; // eof
-		} else if (ret == MBEDTLS_ERR_SSL_TIMEOUT) {
-			return 0;
-		} else {
-			if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
-				return -2;
-			}
-			return -1; //Connnection error
+	ret = mbedtls_ssl_read(&ssl->ssl_ctx, buffer, len);
+	if (ret > 0) {
+		return ret;
+	} else if (ret == 0) {
+		return -2; // eof
+	} else if (ret == MBEDTLS_ERR_SSL_TIMEOUT) {
+		return 0;
+	} else {
+		if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+			return -2;
 		}
+		return -1; //Connnection error
 	}
-	return readLen;
+}
+
+int mqtt_ssl_read_all(Network *n, unsigned char *buffer, int len, int timeout_ms)
+{
+	return network_read(n, buffer, len, timeout_ms, mqtt_ssl_recv);
 }
 
 int mqtt_ssl_write_all(Network *n, unsigned char *buffer, int len, int timeout_ms)
@@ -598,6 +703,7 @@ int NetworkConnectTLS(Network *n, const char *addr, int po, Certs *certs)
 	n->mqttread = mqtt_ssl_read_all;
 	n->mqttwrite = mqtt_ssl_write_all;
 	n->disconnect = mqtt_ssl_disconnect;
+	network_alloc_rxbuf(n);
 
 	return 0;
 }
@@ -613,6 +719,7 @@ int NetworkDisconnectTLS(Network* n)
 	if (ssl != NULL) {
 		vPortFree(ssl);
 	}
+	network_free_rxbuf(n);
 
 	return 0;
 }
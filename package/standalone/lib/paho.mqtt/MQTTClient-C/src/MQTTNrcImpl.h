@@ -37,6 +37,16 @@ typedef struct Timer
 	TimeOut_t xTimeOut;
 } Timer;
 
+/* Size of the receive buffer allocated on connect, 0 reads straight into the caller's buffer */
+#ifndef MQTT_NETWORK_RX_BUFFER_SIZE
+#define MQTT_NETWORK_RX_BUFFER_SIZE 256
+#endif
+
+/* How long the rest of a read is waited for once its first bytes have arrived, in milliseconds */
+#ifndef MQTT_NETWORK_REST_TIMEOUT_MS
+#define MQTT_NETWORK_REST_TIMEOUT_MS 1000
+#endif
+
 typedef struct Network Network;
 
 struct Network
@@ -45,6 +55,10 @@ struct Network
 	int (*mqttread) (Network*, unsigned char*, int, int);
 	int (*mqttwrite) (Network*, unsigned char*, int, int);
 	void (*disconnect) (Network*);
+	unsigned char *rxbuf; /* bytes received ahead of the reader */
+	int rxbuf_size;
+	int rxhead;
+	int rxtail;
 };
 
 void TimerInit(Timer*);
@@ -69,12 +83,16 @@ typedef struct Thread
 
 int ThreadStart(Thread*, void (*fn)(void*), void* arg);
 
+#define MQTTMalloc(size)	pvPortMalloc(size)
+#define MQTTFree(ptr)		vPortFree(ptr)
+
 int nrc_sock_read(Network*, unsigned char*, int, int);
 int nrc_sock_write(Network*, unsigned char*, int, int);
 
 void NetworkInit(Network*);
 int NetworkConnect(Network*, char*, int);
 int NetworkDisconnect(Network* n);
+int NetworkRxPending(Network*);
 
 #if defined( SUPPORT_MBEDTLS )
 typedef struct Certs{
@@ -0,0 +1,354 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "MQTTClient.h"
+#include "MQTTTopicTrie.h"
+
+#include <string.h>
+
+static MQTTTopicNode* newNode(const char* level, int len)
+{
+    MQTTTopicNode* node = (MQTTTopicNode*)MQTTMalloc(sizeof(MQTTTopicNode) + len);
+
+    if (node != NULL)
+    {
+        memset(node, 0, sizeof(MQTTTopicNode));
+        memcpy(node->level, level, len);
+        node->len = len;
+    }
+    return node;
+}
+
+
+static void freeNode(MQTTTopicNode* node)
+{
+    int i;
+
+    if (node == NULL)
+        return;
+
+    for (i = 0; i < node->nchildren; ++i)
+        freeNode(node->children[i]);
+    freeNode(node->plus);
+    freeNode(node->hash);
+    if (node->children != NULL)
+        MQTTFree(node->children);
+    MQTTFree(node);
+}
+
+
+static int isEmpty(MQTTTopicNode* node)
+{
+    return node->fp == NULL && node->nchildren == 0 && node->plus == NULL && node->hash == NULL;
+}
+
+
+/* binary search of the literal children, returns the index of the level or where it belongs */
+static int findChild(MQTTTopicNode* node, const char* level, int len, int* found)
+{
+    int lo = 0, hi = node->nchildren;
+
+    *found = 0;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        MQTTTopicNode* child = node->children[mid];
+        int n = (child->len < len) ? child->len : len;
+        int cmp = memcmp(child->level, level, n);
+
+        if (cmp == 0)
+            cmp = child->len - len;
+        if (cmp == 0)
+        {
+            *found = 1;
+            return mid;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+static MQTTTopicNode* addChild(MQTTTopicNode* node, const char* level, int len)
+{
+    MQTTTopicNode** slot;
+    MQTTTopicNode* child;
+    int found;
+    int i;
+
+    if (len == 1 && level[0] == '+')
+        slot = &node->plus;
+    else if (len == 1 && level[0] == '#')
+        slot = &node->hash;
+    else
+    {
+        i = findChild(node, level, len, &found);
+        if (found)
+            return node->children[i];
+
+        if (node->nchildren == node->capacity)
+        {
+            int capacity = node->capacity ? node->capacity * 2 : 2;
+            MQTTTopicNode** children = (MQTTTopicNode**)MQTTMalloc(capacity * sizeof(MQTTTopicNode*));
+
+            if (children == NULL)
+                return NULL;
+            if (node->children != NULL)
+            {
+                memcpy(children, node->children, node->nchildren * sizeof(MQTTTopicNode*));
+                MQTTFree(node->children);
+            }
+            node->children = children;
+            node->capacity = capacity;
+        }
+
+        if ((child = newNode(level, len)) == NULL)
+            return NULL;
+        memmove(&node->children[i + 1], &node->children[i], (node->nchildren - i) * sizeof(MQTTTopicNode*));
+        node->children[i] = child;
+        node->nchildren++;
+        return child;
+    }
+
+    if (*slot == NULL)
+        *slot = newNode(level, len);
+    return *slot;
+}
+
+
+/* the slot of the level below node, NULL if it has no such literal child */
+static MQTTTopicNode** findSlot(MQTTTopicNode* node, const char* level, int len, int* index)
+{
+    int found;
+
+    if (len == 1 && level[0] == '+')
+        return &node->plus;
+    if (len == 1 && level[0] == '#')
+        return &node->hash;
+
+    *index = findChild(node, level, len, &found);
+    return found ? &node->children[*index] : NULL;
+}
+
+
+/* free the child in slot if nothing hangs off it any more */
+static void pruneSlot(MQTTTopicNode* node, MQTTTopicNode** slot, int index)
+{
+    if (!isEmpty(*slot))
+        return;
+
+    freeNode(*slot);
+    if (slot == &node->plus || slot == &node->hash)
+        *slot = NULL;
+    else
+        memmove(&node->children[index], &node->children[index + 1], (--node->nchildren - index) * sizeof(MQTTTopicNode*));
+}
+
+
+/* remove the handler of the filter from level on below node, returns 1 if it was found */
+static int removeFilter(MQTTTopicNode* node, const char* level, const char* end)
+{
+    const char* next;
+    MQTTTopicNode** slot;
+    int len, i = 0, found;
+
+    if (level == NULL)
+    {
+        found = (node->fp != NULL);
+        node->fp = NULL;
+        return found;
+    }
+
+    next = memchr(level, '/', end - level);
+    len = (next ? next : end) - level;
+
+    slot = findSlot(node, level, len, &i);
+    if (slot == NULL || *slot == NULL || !removeFilter(*slot, next ? next + 1 : NULL, end))
+        return 0;
+
+    pruneSlot(node, slot, i);
+    return 1;
+}
+
+
+/* free the empty nodes a failed insert of the filter left from level on below node */
+static void pruneFilter(MQTTTopicNode* node, const char* level, const char* end)
+{
+    const char* next = memchr(level, '/', end - level);
+    int len = (next ? next : end) - level;
+    MQTTTopicNode** slot;
+    int i = 0;
+
+    slot = findSlot(node, level, len, &i);
+    if (slot == NULL || *slot == NULL)
+        return;
+
+    if (next != NULL)
+        pruneFilter(*slot, next + 1, end);
+    pruneSlot(node, slot, i);
+}
+
+
+/* wildcards take a whole level, '#' only the last one */
+static int validFilter(const char* level, const char* end)
+{
+    if (level == end)
+        return 0;
+
+    while (level != NULL)
+    {
+        const char* next = memchr(level, '/', end - level);
+        int len = (next ? next : end) - level;
+
+        if ((len > 1 && (memchr(level, '+', len) || memchr(level, '#', len))) ||
+                (len == 1 && level[0] == '#' && next != NULL))
+            return 0;
+        level = next ? next + 1 : NULL;
+    }
+    return 1;
+}
+
+
+/* node matched the topic up to level, NULL once all levels are matched */
+static int deliver(MQTTTopicNode* node, const char* level, const char* end, int wildcards, struct MessageData* md)
+{
+    const char* next;
+    const char* rest;
+    int count = 0;
+    int len, i, found;
+
+    /* '#' also matches the parent level */
+    if (node->hash != NULL && wildcards)
+    {
+        node->hash->fp(md);
+        count++;
+    }
+
+    if (level == NULL)
+    {
+        if (node->fp != NULL)
+        {
+            node->fp(md);
+            count++;
+        }
+        return count;
+    }
+
+    next = memchr(level, '/', end - level);
+    len = (next ? next : end) - level;
+    rest = next ? next + 1 : NULL;
+
+    if (node->nchildren > 0)
+    {
+        i = findChild(node, level, len, &found);
+        if (found)
+            count += deliver(node->children[i], rest, end, 1, md);
+    }
+    if (node->plus != NULL && wildcards)
+        count += deliver(node->plus, rest, end, 1, md);
+
+    return count;
+}
+
+
+void MQTTTopicTrie_init(MQTTTopicTrie* trie)
+{
+    trie->root = NULL;
+    trie->count = 0;
+}
+
+
+int MQTTTopicTrie_set(MQTTTopicTrie* trie, const char* topicFilter, MQTTTopicHandler fp)
+{
+    const char* level = topicFilter;
+    const char* end = topicFilter + strlen(topicFilter);
+    MQTTTopicNode* node;
+
+    if (!validFilter(level, end))
+        return FAILURE;
+
+    if (fp == NULL)
+    {
+        if (trie->root == NULL || !removeFilter(trie->root, level, end))
+            return FAILURE;
+        trie->count--;
+        if (isEmpty(trie->root))
+        {
+            freeNode(trie->root);
+            trie->root = NULL;
+        }
+        return SUCCESS;
+    }
+
+    if (trie->root == NULL && (trie->root = newNode("", 0)) == NULL)
+        return FAILURE;
+
+    for (node = trie->root; level != NULL; )
+    {
+        const char* next = memchr(level, '/', end - level);
+        int len = (next ? next : end) - level;
+
+        if ((node = addChild(node, level, len)) == NULL)
+        {
+            /* out of memory, drop the levels added for the filter */
+            pruneFilter(trie->root, topicFilter, end);
+            if (isEmpty(trie->root))
+            {
+                freeNode(trie->root);
+                trie->root = NULL;
+            }
+            return FAILURE;
+        }
+        level = next ? next + 1 : NULL;
+    }
+
+    if (node->fp == NULL)
+        trie->count++;
+    node->fp = fp;
+    return SUCCESS;
+}
+
+
+int MQTTTopicTrie_deliver(MQTTTopicTrie* trie, MQTTString* topicName, struct MessageData* md)
+{
+    const char* topic = topicName->cstring ? topicName->cstring : topicName->lenstring.data;
+    int len = topicName->cstring ? strlen(topicName->cstring) : topicName->lenstring.len;
+
+    if (trie->root == NULL)
+        return 0;
+
+    /* wildcards at the first level do not match topics starting with '$' */
+    return deliver(trie->root, topic, topic + len, len == 0 || topic[0] != '$', md);
+}
+
+
+void MQTTTopicTrie_clear(MQTTTopicTrie* trie)
+{
+    freeNode(trie->root);
+    MQTTTopicTrie_init(trie);
+}
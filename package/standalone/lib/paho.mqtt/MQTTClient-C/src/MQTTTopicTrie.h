@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#if !defined(MQTT_TOPIC_TRIE_H)
+#define MQTT_TOPIC_TRIE_H
+
+#include "MQTTPacket.h"
+
+/* Message handlers of the subscriptions, indexed by topic filter.
+ *
+ * Each node of the trie is one level of a topic filter. Literal levels below a node are kept
+ * sorted and found by binary search, '+' and '#' have a slot of their own, so delivering a
+ * message costs a lookup per topic level (and per matching '+' branch) instead of a match
+ * against every subscription. Nodes are allocated as filters are added and freed as they are
+ * removed, there is no limit on the number of subscriptions. */
+
+struct MessageData;
+typedef void (*MQTTTopicHandler)(struct MessageData*);
+
+typedef struct MQTTTopicNode
+{
+    struct MQTTTopicNode** children;    /* literal levels below this one, sorted */
+    unsigned short nchildren;
+    unsigned short capacity;
+    struct MQTTTopicNode* plus;         /* '+' level below this one */
+    struct MQTTTopicNode* hash;         /* '#' level below this one, always a leaf */
+    MQTTTopicHandler fp;                /* handler of the filter which ends at this level */
+    unsigned short len;
+    char level[1];                      /* not terminated */
+} MQTTTopicNode;
+
+typedef struct MQTTTopicTrie
+{
+    MQTTTopicNode* root;
+    int count;                          /* number of topic filters */
+} MQTTTopicTrie;
+
+void MQTTTopicTrie_init(MQTTTopicTrie* trie);
+
+/** Set, replace or with a NULL handler remove the handler of a topic filter
+ *  @return SUCCESS, FAILURE if the filter is invalid, out of memory or not found for removal */
+int MQTTTopicTrie_set(MQTTTopicTrie* trie, const char* topicFilter, MQTTTopicHandler fp);
+
+/** Call the handler of every topic filter matching the topic name
+ *  @return number of handlers called */
+int MQTTTopicTrie_deliver(MQTTTopicTrie* trie, MQTTString* topicName, struct MessageData* md);
+
+/** Remove all topic filters */
+void MQTTTopicTrie_clear(MQTTTopicTrie* trie);
+
+#endif
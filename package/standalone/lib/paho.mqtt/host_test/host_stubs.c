@@ -0,0 +1,340 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Host stand-ins for the FreeRTOS calls of the paho port and counters for the socket calls
+ * which cost a round trip through the lwIP core on the target. The TLS build also gets the
+ * mbedtls calls of the port's TLS transport.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+#include "lwip/sockets.h"
+
+#undef select
+#undef recv
+
+unsigned int host_select_count = 0;
+unsigned int host_recv_count = 0;
+
+int host_select (int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+				struct timeval *timeout)
+{
+	/* only reads are counted, the client does not select() before a write in this test */
+	if (readfds)
+		host_select_count++;
+
+	return select(nfds, readfds, writefds, exceptfds, timeout);
+}
+
+ssize_t host_recv (int fd, void *buf, size_t len, int flags)
+{
+	host_recv_count++;
+
+	return recv(fd, buf, len, flags);
+}
+
+/**********************************************************************************************/
+
+TickType_t xTaskGetTickCount (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (TickType_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void vTaskSetTimeOutState (TimeOut_t *timeout)
+{
+	timeout->xTimeOnEntering = xTaskGetTickCount();
+}
+
+BaseType_t xTaskCheckForTimeOut (TimeOut_t *timeout, TickType_t *ticks_to_wait)
+{
+	TickType_t now = xTaskGetTickCount();
+	TickType_t elapsed = now - timeout->xTimeOnEntering;
+
+	if (elapsed >= *ticks_to_wait) {
+		*ticks_to_wait = 0;
+		return pdTRUE;
+	}
+
+	*ticks_to_wait -= elapsed;
+	timeout->xTimeOnEntering = now;
+
+	return pdFALSE;
+}
+
+BaseType_t xTaskCreate (TaskFunction_t func, const char *name, uint32_t stack_depth,
+						void *param, UBaseType_t priority, TaskHandle_t *handle)
+{
+	return pdFALSE;
+}
+
+UBaseType_t uxTaskPriorityGet (TaskHandle_t task)
+{
+	return 0;
+}
+
+void vTaskDelay (TickType_t ticks)
+{
+	struct timespec ts = { ticks / 1000, (ticks % 1000) * 1000000 };
+
+	nanosleep(&ts, NULL);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex (void)
+{
+	pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+
+	pthread_mutex_init(mutex, NULL);
+
+	return (SemaphoreHandle_t)mutex;
+}
+
+BaseType_t xSemaphoreTake (SemaphoreHandle_t sem, TickType_t ticks)
+{
+	return pthread_mutex_lock((pthread_mutex_t *)sem) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive (SemaphoreHandle_t sem)
+{
+	return pthread_mutex_unlock((pthread_mutex_t *)sem) == 0 ? pdTRUE : pdFALSE;
+}
+
+int host_malloc_countdown = 0;
+
+void *pvPortMalloc (size_t size)
+{
+	if (host_malloc_countdown > 0 && --host_malloc_countdown == 0)
+		return NULL;
+
+	return malloc(size);
+}
+
+void vPortFree (void *ptr)
+{
+	free(ptr);
+}
+
+/**********************************************************************************************/
+
+#if defined(SUPPORT_MBEDTLS)
+
+#include "mbedtls/net.h"
+#include "mbedtls/ssl.h"
+
+/* how long a read with a timeout of 0 waits here, the test fails on it but should not hang */
+#define HOST_SSL_UNBOUNDED_WAIT		2000	/* ms */
+
+unsigned int host_ssl_unbounded_read_count = 0;
+
+void mbedtls_net_init (mbedtls_net_context *ctx)
+{
+	ctx->fd = -1;
+}
+
+int mbedtls_net_connect (mbedtls_net_context *ctx, const char *host, const char *port, int proto)
+{
+	struct sockaddr_in addr;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr(host);
+	addr.sin_port = htons(atoi(port));
+
+	ctx->fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (ctx->fd < 0 || connect(ctx->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+		return -0x0044; /* MBEDTLS_ERR_NET_CONNECT_FAILED */
+
+	return 0;
+}
+
+int mbedtls_net_send (void *ctx, const unsigned char *buf, size_t len)
+{
+	return send(((mbedtls_net_context *)ctx)->fd, buf, len, MSG_NOSIGNAL);
+}
+
+int mbedtls_net_recv (void *ctx, unsigned char *buf, size_t len)
+{
+	return mbedtls_net_recv_timeout(ctx, buf, len, HOST_SSL_UNBOUNDED_WAIT);
+}
+
+int mbedtls_net_recv_timeout (void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
+{
+	int fd = ((mbedtls_net_context *)ctx)->fd;
+	struct timeval tv;
+	fd_set fdset;
+	int ret;
+
+	if (timeout == 0) {
+		host_ssl_unbounded_read_count++;
+		timeout = HOST_SSL_UNBOUNDED_WAIT;
+	}
+
+	FD_ZERO(&fdset);
+	FD_SET(fd, &fdset);
+	tv.tv_sec = timeout / 1000;
+	tv.tv_usec = (timeout % 1000) * 1000;
+
+	ret = host_select(fd + 1, &fdset, NULL, NULL, &tv);
+	if (ret == 0)
+		return MBEDTLS_ERR_SSL_TIMEOUT;
+	if (ret < 0)
+		return -0x004C; /* MBEDTLS_ERR_NET_RECV_FAILED */
+
+	ret = host_recv(fd, buf, len, 0);
+
+	return (ret < 0) ? -0x004C : ret;
+}
+
+void mbedtls_net_free (mbedtls_net_context *ctx)
+{
+	if (ctx->fd >= 0)
+		close(ctx->fd);
+	ctx->fd = -1;
+}
+
+void mbedtls_ssl_init (mbedtls_ssl_context *ssl)
+{
+	memset(ssl, 0, sizeof(*ssl));
+}
+
+void mbedtls_ssl_config_init (mbedtls_ssl_config *conf)
+{
+	memset(conf, 0, sizeof(*conf));
+}
+
+int mbedtls_ssl_config_defaults (mbedtls_ssl_config *conf, int endpoint, int transport, int preset)
+{
+	return 0;
+}
+
+void mbedtls_ssl_conf_authmode (mbedtls_ssl_config *conf, int authmode)
+{
+}
+
+void mbedtls_ssl_conf_rng (mbedtls_ssl_config *conf,
+						int (*f_rng) (void *, unsigned char *, size_t), void *p_rng)
+{
+}
+
+void mbedtls_ssl_conf_dbg (mbedtls_ssl_config *conf,
+						void (*f_dbg) (void *, int, const char *, int, const char *), void *p_dbg)
+{
+}
+
+void mbedtls_ssl_conf_read_timeout (mbedtls_ssl_config *conf, uint32_t timeout)
+{
+	conf->read_timeout = timeout;
+}
+
+int mbedtls_ssl_setup (mbedtls_ssl_context *ssl, const mbedtls_ssl_config *conf)
+{
+	ssl->conf = conf;
+
+	return 0;
+}
+
+int mbedtls_ssl_set_hostname (mbedtls_ssl_context *ssl, const char *hostname)
+{
+	return 0;
+}
+
+void mbedtls_ssl_set_bio (mbedtls_ssl_context *ssl, void *p_bio, mbedtls_ssl_send_t *f_send,
+						mbedtls_ssl_recv_t *f_recv, mbedtls_ssl_recv_timeout_t *f_recv_timeout)
+{
+	ssl->p_bio = p_bio;
+	ssl->f_send = f_send;
+	ssl->f_recv_timeout = f_recv_timeout;
+}
+
+int mbedtls_ssl_handshake (mbedtls_ssl_context *ssl)
+{
+	return 0;
+}
+
+uint32_t mbedtls_ssl_get_verify_result (const mbedtls_ssl_context *ssl)
+{
+	return 0;
+}
+
+size_t mbedtls_ssl_get_bytes_avail (const mbedtls_ssl_context *ssl)
+{
+	return ssl->in_len - ssl->in_offt;
+}
+
+int mbedtls_ssl_read (mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+{
+	if (ssl->in_offt == ssl->in_len) {
+		int ret = ssl->f_recv_timeout(ssl->p_bio, ssl->in_buf, sizeof(ssl->in_buf),
+										ssl->conf->read_timeout);
+
+		if (ret <= 0)
+			return ret;
+
+		ssl->in_offt = 0;
+		ssl->in_len = ret;
+	}
+
+	if (len > ssl->in_len - ssl->in_offt)
+		len = ssl->in_len - ssl->in_offt;
+
+	memcpy(buf, ssl->in_buf + ssl->in_offt, len);
+	ssl->in_offt += len;
+
+	return len;
+}
+
+int mbedtls_ssl_write (mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len)
+{
+	return ssl->f_send(ssl->p_bio, buf, len);
+}
+
+int mbedtls_ssl_close_notify (mbedtls_ssl_context *ssl)
+{
+	return 0;
+}
+
+void mbedtls_ssl_free (mbedtls_ssl_context *ssl)
+{
+}
+
+void mbedtls_ssl_config_free (mbedtls_ssl_config *conf)
+{
+}
+
+int mbedtls_x509_crt_info (char *buf, size_t size, const char *prefix, const mbedtls_x509_crt *crt)
+{
+	buf[0] = '\0';
+
+	return 0;
+}
+
+#endif /* #if defined(SUPPORT_MBEDTLS) */
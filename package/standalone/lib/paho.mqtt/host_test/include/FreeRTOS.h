@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __FREERTOS_H__
+#define __FREERTOS_H__
+/**********************************************************************************************/
+
+/*
+ * FreeRTOS kernel API used by the paho port (MQTTNrcImpl.c), implemented in host_stubs.c.
+ * There is a single task; the tick is a millisecond of CLOCK_MONOTONIC.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef int32_t TickType_t; /* signed, TimerLeftMS() checks for a negative count */
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef struct QueueDefinition *SemaphoreHandle_t;
+
+typedef void (*TaskFunction_t) (void *);
+
+typedef struct
+{
+	TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+#define configMINIMAL_STACK_SIZE	256
+
+#define pdFALSE						((BaseType_t)0)
+#define pdTRUE						((BaseType_t)1)
+
+#define portMAX_DELAY				((TickType_t)0x7fffffff)
+#define portTICK_PERIOD_MS			((TickType_t)1)
+
+#define pdMS_TO_TICKS(ms)			((TickType_t)(ms))
+
+extern BaseType_t xTaskCreate (TaskFunction_t func, const char *name, uint32_t stack_depth,
+								void *param, UBaseType_t priority, TaskHandle_t *handle);
+extern UBaseType_t uxTaskPriorityGet (TaskHandle_t task);
+extern void vTaskDelay (TickType_t ticks);
+extern TickType_t xTaskGetTickCount (void);
+extern void vTaskSetTimeOutState (TimeOut_t *timeout);
+extern BaseType_t xTaskCheckForTimeOut (TimeOut_t *timeout, TickType_t *ticks_to_wait);
+
+extern SemaphoreHandle_t xSemaphoreCreateMutex (void);
+extern BaseType_t xSemaphoreTake (SemaphoreHandle_t sem, TickType_t ticks);
+extern BaseType_t xSemaphoreGive (SemaphoreHandle_t sem);
+
+extern void *pvPortMalloc (size_t size);
+extern void vPortFree (void *ptr);
+
+/* when set, the allocation that counts it down to 0 fails */
+extern int host_malloc_countdown;
+
+/**********************************************************************************************/
+#endif /* #ifndef __FREERTOS_H__ */
@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __MBEDTLS_NET_H__
+#define __MBEDTLS_NET_H__
+/**********************************************************************************************/
+
+/*
+ * mbedtls network layer used by the TLS transport of the paho port, implemented in host_stubs.c
+ * over host sockets.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_NET_PROTO_TCP		0
+
+typedef struct
+{
+	int fd;
+} mbedtls_net_context;
+
+extern void mbedtls_net_init (mbedtls_net_context *ctx);
+extern int mbedtls_net_connect (mbedtls_net_context *ctx, const char *host, const char *port, int proto);
+extern int mbedtls_net_send (void *ctx, const unsigned char *buf, size_t len);
+extern int mbedtls_net_recv (void *ctx, unsigned char *buf, size_t len);
+extern int mbedtls_net_recv_timeout (void *ctx, unsigned char *buf, size_t len, uint32_t timeout);
+extern void mbedtls_net_free (mbedtls_net_context *ctx);
+
+/**********************************************************************************************/
+#endif /* #ifndef __MBEDTLS_NET_H__ */
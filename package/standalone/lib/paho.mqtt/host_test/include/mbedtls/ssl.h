@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __MBEDTLS_SSL_H__
+#define __MBEDTLS_SSL_H__
+/**********************************************************************************************/
+
+/*
+ * mbedtls SSL API used by the TLS transport of the paho port, implemented in host_stubs.c.
+ * There is no encryption, records are the bytes on the socket. As in mbedtls, a read takes
+ * whatever has arrived into the context and a read timeout of 0 waits without limit.
+ * Certificates are not parsed, MBEDTLS_X509_CRT_PARSE_C is not defined.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_ERR_SSL_TIMEOUT					-0x6800
+#define MBEDTLS_ERR_SSL_WANT_READ				-0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE				-0x6880
+#define MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY		-0x7880
+
+#define MBEDTLS_SSL_IS_CLIENT					0
+#define MBEDTLS_SSL_TRANSPORT_STREAM			0
+#define MBEDTLS_SSL_PRESET_DEFAULT				0
+#define MBEDTLS_SSL_VERIFY_NONE					0
+#define MBEDTLS_SSL_VERIFY_OPTIONAL				1
+
+#define MBEDTLS_X509_BADCERT_EXPIRED			0x01
+#define MBEDTLS_X509_BADCERT_REVOKED			0x02
+#define MBEDTLS_X509_BADCERT_CN_MISMATCH		0x04
+#define MBEDTLS_X509_BADCERT_NOT_TRUSTED		0x08
+
+#define MBEDTLS_SSL_IN_BUFFER_LEN				1024
+
+typedef struct mbedtls_x509_crt
+{
+	struct mbedtls_x509_crt *next;
+} mbedtls_x509_crt;
+
+typedef struct
+{
+	const void *pk_info;
+} mbedtls_pk_context;
+
+typedef int mbedtls_ssl_send_t (void *ctx, const unsigned char *buf, size_t len);
+typedef int mbedtls_ssl_recv_t (void *ctx, unsigned char *buf, size_t len);
+typedef int mbedtls_ssl_recv_timeout_t (void *ctx, unsigned char *buf, size_t len, uint32_t timeout);
+
+typedef struct
+{
+	uint32_t read_timeout;
+} mbedtls_ssl_config;
+
+typedef struct
+{
+	const mbedtls_ssl_config *conf;
+	void *p_bio;
+	mbedtls_ssl_send_t *f_send;
+	mbedtls_ssl_recv_timeout_t *f_recv_timeout;
+	unsigned char in_buf[MBEDTLS_SSL_IN_BUFFER_LEN];
+	size_t in_offt;
+	size_t in_len;
+} mbedtls_ssl_context;
+
+extern void mbedtls_ssl_init (mbedtls_ssl_context *ssl);
+extern void mbedtls_ssl_config_init (mbedtls_ssl_config *conf);
+extern int mbedtls_ssl_config_defaults (mbedtls_ssl_config *conf, int endpoint, int transport, int preset);
+extern void mbedtls_ssl_conf_authmode (mbedtls_ssl_config *conf, int authmode);
+extern void mbedtls_ssl_conf_rng (mbedtls_ssl_config *conf,
+								int (*f_rng) (void *, unsigned char *, size_t), void *p_rng);
+extern void mbedtls_ssl_conf_dbg (mbedtls_ssl_config *conf,
+								void (*f_dbg) (void *, int, const char *, int, const char *), void *p_dbg);
+extern void mbedtls_ssl_conf_read_timeout (mbedtls_ssl_config *conf, uint32_t timeout);
+extern int mbedtls_ssl_setup (mbedtls_ssl_context *ssl, const mbedtls_ssl_config *conf);
+extern int mbedtls_ssl_set_hostname (mbedtls_ssl_context *ssl, const char *hostname);
+extern void mbedtls_ssl_set_bio (mbedtls_ssl_context *ssl, void *p_bio, mbedtls_ssl_send_t *f_send,
+								mbedtls_ssl_recv_t *f_recv, mbedtls_ssl_recv_timeout_t *f_recv_timeout);
+extern int mbedtls_ssl_handshake (mbedtls_ssl_context *ssl);
+extern uint32_t mbedtls_ssl_get_verify_result (const mbedtls_ssl_context *ssl);
+extern size_t mbedtls_ssl_get_bytes_avail (const mbedtls_ssl_context *ssl);
+extern int mbedtls_ssl_read (mbedtls_ssl_context *ssl, unsigned char *buf, size_t len);
+extern int mbedtls_ssl_write (mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len);
+extern int mbedtls_ssl_close_notify (mbedtls_ssl_context *ssl);
+extern void mbedtls_ssl_free (mbedtls_ssl_context *ssl);
+extern void mbedtls_ssl_config_free (mbedtls_ssl_config *conf);
+
+extern int mbedtls_x509_crt_info (char *buf, size_t size, const char *prefix, const mbedtls_x509_crt *crt);
+
+/* reads made with a read timeout of 0, each of them would block the reader for good */
+extern unsigned int host_ssl_unbounded_read_count;
+
+/**********************************************************************************************/
+#endif /* #ifndef __MBEDTLS_SSL_H__ */
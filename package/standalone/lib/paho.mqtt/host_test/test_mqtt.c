@@ -0,0 +1,1164 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Newracom, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Host test of the paho port and client against a broker stand-in on a loopback socket.
+ *
+ *   test_mqtt                            all tests
+ *   test_mqtt receive|publish [scenario] one test, or one scenario of it
+ *   test_mqtt run                        MQTTRun() with packets split across segments
+ *   test_mqtt dispatch                   subscription dispatch, no broker
+ *
+ * receive: the broker sends PUBLISH packets and the select()/recv() calls made by the client for
+ * each message are counted, each of them is a round trip through the lwIP core on the target.
+ * test_mqtt_unbuffered is the same test built with MQTT_NETWORK_RX_BUFFER_SIZE 0 for comparison.
+ * test_mqtt_tls runs the tests over the TLS transport with an mbedtls stand-in that fails any read
+ * made with a timeout of 0, which mbedtls takes as no timeout.
+ *
+ * publish: QoS 1/2 publish throughput when the broker acks after an injected round trip time,
+ * with MQTTPublish() and with MQTTPublishAsync() and several in-flight windows. The acks are
+ * jittered so that they arrive out of order, and the retry scenario drops publishes.
+ *
+ * run: MQTTRun() reads publishes that arrive split across segments, the rest of a packet must be
+ * waited for even when its start came in with the packet before.
+ *
+ * dispatch: a topic stream is delivered to a few hundred device shadow, jobs and sensor
+ * subscriptions. The handlers called are checked against a linear scan with a reference matcher.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+
+#include "MQTTClient.h"
+#include "lwip/sockets.h"
+#if defined(SUPPORT_MBEDTLS)
+#include "mbedtls/ssl.h"
+#endif
+
+#define TEST_MQTT_TOPIC				"halow/11ah/mqtt/test"
+#define TEST_MQTT_MAX_PAYLOAD		700
+#define TEST_MQTT_BUF_SIZE			1024
+#define TEST_MQTT_TIMEOUT			1000
+
+#if defined(SUPPORT_MBEDTLS)
+#define TEST_MQTT_TRANSPORT			" over TLS"
+#else
+#define TEST_MQTT_TRANSPORT			""
+#endif
+
+#define TEST_MQTT_PUBLISH_COUNT		64
+#define TEST_MQTT_PUBLISH_RTT		30		/* ms */
+#define TEST_MQTT_PUBLISH_JITTER	10		/* ms */
+#define TEST_MQTT_PUBLISH_TIMEOUT	300		/* ms, command timeout and retry interval */
+
+extern int cycle (MQTTClient *c, Timer *timer);
+extern void MQTTRun (void *parm);
+
+typedef struct
+{
+	const char *name;
+	int count;
+	int burst;		/* messages sent before waiting for the client to catch up */
+	int fragment;	/* bytes per write, 0 writes whole bursts */
+	int max_select;	/* per 100 messages with the receive buffer, payloads above its size take a second recv() */
+	int max_recv;
+} test_mqtt_receive_scenario;
+
+static const test_mqtt_receive_scenario s_test_mqtt_receive_scenarios[] =
+{
+	{ "single",		1024,	1,		0,		100,	175 },
+	{ "burst",		1024,	64,		0,		50,		130 },
+	{ "fragment",	64,		4,		7,		-1,		-1 },
+};
+
+#define TEST_MQTT_RECEIVE_SCENARIOS (sizeof(s_test_mqtt_receive_scenarios) / sizeof(s_test_mqtt_receive_scenarios[0]))
+
+static int s_broker = -1;
+static const test_mqtt_receive_scenario *s_scenario;
+static volatile int s_received;
+static int s_errors;
+
+static int test_mqtt_payload (int seq, unsigned char *payload)
+{
+	int len = 4 + (seq * 37) % (TEST_MQTT_MAX_PAYLOAD - 4);
+	int i;
+
+	payload[0] = seq >> 24;
+	payload[1] = seq >> 16;
+	payload[2] = seq >> 8;
+	payload[3] = seq;
+
+	for (i = 4 ; i < len ; i++)
+		payload[i] = seq + i;
+
+	return len;
+}
+
+static void test_mqtt_message (MessageData *md)
+{
+	unsigned char payload[TEST_MQTT_MAX_PAYLOAD];
+	int len = test_mqtt_payload(s_received, payload);
+
+	if (!MQTTPacket_equals(md->topicName, TEST_MQTT_TOPIC) ||
+			md->message->payloadlen != len || memcmp(md->message->payload, payload, len) != 0) {
+		printf("  message %d: unexpected topic or payload\n", s_received);
+		s_errors++;
+	}
+
+	s_received++;
+}
+
+static int test_mqtt_write (const unsigned char *buf, int len)
+{
+	int fragment = s_scenario->fragment ? s_scenario->fragment : len;
+	int off;
+
+	for (off = 0 ; off < len ; off += fragment) {
+		int size = (len - off < fragment) ? len - off : fragment;
+
+		if (write(s_broker, buf + off, size) != size)
+			return -1;
+
+		if (s_scenario->fragment)
+			usleep(100);
+	}
+
+	return 0;
+}
+
+static void *test_mqtt_receive_broker (void *arg)
+{
+	static unsigned char buf[64 * (TEST_MQTT_MAX_PAYLOAD + 32)];
+	unsigned char payload[TEST_MQTT_MAX_PAYLOAD];
+	MQTTString topic = MQTTString_initializer;
+	int seq = 0;
+
+	topic.cstring = TEST_MQTT_TOPIC;
+
+	while (seq < s_scenario->count) {
+		int len = 0;
+		int i;
+
+		for (i = 0 ; i < s_scenario->burst && seq < s_scenario->count ; i++, seq++) {
+			int size = test_mqtt_payload(seq, payload);
+
+			len += MQTTSerialize_publish(buf + len, sizeof(buf) - len, 0, 0, 0, 0,
+										topic, payload, size);
+		}
+
+		if (test_mqtt_write(buf, len) < 0)
+			break;
+
+		/* let the client catch up so that the next burst arrives on its own */
+		while (s_received < seq && s_errors == 0)
+			usleep(20);
+	}
+
+	return NULL;
+}
+
+static int test_mqtt_connect (Network *n, MQTTClient *c, unsigned char *sendbuf, unsigned char *readbuf)
+{
+	MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+#if defined(SUPPORT_MBEDTLS)
+	Certs certs = { NULL, };
+#endif
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+	unsigned char connack[4];
+	int listener;
+	int len;
+
+	listener = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0 ||
+			getsockname(listener, (struct sockaddr *)&addr, &addrlen) < 0) {
+		close(listener);
+		return -1;
+	}
+
+	NetworkInit(n);
+#if defined(SUPPORT_MBEDTLS)
+	if (NetworkConnectTLS(n, "127.0.0.1", ntohs(addr.sin_port), &certs) != 0) {
+#else
+	if (NetworkConnect(n, "127.0.0.1", ntohs(addr.sin_port)) != 0) {
+#endif
+		close(listener);
+		return -1;
+	}
+
+	s_broker = accept(listener, NULL, NULL);
+	close(listener);
+	if (s_broker < 0)
+		return -1;
+
+	/* the CONNECT is left unread, the socket buffer holds it */
+	len = MQTTSerialize_connack(connack, sizeof(connack), 0, 0);
+	if (write(s_broker, connack, len) != len)
+		return -1;
+
+	MQTTClientInit(c, n, TEST_MQTT_TIMEOUT, sendbuf, TEST_MQTT_BUF_SIZE, readbuf, TEST_MQTT_BUF_SIZE);
+	if (MQTTConnect(c, &options) != SUCCESS)
+		return -1;
+
+	c->defaultMessageHandler = test_mqtt_message;
+
+	return 0;
+}
+
+static void test_mqtt_disconnect (Network *n)
+{
+#if defined(SUPPORT_MBEDTLS)
+	n->disconnect(n);
+	NetworkDisconnectTLS(n);
+#else
+	NetworkDisconnect(n);
+#endif
+}
+
+static int test_mqtt_receive_run (const test_mqtt_receive_scenario *scenario)
+{
+	static unsigned char sendbuf[TEST_MQTT_BUF_SIZE], readbuf[TEST_MQTT_BUF_SIZE];
+	unsigned int selects, recvs;
+	struct timespec start, end;
+	pthread_t broker;
+	MQTTClient c;
+	Network n;
+	Timer timer;
+	double us;
+	int ret = 0;
+	int rc;
+
+	s_scenario = scenario;
+	s_received = 0;
+	s_errors = 0;
+
+	if (test_mqtt_connect(&n, &c, sendbuf, readbuf) != 0) {
+		printf("  %-10s connect failed\n", scenario->name);
+		return 1;
+	}
+
+	/* nothing pending, the read times out */
+	TimerInit(&timer);
+	TimerCountdownMS(&timer, 10);
+	if ((rc = cycle(&c, &timer)) != 0) {
+		printf("  %-10s idle read returned %d\n", scenario->name, rc);
+		ret = 1;
+	}
+
+	/* nor does a poll, which must not wait */
+	TimerCountdownMS(&timer, 0);
+	if ((rc = cycle(&c, &timer)) != 0) {
+		printf("  %-10s poll returned %d\n", scenario->name, rc);
+		ret = 1;
+	}
+
+	selects = host_select_count;
+	recvs = host_recv_count;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	pthread_create(&broker, NULL, test_mqtt_receive_broker, NULL);
+
+	while (s_received < scenario->count && s_errors == 0) {
+		TimerInit(&timer);
+		TimerCountdownMS(&timer, TEST_MQTT_TIMEOUT);
+		if ((rc = cycle(&c, &timer)) <= 0) {
+			printf("  %-10s read failed after %d messages: %d\n", scenario->name, s_received, rc);
+			s_errors++;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	selects = host_select_count - selects;
+	recvs = host_recv_count - recvs;
+
+	/* unblock the broker before joining it if the client gave up */
+	s_errors += (s_received < scenario->count);
+	pthread_join(broker, NULL);
+
+	test_mqtt_disconnect(&n);
+	close(s_broker);
+
+	us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+	printf("  %-10s %5d %11.2f %9.2f %8.1f\n", scenario->name, s_received,
+			(double)selects / scenario->count, (double)recvs / scenario->count, us / scenario->count);
+
+	if (s_errors)
+		ret = 1;
+
+#if defined(SUPPORT_MBEDTLS)
+	/* mbedtls takes a read timeout of 0 as no timeout at all */
+	if (host_ssl_unbounded_read_count > 0) {
+		printf("  %-10s %u TLS reads without a timeout\n", scenario->name, host_ssl_unbounded_read_count);
+		host_ssl_unbounded_read_count = 0;
+		ret = 1;
+	}
+#endif
+
+#if MQTT_NETWORK_RX_BUFFER_SIZE > 0
+	if ((scenario->max_select >= 0 && selects * 100 > scenario->max_select * scenario->count) ||
+			(scenario->max_recv >= 0 && recvs * 100 > scenario->max_recv * scenario->count)) {
+		printf("  %-10s more socket calls than expected\n", scenario->name);
+		ret = 1;
+	}
+#endif
+
+	return ret;
+}
+
+static int test_mqtt_receive (int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	printf("MQTT receive%s, %d byte buffer, payload 4..%d bytes\n", TEST_MQTT_TRANSPORT,
+			MQTT_NETWORK_RX_BUFFER_SIZE, TEST_MQTT_MAX_PAYLOAD - 1);
+	printf("  scenario    msgs  select/msg  recv/msg   us/msg\n");
+
+	for (i = 0 ; i < TEST_MQTT_RECEIVE_SCENARIOS ; i++) {
+		if (argc > 1 && strcmp(argv[1], s_test_mqtt_receive_scenarios[i].name) != 0)
+			continue;
+
+		ret |= test_mqtt_receive_run(&s_test_mqtt_receive_scenarios[i]);
+	}
+
+	printf("%s\n", ret ? "FAIL" : "PASS");
+
+	return ret;
+}
+
+/**********************************************************************************************/
+
+typedef struct
+{
+	const char *name;
+	int qos;
+	int window;		/* 0 publishes with MQTTPublish() */
+	int drop;		/* the broker ignores the first transmission of every drop-th publish */
+} test_mqtt_publish_scenario;
+
+static const test_mqtt_publish_scenario s_test_mqtt_publish_scenarios[] =
+{
+	{ "sync1",		1,	0,	0 },
+	{ "async1",		1,	1,	0 },
+	{ "async4",		1,	4,	0 },
+	{ "async8",		1,	8,	0 },
+	{ "sync2",		2,	0,	0 },
+	{ "async8-qos2",	2,	8,	0 },
+	{ "retry",		1,	8,	10 },
+};
+
+#define TEST_MQTT_PUBLISH_SCENARIOS (sizeof(s_test_mqtt_publish_scenarios) / sizeof(s_test_mqtt_publish_scenarios[0]))
+
+typedef struct
+{
+	TickType_t time;
+	int type;
+	unsigned short id;
+} test_mqtt_ack;
+
+static const test_mqtt_publish_scenario *s_publish;
+static unsigned char s_published[TEST_MQTT_PUBLISH_COUNT];	/* times each message reached the broker */
+static int s_duplicates;
+static int s_completed;
+static int s_failed;
+
+static void test_mqtt_send_ack (int type, unsigned short id)
+{
+	unsigned char buf[4];
+	int len = MQTTSerialize_ack(buf, sizeof(buf), type, 0, id);
+
+	if (write(s_broker, buf, len) != len)
+		s_errors++;
+}
+
+static void test_mqtt_publish_packet (unsigned char *buf, int len, test_mqtt_ack *acks, int *nacks)
+{
+	MQTTHeader header;
+	unsigned char dup, retained, *payload;
+	int qos, payloadlen;
+	unsigned short id;
+	MQTTString topic;
+	int type = 0;
+	int seq;
+
+	header.byte = buf[0];
+
+	switch (header.bits.type) {
+		case PUBLISH:
+			if (MQTTDeserialize_publish(&dup, &qos, &retained, &id, &topic, &payload, &payloadlen,
+										buf, len) != 1 || payloadlen != 4) {
+				s_errors++;
+				return;
+			}
+
+			seq = (payload[0] << 24) | (payload[1] << 16) | (payload[2] << 8) | payload[3];
+			if (seq < 0 || seq >= TEST_MQTT_PUBLISH_COUNT) {
+				s_errors++;
+				return;
+			}
+
+			if (s_published[seq]++ > 0) {
+				s_duplicates++;
+				if (!dup)
+					s_errors++;
+			} else if (s_publish->drop && seq % s_publish->drop == s_publish->drop - 1) {
+				return;
+			}
+
+			type = (qos == 2) ? PUBREC : PUBACK;
+			break;
+
+		case PUBREL:
+			if (MQTTDeserialize_ack(&dup, &dup, &id, buf, len) != 1) {
+				s_errors++;
+				return;
+			}
+			type = PUBCOMP;
+			break;
+
+		default:
+			return;
+	}
+
+	/* a later publish can be acked first */
+	acks[*nacks].time = xTaskGetTickCount() + TEST_MQTT_PUBLISH_RTT + (id * 7) % TEST_MQTT_PUBLISH_JITTER;
+	acks[*nacks].type = type;
+	acks[*nacks].id = id;
+	(*nacks)++;
+}
+
+static void *test_mqtt_publish_broker (void *arg)
+{
+	static test_mqtt_ack acks[TEST_MQTT_PUBLISH_COUNT * 4];
+	static unsigned char buf[TEST_MQTT_BUF_SIZE * 4];
+	int nacks = 0;
+	int len = 0;
+
+	for (;;) {
+		struct pollfd pfd = { s_broker, POLLIN, 0 };
+		TickType_t now = xTaskGetTickCount();
+		int timeout = -1;
+		int i, rc;
+
+		for (i = 0 ; i < nacks ; i++) {
+			if (acks[i].time <= now) {
+				test_mqtt_send_ack(acks[i].type, acks[i].id);
+				acks[i--] = acks[--nacks];
+			} else if (timeout < 0 || acks[i].time - now < timeout) {
+				timeout = acks[i].time - now;
+			}
+		}
+
+		if (poll(&pfd, 1, timeout) <= 0)
+			continue;
+
+		rc = read(s_broker, buf + len, sizeof(buf) - len);
+		if (rc <= 0)
+			break;
+		len += rc;
+
+		/* handle every complete packet */
+		for (;;) {
+			int rem_len = 0, multiplier = 1, pos = 1;
+
+			for (; pos < len && (buf[pos] & 128) ; pos++, multiplier *= 128)
+				rem_len += (buf[pos] & 127) * multiplier;
+
+			if (pos >= len)
+				break;
+			rem_len += buf[pos++] * multiplier;
+
+			if (pos + rem_len > len)
+				break;
+
+			test_mqtt_publish_packet(buf, pos + rem_len, acks, &nacks);
+			memmove(buf, buf + pos + rem_len, len - pos - rem_len);
+			len -= pos + rem_len;
+		}
+	}
+
+	return NULL;
+}
+
+static void test_mqtt_published (void *context, unsigned short id, int rc)
+{
+	if (rc == SUCCESS)
+		s_completed++;
+	else
+		s_failed++;
+}
+
+static int test_mqtt_publish_run (const test_mqtt_publish_scenario *scenario)
+{
+	static unsigned char sendbuf[TEST_MQTT_BUF_SIZE], readbuf[TEST_MQTT_BUF_SIZE];
+	static unsigned char payloads[TEST_MQTT_PUBLISH_COUNT][4];
+	struct timespec start, end;
+	pthread_t broker;
+	MQTTClient c;
+	Network n;
+	Timer timer;
+	double ms;
+	int ret = 0;
+	int i;
+
+	s_publish = scenario;
+	s_errors = 0;
+	s_duplicates = 0;
+	s_completed = 0;
+	s_failed = 0;
+	memset(s_published, 0, sizeof(s_published));
+
+	if (test_mqtt_connect(&n, &c, sendbuf, readbuf) != 0) {
+		printf("  %-12s connect failed\n", scenario->name);
+		return 1;
+	}
+
+	c.command_timeout_ms = TEST_MQTT_PUBLISH_TIMEOUT;
+	if (scenario->window)
+		MQTTSetInflightWindow(&c, scenario->window);
+
+	pthread_create(&broker, NULL, test_mqtt_publish_broker, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0 ; i < TEST_MQTT_PUBLISH_COUNT ; i++) {
+		MQTTMessage message;
+		int rc;
+
+		payloads[i][0] = i >> 24;
+		payloads[i][1] = i >> 16;
+		payloads[i][2] = i >> 8;
+		payloads[i][3] = i;
+
+		memset(&message, 0, sizeof(message));
+		message.qos = scenario->qos;
+		message.payload = payloads[i];
+		message.payloadlen = sizeof(payloads[i]);
+
+		if (scenario->window)
+			rc = MQTTPublishAsync(&c, TEST_MQTT_TOPIC, &message, test_mqtt_published, NULL);
+		else if ((rc = MQTTPublish(&c, TEST_MQTT_TOPIC, &message)) == SUCCESS)
+			s_completed++;
+
+		if (rc != SUCCESS) {
+			printf("  %-12s publish %d failed: %d\n", scenario->name, i, rc);
+			ret = 1;
+			break;
+		}
+	}
+
+	/* read the acks of the publishes still in flight */
+	while (MQTTInflightCount(&c) > 0 && MQTTIsConnected(&c)) {
+		TimerInit(&timer);
+		TimerCountdownMS(&timer, TEST_MQTT_PUBLISH_TIMEOUT);
+		cycle(&c, &timer);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	MQTTDisconnect(&c);
+	test_mqtt_disconnect(&n);
+	pthread_join(broker, NULL);
+	close(s_broker);
+
+	for (i = 0 ; i < TEST_MQTT_PUBLISH_COUNT ; i++) {
+		if (s_published[i] == 0)
+			s_errors++;
+	}
+
+	ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+	printf("  %-12s %4d %6d %6d %6d %9.0f %8.1f\n", scenario->name, scenario->qos, scenario->window,
+			s_completed, s_duplicates, ms, TEST_MQTT_PUBLISH_COUNT * 1e3 / ms);
+
+	if (s_errors || s_failed || s_completed != TEST_MQTT_PUBLISH_COUNT ||
+			(scenario->drop == 0 && s_duplicates != 0)) {
+		printf("  %-12s %d errors, %d failed\n", scenario->name, s_errors, s_failed);
+		ret = 1;
+	}
+
+#if defined(SUPPORT_MBEDTLS)
+	if (host_ssl_unbounded_read_count > 0) {
+		printf("  %-12s %u TLS reads without a timeout\n", scenario->name, host_ssl_unbounded_read_count);
+		host_ssl_unbounded_read_count = 0;
+		ret = 1;
+	}
+#endif
+
+	return ret;
+}
+
+static int test_mqtt_publish (int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	printf("MQTT publish%s, %d messages, %d ms round trip time\n", TEST_MQTT_TRANSPORT,
+			TEST_MQTT_PUBLISH_COUNT, TEST_MQTT_PUBLISH_RTT);
+	printf("  scenario      qos window  acked    dup   time/ms    msg/s\n");
+
+	for (i = 0 ; i < TEST_MQTT_PUBLISH_SCENARIOS ; i++) {
+		if (argc > 1 && strcmp(argv[1], s_test_mqtt_publish_scenarios[i].name) != 0)
+			continue;
+
+		ret |= test_mqtt_publish_run(&s_test_mqtt_publish_scenarios[i]);
+	}
+
+	printf("%s\n", ret ? "FAIL" : "PASS");
+
+	return ret;
+}
+
+/**********************************************************************************************/
+
+#define TEST_MQTT_RUN_COUNT			32		/* QoS 1 messages, sent in pairs */
+#define TEST_MQTT_RUN_GAP			30		/* ms between the segments of a pair */
+
+static void *test_mqtt_run_task (void *arg)
+{
+	MQTTRun(arg);
+
+	return NULL;
+}
+
+/* read the PUBACKs of the client, the CONNECT left unread is skipped */
+static int test_mqtt_run_acks (int count)
+{
+	static unsigned char buf[TEST_MQTT_BUF_SIZE];
+	int acks = 0;
+	int len = 0;
+
+	while (acks < count) {
+		struct pollfd pfd = { s_broker, POLLIN, 0 };
+		int rc;
+
+		if (poll(&pfd, 1, TEST_MQTT_TIMEOUT) <= 0)
+			break;
+
+		rc = read(s_broker, buf + len, sizeof(buf) - len);
+		if (rc <= 0)
+			break;
+		len += rc;
+
+		for (;;) {
+			int rem_len = 0, multiplier = 1, pos = 1;
+			MQTTHeader header;
+
+			for (; pos < len && (buf[pos] & 128) ; pos++, multiplier *= 128)
+				rem_len += (buf[pos] & 127) * multiplier;
+
+			if (pos >= len)
+				break;
+			rem_len += buf[pos++] * multiplier;
+
+			if (pos + rem_len > len)
+				break;
+
+			header.byte = buf[0];
+			if (header.bits.type == PUBACK) {
+				unsigned char type, dup;
+				unsigned short id;
+
+				if (MQTTDeserialize_ack(&type, &dup, &id, buf, pos + rem_len) != 1 || id != acks + 1)
+					s_errors++;
+				acks++;
+			}
+
+			memmove(buf, buf + pos + rem_len, len - pos - rem_len);
+			len -= pos + rem_len;
+		}
+	}
+
+	return acks;
+}
+
+/*
+ * MQTTRun() reads on while more has arrived. The broker sends QoS 1 publishes in pairs: the
+ * first one whole with the header byte of the second, then its remaining length, then the rest,
+ * each after a pause. The client must wait for the rest of the second publish and ack both.
+ */
+static int test_mqtt_run (int argc, char *argv[])
+{
+	static unsigned char sendbuf[TEST_MQTT_BUF_SIZE], readbuf[TEST_MQTT_BUF_SIZE];
+	static unsigned char buf[2 * (TEST_MQTT_MAX_PAYLOAD + 32)];
+	unsigned char payload[TEST_MQTT_MAX_PAYLOAD];
+	MQTTString topic = MQTTString_initializer;
+	pthread_t task;
+	MQTTClient c;
+	Network n;
+	int seq, acks;
+	int ret = 0;
+
+	printf("MQTT run%s, %d byte buffer, %d publishes split across segments\n", TEST_MQTT_TRANSPORT,
+			MQTT_NETWORK_RX_BUFFER_SIZE, TEST_MQTT_RUN_COUNT);
+
+	topic.cstring = TEST_MQTT_TOPIC;
+	s_received = 0;
+	s_errors = 0;
+
+	if (test_mqtt_connect(&n, &c, sendbuf, readbuf) != 0) {
+		printf("  connect failed\n");
+		printf("FAIL\n");
+		return 1;
+	}
+
+	pthread_create(&task, NULL, test_mqtt_run_task, &c);
+
+	for (seq = 0 ; seq < TEST_MQTT_RUN_COUNT && s_errors == 0 ; seq += 2) {
+		int segments[3];
+		int first, off, i;
+		TickType_t start;
+
+		first = MQTTSerialize_publish(buf, sizeof(buf), 0, 1, 0, seq + 1, topic,
+									payload, test_mqtt_payload(seq, payload));
+		segments[0] = first + 1;
+		segments[1] = 1;
+		segments[2] = MQTTSerialize_publish(buf + first, sizeof(buf) - first, 0, 1, 0, seq + 2, topic,
+									payload, test_mqtt_payload(seq + 1, payload)) - 2;
+
+		for (i = 0, off = 0 ; i < 3 ; off += segments[i++]) {
+			if (i > 0)
+				usleep(TEST_MQTT_RUN_GAP * 1000);
+			if (write(s_broker, buf + off, segments[i]) != segments[i])
+				s_errors++;
+		}
+
+		start = xTaskGetTickCount();
+		while (s_received < seq + 2 && s_errors == 0) {
+			if (xTaskGetTickCount() - start > TEST_MQTT_TIMEOUT) {
+				printf("  publish %d not received\n", s_received);
+				s_errors++;
+			}
+			usleep(1000);
+		}
+	}
+
+	acks = test_mqtt_run_acks(TEST_MQTT_RUN_COUNT);
+
+	pthread_cancel(task);
+	pthread_join(task, NULL);
+
+	printf("  received %d, acked %d, %s\n", s_received, acks,
+			MQTTIsConnected(&c) ? "connected" : "disconnected");
+
+	if (s_errors || s_received != TEST_MQTT_RUN_COUNT || acks != TEST_MQTT_RUN_COUNT || !MQTTIsConnected(&c))
+		ret = 1;
+
+#if defined(SUPPORT_MBEDTLS)
+	if (host_ssl_unbounded_read_count > 0) {
+		printf("  %u TLS reads without a timeout\n", host_ssl_unbounded_read_count);
+		host_ssl_unbounded_read_count = 0;
+		ret = 1;
+	}
+#endif
+
+	test_mqtt_disconnect(&n);
+	close(s_broker);
+
+	printf("%s\n", ret ? "FAIL" : "PASS");
+
+	return ret;
+}
+
+/**********************************************************************************************/
+
+/*
+ * The broker sends half of a publish and then nothing. The bytes already taken can't be put
+ * back, so the read must fail and close the session rather than time out and lose its place.
+ */
+static int test_mqtt_stall (int argc, char *argv[])
+{
+	static unsigned char sendbuf[TEST_MQTT_BUF_SIZE], readbuf[TEST_MQTT_BUF_SIZE];
+	static unsigned char buf[TEST_MQTT_MAX_PAYLOAD + 32];
+	unsigned char payload[TEST_MQTT_MAX_PAYLOAD];
+	MQTTString topic = MQTTString_initializer;
+	MQTTClient c;
+	Network n;
+	Timer timer;
+	int ret = 0;
+	int len;
+	int rc;
+
+	printf("MQTT stall%s, %d byte buffer, publish cut off after half\n", TEST_MQTT_TRANSPORT,
+			MQTT_NETWORK_RX_BUFFER_SIZE);
+
+	topic.cstring = TEST_MQTT_TOPIC;
+	s_received = 0;
+	s_errors = 0;
+
+	if (test_mqtt_connect(&n, &c, sendbuf, readbuf) != 0) {
+		printf("  connect failed\n");
+		printf("FAIL\n");
+		return 1;
+	}
+
+	memset(payload, 0x5a, sizeof(payload));
+	len = MQTTSerialize_publish(buf, sizeof(buf), 0, 0, 0, 0, topic, payload, sizeof(payload));
+	if (write(s_broker, buf, len / 2) != len / 2)
+		s_errors++;
+
+	TimerInit(&timer);
+	TimerCountdownMS(&timer, TEST_MQTT_TIMEOUT);
+	rc = cycle(&c, &timer);
+
+	printf("  cycle returned %d, received %d, %s\n", rc, s_received,
+			MQTTIsConnected(&c) ? "connected" : "disconnected");
+
+	if (s_errors || rc >= 0 || s_received != 0 || MQTTIsConnected(&c))
+		ret = 1;
+
+	test_mqtt_disconnect(&n);
+	close(s_broker);
+
+	printf("%s\n", ret ? "FAIL" : "PASS");
+
+	return ret;
+}
+
+/**********************************************************************************************/
+
+#define TEST_MQTT_DEVICES			40
+#define TEST_MQTT_HANDLERS			8
+#define TEST_MQTT_TOPICS			4096
+#define TEST_MQTT_DISPATCH_ROUNDS	16
+
+extern int deliverMessage (MQTTClient *c, MQTTString *topicName, MQTTMessage *message);
+
+static const char *s_test_mqtt_filters[] =
+{
+	"$aws/things/dev%d/shadow/update/accepted",
+	"$aws/things/dev%d/shadow/update/rejected",
+	"$aws/things/dev%d/shadow/update/delta",
+	"$aws/things/dev%d/shadow/get/+",
+	"$aws/things/dev%d/jobs/notify-next",
+	"$aws/things/dev%d/jobs/+/get/accepted",
+	"$aws/things/dev%d/jobs/+/update/#",
+};
+
+static const char *s_test_mqtt_shared_filters[] =
+{
+	"sensors/+/temperature",
+	"sensors/#",
+	"home/+/+/state",
+	"+/status",
+	"#",
+	"$SYS/#",
+};
+
+/* device numbers above TEST_MQTT_DEVICES have no subscriptions */
+static const char *s_test_mqtt_topics[] =
+{
+	"$aws/things/dev%d/shadow/update/accepted",
+	"$aws/things/dev%d/shadow/update/delta",
+	"$aws/things/dev%d/shadow/get/accepted",
+	"$aws/things/dev%d/shadow/delete/accepted",
+	"$aws/things/dev%d/jobs/notify-next",
+	"$aws/things/dev%d/jobs/job%d/get/accepted",
+	"$aws/things/dev%d/jobs/job%d/update/accepted",
+	"sensors/s%d/temperature",
+	"sensors/s%d/humidity/%d",
+	"home/h%d/room%d/state",
+	"dev%d/status",
+	"$SYS/broker/clients/%d",
+};
+
+#define TEST_MQTT_FILTER_COUNT (sizeof(s_test_mqtt_filters) / sizeof(s_test_mqtt_filters[0]))
+#define TEST_MQTT_SHARED_FILTER_COUNT (sizeof(s_test_mqtt_shared_filters) / sizeof(s_test_mqtt_shared_filters[0]))
+#define TEST_MQTT_TOPIC_COUNT (sizeof(s_test_mqtt_topics) / sizeof(s_test_mqtt_topics[0]))
+#define TEST_MQTT_SUBSCRIPTIONS (TEST_MQTT_DEVICES * TEST_MQTT_FILTER_COUNT + TEST_MQTT_SHARED_FILTER_COUNT)
+
+static char s_subscriptions[TEST_MQTT_SUBSCRIPTIONS][64];
+static char s_topics[TEST_MQTT_TOPICS][64];
+static int s_hits[TEST_MQTT_HANDLERS];
+static int s_default_hits;
+
+#define TEST_MQTT_HANDLER(n) static void test_mqtt_handler##n (MessageData *md) { s_hits[n]++; }
+TEST_MQTT_HANDLER(0) TEST_MQTT_HANDLER(1) TEST_MQTT_HANDLER(2) TEST_MQTT_HANDLER(3)
+TEST_MQTT_HANDLER(4) TEST_MQTT_HANDLER(5) TEST_MQTT_HANDLER(6) TEST_MQTT_HANDLER(7)
+
+static const messageHandler s_handlers[TEST_MQTT_HANDLERS] =
+{
+	test_mqtt_handler0, test_mqtt_handler1, test_mqtt_handler2, test_mqtt_handler3,
+	test_mqtt_handler4, test_mqtt_handler5, test_mqtt_handler6, test_mqtt_handler7,
+};
+
+static void test_mqtt_default_handler (MessageData *md)
+{
+	s_default_hits++;
+}
+
+/* topic filter matching as specified by MQTT 3.1.1, section 4.7 */
+static int test_mqtt_match (const char *filter, const char *topic)
+{
+	if (topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+		return 0;
+
+	for (;;) {
+		const char *f_end = strchr(filter, '/');
+		const char *t_end = strchr(topic, '/');
+		int f_len = f_end ? f_end - filter : strlen(filter);
+		int t_len = t_end ? t_end - topic : strlen(topic);
+
+		if (f_len == 1 && filter[0] == '#')
+			return 1;
+		if (!(f_len == 1 && filter[0] == '+') && (f_len != t_len || memcmp(filter, topic, f_len) != 0))
+			return 0;
+		if (!f_end || !t_end) {
+			/* "a/#" matches "a" as well */
+			return (!f_end && !t_end) || (f_end && !t_end && strcmp(f_end, "/#") == 0);
+		}
+
+		filter = f_end + 1;
+		topic = t_end + 1;
+	}
+}
+
+static void test_mqtt_topic_stream (void)
+{
+	unsigned int seed = 12345;
+	int i;
+
+	for (i = 0 ; i < TEST_MQTT_TOPICS ; i++) {
+		int a, b;
+
+		seed = seed * 1103515245 + 12345;
+		a = (seed >> 8) % (TEST_MQTT_DEVICES + TEST_MQTT_DEVICES / 4);
+		b = (seed >> 20) % 16;
+		snprintf(s_topics[i], sizeof(s_topics[i]), s_test_mqtt_topics[(seed >> 16) % TEST_MQTT_TOPIC_COUNT], a, b);
+	}
+}
+
+/* subscribed: every subscribed-th subscription is set, 0 for none */
+static int test_mqtt_dispatch_check (MQTTClient *c, int subscribed, const char *step)
+{
+	int expected[TEST_MQTT_HANDLERS];
+	int expected_default;
+	int errors = 0;
+	int i, j;
+
+	for (i = 0 ; i < TEST_MQTT_TOPICS ; i++) {
+		MQTTString topic = MQTTString_initializer;
+		MQTTMessage message;
+
+		memset(expected, 0, sizeof(expected));
+		for (j = 0 ; j < TEST_MQTT_SUBSCRIPTIONS ; j++) {
+			if (subscribed && j % subscribed == 0 && test_mqtt_match(s_subscriptions[j], s_topics[i]))
+				expected[j % TEST_MQTT_HANDLERS]++;
+		}
+		expected_default = (memcmp(expected, (int[TEST_MQTT_HANDLERS]){ 0 }, sizeof(expected)) == 0);
+
+		memset(s_hits, 0, sizeof(s_hits));
+		s_default_hits = 0;
+		memset(&message, 0, sizeof(message));
+		topic.lenstring.data = s_topics[i];
+		topic.lenstring.len = strlen(s_topics[i]);
+		deliverMessage(c, &topic, &message);
+
+		if (memcmp(expected, s_hits, sizeof(expected)) != 0 || expected_default != s_default_hits) {
+			if (errors++ < 5)
+				printf("  %s: %s delivered to the wrong handlers\n", step, s_topics[i]);
+		}
+	}
+
+	return errors;
+}
+
+static int test_mqtt_dispatch_nodes (MQTTTopicNode *node)
+{
+	int count = 1;
+	int i;
+
+	if (node == NULL)
+		return 0;
+
+	for (i = 0 ; i < node->nchildren ; i++)
+		count += test_mqtt_dispatch_nodes(node->children[i]);
+
+	return count + test_mqtt_dispatch_nodes(node->plus) + test_mqtt_dispatch_nodes(node->hash);
+}
+
+/* neither an invalid filter nor running out of memory part-way leaves nodes behind */
+static int test_mqtt_dispatch_failed_set (MQTTClient *c)
+{
+	const char *filter = "$aws/things/dev1/jobs/oom/+/next/#";
+	int nodes = test_mqtt_dispatch_nodes(c->messageHandlers.root);
+	int count = c->messageHandlers.count;
+	int errors = 0;
+	int i, rc;
+
+	if (MQTTSetMessageHandler(c, "$aws/things/dev1/jobs/oom/b+/c", s_handlers[0]) == SUCCESS ||
+			MQTTSetMessageHandler(c, "$aws/things/dev1/jobs/oom/#/c", s_handlers[0]) == SUCCESS)
+		errors++;
+
+	/* fail the first allocation, then the second and so on until the filter fits */
+	for (i = 1, rc = FAILURE ; rc != SUCCESS ; i++) {
+		host_malloc_countdown = i;
+		rc = MQTTSetMessageHandler(c, filter, s_handlers[0]);
+		host_malloc_countdown = 0;
+
+		if (rc != SUCCESS && (test_mqtt_dispatch_nodes(c->messageHandlers.root) != nodes ||
+								c->messageHandlers.count != count)) {
+			printf("  allocation %d failed: %d nodes left, %d before\n", i,
+					test_mqtt_dispatch_nodes(c->messageHandlers.root), nodes);
+			errors++;
+		}
+	}
+
+	if (MQTTSetMessageHandler(c, filter, NULL) != SUCCESS ||
+			test_mqtt_dispatch_nodes(c->messageHandlers.root) != nodes)
+		errors++;
+
+	return errors;
+}
+
+static int test_mqtt_dispatch (int argc, char *argv[])
+{
+	static MQTTClient c;
+	struct timespec start, end;
+	double linear_us, trie_us;
+	int delivered = 0;
+	int errors = 0;
+	int i, j, round;
+
+	MQTTClientInit(&c, NULL, TEST_MQTT_TIMEOUT, NULL, 0, NULL, 0);
+	c.defaultMessageHandler = test_mqtt_default_handler;
+
+	for (i = 0 ; i < TEST_MQTT_SUBSCRIPTIONS ; i++) {
+		if (i < TEST_MQTT_DEVICES * TEST_MQTT_FILTER_COUNT)
+			snprintf(s_subscriptions[i], sizeof(s_subscriptions[i]),
+						s_test_mqtt_filters[i % TEST_MQTT_FILTER_COUNT], i / TEST_MQTT_FILTER_COUNT);
+		else
+			strcpy(s_subscriptions[i], s_test_mqtt_shared_filters[i - TEST_MQTT_DEVICES * TEST_MQTT_FILTER_COUNT]);
+
+		if (MQTTSetMessageHandler(&c, s_subscriptions[i], s_handlers[i % TEST_MQTT_HANDLERS]) != SUCCESS) {
+			printf("  %s: subscription failed\n", s_subscriptions[i]);
+			errors++;
+		}
+	}
+
+	test_mqtt_topic_stream();
+
+	printf("MQTT dispatch, %d subscriptions, %d topics\n", c.messageHandlers.count, TEST_MQTT_TOPICS);
+
+	errors += test_mqtt_dispatch_check(&c, 1, "all");
+	errors += test_mqtt_dispatch_failed_set(&c);
+
+	/* the old handler table: every filter is matched against every topic */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (round = 0 ; round < TEST_MQTT_DISPATCH_ROUNDS ; round++) {
+		for (i = 0 ; i < TEST_MQTT_TOPICS ; i++) {
+			for (j = 0 ; j < TEST_MQTT_SUBSCRIPTIONS ; j++)
+				delivered += test_mqtt_match(s_subscriptions[j], s_topics[i]);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	linear_us = ((end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3) /
+				(TEST_MQTT_DISPATCH_ROUNDS * TEST_MQTT_TOPICS);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (round = 0 ; round < TEST_MQTT_DISPATCH_ROUNDS ; round++) {
+		for (i = 0 ; i < TEST_MQTT_TOPICS ; i++) {
+			MQTTString topic = MQTTString_initializer;
+			MQTTMessage message;
+
+			topic.lenstring.data = s_topics[i];
+			topic.lenstring.len = strlen(s_topics[i]);
+			deliverMessage(&c, &topic, &message);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	trie_us = ((end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3) /
+				(TEST_MQTT_DISPATCH_ROUNDS * TEST_MQTT_TOPICS);
+
+	printf("  linear scan %8.3f us/msg, %.2f handlers/msg\n", linear_us,
+			(double)delivered / (TEST_MQTT_DISPATCH_ROUNDS * TEST_MQTT_TOPICS));
+	printf("  trie        %8.3f us/msg\n", trie_us);
+
+	/* remove every other subscription, then all of them */
+	for (i = 0 ; i < TEST_MQTT_SUBSCRIPTIONS ; i++) {
+		if (i % 2 != 0 && MQTTSetMessageHandler(&c, s_subscriptions[i], NULL) != SUCCESS)
+			errors++;
+	}
+	if (MQTTSetMessageHandler(&c, s_subscriptions[1], NULL) == SUCCESS)
+		errors++;
+	errors += test_mqtt_dispatch_check(&c, 2, "half");
+
+	MQTTCleanSession(&c);
+	if (c.messageHandlers.root != NULL || c.messageHandlers.count != 0)
+		errors++;
+	errors += test_mqtt_dispatch_check(&c, 0, "none");
+
+	/* invalid filters, and out of memory on an empty trie */
+	if (MQTTSetMessageHandler(&c, "a/#/b", s_handlers[0]) == SUCCESS ||
+			MQTTSetMessageHandler(&c, "a/b+", s_handlers[0]) == SUCCESS ||
+			MQTTSetMessageHandler(&c, "", s_handlers[0]) == SUCCESS)
+		errors++;
+	errors += test_mqtt_dispatch_failed_set(&c);
+	if (c.messageHandlers.root != NULL)
+		errors++;
+	MQTTCleanSession(&c);
+
+	printf("%s\n", errors ? "FAIL" : "PASS");
+
+	return errors ? 1 : 0;
+}
+
+/**********************************************************************************************/
+
+static const struct
+{
+	const char *name;
+	int (*func) (int argc, char *argv[]);
+} s_test_mqtt_cmds[] =
+{
+	{ "receive",	test_mqtt_receive },
+	{ "publish",	test_mqtt_publish },
+	{ "run",		test_mqtt_run },
+	{ "stall",		test_mqtt_stall },
+	{ "dispatch",	test_mqtt_dispatch },
+};
+
+#define TEST_MQTT_CMDS (sizeof(s_test_mqtt_cmds) / sizeof(s_test_mqtt_cmds[0]))
+
+int main (int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0 ; i < TEST_MQTT_CMDS ; i++) {
+		if (argc > 1 && strcmp(argv[1], s_test_mqtt_cmds[i].name) != 0)
+			continue;
+
+		ret |= s_test_mqtt_cmds[i].func(argc - 1, argv + 1);
+	}
+
+	return ret;
+}
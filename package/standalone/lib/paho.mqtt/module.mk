@@ -21,4 +21,5 @@ CSRCS		+= \
 	MQTTUnsubscribeClient.c \
 	MQTTUnsubscribeServer.c \
 	MQTTNrcImpl.c \
-	MQTTClient.c
+	MQTTClient.c \
+	MQTTTopicTrie.c
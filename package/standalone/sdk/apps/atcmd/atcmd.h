@@ -259,6 +259,7 @@ enum ATCMD_ID
 	ATCMD_SOCKET_TCP_KEEPALIVE,
 	ATCMD_SOCKET_TCP_NODELAY,
 	ATCMD_SOCKET_TIMEOUT,
+	ATCMD_SOCKET_RECV_BATCH,
 
 	/* Command for internal */
 #if defined(CONFIG_ATCMD_SOCKET_INTERNAL)
@@ -325,10 +326,17 @@ typedef struct
 
 typedef int (*atcmd_handler_t) (int argc, char *argv[]);
 
-typedef struct
+typedef struct atcmd_info
 {
 	atcmd_list_t list;
 
+	struct
+	{
+		struct atcmd_info *next;
+		atcmd_group_t *group;
+		uint32_t key;
+	} hash;
+
 	enum ATCMD_GROUP_ID group;
 
 	int id;
@@ -402,6 +410,7 @@ extern int atcmd_group_unregister (enum ATCMD_GROUP_ID id);
 
 extern void atcmd_info_print (atcmd_group_t *group);
 extern atcmd_info_t *atcmd_search (atcmd_group_t *group, enum ATCMD_ID id);
+extern atcmd_info_t *atcmd_info_lookup (const char *cmd);
 extern int atcmd_info_register (enum ATCMD_GROUP_ID gid, atcmd_info_t *info);
 extern void atcmd_info_unregister (enum ATCMD_GROUP_ID gid, enum ATCMD_ID id);
 
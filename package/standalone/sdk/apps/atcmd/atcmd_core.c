@@ -414,7 +414,8 @@ typedef struct
 	bool binary;
 	char *exit_cmd;
 
-	uint32_t cnt;
+	uint32_t cnt; /* staged in the receive buffer */
+	uint32_t direct; /* passed to the socket without staging */
 	uint32_t send_len;
 	uint32_t send_done;
 	uint32_t send_drop;
@@ -436,6 +437,7 @@ static atcmd_data_mode_t g_atcmd_data_mode =
 	.exit_cmd = NULL,
 
 	.cnt = 0,
+	.direct = 0,
 	.send_len = 0,
 	.send_done = 0,
 	.send_drop = 0,
@@ -480,6 +482,7 @@ static int _atcmd_data_mode_enable (atcmd_socket_t *socket, int32_t len, uint32_
 	g_atcmd_data_mode.exit_cmd = exit_cmd ? exit_cmd : "AT\r\n";
 
 	g_atcmd_data_mode.cnt = 0;
+	g_atcmd_data_mode.direct = 0;
 	g_atcmd_data_mode.send_len = abs(len);
 	g_atcmd_data_mode.send_done = 0;
 	g_atcmd_data_mode.send_drop = 0;
@@ -525,6 +528,7 @@ static int atcmd_data_mode_disable (void)
 	g_atcmd_data_mode.exit_cmd = NULL;
 
 	g_atcmd_data_mode.cnt = 0;
+	g_atcmd_data_mode.direct = 0;
 	g_atcmd_data_mode.send_len = 0;
 	g_atcmd_data_mode.send_done = 0;
 	g_atcmd_data_mode.send_drop = 0;
@@ -739,14 +743,19 @@ static void atcmd_list_add (atcmd_list_t *head, atcmd_list_t *list)
 	list->next = head;
 	list->prev = head->prev;
 
-	head->prev->next = list;
+	/* The first entry has no predecessor. */
+	if (head->prev)
+		head->prev->next = list;
+
 	head->prev = list;
 }
 
 static void atcmd_list_del (atcmd_list_t *list)
 {
 	list->next->prev = list->prev;
-	list->prev->next = list->next;
+
+	if (list->prev)
+		list->prev->next = list->next;
 
 	list->next = NULL;
 	list->prev = NULL;
@@ -754,6 +763,97 @@ static void atcmd_list_del (atcmd_list_t *list)
 
 /*******************************************************************************************/
 
+/*
+ * Commands are hashed by their full name (prefix + command) when registered,
+ * so that atcmd_handler() does not walk the group and command lists.
+ * The key is FNV-1a over the upper-cased name, and the last registered entry wins
+ * as it did with the list search.
+ */
+
+#define ATCMD_HASH_SIZE		128 /* power of 2 */
+#define ATCMD_HASH_MASK		(ATCMD_HASH_SIZE - 1)
+
+static atcmd_info_t *g_atcmd_hash_table[ATCMD_HASH_SIZE] = { NULL, };
+
+static uint32_t atcmd_hash_update (uint32_t key, const char *str)
+{
+	char c;
+
+	for ( ; *str != '\0' ; str++)
+	{
+		c = *str;
+
+		if (c >= 'a' && c <= 'z')
+			c -= 'a' - 'A';
+
+		key = (key ^ (uint8_t)c) * 16777619UL;
+	}
+
+	return key;
+}
+
+static uint32_t atcmd_hash_key (const char *prefix, const char *cmd)
+{
+	return atcmd_hash_update(atcmd_hash_update(2166136261UL, prefix), cmd);
+}
+
+static void atcmd_hash_add (atcmd_group_t *group, atcmd_info_t *info)
+{
+	atcmd_info_t **head;
+
+	info->hash.key = atcmd_hash_key(group->cmd_prefix, info->cmd);
+	info->hash.group = group;
+
+	head = &g_atcmd_hash_table[info->hash.key & ATCMD_HASH_MASK];
+
+	info->hash.next = *head;
+	*head = info;
+}
+
+static void atcmd_hash_del (atcmd_info_t *info)
+{
+	atcmd_info_t **entry;
+
+	if (!info->hash.group)
+		return;
+
+	for (entry = &g_atcmd_hash_table[info->hash.key & ATCMD_HASH_MASK] ; *entry ;
+			entry = &(*entry)->hash.next)
+	{
+		if (*entry == info)
+		{
+			*entry = info->hash.next;
+			break;
+		}
+	}
+
+	info->hash.next = NULL;
+	info->hash.group = NULL;
+}
+
+atcmd_info_t *atcmd_info_lookup (const char *cmd)
+{
+	uint32_t key = atcmd_hash_key("", cmd);
+	atcmd_group_t *group;
+	atcmd_info_t *info;
+
+	for (info = g_atcmd_hash_table[key & ATCMD_HASH_MASK] ; info ; info = info->hash.next)
+	{
+		if (info->hash.key != key)
+			continue;
+
+		group = info->hash.group;
+
+		if (strncasecmp(cmd, group->cmd_prefix, group->cmd_prefix_size) == 0 &&
+				strcasecmp(cmd + group->cmd_prefix_size, info->cmd) == 0)
+			return info;
+	}
+
+	return NULL;
+}
+
+/*******************************************************************************************/
+
 static atcmd_list_t g_atcmd_group_head =
 {
 	.next = NULL,
@@ -812,12 +912,16 @@ int atcmd_group_register (atcmd_group_t *group)
 
 int atcmd_group_unregister (enum ATCMD_GROUP_ID id)
 {
-	atcmd_list_t *list = (atcmd_list_t *)atcmd_group_search(id);
+	atcmd_group_t *group = atcmd_group_search(id);
+	atcmd_list_t *list;
 
-	if (!list)
+	if (!group)
 		return -1;
 
-	atcmd_list_del(list);
+	for (list = group->cmd_list_head.prev ; list ; list = list->prev)
+		atcmd_hash_del((atcmd_info_t *)list);
+
+	atcmd_list_del(&group->list);
 
 	return 0;
 }
@@ -878,6 +982,7 @@ int atcmd_info_register (enum ATCMD_GROUP_ID gid, atcmd_info_t *info)
 		return -1;
 
 	atcmd_list_add(&group->cmd_list_head, &info->list);
+	atcmd_hash_add(group, info);
 
 	return 0;
 }
@@ -891,7 +996,10 @@ void atcmd_info_unregister (enum ATCMD_GROUP_ID gid, enum ATCMD_ID id)
 		atcmd_info_t *info = atcmd_info_search(group, id);
 
 		if (info)
+		{
+			atcmd_hash_del(info);
 			atcmd_list_del(&info->list);
+		}
 	}
 }
 
@@ -1025,60 +1133,31 @@ static int atcmd_handler (char *cmd)
 
 	if (type != ATCMD_HANDLER_NONE && argc > 0)
 	{
-		atcmd_group_t *group;
-		atcmd_list_t *list;
+		atcmd_info_t *atcmd = atcmd_info_lookup(argv[0]);
 
-		for (list = g_atcmd_group_head.prev ; list ; list = list->prev)
+		if (atcmd)
 		{
-			group = (atcmd_group_t *)list;
-
-/*			_atcmd_debug("Group %s: id=%d prefix=%s prefix_size=%d next=%p prev=%p",
-							group->name, group->id,
-							group->cmd_prefix, group->cmd_prefix_size,
-							group->list.next, group->list.prev); */
-
-			if (group->cmd_prefix_size == 0 ||
-					strncmp(argv[0], group->cmd_prefix, group->cmd_prefix_size) == 0)
-			{
-				atcmd_info_t *atcmd;
-
-				for (list = group->cmd_list_head.prev ; list ; list = list->prev)
-				{
-					atcmd = (atcmd_info_t *)list;
+			int ret = ATCMD_ERROR_NOTSUPP;
 
-/*					_atcmd_debug("Command %s: id=%d next=%p prev=%p",
-									atcmd->cmd, atcmd->id,
-									atcmd->list.next, atcmd->list.prev); */
-
-					if (strcmp(argv[0] + group->cmd_prefix_size, atcmd->cmd) == 0)
-					{
-						int ret = ATCMD_ERROR_NOTSUPP;
+/*			_atcmd_debug("Command %s: group=%d id=%d", argv[0], atcmd->group, atcmd->id); */
 
-						if (atcmd->handler[type])
-							ret = atcmd->handler[type](argc - 1, argv + 1);
+			if (atcmd->handler[type])
+				ret = atcmd->handler[type](argc - 1, argv + 1);
 
-						if (ret == ATCMD_NO_RETURN)
-							ret = ATCMD_SUCCESS;
-						else
-						{
-							if (ret == ATCMD_ERROR_NOTSUPP)
-								ATCMD_MSG_RETURN(NULL, ret);
-							else
-								ATCMD_MSG_RETURN(argv[0], ret);
-						}
-
-						if (ret != ATCMD_SUCCESS)
-							_atcmd_info("cmd=%s ret=%d", argv[0], ret);
-
-						return ret;
-					}
-				}
-
-				if (group->cmd_prefix_size > 0)
-					break;
+			if (ret == ATCMD_NO_RETURN)
+				ret = ATCMD_SUCCESS;
+			else
+			{
+				if (ret == ATCMD_ERROR_NOTSUPP)
+					ATCMD_MSG_RETURN(NULL, ret);
+				else
+					ATCMD_MSG_RETURN(argv[0], ret);
 			}
 
-			list = &group->list;
+			if (ret != ATCMD_SUCCESS)
+				_atcmd_info("cmd=%s ret=%d", argv[0], ret);
+
+			return ret;
 		}
 	}
 
@@ -1565,16 +1644,31 @@ static int atcmd_receive_data (char *buf, int len)
 
 	if (g_atcmd_data_mode.send_len > 0)
 	{
-		send_len = g_atcmd_data_mode.send_len;
+		send_len = g_atcmd_data_mode.send_len - g_atcmd_data_mode.direct;
 
 		if ((g_atcmd_data_mode.cnt + len) > send_len)
 			len = send_len - g_atcmd_data_mode.cnt;
 		else if ((g_atcmd_data_mode.cnt + len) < send_len)
 		{
-			memcpy(_buf + g_atcmd_data_mode.cnt, buf, len);
-			g_atcmd_data_mode.cnt += len;
+			/*
+			 * TCP has no message boundary, a partial data is sent from the HIF buffer as it is.
+			 * UDP and the firmware download are staged to keep the data in one piece.
+			 */
+			if (!g_atcmd_data_mode.binary &&
+					g_atcmd_data_mode.socket.protocol == ATCMD_SOCKET_PROTO_TCP)
+			{
+				g_atcmd_data_mode.send_done += _atcmd_receive_data(buf, len);
+				g_atcmd_data_mode.direct += len;
 
-			_atcmd_data_mode_debug("data: %d/%d\n", g_atcmd_data_mode.cnt, send_len);
+				_atcmd_data_mode_debug("data: %d/%d\n", g_atcmd_data_mode.direct, g_atcmd_data_mode.send_len);
+			}
+			else
+			{
+				memcpy(_buf + g_atcmd_data_mode.cnt, buf, len);
+				g_atcmd_data_mode.cnt += len;
+
+				_atcmd_data_mode_debug("data: %d/%d\n", g_atcmd_data_mode.cnt, send_len);
+			}
 
 			goto recv_data_done;
 		}
@@ -1607,6 +1701,8 @@ static int atcmd_receive_data (char *buf, int len)
 		int id = g_atcmd_data_mode.socket.id;
 		bool done_event = g_atcmd_data_mode.done_event;
 
+		send_done = g_atcmd_data_mode.send_done;
+
 		atcmd_data_mode_disable();
 
 		if (done_event)
@@ -25,6 +25,7 @@
 
 
 #include "atcmd.h"
+#include "drv_rtc.h"
 
 
 /**********************************************************************************************/
@@ -54,6 +55,8 @@ static atcmd_socket_t *g_atcmd_socket = NULL;
 static atcmd_socket_rxd_t *g_atcmd_socket_rxd = NULL;
 #endif
 
+static atcmd_socket_rxd_batch_t *g_atcmd_socket_rxd_batch = NULL;
+
 static char str_atcmd_socket_send_exit[32 + 1] = { 'A', 'T', '\r', '\n', '\0', };
 
 static struct
@@ -75,17 +78,23 @@ static struct
 	uint16_t passive:1;
 	uint16_t ready_event:1; /* 0:disable, 1/2: enable */
 	uint16_t error_verbose:1;
-	uint16_t reserved:12;
+	uint16_t batch:1;
+	uint16_t reserved:11;
 
 	uint16_t ready;
+
+	uint32_t batch_latency; /* usec */
 } g_atcmd_socket_recv_config =
 {
 	.verbose = 0,
 	.passive = 0,
 	.ready_event = 1,
 	.error_verbose = 0,
+	.batch = 0,
 
 	.ready = 0,
+
+	.batch_latency = CONFIG_ATCMD_SOCKET_RECV_BATCH_LATENCY,
 };
 
 static struct
@@ -568,6 +577,70 @@ static void _atcmd_socket_send_handler (int id)
 
 /**********************************************************************************************/
 
+static int _atcmd_socket_recv_batch_enable (bool enable)
+{
+	if (enable && !g_atcmd_socket_rxd_batch)
+	{
+		g_atcmd_socket_rxd_batch = _atcmd_malloc(sizeof(atcmd_socket_rxd_batch_t));
+		if (!g_atcmd_socket_rxd_batch)
+		{
+			_atcmd_error("malloc()");
+			return -1;
+		}
+
+		g_atcmd_socket_rxd_batch->cnt = 0;
+		g_atcmd_socket_rxd_batch->len = 0;
+	}
+
+	/* The buffer is kept until disabled, the socket task may still flush it */
+	g_atcmd_socket_recv_config.batch = enable ? 1 : 0;
+
+	return 0;
+}
+
+static void _atcmd_socket_recv_batch_flush (void)
+{
+	atcmd_socket_rxd_batch_t *batch = g_atcmd_socket_rxd_batch;
+	char msg[ATCMD_MSG_LEN_MAX + 1];
+	char *buf;
+	int len;
+
+	if (!batch || batch->cnt == 0)
+		return;
+
+	len = ATCMD_MSG_SRXDB(msg, sizeof(msg) - 1, "%d,%d", batch->cnt, batch->len);
+
+	buf = batch->buf.records - len;
+	memcpy(buf, msg, len);
+
+	atcmd_transmit(buf, len + batch->len);
+
+	batch->cnt = 0;
+	batch->len = 0;
+}
+
+static void _atcmd_socket_recv_batch (atcmd_socket_rxd_t *rxd, char *msg)
+{
+	atcmd_socket_rxd_batch_t *batch = g_atcmd_socket_rxd_batch;
+
+	if ((batch->len + rxd->len.msg + rxd->len.data) > sizeof(batch->buf.records))
+		_atcmd_socket_recv_batch_flush();
+
+	if (batch->cnt == 0)
+		batch->start = drv_rtc_get_us();
+
+	memcpy(batch->buf.records + batch->len, msg, rxd->len.msg);
+	batch->len += rxd->len.msg;
+
+	memcpy(batch->buf.records + batch->len, rxd->buf.data, rxd->len.data);
+	batch->len += rxd->len.data;
+
+	batch->cnt++;
+
+	if ((drv_rtc_get_us() - batch->start) >= g_atcmd_socket_recv_config.batch_latency)
+		_atcmd_socket_recv_batch_flush();
+}
+
 static void _atcmd_socket_recv_data (atcmd_socket_rxd_t *rxd)
 {
 	char msg[ATCMD_MSG_LEN_MAX + 1];
@@ -590,6 +663,14 @@ static void _atcmd_socket_recv_data (atcmd_socket_rxd_t *rxd)
 		rxd->len.msg = ATCMD_MSG_SRXD(msg, sizeof(msg) - 1, "%d,%d", rxd->socket.id, rxd->len.data);
 	}
 
+	/* AT+SRECV replies in passive mode are never held back */
+	if (g_atcmd_socket_recv_config.batch && !g_atcmd_socket_recv_config.passive &&
+			g_atcmd_socket_rxd_batch)
+	{
+		_atcmd_socket_recv_batch(rxd, msg);
+		return;
+	}
+
 	buf = rxd->buf.msg + sizeof(rxd->buf.msg) - rxd->len.msg;
 	len = rxd->len.msg + rxd->len.data;
 
@@ -663,6 +744,10 @@ static int __atcmd_socket_recv_handler (int id, int len, bool passive)
 			ret = 0;
 		else
 		{
+			/* Data received before the error goes out first */
+			if (!passive)
+				_atcmd_socket_recv_batch_flush();
+
 			switch (ret)
 			{
 				case -EBADF:
@@ -783,6 +868,7 @@ static int _atcmd_socket_init (void)
 	cb.send_ready = _atcmd_socket_send_handler;
 	cb.recv_ready = _atcmd_socket_recv_handler;
 	cb.tcp_connect = _atcmd_socket_tcp_connect_handler;
+	cb.recv_flush = _atcmd_socket_recv_batch_flush;
 
 	for (i = 0 ; i < ATCMD_SOCKET_NUM_MAX ; i++)
 		_atcmd_socket_reset(&g_atcmd_socket[i]);
@@ -1636,6 +1722,84 @@ static atcmd_info_t g_atcmd_socket_recv_mode =
 
 /**********************************************************************************************/
 
+static int _atcmd_socket_recv_batch_get (int argc, char *argv[])
+{
+	switch (argc)
+	{
+		case 0:
+			ATCMD_MSG_INFO("SRECVBATCH", "%d,%u",
+					g_atcmd_socket_recv_config.batch, g_atcmd_socket_recv_config.batch_latency);
+			break;
+
+		default:
+			return ATCMD_ERROR_INVAL;
+	}
+
+	return ATCMD_SUCCESS;
+}
+
+static int _atcmd_socket_recv_batch_set (int argc, char *argv[])
+{
+	char *param_latency = NULL;
+
+	switch (argc)
+	{
+		case 0:
+			ATCMD_MSG_HELP("AT+SRECVBATCH=<mode>[,<latency>]");
+			/*
+			 * mode : 0=off, 1=on
+			 * latency : max usec to hold received data, 0 ~ 1000000
+			 */
+			break;
+
+		case 2:
+			param_latency = argv[1];
+
+		case 1:
+		{
+			int mode = atoi(argv[0]);
+			int latency = g_atcmd_socket_recv_config.batch_latency;
+
+			if (param_latency)
+				latency = atoi(param_latency);
+
+			if (mode == 0 || mode == 1)
+			{
+				if (latency >= 0 && latency <= ATCMD_SOCKET_RECV_BATCH_LATENCY_MAX)
+				{
+					g_atcmd_socket_recv_config.batch_latency = latency;
+
+					if (_atcmd_socket_recv_batch_enable(!!mode) != 0)
+						return ATCMD_ERROR_FAIL;
+					break;
+				}
+			}
+		}
+
+		default:
+			return ATCMD_ERROR_INVAL;
+	}
+
+	return ATCMD_SUCCESS;
+}
+
+static atcmd_info_t g_atcmd_socket_recv_batch =
+{
+	.list.next = NULL,
+	.list.prev = NULL,
+
+	.group = ATCMD_GROUP_SOCKET,
+
+	.cmd = "RECVBATCH",
+	.id = ATCMD_SOCKET_RECV_BATCH,
+
+	.handler[ATCMD_HANDLER_RUN] = NULL,
+	.handler[ATCMD_HANDLER_GET] = _atcmd_socket_recv_batch_get,
+	.handler[ATCMD_HANDLER_SET] = _atcmd_socket_recv_batch_set,
+};
+
+/**********************************************************************************************/
+
 static int _atcmd_socket_recv_info_get (int argc, char *argv[])
 {
 	switch (argc)
@@ -2393,6 +2557,7 @@ static atcmd_info_t *g_atcmd_info_socket[] =
 	&g_atcmd_socket_tcp_keepalive,
 	&g_atcmd_socket_tcp_nodelay,
 	&g_atcmd_socket_timeout,
+	&g_atcmd_socket_recv_batch,
 
 	/*
 	 * Command for internal
@@ -2433,6 +2598,9 @@ int atcmd_socket_enable (void)
 	}
 #endif
 
+	if (_atcmd_socket_recv_batch_enable(!!CONFIG_ATCMD_SOCKET_RECV_BATCH) != 0)
+		return -1;
+
 	_atcmd_socket_init();
 
 	if (atcmd_group_register(&g_atcmd_group_socket) != 0)
@@ -2460,6 +2628,12 @@ void atcmd_socket_disable (void)
 
 	_atcmd_free(g_atcmd_socket_rxd);
 	_atcmd_free(g_atcmd_socket);
+
+	if (g_atcmd_socket_rxd_batch)
+	{
+		_atcmd_free(g_atcmd_socket_rxd_batch);
+		g_atcmd_socket_rxd_batch = NULL;
+	}
 }
 
 int atcmd_socket_send_data (atcmd_socket_t *socket, char *data, int len)
@@ -2545,6 +2719,7 @@ static int cmd_atcmd_socket_log (cmd_tbl_t *t, int argc, char *argv[])
 
 static int cmd_atcmd_socket_data (cmd_tbl_t *t, int argc, char *argv[])
 {
+	uint32_t wakeups, events, msec;
 	int ret = CMD_RET_SUCCESS;
 	int i;
 
@@ -2563,6 +2738,8 @@ static int cmd_atcmd_socket_data (cmd_tbl_t *t, int argc, char *argv[])
 				g_cmd_socket.data[i].len = 0;
 			}
 
+			_lwip_socket_clear_wakeups();
+
 		case 0:
 			for (i = 0 ; i < 2 ; i++)
 			{
@@ -2575,6 +2752,12 @@ static int cmd_atcmd_socket_data (cmd_tbl_t *t, int argc, char *argv[])
 				_atcmd_printf(" -- passive: event=%d, ready=0x%02X\n",
 					g_atcmd_socket_recv_config.ready_event, g_atcmd_socket_recv_config.ready);
 			}
+
+			if (_lwip_socket_get_wakeups(&wakeups, &events, &msec) == 0)
+			{
+				_atcmd_printf(" - task: wakeups=%u (%u/s) events=%u\n", wakeups,
+					msec ? (uint32_t)((uint64_t)wakeups * 1000 / msec) : 0, events);
+			}
 			break;
 
 		default:
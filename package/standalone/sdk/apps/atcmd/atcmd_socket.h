@@ -35,6 +35,20 @@
 #define ATCMD_SOCKET_IPADDR_LEN_MIN		ATCMD_IPADDR_LEN_MIN
 #define ATCMD_SOCKET_IPADDR_LEN_MAX		ATCMD_IPADDR_LEN_MAX
 
+/*
+ * Receive coalescing (AT+SRECVBATCH), +RXD records of all ready sockets are
+ * sent in one transfer prefixed with "+RXDB:<count>,<length>".
+ */
+#ifndef CONFIG_ATCMD_SOCKET_RECV_BATCH
+#define CONFIG_ATCMD_SOCKET_RECV_BATCH			0		/* default mode, 0:off 1:on */
+#endif
+
+#ifndef CONFIG_ATCMD_SOCKET_RECV_BATCH_LATENCY
+#define CONFIG_ATCMD_SOCKET_RECV_BATCH_LATENCY	2000	/* default latency cap, usec */
+#endif
+
+#define ATCMD_SOCKET_RECV_BATCH_LATENCY_MAX		1000000	/* usec */
+
 enum ATCMD_SOCKET_PROTO
 {
 	ATCMD_SOCKET_PROTO_NONE = -1,
@@ -88,6 +102,19 @@ typedef struct
 	} buf;
 } atcmd_socket_rxd_t;
 
+typedef struct
+{
+	int cnt;			/* +RXD records */
+	int len;			/* bytes of records */
+	uint64_t start;		/* usec, first record */
+
+	struct
+	{
+		char head[ATCMD_MSG_LEN_MAX];
+		char records[ATCMD_MSG_LEN_MAX + ATCMD_TXBUF_SIZE];
+	} buf;
+} atcmd_socket_rxd_batch_t;
+
 /**********************************************************************************************/
 
 #define ATCMD_MSG_SEVENT(fmt, ...)	\
@@ -96,6 +123,9 @@ typedef struct
 #define ATCMD_MSG_SRXD(buf, len, fmt, ...)	\
 		atcmd_msg_snprint(ATCMD_MSG_TYPE_EVENT, buf, len, "RXD:" fmt, ##__VA_ARGS__)
 
+#define ATCMD_MSG_SRXDB(buf, len, fmt, ...)	\
+		atcmd_msg_snprint(ATCMD_MSG_TYPE_EVENT, buf, len, "RXDB:" fmt, ##__VA_ARGS__)
+
 extern void atcmd_socket_reset (atcmd_socket_t *socket);
 extern int atcmd_socket_enable (void);
 extern void atcmd_socket_disable (void);
@@ -118,6 +118,46 @@ int _hif_read (char *buf, int len)
 	return rd_size;
 }
 
+/*
+ * Zero-copy read, returns -1 if the HIF has no span access.
+ * The spans must be released by _hif_commit() before the next call.
+ */
+int _hif_peek (_hif_buf_t span[2], int len)
+{
+	int rd_size = -1;
+
+	switch (_hif_get_type())
+	{
+		case _HIF_TYPE_UART:
+		case _HIF_TYPE_UART_HFC:
+#if defined(CONFIG_ATCMD_UART) || defined(CONFIG_ATCMD_UART_HFC)
+			rd_size = _hif_uart_peek(span, len);
+#endif
+			break;
+
+		default:
+			break;
+	}
+
+	return rd_size;
+}
+
+void _hif_commit (int len)
+{
+	switch (_hif_get_type())
+	{
+		case _HIF_TYPE_UART:
+		case _HIF_TYPE_UART_HFC:
+#if defined(CONFIG_ATCMD_UART) || defined(CONFIG_ATCMD_UART_HFC)
+			_hif_uart_commit(len);
+#endif
+			break;
+
+		default:
+			break;
+	}
+}
+
 int _hif_write (char *buf, int len)
 {
 	int wr_size = 0;
@@ -153,16 +193,38 @@ static void _hif_rx_task (void *pvParameters)
 	_hif_rx_params_t *params = (_hif_rx_params_t *)pvParameters;
 	char *buf = params->buf.addr;
 	int len = params->buf.size;
+	_hif_buf_t span[2];
 	int ret;
+	int i;
 
 	while (1)
 	{
-		ret = _hif_read(buf, len);
+		/* With flow control the UART FIFO is passed on in place, without the copy into buf. */
+		ret = _hif_peek(span, len);
+
+		if (ret > 0)
+		{
+			if (params->cb)
+			{
+				for (i = 0 ; i < 2 && span[i].size > 0 ; i++)
+					params->cb(span[i].addr, span[i].size);
+			}
+
+			_hif_commit(ret);
+			continue;
+		}
+		else if (ret < 0)
+		{
+			ret = _hif_read(buf, len);
+
+			if (ret > 0 && params->cb)
+			{
+				params->cb(buf, ret);
+				continue;
+			}
+		}
 
-		if (ret > 0 && params->cb)
-			params->cb(buf, ret);
-		else
-			_hif_rx_suspend(100);
+		_hif_rx_suspend(100);
 	}
 }
 
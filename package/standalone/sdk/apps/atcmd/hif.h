@@ -157,11 +157,15 @@ extern char _hif_fifo_getc (_hif_fifo_t *fifo);
 extern void _hif_fifo_putc (_hif_fifo_t *fifo, char c);
 extern int _hif_fifo_read (_hif_fifo_t *fifo, char *buf, int len);
 extern int _hif_fifo_write (_hif_fifo_t *fifo, char *buf, int len);
+extern int _hif_fifo_peek (_hif_fifo_t *fifo, _hif_buf_t span[2], int len);
+extern int _hif_fifo_commit (_hif_fifo_t *fifo, int len);
 
 extern int _hif_uart_open (_hif_info_t *info);
 extern void _hif_uart_close (void);
 extern int _hif_uart_change (_hif_uart_t *uart);
 extern int _hif_uart_read (char *buf, int len);
+extern int _hif_uart_peek (_hif_buf_t span[2], int len);
+extern void _hif_uart_commit (int len);
 extern int _hif_uart_write (char *buf, int len);
 extern void _hif_uart_get_info (_hif_uart_t *info);
 
@@ -175,6 +179,8 @@ extern enum _HIF_TYPE _hif_get_type (void);
 extern int _hif_open (_hif_info_t *info);
 extern void _hif_close (void);
 extern int _hif_read (char *buf, int len);
+extern int _hif_peek (_hif_buf_t span[2], int len);
+extern void _hif_commit (int len);
 extern int _hif_write (char *buf, int len);
 extern int _hif_rx_suspend (int time);
 extern void _hif_rx_resume (void);
@@ -130,8 +130,9 @@ char _hif_fifo_getc (_hif_fifo_t *fifo)
 {
 	char data;
 
-	data = fifo->buffer[fifo->pop_idx % fifo->size];
-	fifo->pop_idx++;
+	data = fifo->buffer[fifo->pop_idx];
+	if (++fifo->pop_idx == fifo->size)
+		fifo->pop_idx = 0;
 
 	fifo->cnt--;
 
@@ -140,8 +141,9 @@ char _hif_fifo_getc (_hif_fifo_t *fifo)
 
 void _hif_fifo_putc (_hif_fifo_t *fifo, char c)
 {
-	fifo->buffer[fifo->push_idx % fifo->size] = c;
-	fifo->push_idx++;
+	fifo->buffer[fifo->push_idx] = c;
+	if (++fifo->push_idx == fifo->size)
+		fifo->push_idx = 0;
 
 	fifo->cnt++;
 }
@@ -156,7 +158,7 @@ int _hif_fifo_read (_hif_fifo_t *fifo, char *buf, int len)
 			len = fill_size;
 
 		if (!buf)
-			fifo->pop_idx += len;
+			fifo->pop_idx = (fifo->pop_idx + len) % fifo->size;
 		else
 		{
 			char *pop_addr;
@@ -165,7 +167,7 @@ int _hif_fifo_read (_hif_fifo_t *fifo, char *buf, int len)
 
 			for (i = 0 ; i < len ; )
 			{
-				pop_addr = &fifo->buffer[fifo->pop_idx % fifo->size];
+				pop_addr = &fifo->buffer[fifo->pop_idx];
 
 				pop_len = fifo->buffer_end - pop_addr;
 				if (pop_len > (len - i))
@@ -175,6 +177,8 @@ int _hif_fifo_read (_hif_fifo_t *fifo, char *buf, int len)
 
 				i += pop_len;
 				fifo->pop_idx += pop_len;
+				if (fifo->pop_idx == fifo->size)
+					fifo->pop_idx = 0;
 			}
 		}
 
@@ -196,7 +200,7 @@ int _hif_fifo_write (_hif_fifo_t *fifo, char *buf, int len)
 			len = free_size;
 
 		if (!buf)
-			fifo->push_idx += len;
+			fifo->push_idx = (fifo->push_idx + len) % fifo->size;
 		else
 		{
 			char *push_addr;
@@ -205,7 +209,7 @@ int _hif_fifo_write (_hif_fifo_t *fifo, char *buf, int len)
 
 			for (i = 0 ; i < len ; )
 			{
-				push_addr = &fifo->buffer[fifo->push_idx % fifo->size];
+				push_addr = &fifo->buffer[fifo->push_idx];
 
 				push_len = fifo->buffer_end - push_addr;
 				if (push_len > (len - i))
@@ -215,6 +219,8 @@ int _hif_fifo_write (_hif_fifo_t *fifo, char *buf, int len)
 
 				i += push_len;
 				fifo->push_idx += push_len;
+				if (fifo->push_idx == fifo->size)
+					fifo->push_idx = 0;
 			}
 		}
 
@@ -225,3 +231,42 @@ int _hif_fifo_write (_hif_fifo_t *fifo, char *buf, int len)
 
 	return 0;
 }
+
+/*
+ * Zero-copy read, _hif_fifo_peek() returns the readable data in place as up to two spans,
+ * the second one is set if the data wraps at the end of the buffer. The data is kept
+ * in the FIFO until released by _hif_fifo_commit(), writes through the FIFO leave it alone.
+ * A writer that fills the buffer behind the FIFO's back does not: the UART RX DMA writes
+ * the ring circularly and is only accounted for afterwards, see _hif_uart_peek().
+ */
+
+int _hif_fifo_peek (_hif_fifo_t *fifo, _hif_buf_t span[2], int len)
+{
+	if (fifo && span && len > 0)
+	{
+		int fill_size = _hif_fifo_fill_size(fifo);
+		char *pop_addr;
+
+		if (len > fill_size)
+			len = fill_size;
+
+		pop_addr = &fifo->buffer[fifo->pop_idx];
+
+		span[0].addr = pop_addr;
+		span[0].size = fifo->buffer_end - pop_addr;
+		if (span[0].size > len)
+			span[0].size = len;
+
+		span[1].addr = fifo->buffer;
+		span[1].size = len - span[0].size;
+
+		return len;
+	}
+
+	return 0;
+}
+
+int _hif_fifo_commit (_hif_fifo_t *fifo, int len)
+{
+	return _hif_fifo_read(fifo, NULL, len);
+}
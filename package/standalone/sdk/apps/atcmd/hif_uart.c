@@ -535,6 +535,41 @@ int _hif_uart_read (char *buf, int len)
 	return rx_cnt;
 }
 
+/*
+ * Zero-copy read from the RX FIFO, returns -1 if the data has to be copied out by
+ * _hif_uart_read() instead. Only with flow control does the RX interrupt stop at a full
+ * FIFO, so that the spans stay valid until _hif_uart_commit(). Without it the RX DMA keeps
+ * writing the ring while the spans are in use and would overwrite them.
+ */
+int _hif_uart_peek (_hif_buf_t span[2], int len)
+{
+	int rx_cnt = 0;
+
+	if (g_hif_uart.channel < 0)
+		return 0;
+
+	if (!g_hif_uart_rx_fifo || g_hif_uart.hfc != UART_HFC_ENABLE)
+		return -1;
+
+	_hif_uart_rx_int_disable();
+	rx_cnt = _hif_fifo_peek(g_hif_uart_rx_fifo, span, len);
+	_hif_uart_rx_int_enable();
+
+	return rx_cnt;
+}
+
+void _hif_uart_commit (int len)
+{
+	if (g_hif_uart.channel < 0 || !g_hif_uart_rx_fifo || g_hif_uart.hfc != UART_HFC_ENABLE)
+		return;
+
+	_hif_uart_rx_int_disable();
+	len = _hif_fifo_commit(g_hif_uart_rx_fifo, len);
+	_hif_uart_rx_int_enable();
+
+	g_cmd_uart_data.rx += len;
+}
+
 int _hif_uart_write (char *buf, int len)
 {
 	int tx_cnt = 0;
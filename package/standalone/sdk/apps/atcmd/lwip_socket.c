@@ -27,6 +27,8 @@
 #include "atcmd.h"
 #include "lwip_socket.h"
 #include "lwip/netdb.h"
+#include "lwip/api.h"
+#include "nrc_lwip.h"
 
 
 static lwip_socket_info_t *g_lwip_socket_info = NULL;
@@ -508,6 +510,12 @@ static int _lwip_socket_connect (int fd, ip_addr_t *remote_addr, uint16_t remote
 
 #define _lwip_socket_fds_debug		/* _lwip_socket_log */
 
+static void _lwip_socket_task_wakeup (lwip_socket_info_t *info)
+{
+	if (info->task)
+		xTaskNotifyGive(info->task);
+}
+
 static bool _lwip_socket_fds_mutex_take (lwip_socket_info_t *info)
 {
 	if (xSemaphoreTake(info->fds.mutex, LWIP_SOCKET_FDS_MUTEX_TIMEOUT) == pdFALSE)
@@ -585,6 +593,8 @@ static int _lwip_socket_fds_set (lwip_socket_info_t *info, int fd, bool listen)
 
 	LWIP_SOCKET_FDS_UNLOCK(info);
 
+	_lwip_socket_task_wakeup(info);
+
 	return 0;
 }
 
@@ -603,12 +613,51 @@ static int _lwip_socket_fds_clear (lwip_socket_info_t *info, int fd)
 	return 0;
 }
 
+/*
+ * Called from the tcpip thread (LWIP_HOOK_SOCKETS_EVENT) when a socket may have
+ * become ready. Only sockets the task is waiting on wake it up.
+ */
+static void _lwip_socket_event_cb (int fd, int evt)
+{
+	lwip_socket_info_t *info = g_lwip_socket_info;
+	bool wakeup = false;
+
+	if (!info || fd < 0 || fd >= FD_SETSIZE)
+		return;
+
+	switch (evt)
+	{
+		case NETCONN_EVT_RCVPLUS:
+			wakeup = FD_ISSET(fd, &info->fds.read);
+			break;
+
+		case NETCONN_EVT_SENDPLUS:
+			wakeup = FD_ISSET(fd, &info->fds.write);
+			break;
+
+		case NETCONN_EVT_ERROR:
+			wakeup = FD_ISSET(fd, &info->fds.read) || FD_ISSET(fd, &info->fds.write);
+			break;
+
+		default:
+			break;
+	}
+
+	if (wakeup)
+	{
+		info->stats.events++;
+		_lwip_socket_task_wakeup(info);
+	}
+}
+
 static void _lwip_socket_task (void *arg)
 {
-	const uint32_t default_timeout = (1 * 1000); /* usec */
 	lwip_socket_info_t *info = (lwip_socket_info_t *)arg;
 	fd_set fds_read, fds_write;
-	struct timeval timeout;
+	struct timeval timeout = { 0, 0 };
+	TickType_t wait;
+	uint32_t ready;
+	bool pending = false;
 	int nfds;
 	int ret;
 	int fd;
@@ -616,18 +665,33 @@ static void _lwip_socket_task (void *arg)
 	FD_ZERO(&fds_read);
 	FD_ZERO(&fds_write);
 
-	if (info->timeout.task == 0)
-		info->timeout.task = default_timeout;
-
 	while (1)
 	{
+		if (!pending)
+		{
+			if (info->cb.recv_flush)
+				info->cb.recv_flush();
+
+			/*
+			 * Sleep until a socket event or an fd set change wakes us up.
+			 * A nonzero timeout.task adds a periodic check as a fallback.
+			 */
+			wait = portMAX_DELAY;
+			if (info->timeout.task > 0)
+			{
+				wait = pdMS_TO_TICKS(info->timeout.task / 1000);
+				if (wait == 0)
+					wait = 1;
+			}
+
+			ulTaskNotifyTake(pdTRUE, wait);
+			info->stats.wakeups++;
+		}
+
 		nfds = _lwip_socket_fds_get(info, &fds_read, &fds_write);
 		if (nfds <= 0)
 		{
-/*			if (info->log.task)
-				_lwip_socket_log("SOCK_TASK: no fds"); */
-
-			_delay_ms(10);
+			pending = false;
 			continue;
 		}
 
@@ -637,9 +701,7 @@ static void _lwip_socket_task (void *arg)
 					nfds, fds_read.__fds_bits[0], fds_write.__fds_bits[0]);
 		}
 
-		timeout.tv_sec = info->timeout.task / 1000000;
-		timeout.tv_usec = info->timeout.task % 1000000;
-
+		/* Only sample the current state, waiting is done on the task notification */
 		ret = select(nfds,
 					(fds_read.__fds_bits[0]) ? &fds_read : NULL,
 					(fds_write.__fds_bits[0]) ? &fds_write : NULL,
@@ -654,7 +716,7 @@ static void _lwip_socket_task (void *arg)
 
 			case 0:
 				if (info->log.task)
-					_lwip_socket_log("SOCK_TASK: timeout, %uus", info->timeout.task);
+					_lwip_socket_log("SOCK_TASK: not ready");
 				break;
 
 			default:
@@ -665,12 +727,19 @@ static void _lwip_socket_task (void *arg)
 				}
 		}
 
-		for (fd = 0 ; ret > 0 && fd < nfds ; fd++)
+		/* Readiness is level triggered, look again before going back to sleep */
+		pending = (ret > 0);
+		if (ret <= 0)
+			continue;
+
+		ready = fds_read.__fds_bits[0] | fds_write.__fds_bits[0];
+
+		for ( ; ready ; ready &= ready - 1)
 		{
+			fd = __builtin_ctz(ready);
+
 			if (FD_ISSET(fd, &fds_read))
 			{
-				ret--;
-
 				if (FD_ISSET(fd, &info->fds.listen))
 				{
 					_lwip_socket_fds_debug("SOCK_FDS_LISTEN: fd=%d", fd);
@@ -702,8 +771,6 @@ static void _lwip_socket_task (void *arg)
 
 			if (FD_ISSET(fd, &fds_write))
 			{
-				ret--;
-
 				_lwip_socket_fds_debug("SOCK_FDS_WRITE: fd=%d", fd);
 
 				if (info->cb.send_ready)
@@ -712,12 +779,42 @@ static void _lwip_socket_task (void *arg)
 //				_lwip_socket_send_done(fd);
 			}
 		}
-
-		if (ret > 0)
-			_lwip_socket_log("SOCK_TASK: ret=%d", ret);
 	}
 }
 
+int _lwip_socket_get_wakeups (uint32_t *wakeups, uint32_t *events, uint32_t *msec)
+{
+	lwip_socket_info_t *info = g_lwip_socket_info;
+
+	if (!info)
+		return _lwip_socket_error(EPERM);
+
+	if (wakeups)
+		*wakeups = info->stats.wakeups;
+
+	if (events)
+		*events = info->stats.events;
+
+	if (msec)
+		*msec = (xTaskGetTickCount() - info->stats.start) * portTICK_PERIOD_MS;
+
+	return 0;
+}
+
+int _lwip_socket_clear_wakeups (void)
+{
+	lwip_socket_info_t *info = g_lwip_socket_info;
+
+	if (!info)
+		return _lwip_socket_error(EPERM);
+
+	info->stats.wakeups = 0;
+	info->stats.events = 0;
+	info->stats.start = xTaskGetTickCount();
+
+	return 0;
+}
+
 /**********************************************************************************************/
 
 int _lwip_socket_init (lwip_socket_cb_t *cb)
@@ -761,8 +858,12 @@ int _lwip_socket_init (lwip_socket_cb_t *cb)
 	info->log.send = 0;
 	info->log.recv = 0;
 
+	info->stats.start = xTaskGetTickCount();
+
 	g_lwip_socket_info = info;
 
+	nrc_lwip_set_socket_event_cb(_lwip_socket_event_cb);
+
 	return 0;
 
 _lwip_socket_init_fail:
@@ -786,6 +887,8 @@ int _lwip_socket_deinit (void)
 	if (!info)
 		return _lwip_socket_error(EPERM);
 
+	nrc_lwip_set_socket_event_cb(NULL);
+
 	vTaskDelete(info->task);
 
 	if (info->send_done_event)
@@ -949,6 +1052,8 @@ int _lwip_socket_send_request (int fd)
 
 			LWIP_SOCKET_FDS_UNLOCK(info);
 
+			_lwip_socket_task_wakeup(info);
+
 //			xEventGroupClearBits(info->send_done_event, (1 << fd));
 
 			for (retry = event = 0 ; retry < retry_max ; retry++)
@@ -1105,6 +1210,8 @@ int _lwip_socket_recv_request (int fd)
 
 		LWIP_SOCKET_FDS_UNLOCK(info);
 
+		_lwip_socket_task_wakeup(info);
+
 		return 0;
 	}
 
@@ -1545,7 +1652,7 @@ static int cmd_atcmd_lwip (cmd_tbl_t *t, int argc, char *argv[])
 			_atcmd_printf("atcmd lwip addrinfo <name> <addr>\n");
 #if !defined(CONFIG_ATCMD_CLI_MINIMUM)
 			_atcmd_printf("atcmd lwip fds\n");
-			_atcmd_printf("atcmd lwip timeout <usec>\n");
+			_atcmd_printf("atcmd lwip timeout <usec>, 0 = wait for events only\n");
 #endif
 			return CMD_RET_SUCCESS;
 		}
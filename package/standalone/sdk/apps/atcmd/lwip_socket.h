@@ -68,6 +68,7 @@ typedef struct
 	void (*send_ready) (int fd);
 	void (*recv_ready) (int fd);
 	void (*tcp_connect) (int fd, ip_addr_t *remote_addr, uint16_t remote_port);
+	void (*recv_flush) (void); /* called before the task goes back to sleep */
 } lwip_socket_cb_t;
 
 typedef struct
@@ -89,9 +90,16 @@ typedef struct
 
 	struct
 	{
-		uint32_t task;
+		uint32_t task; /* usec, fallback wakeup period of the task, 0 = none */
 	} timeout;
 
+	struct
+	{
+		uint32_t wakeups;
+		uint32_t events;
+		TickType_t start;
+	} stats;
+
 	struct
 	{
 		uint16_t task:1;
@@ -118,6 +126,9 @@ extern int _lwip_socket_tcp_set_nodelay (int fd, bool enable);
 extern int _lwip_socket_init (lwip_socket_cb_t *cb);
 extern int _lwip_socket_deinit (void);
 
+extern int _lwip_socket_get_wakeups (uint32_t *wakeups, uint32_t *events, uint32_t *msec);
+extern int _lwip_socket_clear_wakeups (void);
+
 extern int _lwip_socket_open_udp (int *fd, uint16_t local_port, bool ipv6, bool reuse_addr);
 extern int _lwip_socket_open_tcp_server (int *fd, uint16_t local_port, bool ipv6, bool reuse_addr);
 extern int _lwip_socket_open_tcp_client (int *fd, ip_addr_t *remote_addr, uint16_t remote_port,
@@ -26,6 +26,7 @@
 #include "nrc_sdk.h"
 
 #include <esp_http_server.h>
+#include <httpd_static.h>
 #include <esp_err.h>
 #include "wifi_config_setup.h"
 #include "wifi_connect_common.h"
@@ -42,35 +43,6 @@ static nvs_handle_t nvs_handle;
 #define AP_SSID "halow_setup"
 #define SECURITY_MODE_SIZE 10
 
-static const char input_element[] = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<body>
-
-<h1>Configure Wi-Fi</h1>
-
-<form action="/hello">
-  <label for="ssid">Wi-Fi name:</label>
-  <input type="text" id="ssid" name="ssid"><br><br>
-  <label for="passwd">Wi-Fi password:</label>
-  <input type="text" id="passwd" name="passwd"><br><br>
-  <label for="security">Security mode:</label>
-  <select id="security" name="security">
-    <option value="open">OPEN</option>
-    <option value="wpa2">WPA2</option>
-    <option value="wpa3-sae">WPA3-SAE</option>
-    <option value="wpa3-owe">WPA3-OWE</option>
-  </select>
-  <input type="submit" value="Submit">
-</form>
-
-<p>Input desired values and click the "Submit" button.</p>
-
-</body>
-</html>
-
-)rawliteral";
-
 static const char complete_element[] = R"rawliteral(
 <!DOCTYPE html>
 <html>
@@ -351,17 +323,15 @@ static httpd_uri_t rebooting = {
 	.user_ctx  = NULL
 };
 
-static esp_err_t input_handler(httpd_req_t *req)
-{
-	/* Recv, Process and Send */
-	return httpd_resp_send(req, input_element, strlen(input_element));
-}
+/* www/ bundled by lib/http_server/tools/httpd_bundle.py into sample_http_server_www.c,
+ * regenerate it from this directory with the command at its top */
+extern const httpd_static_bundle_t sample_http_server_www;
 
 static httpd_uri_t input = {
 	.uri = "/",
 	.method = HTTP_GET,
-	.handler = input_handler,
-	.user_ctx = NULL
+	.handler = httpd_static_handler,
+	.user_ctx = (void *) &sample_http_server_www
 };
 
 /******************************************************************************
@@ -0,0 +1,91 @@
+/* Generated by httpd_bundle.py, do not edit. Regenerate with
+ *   ../../../lib/http_server/tools/httpd_bundle.py -o sample_http_server_www.c -n sample_http_server_www --identity www
+ */
+
+#include <httpd_static.h>
+
+/* /, 321 bytes gzip */
+static const uint8_t sample_http_server_www_0[] = {
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x92, 0x4d, 0x6b, 0xc3, 0x30,
+	0x0c, 0x86, 0xef, 0xfd, 0x15, 0x9a, 0xef, 0x9d, 0x59, 0x7b, 0x1b, 0x8e, 0xa1, 0x74, 0x19, 0xec,
+	0xb2, 0x16, 0x3a, 0x28, 0x3b, 0x3a, 0xb1, 0xba, 0x98, 0x39, 0xb6, 0x89, 0x9d, 0x65, 0xf9, 0xf7,
+	0x73, 0x9c, 0xa4, 0xd0, 0x7d, 0xd0, 0x1d, 0x4c, 0xac, 0xe8, 0x79, 0x25, 0x4b, 0xbc, 0xec, 0xe6,
+	0x61, 0xb7, 0x7d, 0x79, 0xdd, 0xe7, 0x50, 0x85, 0x5a, 0xf3, 0x05, 0x9b, 0x3e, 0x85, 0x95, 0x3d,
+	0x5f, 0xc4, 0xf0, 0x8e, 0x6f, 0xad, 0x39, 0xa9, 0xb7, 0xb6, 0x41, 0x38, 0xaa, 0xe5, 0xa3, 0x62,
+	0x34, 0xfe, 0x8b, 0x99, 0x93, 0x6d, 0x6a, 0x10, 0x65, 0x50, 0xd6, 0x64, 0x84, 0x56, 0xa8, 0xb5,
+	0x25, 0x7c, 0x01, 0xc0, 0xb4, 0x28, 0x50, 0x43, 0x4c, 0x67, 0xc4, 0x7b, 0x25, 0x09, 0x4f, 0x32,
+	0x30, 0xa2, 0xc6, 0x7b, 0x46, 0x53, 0x36, 0x71, 0xca, 0xb8, 0x36, 0x40, 0xe8, 0x1d, 0x66, 0x24,
+	0xe0, 0x67, 0x20, 0xa0, 0xe4, 0x24, 0x49, 0xf0, 0x2c, 0x67, 0x45, 0x93, 0xce, 0xb7, 0xda, 0x4e,
+	0x78, 0xdf, 0x9d, 0xab, 0xa7, 0xc8, 0x36, 0xf2, 0x1f, 0x1d, 0x26, 0xe1, 0xd4, 0x63, 0x2e, 0xf3,
+	0x47, 0x17, 0x8f, 0x65, 0xdb, 0xa8, 0xd0, 0x13, 0x7e, 0x98, 0x6e, 0x50, 0x5b, 0x79, 0x39, 0x88,
+	0x47, 0x8d, 0x65, 0x18, 0x5f, 0x3f, 0xe3, 0xf3, 0x04, 0x67, 0x79, 0x04, 0x23, 0x6a, 0xdd, 0xb0,
+	0x2f, 0xf8, 0x10, 0xba, 0x8d, 0x59, 0xeb, 0xd0, 0x10, 0xbe, 0xdb, 0xe7, 0xcf, 0x8c, 0x8e, 0x99,
+	0x5f, 0xb1, 0xce, 0x89, 0x55, 0x9c, 0x73, 0xbf, 0x59, 0x5d, 0xc3, 0xd6, 0x4b, 0x2f, 0x30, 0xa1,
+	0xeb, 0xe5, 0x61, 0x93, 0x5f, 0xc7, 0x6d, 0x37, 0xe3, 0xbb, 0xe3, 0x05, 0xce, 0xe8, 0x38, 0xd5,
+	0x8f, 0x3d, 0xfa, 0xb6, 0xa8, 0x55, 0xdc, 0xe4, 0x54, 0xe5, 0x30, 0x86, 0xd1, 0x31, 0x74, 0x30,
+	0xc4, 0x60, 0x0c, 0xc7, 0x9f, 0x12, 0x2f, 0xd1, 0xab, 0x06, 0xe5, 0x48, 0x7a, 0x10, 0x46, 0x42,
+	0xa9, 0x55, 0xf9, 0x0e, 0xa1, 0x42, 0x98, 0x85, 0x50, 0xb4, 0x21, 0x58, 0x73, 0xcb, 0xa8, 0x1b,
+	0xb4, 0x74, 0xf4, 0x5d, 0xf4, 0x58, 0xb2, 0xe1, 0x17, 0xa9, 0xed, 0x7e, 0x5e, 0x9e, 0x02, 0x00,
+	0x00,
+};
+
+/* /index.html, 670 bytes */
+static const uint8_t sample_http_server_www_0_identity[] = {
+	0x3c, 0x21, 0x44, 0x4f, 0x43, 0x54, 0x59, 0x50, 0x45, 0x20, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x0a,
+	0x3c, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x0a, 0x3c, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0x0a, 0x0a, 0x3c,
+	0x68, 0x31, 0x3e, 0x43, 0x6f, 0x6e, 0x66, 0x69, 0x67, 0x75, 0x72, 0x65, 0x20, 0x57, 0x69, 0x2d,
+	0x46, 0x69, 0x3c, 0x2f, 0x68, 0x31, 0x3e, 0x0a, 0x0a, 0x3c, 0x66, 0x6f, 0x72, 0x6d, 0x20, 0x61,
+	0x63, 0x74, 0x69, 0x6f, 0x6e, 0x3d, 0x22, 0x2f, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x22, 0x3e, 0x0a,
+	0x20, 0x20, 0x3c, 0x6c, 0x61, 0x62, 0x65, 0x6c, 0x20, 0x66, 0x6f, 0x72, 0x3d, 0x22, 0x73, 0x73,
+	0x69, 0x64, 0x22, 0x3e, 0x57, 0x69, 0x2d, 0x46, 0x69, 0x20, 0x6e, 0x61, 0x6d, 0x65, 0x3a, 0x3c,
+	0x2f, 0x6c, 0x61, 0x62, 0x65, 0x6c, 0x3e, 0x0a, 0x20, 0x20, 0x3c, 0x69, 0x6e, 0x70, 0x75, 0x74,
+	0x20, 0x74, 0x79, 0x70, 0x65, 0x3d, 0x22, 0x74, 0x65, 0x78, 0x74, 0x22, 0x20, 0x69, 0x64, 0x3d,
+	0x22, 0x73, 0x73, 0x69, 0x64, 0x22, 0x20, 0x6e, 0x61, 0x6d, 0x65, 0x3d, 0x22, 0x73, 0x73, 0x69,
+	0x64, 0x22, 0x3e, 0x3c, 0x62, 0x72, 0x3e, 0x3c, 0x62, 0x72, 0x3e, 0x0a, 0x20, 0x20, 0x3c, 0x6c,
+	0x61, 0x62, 0x65, 0x6c, 0x20, 0x66, 0x6f, 0x72, 0x3d, 0x22, 0x70, 0x61, 0x73, 0x73, 0x77, 0x64,
+	0x22, 0x3e, 0x57, 0x69, 0x2d, 0x46, 0x69, 0x20, 0x70, 0x61, 0x73, 0x73, 0x77, 0x6f, 0x72, 0x64,
+	0x3a, 0x3c, 0x2f, 0x6c, 0x61, 0x62, 0x65, 0x6c, 0x3e, 0x0a, 0x20, 0x20, 0x3c, 0x69, 0x6e, 0x70,
+	0x75, 0x74, 0x20, 0x74, 0x79, 0x70, 0x65, 0x3d, 0x22, 0x74, 0x65, 0x78, 0x74, 0x22, 0x20, 0x69,
+	0x64, 0x3d, 0x22, 0x70, 0x61, 0x73, 0x73, 0x77, 0x64, 0x22, 0x20, 0x6e, 0x61, 0x6d, 0x65, 0x3d,
+	0x22, 0x70, 0x61, 0x73, 0x73, 0x77, 0x64, 0x22, 0x3e, 0x3c, 0x62, 0x72, 0x3e, 0x3c, 0x62, 0x72,
+	0x3e, 0x0a, 0x20, 0x20, 0x3c, 0x6c, 0x61, 0x62, 0x65, 0x6c, 0x20, 0x66, 0x6f, 0x72, 0x3d, 0x22,
+	0x73, 0x65, 0x63, 0x75, 0x72, 0x69, 0x74, 0x79, 0x22, 0x3e, 0x53, 0x65, 0x63, 0x75, 0x72, 0x69,
+	0x74, 0x79, 0x20, 0x6d, 0x6f, 0x64, 0x65, 0x3a, 0x3c, 0x2f, 0x6c, 0x61, 0x62, 0x65, 0x6c, 0x3e,
+	0x0a, 0x20, 0x20, 0x3c, 0x73, 0x65, 0x6c, 0x65, 0x63, 0x74, 0x20, 0x69, 0x64, 0x3d, 0x22, 0x73,
+	0x65, 0x63, 0x75, 0x72, 0x69, 0x74, 0x79, 0x22, 0x20, 0x6e, 0x61, 0x6d, 0x65, 0x3d, 0x22, 0x73,
+	0x65, 0x63, 0x75, 0x72, 0x69, 0x74, 0x79, 0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x6f,
+	0x70, 0x74, 0x69, 0x6f, 0x6e, 0x20, 0x76, 0x61, 0x6c, 0x75, 0x65, 0x3d, 0x22, 0x6f, 0x70, 0x65,
+	0x6e, 0x22, 0x3e, 0x4f, 0x50, 0x45, 0x4e, 0x3c, 0x2f, 0x6f, 0x70, 0x74, 0x69, 0x6f, 0x6e, 0x3e,
+	0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x6f, 0x70, 0x74, 0x69, 0x6f, 0x6e, 0x20, 0x76, 0x61, 0x6c,
+	0x75, 0x65, 0x3d, 0x22, 0x77, 0x70, 0x61, 0x32, 0x22, 0x3e, 0x57, 0x50, 0x41, 0x32, 0x3c, 0x2f,
+	0x6f, 0x70, 0x74, 0x69, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x6f, 0x70, 0x74,
+	0x69, 0x6f, 0x6e, 0x20, 0x76, 0x61, 0x6c, 0x75, 0x65, 0x3d, 0x22, 0x77, 0x70, 0x61, 0x33, 0x2d,
+	0x73, 0x61, 0x65, 0x22, 0x3e, 0x57, 0x50, 0x41, 0x33, 0x2d, 0x53, 0x41, 0x45, 0x3c, 0x2f, 0x6f,
+	0x70, 0x74, 0x69, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x6f, 0x70, 0x74, 0x69,
+	0x6f, 0x6e, 0x20, 0x76, 0x61, 0x6c, 0x75, 0x65, 0x3d, 0x22, 0x77, 0x70, 0x61, 0x33, 0x2d, 0x6f,
+	0x77, 0x65, 0x22, 0x3e, 0x57, 0x50, 0x41, 0x33, 0x2d, 0x4f, 0x57, 0x45, 0x3c, 0x2f, 0x6f, 0x70,
+	0x74, 0x69, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x3c, 0x2f, 0x73, 0x65, 0x6c, 0x65, 0x63, 0x74,
+	0x3e, 0x0a, 0x20, 0x20, 0x3c, 0x69, 0x6e, 0x70, 0x75, 0x74, 0x20, 0x74, 0x79, 0x70, 0x65, 0x3d,
+	0x22, 0x73, 0x75, 0x62, 0x6d, 0x69, 0x74, 0x22, 0x20, 0x76, 0x61, 0x6c, 0x75, 0x65, 0x3d, 0x22,
+	0x53, 0x75, 0x62, 0x6d, 0x69, 0x74, 0x22, 0x3e, 0x0a, 0x3c, 0x2f, 0x66, 0x6f, 0x72, 0x6d, 0x3e,
+	0x0a, 0x0a, 0x3c, 0x70, 0x3e, 0x49, 0x6e, 0x70, 0x75, 0x74, 0x20, 0x64, 0x65, 0x73, 0x69, 0x72,
+	0x65, 0x64, 0x20, 0x76, 0x61, 0x6c, 0x75, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x63, 0x6c,
+	0x69, 0x63, 0x6b, 0x20, 0x74, 0x68, 0x65, 0x20, 0x22, 0x53, 0x75, 0x62, 0x6d, 0x69, 0x74, 0x22,
+	0x20, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x2e, 0x3c, 0x2f, 0x70, 0x3e, 0x0a, 0x0a, 0x3c, 0x2f,
+	0x62, 0x6f, 0x64, 0x79, 0x3e, 0x0a, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x0a,
+};
+
+static const httpd_static_asset_t sample_http_server_www_identities[] = {
+	{ "/index.html", "text/html", "\"53b915b50984a128\"", sample_http_server_www_0_identity, sizeof(sample_http_server_www_0_identity), false },
+};
+
+static const httpd_static_asset_t sample_http_server_www_assets[] = {
+	{ "/", "text/html", "\"47e241d888c091ef\"", sample_http_server_www_0, sizeof(sample_http_server_www_0), true, &sample_http_server_www_identities[0] },
+	{ "/index.html", "text/html", "\"47e241d888c091ef\"", sample_http_server_www_0, sizeof(sample_http_server_www_0), true, &sample_http_server_www_identities[0] },
+};
+
+const httpd_static_bundle_t sample_http_server_www = {
+	.assets = sample_http_server_www_assets,
+	.count = sizeof(sample_http_server_www_assets) / sizeof(sample_http_server_www_assets[0]),
+	.cache_control = "no-cache",
+};